@@ -0,0 +1,65 @@
+/**
+ * @file hash.hpp
+ * @author Jonah Chen
+ * @brief mixing functions for hashing keys made of several integers or floats.
+ * Combining the hashes of the parts with XOR is symmetric, so keys that are
+ * permutations of each other, like (1,2) and (2,1), always collide. Instead,
+ * the parts are packed into 64 bits and every bit of the result is mixed with
+ * every bit of the key.
+ * @version 1.0
+ * @date 2021-11-25
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace hashing {
+
+/**
+ * @brief mix the bits of a 64 bit key with the finalizer of splitmix64, so
+ * keys that differ in any bit have unrelated hashes.
+ *
+ * @param x the key.
+ * @return uint64_t the mixed key.
+ */
+constexpr uint64_t mix(uint64_t x)
+{
+	x ^= x >> 30;
+	x *= 0xbf58476d1ce4e5b9ull;
+	x ^= x >> 27;
+	x *= 0x94d049bb133111ebull;
+	x ^= x >> 31;
+	return x;
+}
+
+/**
+ * @brief hash a pair of 32 bit integers, in order.
+ */
+constexpr uint64_t combine(uint32_t a, uint32_t b)
+{ return mix((uint64_t) a << 32 | b); }
+
+/**
+ * @brief hash three 32 bit integers, in order.
+ */
+constexpr uint64_t combine(uint32_t a, uint32_t b, uint32_t c)
+{ return mix(combine(a, b) ^ c); }
+
+/**
+ * @brief the bits of a float, with -0.0f and 0.0f being the same key because
+ * they compare equal.
+ */
+inline uint32_t bits(float f)
+{
+	if (f == 0.0f)
+		return 0;
+	uint32_t u;
+	std::memcpy(&u, &f, sizeof(u));
+	return u;
+}
+
+}
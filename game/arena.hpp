@@ -0,0 +1,228 @@
+/**
+ * @file arena.hpp
+ * @author Jonah Chen
+ * @brief slab allocator for the nodes and edges of the game. Objects are
+ * constructed inside large slabs which are kept around when the arena is reset,
+ * so loading and resetting worlds over and over reuses the same memory.
+ * @version 1.0
+ * @date 2021-11-21
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace game {
+
+/**
+ * @brief An arena of objects of type T allocated in slabs of SLAB_SIZE objects.
+ *
+ * @details
+ * - Slots are handed out from the free list first, then from the end of the
+ *   used part of the slabs.
+ * - Every object gets a generation number when it is created. A handle stores
+ *   the slot and the generation, so a handle to an object that was destroyed
+ *   (or to a slot that was reused) is detected as stale.
+ * - reset() forgets every object at once. When T is trivially destructible this
+ *   only touches the arena itself, otherwise the destructors of the live objects
+ *   are run. The slabs are kept for the next world.
+ *
+ * @tparam T type of the objects.
+ * @tparam SLAB_SIZE number of objects per slab.
+ */
+template<typename T, std::size_t SLAB_SIZE = 1024>
+class arena
+{
+public:
+	/**
+	 * @brief a reference to an object in the arena that can be checked for
+	 * staleness.
+	 */
+	struct handle
+	{
+		uint32_t index = 0;
+		uint32_t generation = 0; // 0 is never a valid generation
+
+		bool operator==(const handle &other) const = default;
+	};
+
+	arena() = default;
+
+	arena(const arena &) = delete;
+
+	arena &operator=(const arena &) = delete;
+
+	~arena()
+	{ reset(); }
+
+	/**
+	 * @brief construct an object inside the arena.
+	 *
+	 * @param args arguments forwarded to the constructor of T.
+	 * @return T* pointer to the new object.
+	 */
+	template<typename... Args>
+	T *create(Args &&... args)
+	{
+		uint32_t index;
+		if (free_ != NONE)
+		{
+			index = free_;
+			free_ = at(index).next_free;
+		}
+		else
+		{
+			if (used_ == slabs_.size() * SLAB_SIZE)
+				slabs_.emplace_back(new slot[SLAB_SIZE]);
+			index = used_++;
+		}
+
+		slot &s = at(index);
+		T *obj = new(s.storage) T(std::forward<Args>(args)...);
+		s.index = index;
+		s.generation = next_generation();
+		++size_;
+		return obj;
+	}
+
+	/**
+	 * @brief destroy an object created by this arena and recycle its slot.
+	 *
+	 * @param obj pointer to the object to destroy.
+	 */
+	void destroy(T *obj)
+	{
+		if (!owns(obj))
+			return;
+
+		slot &s = *reinterpret_cast<slot *>(obj);
+		obj->~T();
+		s.generation = 0;
+		s.next_free = free_;
+		free_ = s.index;
+		--size_;
+	}
+
+	/**
+	 * @brief check whether a pointer refers to a live object of this arena.
+	 *
+	 * @warning the pointer must be either nullptr, or a pointer that was
+	 * returned by create() of some arena of type T, or the result is undefined.
+	 */
+	bool owns(const T *obj) const
+	{
+		if (!obj)
+			return false;
+		const slot &s = *reinterpret_cast<const slot *>(obj);
+		return s.generation and s.index < used_ and &at(s.index) == &s;
+	}
+
+	/**
+	 * @return handle to a live object of this arena.
+	 */
+	handle get_handle(const T *obj) const
+	{
+		const slot &s = *reinterpret_cast<const slot *>(obj);
+		return {s.index, s.generation};
+	}
+
+	/**
+	 * @return T* pointer to the object referred to by the handle.
+	 * @return nullptr if the handle is stale.
+	 */
+	T *get(handle h) const
+	{
+		if (!h.generation or h.index >= used_)
+			return nullptr;
+		const slot &s = at(h.index);
+		return s.generation == h.generation
+			   ? reinterpret_cast<T *>(const_cast<unsigned char *>(s.storage))
+			   : nullptr;
+	}
+
+	/**
+	 * @brief call a function on every live object of the arena.
+	 */
+	template<typename F>
+	void for_each(F &&f)
+	{
+		for (uint32_t i = 0; i < used_; ++i)
+			if (at(i).generation)
+				f(reinterpret_cast<T *>(at(i).storage));
+	}
+
+	/**
+	 * @brief destroy every object in the arena at once, keeping the slabs.
+	 * Every handle given out before the reset becomes stale.
+	 */
+	void reset()
+	{
+		if constexpr (!std::is_trivially_destructible_v<T>)
+			for_each([](T *obj) { obj->~T(); });
+
+		used_ = 0;
+		size_ = 0;
+		free_ = NONE;
+	}
+
+	/**
+	 * @brief destroy every object and give the slabs back to the system.
+	 */
+	void release()
+	{
+		reset();
+		slabs_.clear();
+	}
+
+	// number of live objects
+	inline std::size_t size() const
+	{ return size_; }
+
+	// number of objects that fit in the slabs
+	inline std::size_t capacity() const
+	{ return slabs_.size() * SLAB_SIZE; }
+
+	inline std::size_t num_slabs() const
+	{ return slabs_.size(); }
+
+private:
+	static constexpr uint32_t NONE = UINT32_MAX;
+
+	// the storage must be the first member, so a T* is also a slot*
+	struct slot
+	{
+		alignas(T) unsigned char storage[sizeof(T)];
+		uint32_t index;
+		uint32_t generation = 0;
+		uint32_t next_free;
+	};
+
+	std::vector<std::unique_ptr<slot[]>> slabs_;
+	uint32_t used_ = 0;       // slots below this index have been handed out
+	uint32_t free_ = NONE;    // head of the list of recycled slots
+	std::size_t size_ = 0;
+	uint32_t generation_ = 0; // last generation handed out, never reset
+
+	inline slot &at(uint32_t index)
+	{ return slabs_[index / SLAB_SIZE][index % SLAB_SIZE]; }
+
+	inline const slot &at(uint32_t index) const
+	{ return slabs_[index / SLAB_SIZE][index % SLAB_SIZE]; }
+
+	inline uint32_t next_generation()
+	{
+		if (!++generation_)
+			++generation_;
+		return generation_;
+	}
+};
+
+}
@@ -0,0 +1,547 @@
+/**
+ * @file canonical.cpp
+ * @author Jonah Chen
+ * @brief implement the store of canonical forms specified in canonical.hpp
+ * @version 1.0
+ * @date 2021-11-30
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include "canonical.hpp"
+#include "common/hash.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace game {
+
+// multiples of up and nimbers tried when printing an infinitesimal
+static constexpr int64_t MAX_PRINTED_UPS = 8;
+static constexpr uint64_t MAX_PRINTED_STAR = 8;
+
+const char *outcome_name(outcome o)
+{
+	switch (o)
+	{
+	case outcome::previous: return "P";
+	case outcome::next: return "N";
+	case outcome::left: return "L";
+	case outcome::right: return "R";
+	default: return "?";
+	}
+}
+
+static inline uint64_t pair_key(uint32_t a, uint32_t b)
+{ return (uint64_t) a << 32 | b; }
+
+static void tidy(std::vector<forms::id_t> &v)
+{
+	std::sort(v.begin(), v.end());
+	v.erase(std::unique(v.begin(), v.end()), v.end());
+}
+
+static uint64_t hash_options(const std::vector<forms::id_t> &left,
+							 const std::vector<forms::id_t> &right)
+{
+	uint64_t h = hashing::combine(left.size(), right.size());
+	for (forms::id_t l: left)
+		h = hashing::mix(h ^ l);
+	for (forms::id_t r: right)
+		h = hashing::mix(h ^ ~(uint64_t) r);
+	return h;
+}
+
+forms::forms()
+{
+	forms_.push_back({0, 0, 0, 0, 0, true, 0});
+	negatives_.push_back(zero);
+	numbers_.emplace(zero, dyadic(0));
+	number_ids_.emplace(dyadic(0), zero);
+	nimbers_.push_back(zero);
+	interned_.emplace(hash_options({}, {}), zero);
+}
+
+forms::id_t forms::intern(const std::vector<id_t> &left,
+						  const std::vector<id_t> &right)
+{
+	const uint64_t h = hash_options(left, right);
+	const auto range = interned_.equal_range(h);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		const id_t g = it->second;
+		if (std::equal(left.begin(), left.end(), left_begin(g), left_end(g)) and
+			std::equal(right.begin(), right.end(), right_begin(g), right_end(g)))
+			return g;
+	}
+
+	form f{(uint32_t) options_.size(), (uint32_t) left.size(), 0,
+		   (uint32_t) right.size(), 0, false, -1};
+	options_.insert(options_.end(), left.begin(), left.end());
+	f.right = options_.size();
+	options_.insert(options_.end(), right.begin(), right.end());
+	for (id_t o: left)
+		f.birthday = std::max(f.birthday, forms_[o].birthday + 1);
+	for (id_t o: right)
+		f.birthday = std::max(f.birthday, forms_[o].birthday + 1);
+
+	// a canonical game whose options are numbers, every left one less than
+	// every right one, is the canonical form of the simplest number between
+	const bool numeric = std::all_of(left.begin(), left.end(),
+									 [&](id_t o) { return forms_[o].number; }) and
+						 std::all_of(right.begin(), right.end(),
+									 [&](id_t o) { return forms_[o].number; });
+	std::optional<dyadic> l, r;
+	if (numeric and left.size() <= 1 and right.size() <= 1)
+	{
+		if (!left.empty())
+			l = numbers_.at(left[0]);
+		if (!right.empty())
+			r = numbers_.at(right[0]);
+		f.number = !l or !r or *l < *r;
+	}
+
+	// *n has *0 ... *(n-1) as the options of both players
+	if (left == right)
+	{
+		int64_t largest = -1;
+		bool nimbers = true;
+		for (id_t o: left)
+		{
+			nimbers = nimbers and forms_[o].nim >= 0;
+			largest = std::max(largest, forms_[o].nim);
+		}
+		if (nimbers and largest + 1 == (int64_t) left.size())
+			f.nim = left.size();
+	}
+
+	const id_t g = forms_.size();
+	forms_.push_back(f);
+	negatives_.push_back(none);
+	interned_.emplace(h, g);
+	if (f.number)
+	{
+		const dyadic x = simplest(l, r);
+		numbers_.emplace(g, x);
+		number_ids_.emplace(x, g);
+	}
+	return g;
+}
+
+forms::id_t forms::make(std::vector<id_t> left, std::vector<id_t> right)
+{
+	tidy(left);
+	tidy(right);
+	for (bool changed = true; changed;)
+	{
+		changed = false;
+
+		// an option is dominated if the same player has a better one. Equal
+		// options have the same id, so the best options are never all removed.
+		const auto undominated = [&](std::vector<id_t> &v, bool is_left)
+		{
+			std::vector<id_t> kept;
+			for (id_t a: v)
+			{
+				bool dominated = false;
+				for (id_t b: v)
+				{
+					if (b != a and (is_left ? le(a, b) : le(b, a)))
+					{
+						dominated = true;
+						break;
+					}
+				}
+				if (!dominated)
+					kept.push_back(a);
+			}
+			changed = changed or kept.size() != v.size();
+			v.swap(kept);
+		};
+		undominated(left, true);
+		undominated(right, false);
+
+		// a left option A is reversible through its right option A^R when
+		// A^R <= G, and is replaced by the left options of A^R. The mirror
+		// image holds for right options.
+		for (std::size_t i = 0; i < left.size() and !changed; ++i)
+		{
+			const std::vector<id_t> replies(right_begin(left[i]),
+											right_end(left[i]));
+			for (id_t reply: replies)
+			{
+				if (le(reply, left, right))
+				{
+					left.erase(left.begin() + i);
+					left.insert(left.end(), left_begin(reply), left_end(reply));
+					tidy(left);
+					changed = true;
+					break;
+				}
+			}
+		}
+		for (std::size_t i = 0; i < right.size() and !changed; ++i)
+		{
+			const std::vector<id_t> replies(left_begin(right[i]),
+											left_end(right[i]));
+			for (id_t reply: replies)
+			{
+				if (le(left, right, reply))
+				{
+					right.erase(right.begin() + i);
+					right.insert(right.end(), right_begin(reply),
+								 right_end(reply));
+					tidy(right);
+					changed = true;
+					break;
+				}
+			}
+		}
+	}
+	return intern(left, right);
+}
+
+forms::id_t forms::number(const dyadic &x)
+{
+	const auto found = number_ids_.find(x);
+	if (found != number_ids_.end())
+		return found->second;
+
+	const int64_t whole = x.floor();
+	if (x.exp() > MAX_BIRTHDAY or
+		std::abs(whole) + (int64_t) x.exp() > (int64_t) MAX_BIRTHDAY)
+		throw std::overflow_error("number born too late for a canonical form");
+
+	// the canonical forms of numbers are known, so they are interned without
+	// being simplified: n = {n - 1 |}, -n = {| -n + 1}, and
+	// m / 2^k = {(m - 1) / 2^k | (m + 1) / 2^k}
+	if (x.is_integer())
+	{
+		const int64_t step = x.sign();
+		id_t g = zero;
+		for (int64_t n = step; n != whole + step; n += step)
+		{
+			const auto next = number_ids_.find(dyadic(n));
+			if (next != number_ids_.end())
+				g = next->second;
+			else if (step > 0)
+				g = intern({g}, {});
+			else
+				g = intern({}, {g});
+		}
+		return g;
+	}
+	const dyadic epsilon = dyadic(1).ldexp(-(int64_t) x.exp());
+	const id_t l = number(x - epsilon);
+	const id_t r = number(x + epsilon);
+	return intern({l}, {r});
+}
+
+forms::id_t forms::nimber(uint64_t n)
+{
+	if (n > MAX_NIMBER)
+		throw std::overflow_error("nimber too large for a canonical form");
+	while (nimbers_.size() <= n)
+	{
+		// *n = {*0, ..., *(n-1) | *0, ..., *(n-1)} is already canonical
+		std::vector<id_t> options = nimbers_;
+		std::sort(options.begin(), options.end());
+		nimbers_.push_back(intern(options, options));
+	}
+	return nimbers_[n];
+}
+
+forms::id_t forms::up(int64_t n)
+{
+	// up = {0 | *}
+	const id_t star = nimber(1);
+	const id_t one = intern({zero}, {star});
+	id_t g = zero;
+	for (int64_t i = 0; i < std::abs(n); ++i)
+		g = add(g, one);
+	return n < 0 ? neg(g) : g;
+}
+
+forms::id_t forms::add(id_t a, id_t b)
+{
+	if (a == zero)
+		return b;
+	if (b == zero)
+		return a;
+	if (forms_[a].number and forms_[b].number)
+		return number(numbers_.at(a) + numbers_.at(b));
+
+	const uint64_t key = a < b ? pair_key(a, b) : pair_key(b, a);
+	const auto found = sums_.find(key);
+	if (found != sums_.end())
+		return found->second;
+
+	// the options of a + b are a^L + b, a + b^L | a^R + b, a + b^R, except
+	// that a number is never played in when the other term is not a number
+	const std::vector<id_t> al(left_begin(a), left_end(a));
+	const std::vector<id_t> ar(right_begin(a), right_end(a));
+	const std::vector<id_t> bl(left_begin(b), left_end(b));
+	const std::vector<id_t> br(right_begin(b), right_end(b));
+	std::vector<id_t> left, right;
+	if (!forms_[a].number)
+	{
+		for (id_t o: al)
+			left.push_back(add(o, b));
+		for (id_t o: ar)
+			right.push_back(add(o, b));
+	}
+	if (!forms_[b].number)
+	{
+		for (id_t o: bl)
+			left.push_back(add(a, o));
+		for (id_t o: br)
+			right.push_back(add(a, o));
+	}
+
+	const id_t sum = make(std::move(left), std::move(right));
+	sums_.emplace(key, sum);
+	return sum;
+}
+
+forms::id_t forms::neg(id_t a)
+{
+	if (negatives_[a] != none)
+		return negatives_[a];
+
+	id_t result;
+	if (forms_[a].number)
+		result = number(-numbers_.at(a));
+	else if (forms_[a].nim >= 0)
+		result = a;
+	else
+	{
+		// the negative of a canonical form is canonical
+		const std::vector<id_t> al(left_begin(a), left_end(a));
+		const std::vector<id_t> ar(right_begin(a), right_end(a));
+		std::vector<id_t> left, right;
+		for (id_t o: ar)
+			left.push_back(neg(o));
+		for (id_t o: al)
+			right.push_back(neg(o));
+		tidy(left);
+		tidy(right);
+		result = intern(left, right);
+	}
+	negatives_[a] = result;
+	negatives_[result] = a;
+	return result;
+}
+
+bool forms::le(id_t a, id_t b)
+{
+	if (a == b)
+		return true;
+	const form &fa = forms_[a], &fb = forms_[b];
+	if (fa.number and fb.number)
+		return numbers_.at(a) <= numbers_.at(b);
+	if (fa.nim >= 0 and fb.nim >= 0)
+		return false;
+
+	const uint64_t key = pair_key(a, b);
+	const auto found = le_.find(key);
+	if (found != le_.end())
+		return found->second;
+
+	// a <= b unless some a^L >= b or some b^R <= a
+	bool result = true;
+	for (const id_t *o = left_begin(a); o != left_end(a) and result; ++o)
+		result = !le(b, *o);
+	for (const id_t *o = right_begin(b); o != right_end(b) and result; ++o)
+		result = !le(*o, a);
+	le_.emplace(key, result);
+	return result;
+}
+
+bool forms::le(const std::vector<id_t> &left, const std::vector<id_t> &right,
+			   id_t h)
+{
+	for (id_t o: left)
+		if (le(h, o))
+			return false;
+	for (const id_t *o = right_begin(h); o != right_end(h); ++o)
+		if (le(*o, left, right))
+			return false;
+	return true;
+}
+
+bool forms::le(id_t h, const std::vector<id_t> &left,
+			   const std::vector<id_t> &right)
+{
+	for (const id_t *o = left_begin(h); o != left_end(h); ++o)
+		if (le(left, right, *o))
+			return false;
+	for (id_t o: right)
+		if (le(o, h))
+			return false;
+	return true;
+}
+
+/**
+ * @details by number avoidance, when g is not a number, nobody needs to move
+ * in x to win g - x, so g >= x unless some g^R <= x, and g <= x unless some
+ * g^L >= x.
+ */
+bool forms::compare(id_t g, const dyadic &x, bool greater,
+					std::unordered_map<uint64_t, bool> &memo)
+{
+	if (forms_[g].number)
+		return greater ? numbers_.at(g) >= x : numbers_.at(g) <= x;
+
+	const uint64_t key = (uint64_t) g << 1 | greater;
+	const auto found = memo.find(key);
+	if (found != memo.end())
+		return found->second;
+
+	bool result = true;
+	if (greater)
+	{
+		for (const id_t *o = right_begin(g); o != right_end(g) and result; ++o)
+			result = !compare(*o, x, false, memo);
+	}
+	else
+	{
+		for (const id_t *o = left_begin(g); o != left_end(g) and result; ++o)
+			result = !compare(*o, x, true, memo);
+	}
+	memo.emplace(key, result);
+	return result;
+}
+
+outcome forms::outcome_of(id_t g, const dyadic &x)
+{
+	// blue moving first wins unless g + x <= 0, red unless g + x >= 0
+	std::unordered_map<uint64_t, bool> memo;
+	const bool left = !compare(g, -x, false, memo);
+	const bool right = !compare(g, -x, true, memo);
+	if (left)
+		return right ? outcome::next : outcome::left;
+	return right ? outcome::right : outcome::previous;
+}
+
+/**
+ * @details the left stop of g is where the game ends up when blue moves first
+ * and both players stop as soon as the game is a number. A canonical game
+ * that is not a number has options for both players.
+ */
+dyadic forms::stop(id_t g, bool left)
+{
+	if (forms_[g].number)
+		return numbers_.at(g);
+
+	const uint64_t key = (uint64_t) g << 1 | left;
+	const auto found = stops_.find(key);
+	if (found != stops_.end())
+		return found->second;
+
+	std::optional<dyadic> best;
+	if (left)
+	{
+		for (const id_t *o = left_begin(g); o != left_end(g); ++o)
+		{
+			const dyadic s = stop(*o, false);
+			best = best ? std::max(*best, s) : s;
+		}
+	}
+	else
+	{
+		for (const id_t *o = right_begin(g); o != right_end(g); ++o)
+		{
+			const dyadic s = stop(*o, true);
+			best = best ? std::min(*best, s) : s;
+		}
+	}
+	stops_.emplace(key, *best);
+	return *best;
+}
+
+static void print_term(std::ostream &os, const dyadic &x, int64_t ups,
+					   uint64_t star)
+{
+	if (x.sign() or (!ups and !star))
+	{
+		os << x;
+		if (!ups and !star)
+			return;
+		os << " + ";
+	}
+	if (ups == 1)
+		os << "↑";
+	else if (ups == -1)
+		os << "↓";
+	else if (ups == 2)
+		os << "⇑";
+	else if (ups == -2)
+		os << "⇓";
+	else if (ups > 0)
+		os << ups << "↑";
+	else if (ups < 0)
+		os << -ups << "↓";
+	if (star)
+	{
+		os << '*';
+		if (star > 1)
+			os << star;
+	}
+}
+
+void forms::print(std::ostream &os, id_t g, const dyadic &x)
+{
+	if (forms_[g].number)
+	{
+		os << numbers_.at(g) + x;
+		return;
+	}
+	if (forms_[g].nim >= 0)
+	{
+		print_term(os, x, 0, forms_[g].nim);
+		return;
+	}
+
+	// a game whose stops are both s is s plus an infinitesimal, which is
+	// tried against small multiples of up plus small nimbers
+	const dyadic s = stop(g, true);
+	if (s == stop(g, false))
+	{
+		const id_t rest = add(g, number(-s));
+		for (int64_t n = -MAX_PRINTED_UPS; n <= MAX_PRINTED_UPS; ++n)
+		{
+			for (uint64_t m = 0; m < MAX_PRINTED_STAR; ++m)
+			{
+				if (add(up(n), nimber(m)) == rest)
+				{
+					print_term(os, s + x, n, m);
+					return;
+				}
+			}
+		}
+	}
+
+	// the options are copied, as printing them may intern new games
+	const std::vector<id_t> left(left_begin(g), left_end(g));
+	const std::vector<id_t> right(right_begin(g), right_end(g));
+	if (x.sign())
+		os << x << " + ";
+	os << '{';
+	for (std::size_t i = 0; i < left.size(); ++i)
+	{
+		if (i)
+			os << ", ";
+		print(os, left[i]);
+	}
+	os << '|';
+	for (std::size_t i = 0; i < right.size(); ++i)
+	{
+		if (i)
+			os << ", ";
+		print(os, right[i]);
+	}
+	os << '}';
+}
+
+}
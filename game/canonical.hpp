@@ -0,0 +1,199 @@
+/**
+ * @file canonical.hpp
+ * @author Jonah Chen
+ * @brief canonical forms of short games, which value the components that mix
+ * green with red or blue edges. Such a component is neither a number nor a
+ * nimber, and can be worth things like up or * + 1/2, so its value is kept as
+ * the simplest game tree equal to it.
+ * @version 1.0
+ * @date 2021-11-30
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#pragma once
+
+#include "value.hpp"
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+namespace game {
+
+/**
+ * @brief the outcome class of a position, which says who wins it when both
+ * players play perfectly.
+ * - previous: the player who moves second wins, the position is 0.
+ * - next:     the player who moves first wins, the position is fuzzy.
+ * - left:     the blue player wins, the position is positive.
+ * - right:    the red player wins, the position is negative.
+ */
+enum class outcome : uint8_t
+{
+	previous = 0,
+	next,
+	left,
+	right
+};
+
+/**
+ * @return const char* the usual name of the outcome class: P, N, L or R.
+ */
+const char *outcome_name(outcome o);
+
+/**
+ * @brief a store of games in canonical form, where every game is interned in
+ * a hash-consed DAG. A game is an id into the store, and equal games have the
+ * same id, so identical sub-games share their storage, and testing two games
+ * for equality is comparing their ids.
+ *
+ * @details
+ * - make() puts a game given by its options in canonical form: dominated
+ *   options are removed, and reversible options are bypassed by the options
+ *   of their reversing options, until neither applies. The result has no
+ *   dominated or reversible options, and is unique.
+ * - Sums, negatives and comparisons are memoized by the ids of the games, so
+ *   sums of the same components are only worked out once.
+ * - Sums with numbers use the number translation theorem, so adding a number
+ *   to a game that is not a number only moves its options, and never plays in
+ *   the number.
+ * - The store only grows, and is not thread safe.
+ */
+class forms
+{
+public:
+	using id_t = uint32_t;
+
+	// the game where neither player can move, {|}
+	static constexpr id_t zero = 0;
+
+	// largest nimber made by nimber(), as *n has n options
+	static constexpr uint64_t MAX_NIMBER = 256;
+
+	// largest birthday of the numbers made by number()
+	static constexpr uint32_t MAX_BIRTHDAY = 4096;
+
+	forms();
+
+	forms(const forms &) = delete;
+
+	forms &operator=(const forms &) = delete;
+
+	/**
+	 * @brief the canonical form of the game {left | right}.
+	 *
+	 * @param left the options of the blue player, in any order.
+	 * @param right the options of the red player, in any order.
+	 * @return id_t the game.
+	 */
+	id_t make(std::vector<id_t> left, std::vector<id_t> right);
+
+	/**
+	 * @return id_t the canonical form of a number.
+	 * @throw std::overflow_error if the number is born after MAX_BIRTHDAY.
+	 */
+	id_t number(const dyadic &x);
+
+	/**
+	 * @return id_t the nimber *n.
+	 * @throw std::overflow_error if n is more than MAX_NIMBER.
+	 */
+	id_t nimber(uint64_t n);
+
+	/**
+	 * @return id_t n times up, which is down for negative n.
+	 */
+	id_t up(int64_t n);
+
+	id_t add(id_t a, id_t b);
+
+	id_t neg(id_t a);
+
+	/**
+	 * @return true if a <= b, so the blue player wins b - a when red moves
+	 * first.
+	 */
+	bool le(id_t a, id_t b);
+
+	/**
+	 * @return outcome the outcome class of g + x.
+	 */
+	outcome outcome_of(id_t g, const dyadic &x = 0);
+
+	/**
+	 * @brief print g + x. A game equal to a number plus a multiple of up plus
+	 * a nimber is printed like 1/2 + ↑*, and other games by their options.
+	 */
+	void print(std::ostream &os, id_t g, const dyadic &x = 0);
+
+	inline bool is_number(id_t g) const
+	{ return forms_[g].number; }
+
+	/**
+	 * @pre is_number(g) is true.
+	 */
+	inline const dyadic &get_number(id_t g) const
+	{ return numbers_.at(g); }
+
+	inline const id_t *left_begin(id_t g) const
+	{ return options_.data() + forms_[g].left; }
+
+	inline const id_t *left_end(id_t g) const
+	{ return left_begin(g) + forms_[g].num_left; }
+
+	inline const id_t *right_begin(id_t g) const
+	{ return options_.data() + forms_[g].right; }
+
+	inline const id_t *right_end(id_t g) const
+	{ return right_begin(g) + forms_[g].num_right; }
+
+	inline uint32_t birthday(id_t g) const
+	{ return forms_[g].birthday; }
+
+	/**
+	 * @return std::size_t the number of games interned.
+	 */
+	inline std::size_t size() const
+	{ return forms_.size(); }
+
+private:
+	static constexpr id_t none = ~(id_t) 0;
+
+	struct form
+	{
+		uint32_t left, num_left; // range of options_
+		uint32_t right, num_right;
+		uint32_t birthday;
+		bool number; // whether the game is a number, see numbers_
+		int64_t nim; // n if the game is *n, otherwise -1
+	};
+
+	std::vector<form> forms_;
+	std::vector<id_t> options_; // the options of every game
+	std::unordered_multimap<uint64_t, id_t> interned_; // games by options
+	std::unordered_map<id_t, dyadic> numbers_; // value of every number
+	std::map<dyadic, id_t> number_ids_;
+	std::vector<id_t> nimbers_; // *n by n
+	std::vector<id_t> negatives_; // negative of every game, by id
+	std::unordered_map<uint64_t, id_t> sums_; // by the ids of the terms
+	std::unordered_map<uint64_t, bool> le_; // a <= b by the ids of a and b
+	std::unordered_map<uint64_t, dyadic> stops_; // by id and side
+
+	id_t intern(const std::vector<id_t> &left, const std::vector<id_t> &right);
+
+	bool le(const std::vector<id_t> &left, const std::vector<id_t> &right,
+			id_t h);
+
+	bool le(id_t h, const std::vector<id_t> &left,
+			const std::vector<id_t> &right);
+
+	bool compare(id_t g, const dyadic &x, bool greater,
+				 std::unordered_map<uint64_t, bool> &memo);
+
+	dyadic stop(id_t g, bool left);
+};
+
+}
@@ -0,0 +1,111 @@
+/**
+ * @file frustum.hpp
+ * @author Jonah Chen
+ * @brief the view frustum of the camera, used to cull the edges that can not be
+ * seen before they are sent to the renderer.
+ * @version 1.0
+ * @date 2021-11-22
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace game {
+
+/**
+ * @brief the six planes bounding the volume seen by the camera, extracted from
+ * the product of the projection and view matrices.
+ *
+ * @details every plane is stored as (normal, offset) with the normal pointing
+ * into the frustum and normalized, so dot(normal, p) + offset is the signed
+ * distance of the point p from the plane.
+ */
+struct frustum
+{
+	enum side
+	{
+		left = 0, right, bottom, top, near, far
+	};
+
+	glm::vec4 planes[6];
+
+	/**
+	 * @brief extract the planes of the frustum.
+	 *
+	 * @param view_projection the projection matrix multiplied by the view
+	 * matrix.
+	 */
+	explicit frustum(const glm::mat4 &view_projection)
+	{
+		// rows of the matrix, which is stored column major
+		glm::vec4 row[4];
+		for (int i = 0; i < 4; ++i)
+			row[i] = glm::vec4(view_projection[0][i], view_projection[1][i],
+							   view_projection[2][i], view_projection[3][i]);
+
+		for (int i = 0; i < 3; ++i)
+		{
+			planes[2 * i] = row[3] + row[i];
+			planes[2 * i + 1] = row[3] + row[i] * -1.0f;
+		}
+		for (glm::vec4 &plane: planes)
+			plane = plane * (1.0f / glm::length(glm::vec3(plane)));
+	}
+
+	/**
+	 * @return the signed distance of a point from one of the planes, which is
+	 * positive on the inside.
+	 */
+	inline float distance(int plane, const glm::vec3 &p) const
+	{ return glm::dot(glm::vec3(planes[plane]), p) + planes[plane].w; }
+
+	/**
+	 * @brief check whether a capsule (a segment with a radius) may be seen.
+	 * The test is conservative: a capsule is only rejected when both of its
+	 * ends are outside the same plane.
+	 *
+	 * @param p1 position of one end of the segment.
+	 * @param p2 position of the other end of the segment.
+	 * @param radius radius of the capsule.
+	 * @return true if the capsule may intersect the frustum.
+	 * @return false if the capsule is certainly outside the frustum.
+	 */
+	inline bool intersects(const glm::vec3 &p1, const glm::vec3 &p2,
+						   float radius = 0.0f) const
+	{
+		for (int i = 0; i < 6; ++i)
+			if (distance(i, p1) < -radius and distance(i, p2) < -radius)
+				return false;
+		return true;
+	}
+
+	/**
+	 * @brief check whether an axis aligned box may be seen, by testing the
+	 * corner of the box furthest along the normal of every plane.
+	 *
+	 * @param bottomleft corner of the box with the smallest coordinates.
+	 * @param topright corner of the box with the largest coordinates.
+	 * @return true if the box may intersect the frustum.
+	 * @return false if the box is certainly outside the frustum.
+	 */
+	inline bool intersects_box(const glm::vec3 &bottomleft,
+							   const glm::vec3 &topright) const
+	{
+		for (int i = 0; i < 6; ++i)
+		{
+			const glm::vec3 corner(
+					planes[i].x >= 0.0f ? topright.x : bottomleft.x,
+					planes[i].y >= 0.0f ? topright.y : bottomleft.y,
+					planes[i].z >= 0.0f ? topright.z : bottomleft.z);
+			if (distance(i, corner) < 0.0f)
+				return false;
+		}
+		return true;
+	}
+};
+
+}
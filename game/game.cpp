@@ -2,36 +2,47 @@
 
 hackenbush::~hackenbush()
 {
-	for (auto *n: node_buf)
-		delete n;
-	for (auto *e: edge_buf)
-		delete e;
+	reset();
 }
 
-void hackenbush::load_world(const char *filename, const glm::vec3 &offset)
+void hackenbush::reset()
 {
+	// the arenas free what the chops took off along with everything else
+	journal_.clear();
+	undone_.clear();
+	world_.clear();
+	stack_links_.clear();
+	fallen_.clear();
+	partition_.build(world_);
+
+	edge_buf.reset();
+	stack_buf.reset();
+	node_buf.reset();
+}
+
+bool hackenbush::load_world(const char *filename, const glm::vec3 &offset)
+{
+	commit();
 	if (!filename)
 	{
 		std::cerr << "No filename given...loading default world" << std::endl;
 		load_default();
-		return;
+		return true;
 	}
 
     if (strcmp(filename, "0") == 0)
     {
         std::cout << "Loading empty world" << std::endl;
-        return;
+        return true;
     }
 
 	worldgen::lut_t lut;
 	worldgen::adj_list_t adj_list;
 
-	std::size_t cur_num_nodes = node_buf.size();
+	std::size_t cur_num_nodes = world_.num_nodes();
 
 	if (!worldgen::parse(filename, lut, adj_list))
-		return;
-
-	node_buf.reserve(lut.size());
+		return false;
 
 	for (int32_t node_id = 0; node_id < lut.size(); node_id++)
 	{
@@ -43,34 +54,55 @@ void hackenbush::load_world(const char *filename, const glm::vec3 &offset)
 		if (node_type.ty == worldgen::node_type::stack_root)
 		{
 			auto &front_edge = node_type.conn.front();
-			n = new game::nodes::stack_root(pos + offset, front_edge.vec_kwargs,
-											front_edge.type_gen, front_edge
-													.step_gen,
-											front_edge.kwargs);
+			n = stack_buf.create(pos + offset, front_edge.vec_kwargs,
+								 front_edge.type_gen, front_edge.step_gen,
+								 front_edge.kwargs);
+			world_.add_node(n, game::node_kind::stack_root);
 		}
 		else
-			n = new game::nodes::normal(pos + offset);
-
-		node_buf.push_back(n);
-
-		if (n->get_pos().y == 0.0f)
-			grounded_nodes_.insert(n);
+			world_.add_node(node_buf.create(pos + offset),
+							game::node_kind::normal);
 	}
 
 	for (int32_t n_p1 = 0; n_p1 < adj_list.size(); ++n_p1)
 	{
-		auto *p1 = node_buf[n_p1 + cur_num_nodes];
+		auto *p1 = world_.get_node(n_p1 + cur_num_nodes);
 		for (auto &e: adj_list[n_p1].conn)
 		{
-			auto *p2 = node_buf[e.id + cur_num_nodes];
-			game::edge *_e = game::attach(e.type, p1, p2);
-			if (_e) edge_buf.insert(_e);
+			auto *p2 = world_.get_node(e.id + cur_num_nodes);
+			game::edge *_e = game::attach(e.type, p1, p2, edge_buf);
+			if (_e)
+				world_.add_edge(_e);
 		}
 	}
+
+	link_stacks(cur_num_nodes);
+
+	fallen_.clear();
+	world_.settle(cur_num_nodes, fallen_);
+	drop(fallen_);
+	partition_.build(world_);
+	return true;
+}
+
+void hackenbush::link_stacks(game::world::id_t first)
+{
+	for (game::world::id_t id = first; id < world_.num_nodes(); ++id)
+	{
+		if (world_.get_kind(id) != game::node_kind::stack_root)
+			continue;
+
+		auto *root = static_cast<game::nodes::stack_root *>(
+				world_.get_node(id));
+		game::node *limit = root->get_grandchild();
+		if (limit and limit->get_id() != game::world::npos)
+			stack_links_[id] = world_.add_link(id, limit->get_id());
+	}
 }
 
 void hackenbush::load_default()
 {
+	commit();
 	glm::vec3 v1(8.0f, 0.0f, 0.0f);
 	glm::vec3 v2(8.0f, 1.0f, 0.0f);
 	glm::vec3 v3(8.0f, 2.0f, 0.0f);
@@ -80,22 +112,55 @@ void hackenbush::load_default()
 	fraction[0] = 2;
 	fraction[1] = 3;
 
-	auto *n1 = new game::nodes::normal(v1);
-	auto *n2 = new game::nodes::normal(v2);
-	auto *n3 = new game::nodes::normal(v3);
-	auto *n4 = new game::nodes::stack_root(v4, glm::vec3(0.0f, 3.0f, 0.0f),
-										   FRACTION,
-										   GEOMETRIC, fraction);
+	auto *n1 = node_buf.create(v1);
+	auto *n2 = node_buf.create(v2);
+	auto *n3 = node_buf.create(v3);
+	auto *n4 = stack_buf.create(v4, glm::vec3(0.0f, 3.0f, 0.0f), FRACTION,
+								GEOMETRIC, fraction);
+
+	const game::world::id_t first = world_.num_nodes();
+	world_.add_node(n1, game::node_kind::normal);
+	world_.add_node(n2, game::node_kind::normal);
+	world_.add_node(n3, game::node_kind::normal);
+	world_.add_node(n4, game::node_kind::stack_root);
+
+	world_.add_edge(game::attach(game::green, n1, n2, edge_buf));
+	world_.add_edge(game::attach(game::blue, n2, n3, edge_buf));
+	world_.add_edge(game::attach(game::red, n2, n4, edge_buf));
 
-	grounded_nodes_.insert(n1);
-	node_buf.push_back(n1);
-	node_buf.push_back(n2);
-	node_buf.push_back(n3);
-	node_buf.push_back(n4);
+	link_stacks(first);
 
-	edge_buf.insert(game::attach(game::green, n1, n2));
-	edge_buf.insert(game::attach(game::blue, n2, n3));
-	edge_buf.insert(game::attach(game::red, n2, n4));
+	fallen_.clear();
+	world_.settle(first, fallen_);
+	drop(fallen_);
+	partition_.build(world_);
+}
+
+void hackenbush::drop(const game::world::fallout &fallen)
+{
+	// detach the edges first, as they still refer to the nodes
+	for (game::world::id_t e: fallen.edges)
+		if (game::edge *edge = world_.get_edge(e))
+			game::detach(edge, edge_buf);
+	drop_nodes(fallen);
+}
+
+void hackenbush::drop_nodes(const game::world::fallout &fallen)
+{
+	for (game::world::id_t n: fallen.nodes)
+	{
+		game::node *node = world_.get_node(n);
+		switch (world_.get_kind(n))
+		{
+		case game::node_kind::normal:
+			node_buf.destroy(static_cast<game::nodes::normal *>(node));
+			break;
+		case game::node_kind::stack_root:
+			stack_buf.destroy(static_cast<game::nodes::stack_root *>(node));
+			stack_links_.erase(n);
+			break;
+		}
+	}
 }
 
 void hackenbush::get_visible_edges(game::edge::container &edges,
@@ -103,23 +168,187 @@ void hackenbush::get_visible_edges(game::edge::container &edges,
 								   const glm::vec3 &topright) const
 {
 	edges.clear();
-	game::node::container visible_nodes;
-	for (game::node *g_node: grounded_nodes_)
-		(*g_node)(visible_nodes, bottomleft, topright);
-	for (game::node *n: visible_nodes)
-		n->render(edges);
+	world_.visible(edges, bottomleft, topright);
+}
+
+void hackenbush::get_visible_edges(game::edge::container &edges,
+								   const glm::vec3 &bottomleft,
+								   const glm::vec3 &topright,
+								   const game::frustum &view) const
+{
+	edges.clear();
+	world_.visible(edges, bottomleft, topright, view);
+}
+
+game::evaluation hackenbush::value()
+{
+	return partition_.get_value(world_);
+}
+
+game::solution hackenbush::solve() const
+{
+	return solver_(world_);
+}
+
+void hackenbush::print_value(std::ostream &os)
+{
+	partition_.get_evaluator().print(os, value());
+}
+
+void hackenbush::set_table_size(std::size_t megabytes)
+{
+	table_.resize(megabytes);
+}
+
+void hackenbush::load_tablebase(const char *filename)
+{
+	tablebase_.reset(new game::tablebase(filename));
+	solver_.set_tablebase(tablebase_.get());
+	partition_.set_tablebase(tablebase_.get());
+	partition_.build(world_);
 }
 
 bool hackenbush::chop(game::edge *edge, player player)
 {
-	if ((player == blue_player and edge->type != game::red) or
-		(player == red_player and edge->type != game::blue))
+	if ((player == blue_player and edge->type == game::red) or
+		(player == red_player and edge->type == game::blue))
+		return false;
+	if (edge->id != game::world::npos and !world_.is_alive(edge->id))
+		return false;
+
+	entry m;
+	if (edge->id != game::world::npos)
 	{
-		game::detach(edge);
-		edge_buf.erase(edge);
-		return true;
+		m.edge = edge;
+		m.cut = edge->id;
+	}
+	else
+	{
+		// branches of a stack are not in the world. They are owned by the
+		// stack root, and chopping one cuts the stack root off from the node
+		// at the limit of the stack.
+		auto *lower = static_cast<game::nodes::stack *>(edge->p1);
+		auto *upper = static_cast<game::nodes::stack *>(edge->p2);
+		m.root = lower->get_root()->get_id();
+		m.order = std::max(lower->get_order(), upper->get_order());
+	}
+
+	undone_.clear();
+	journal_.push_back(std::move(m));
+	play(journal_.back());
+	return true;
+}
+
+void hackenbush::play(entry &m)
+{
+	fallen_.clear();
+	m.links.clear();
+	if (m.edge)
+	{
+		world_.cut(m.cut, fallen_);
+		partition_.update(world_, m.cut, &fallen_);
+		game::soft_detach(m.edge);
+	}
+	else
+	{
+		auto *root = static_cast<game::nodes::stack_root *>(
+				world_.get_node(m.root));
+		m.cap = root->get_cap();
+		m.limit = root->get_grandchild();
+		root->detach(m.order);
+		world_.restack(m.root);
+
+		auto link = stack_links_.find(m.root);
+		if (link != stack_links_.end())
+		{
+			m.cut = link->second;
+			stack_links_.erase(link);
+			world_.cut(m.cut, fallen_);
+			partition_.update(world_, m.cut, &fallen_);
+		}
+		else
+		{
+			m.cut = game::world::npos;
+			partition_.restack(world_, m.root);
+		}
+	}
+
+	// what fell is kept, so the chop can be taken back
+	for (game::world::id_t e: fallen_.edges)
+		if (game::edge *edge = world_.get_edge(e))
+			game::soft_detach(edge);
+	for (game::world::id_t n: fallen_.nodes)
+	{
+		auto link = stack_links_.find(n);
+		if (link == stack_links_.end())
+			continue;
+		m.links.push_back(*link);
+		stack_links_.erase(link);
 	}
-	return false;
+	m.fallen = fallen_;
+}
+
+bool hackenbush::unmake()
+{
+	if (journal_.empty())
+		return false;
+	entry &m = journal_.back();
+
+	for (const auto &link: m.links)
+		stack_links_.insert(link);
+	for (auto it = m.fallen.edges.rbegin(); it != m.fallen.edges.rend(); ++it)
+		if (game::edge *edge = world_.get_edge(*it))
+			game::reattach(edge);
+
+	if (m.edge)
+		game::reattach(m.edge);
+	else
+	{
+		static_cast<game::nodes::stack_root *>(world_.get_node(m.root))
+				->restore(m.cap, m.limit);
+		world_.restack(m.root);
+		if (m.cut != game::world::npos)
+			stack_links_[m.root] = m.cut;
+	}
+
+	if (m.cut != game::world::npos)
+	{
+		world_.uncut(m.cut, m.fallen);
+		partition_.restore(world_, m.cut, m.fallen);
+	}
+	else
+		partition_.restack(world_, m.root);
+
+	fallen_.clear();
+	undone_.push_back(std::move(m));
+	journal_.pop_back();
+	return true;
+}
+
+bool hackenbush::remake()
+{
+	if (undone_.empty())
+		return false;
+	journal_.push_back(std::move(undone_.back()));
+	undone_.pop_back();
+	play(journal_.back());
+	return true;
+}
+
+void hackenbush::commit()
+{
+	// the chops taken back hold nothing, as what they took off is back
+	for (const entry &m: journal_)
+	{
+		if (m.edge)
+			edge_buf.destroy(m.edge);
+		for (game::world::id_t e: m.fallen.edges)
+			if (game::edge *edge = world_.get_edge(e))
+				edge_buf.destroy(edge);
+		drop_nodes(m.fallen);
+	}
+	journal_.clear();
+	undone_.clear();
 }
 
 void hackenbush::command_terminal()
@@ -146,7 +375,8 @@ void hackenbush::command_terminal()
 						 "EXIT : exit the terminal and go back to the game\n"
 						 "LOAD [filename] [xoffset] [yoffset] : Load a world from file\n"
                          "RESET : Reset the world to an empty world\n"
-						 "LOGINFO : Print the debug info to the terminal\n"
+						 "LOGINFO : Print the transposition table counters\n"
+						 "VALUE : Print the value of the world and who wins it\n"
 						 "KILL : exit the game\n";
 		else if (command == "LOAD")
 		{
@@ -168,10 +398,26 @@ void hackenbush::command_terminal()
         else if (command == "RESET")
         {
             std::cout << "Resetting world...\n";
-            *this = hackenbush();
+            reset();
         }
 		else if (command == "LOGINFO")
-			std::cout << "Logging info is not implemented\n";
+		{
+			const auto stats = table_.get_stats();
+			std::cout << "Transposition table: " << table_.megabytes()
+					  << " MiB, " << stats.probes << " probes, " << stats.hits
+					  << " hits (" << stats.hit_rate() * 100.0 << "%), "
+					  << stats.stores << " stores, " << stats.collisions
+					  << " collisions, " << stats.rejected << " rejected\n";
+		}
+		else if (command == "VALUE")
+		{
+			std::cout << "Value: ";
+			print_value(std::cout);
+			const game::solution s = solve();
+			std::cout << ", outcome "
+					  << (s.solved ? game::outcome_name(s.result) : "unknown")
+					  << '\n';
+		}
 		else
 			std::cout << "Invalid command.\n"
 						 "Type HELP to see the list of commands\n"; 
@@ -14,14 +14,20 @@
 #pragma once
 
 #include "prereqs.hpp"
-#include "render/buffer.hpp"
 #include <vector>
 #include <list>
 #include <cstring>
-#include "interaction/input.hpp"
+#include <ostream>
 #include "worldgen/parser.hpp"
 #include "nodes.hpp"
 #include "generators.hpp"
+#include "world.hpp"
+#include "value.hpp"
+#include "transposition.hpp"
+#include "solver.hpp"
+#include "partition.hpp"
+#include "tablebase.hpp"
+#include <memory>
 
 enum player
 {
@@ -33,6 +39,10 @@ class hackenbush
 public:
 	hackenbush() = default;
 
+	hackenbush(const hackenbush &) = delete;
+
+	hackenbush &operator=(const hackenbush &) = delete;
+
 	~hackenbush();
 
 	/**
@@ -48,8 +58,11 @@ public:
 	 * @param offset a vec3 describing offset to the coordinates to load the
 	 * branches into the world compared to the coordinates specified in the
 	 * world file.
+	 * @return true if the world file was read, or no file was given.
+	 * @throw worldgen::hackenbush_parsing_exception if a line of the file is
+	 * not formatted correctly.
 	 */
-	void load_world(const char *filename,
+	bool load_world(const char *filename,
 					const glm::vec3 &offset = glm::vec3());
 
 	/**
@@ -60,7 +73,15 @@ public:
 	void load_default();
 
 	/**
-	 * @brief chop a branch off the world.
+	 * @brief Remove every node and edge from the world. The memory of the
+	 * arenas is kept, so loading another world does not allocate again.
+	 *
+	 */
+	void reset();
+
+	/**
+	 * @brief chop a branch off the world. Everything that is no longer held
+	 * up by the ground falls, and is removed from the world immediately.
 	 *
 	 * @param edge a pointer to the edge the player chose to chop.
 	 * @param player the player who chose to chop the edge.
@@ -70,6 +91,59 @@ public:
 	 */
 	bool chop(game::edge *edge, player player);
 
+	/**
+	 * @return true if a player has an edge or a branch of a stack to chop,
+	 * which is looked up without a traversal of the world.
+	 * @return false if the player loses when it is their turn.
+	 */
+	inline bool can_move(player player) const
+	{ return world_.has_move(player == blue_player ? game::blue : game::red); }
+
+	/**
+	 * @brief take back the last chop: the chopped edge and everything that
+	 * fell with it are put back into the world, as the chops only take them
+	 * off and keep them until the next load or reset. The cost is
+	 * proportional to what fell, and the chop can be made again with remake.
+	 *
+	 * @return true if a chop was taken back.
+	 * @return false if no chop was made since the world was loaded.
+	 */
+	bool unmake();
+
+	/**
+	 * @brief make the last chop taken back with unmake again. Chopping after
+	 * unmake forgets the chops that were taken back.
+	 *
+	 * @return true if a chop was made again.
+	 * @return false if there is no chop to make again.
+	 */
+	bool remake();
+
+	/**
+	 * @return std::size_t the number of chops made since the world was loaded,
+	 * not counting the chops taken back.
+	 */
+	inline std::size_t num_chops() const
+	{ return journal_.size(); }
+
+	/**
+	 * @brief Get the nodes and edges that fell because of the last chop, load
+	 * or remake, excluding the chopped edge itself.
+	 *
+	 * @warning the nodes and edges are not in the world any more, and those
+	 * that fell on a load are already freed. Those that fell on a chop are
+	 * kept until the next load or reset, so the chop can be taken back.
+	 */
+	inline const game::world::fallout &get_fallen() const
+	{ return fallen_; }
+
+	/**
+	 * @brief Get the world graph of the game, for queries that are not
+	 * covered by the methods below.
+	 */
+	inline const game::world &get_world() const
+	{ return world_; }
+
 	/**
 	 * @brief Get the visible edges to a player with a viewport specified by the
 	 *  bottom left and top right corners (of a cube) so the edges can be
@@ -84,6 +158,78 @@ public:
 	get_visible_edges(game::edge::container &edges, const glm::vec3 &bottomleft,
 					  const glm::vec3 &topright) const;
 
+	/**
+	 * @brief Same as above, but the edges outside the view frustum of the
+	 * player are culled as well.
+	 *
+	 * @param edges a reference to the container to store the edges.
+	 * @param bottomleft a vec3 describing the bottom left corner of the
+	 * viewport.
+	 * @param topright a vec3 describing the top right corner of the viewport.
+	 * @param view the view frustum of the player.
+	 */
+	void
+	get_visible_edges(game::edge::container &edges, const glm::vec3 &bottomleft,
+					  const glm::vec3 &topright,
+					  const game::frustum &view) const;
+
+	/**
+	 * @brief Evaluate the world: the sum of the exact values of its red-blue
+	 * components, the nim sum of its green components and the canonical form
+	 * of its small mixed components. Positive numbers are a win for the blue
+	 * player, negative numbers for the red player. A zero number is a win for
+	 * the player who moves second if the nimber is also zero, and for the
+	 * player who moves first otherwise. With a form, see
+	 * game::evaluator::outcome_of. The values of the components are kept
+	 * between chops, see game::partition, so this only values the components
+	 * the chops since the last call left pending.
+	 *
+	 * @return game::evaluation the value of the world, and how many components
+	 * could not be valued.
+	 */
+	game::evaluation value();
+
+	/**
+	 * @brief Find who wins the world, searching the components that value()
+	 * can not value, such as those mixing green with red or blue edges.
+	 *
+	 * @return game::solution the outcome class of the world, and the value of
+	 * the components that were valued exactly.
+	 */
+	game::solution solve() const;
+
+	/**
+	 * @brief Print the value of the world given by value(), like 3/4 + ↑*.
+	 * The components that could not be valued are printed as ?.
+	 *
+	 * @param os the stream to print to.
+	 */
+	void print_value(std::ostream &os);
+
+	/**
+	 * @brief Resize the transposition table used to evaluate the world, which
+	 * drops the positions it holds.
+	 *
+	 * @param megabytes the size of the table.
+	 */
+	void set_table_size(std::size_t megabytes);
+
+	/**
+	 * @brief Get the transposition table used to evaluate the world, to read
+	 * its hit rate and collisions.
+	 */
+	inline const game::transposition_table &get_table() const
+	{ return table_; }
+
+	/**
+	 * @brief Map a tablebase written by worldgen/tablebase.cxx, so the small
+	 * components of the world are looked up instead of searched.
+	 *
+	 * @param filename the file of the table.
+	 * @throw std::runtime_error if the file is not a table.
+	 */
+	void load_tablebase(const char *filename);
+
 	/**
 	 * @brief Open a command terminal. This is primarily used for debugging (or
 	 * server-side modifications in the future).
@@ -92,8 +238,75 @@ public:
 	void command_terminal();
 
 private:
-	game::node::container grounded_nodes_;
+	// a chop as it was made, with what it needs to be taken back
+	struct entry
+	{
+		game::edge *edge = nullptr; // nullptr for the branch of a stack
+		game::world::id_t cut = game::world::npos; // the edge or link cut
+		game::world::id_t root = game::world::npos; // the stack root, if any
+		int64_t order = 0; // the order the stack was cut at
+		int64_t cap = 0; // the cap of the stack before the chop
+		game::node *limit = nullptr; // the node at the limit of the stack before
+		game::world::fallout fallen;
+
+		// the links of the stack roots that fell, by their stack roots
+		std::vector<std::pair<game::world::id_t, game::world::id_t>> links;
+	};
+
+	game::world world_;
+	game::world::fallout fallen_;
+	std::unordered_map<game::world::id_t, game::world::id_t> stack_links_;
+
+	// the positions searched are kept between evaluations, so evaluating after
+	// a chop only searches the positions that changed
+	game::transposition_table table_;
+	mutable game::solver solver_{&table_};
 
-	std::vector<game::node *> node_buf;
-	game::edge::container edge_buf;
+	// the components of the world with their values, updated after every chop
+	game::partition partition_{&table_};
+
+	std::unique_ptr<game::tablebase> tablebase_;
+
+	// the chops made since the world was loaded, and the chops taken back
+	// with the last taken back at the end
+	std::vector<entry> journal_, undone_;
+
+	game::arena<game::nodes::normal> node_buf;
+	game::arena<game::nodes::stack_root> stack_buf;
+	game::arena<game::edge> edge_buf;
+
+	/**
+	 * @brief add the links between the stack roots loaded since node id
+	 * `first` and the nodes at the limits of their stacks to the world.
+	 *
+	 * @param first id of the first node to check.
+	 */
+	void link_stacks(game::world::id_t first);
+
+	/**
+	 * @brief free the nodes and edges that fell off the world.
+	 *
+	 * @param fallen the nodes and edges reported by the world.
+	 */
+	void drop(const game::world::fallout &fallen);
+
+	/**
+	 * @brief free the nodes that fell off the world, once their edges are
+	 * freed.
+	 *
+	 * @param fallen the nodes and edges reported by the world.
+	 */
+	void drop_nodes(const game::world::fallout &fallen);
+
+	/**
+	 * @brief cut what a chop cuts, and record what fell in the entry. The
+	 * edges are only detached from their nodes, and the nodes kept.
+	 */
+	void play(entry &m);
+
+	/**
+	 * @brief free what the chops of the journal took off, after which they
+	 * can not be taken back.
+	 */
+	void commit();
 };
\ No newline at end of file
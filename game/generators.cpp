@@ -11,6 +11,9 @@
  */
 
 #include "nodes.hpp"
+#include <bit>
+#include <cstdlib>
+#include <numeric>
 
 static inline glm::vec3 operator*(const glm::vec3 &v, float m)
 {
@@ -90,6 +93,9 @@ branch_type green(const int64_t order, void *kwargs)
 branch_type blue(const int64_t order, void *kwargs)
 { return game::blue; }
 
+// guards the LUT of fractions, which stacks may fill from several threads
+static std::mutex fraction_mutex;
+
 static branch_type fraction(const int64_t order, void *kwargs, branch_type one,
 							branch_type zero)
 {
@@ -109,75 +115,107 @@ static branch_type fraction(const int64_t order, void *kwargs, branch_type one,
 		numerator = -numerator;
 	}
 
-	uint32_t integral_part = numerator / denominator;
-
-	int64_t fractional_order = order - integral_part;
-	if (fractional_order < 0)
+	// Berlekamp's rule: an integral part of n is n + 1 branches of the colour
+	// of the sign followed by one of the other colour. After that, every bit of
+	// the fractional part is a branch, of the colour of the sign for a 1.
+	const int64_t integral_part = numerator / denominator;
+	if (order <= integral_part)
 		return one;
-
-	uint32_t fractional_part = numerator % denominator;
-	auto frac = std::make_pair(fractional_part, denominator);
+	if (order == integral_part + 1)
+		return zero;
+
+	int32_t fractional_part = numerator % denominator;
+	const int32_t common = std::gcd(fractional_part, denominator);
+	fractional_part /= common;
+	denominator /= common;
+
+	// the bits repeat after as many bits as there are factors of 2 in the
+	// denominator, so the LUT keeps the bits before the repetition followed by
+	// one period
+	const std::size_t leading = std::countr_zero((uint32_t) denominator);
+	const int64_t bit = order - integral_part - 2;
+
+	std::lock_guard<std::mutex> lock(fraction_mutex);
+	const auto frac = std::make_pair(fractional_part, denominator);
 	auto it = stack_root::fraction_lut.find(frac);
 
 	// if it is not in the LUT, compute it and insert it
-	if (it != stack_root::fraction_lut.end())
-	{
-		auto &bits = it->second;
-		return bits[fractional_order % bits.size()] ? one : zero;
-	}
-	else
+	if (it == stack_root::fraction_lut.end())
 	{
-		std::size_t num_zeros = 0;
-		while (fractional_part < denominator)
+		std::vector<bool> bits;
+		int64_t remainder = fractional_part;
+		const auto next = [&]()
 		{
-			fractional_part <<= 1;
-			num_zeros++;
-		}
-
-		std::vector<bool> bits(num_zeros);
-		while (true)
-		{
-			fractional_part <<= 1;
-			bits.push_back(fractional_part >= denominator);
-			fractional_part %= denominator;
-			const std::size_t length = bits.size() - num_zeros;
-			if (!(length & 1))
-			{
-				auto beginning = bits.begin() + num_zeros;
-				auto half_way = beginning + length / 2;
-				if (std::equal(beginning, half_way, half_way))
-				{
-					bits.erase(half_way, bits.end());
-					break;
-				}
-			}
-		}
-		// add bits to lut
-		stack_root::fraction_lut[frac] = bits;
-		return bits[fractional_order % bits.size()] ? one : zero;
+			remainder <<= 1;
+			bits.push_back(remainder >= denominator);
+			remainder %= denominator;
+		};
+		for (std::size_t i = 0; i < leading; ++i)
+			next();
+		const int64_t start = remainder;
+		do
+			next();
+		while (remainder != start);
+		it = stack_root::fraction_lut.emplace(frac, std::move(bits)).first;
 	}
+
+	const std::vector<bool> &bits = it->second;
+	if (bit < (int64_t) leading)
+		return bits[bit] ? one : zero;
+	return bits[leading + (bit - leading) % (bits.size() - leading)] ? one :
+		   zero;
 }
+
 /**
- * @brief
+ * @brief the branches of a stack worth the fraction numerator / denominator.
+ * Positive fractions start with blue branches, which count as positive.
  *
  * @pre Numerator and denominator must be nonzero.
  * @pre denominator must be positive, and not a power of 2.
  *
- * @param order
- * @param kwargs
- * @return
+ * @param order the order of the branch.
+ * @param kwargs the numerator and the denominator.
+ * @return branch_type the colour of the branch.
  */
 // kwargs is 2 int32_t's. Meaning it must be 8 bytes.
 branch_type fraction(const int64_t order, void *kwargs)
 {
 	if (kwargs)
-		return fraction(order, kwargs, game::red, game::blue);
+		return fraction(order, kwargs, game::blue, game::red);
 	throw std::runtime_error(
 			"Fractional generator requires two int32_t's as kwargs");
 }
 
 }
 
+// branches looked at for a generator whose colours are not known in advance
+static constexpr int64_t FIRST_SCAN = 1024;
+
+int64_t first(type_gen tgen, void *kwargs, branch_type type)
+{
+	if (tgen == (type_gen) F::red or tgen == (type_gen) F::green or
+		tgen == (type_gen) F::blue)
+		return tgen(0, kwargs) == type ? 0 : NOT_FOUND;
+
+	if (tgen == (type_gen) F::fraction and kwargs)
+	{
+		const int64_t numerator = ((int32_t *) kwargs)[0];
+		const int64_t denominator = ((int32_t *) kwargs)[1];
+		const branch_type sign = numerator < 0 ? game::red : game::blue;
+		if (type == game::green)
+			return NOT_FOUND;
+		if (type == sign)
+			return 0;
+		return std::abs(numerator) / denominator + 1;
+	}
+
+	// any other generator is looked at branch by branch
+	for (int64_t order = 0; order < FIRST_SCAN; ++order)
+		if (tgen(order, kwargs) == type)
+			return order;
+	return NOT_FOUND;
+}
+
 
 glm::vec3 f::geometric(const int64_t order, const glm::vec3 &rootpos,
 					   const glm::vec3 &kwargs)
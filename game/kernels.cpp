@@ -0,0 +1,570 @@
+/**
+ * @file kernels.cpp
+ * @author Jonah Chen
+ * @brief implement the batch kernels specified in kernels.hpp. Every kernel has
+ * a scalar version, and on x86 an SSE (4 lanes) and an AVX2 (8 lanes) version,
+ * which are compiled for their instruction set with target attributes and only
+ * called when the processor supports it.
+ * @version 1.0
+ * @date 2021-11-24
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include "kernels.hpp"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define KERNELS_X86
+#include <immintrin.h>
+#define TARGET_SSE __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace game::kernels {
+
+///////////////////////////////////////////////////////////////////////////////
+// Scalar versions, which define the results of the kernels
+///////////////////////////////////////////////////////////////////////////////
+
+namespace scalar {
+
+static std::size_t contained(const float *xs, const float *ys, const float *zs,
+							 std::size_t begin, std::size_t n,
+							 const glm::vec3 &bl, const glm::vec3 &tr,
+							 uint32_t *hits)
+{
+	std::size_t count = 0;
+	for (std::size_t i = begin; i < n; ++i)
+		if (xs[i] >= bl.x and xs[i] <= tr.x and ys[i] >= bl.y and
+			ys[i] <= tr.y and zs[i] >= bl.z and zs[i] <= tr.z)
+			hits[count++] = i;
+	return count;
+}
+
+// same arithmetic as the vector versions, one edge at a time
+static void edge_prisms(const segments &e, std::size_t begin, std::size_t n,
+						float width, float *out)
+{
+	for (std::size_t i = begin; i < n; ++i)
+	{
+		const float dx = e.x2[i] - e.x1[i];
+		const float dy = e.y2[i] - e.y1[i];
+		const float dz = e.z2[i] - e.z1[i];
+
+		// cross product with (0,0,1), or with (1,0,0) if that is parallel
+		const bool use_z = dx != 0.0f and dy != 0.0f;
+		float ax = use_z ? -dy : 0.0f;
+		float ay = use_z ? dx : -dz;
+		float az = use_z ? 0.0f : dy;
+		const float inv_a = 1.0f / std::sqrt(ax * ax + ay * ay + az * az);
+		ax *= inv_a;
+		ay *= inv_a;
+		az *= inv_a;
+
+		float bx = ay * dz - az * dy;
+		float by = az * dx - ax * dz;
+		float bz = ax * dy - ay * dx;
+		const float inv_b = 1.0f / std::sqrt(bx * bx + by * by + bz * bz);
+		bx = bx * inv_b * width;
+		by = by * inv_b * width;
+		bz = bz * inv_b * width;
+		ax *= width;
+		ay *= width;
+		az *= width;
+
+		const float hx = ax * 0.5f + bx * 0.5f;
+		const float hy = ay * 0.5f + by * 0.5f;
+		const float hz = az * 0.5f + bz * 0.5f;
+
+		const float ends[2][3] = {{e.x1[i] - hx, e.y1[i] - hy, e.z1[i] - hz},
+								  {e.x2[i] - hx, e.y2[i] - hy, e.z2[i] - hz}};
+		float *v = out + 24 * i;
+		for (const auto &p: ends)
+		{
+			*v++ = p[0];
+			*v++ = p[1];
+			*v++ = p[2];
+			*v++ = p[0] + ax;
+			*v++ = p[1] + ay;
+			*v++ = p[2] + az;
+			*v++ = p[0] + bx;
+			*v++ = p[1] + by;
+			*v++ = p[2] + bz;
+			*v++ = p[0] + ax + bx;
+			*v++ = p[1] + ay + by;
+			*v++ = p[2] + az + bz;
+		}
+	}
+}
+
+static void node_cubes(const float *xs, const float *ys, const float *zs,
+					   std::size_t begin, std::size_t n, float width,
+					   float *out)
+{
+	for (std::size_t i = begin; i < n; ++i)
+	{
+		const float x = xs[i] - width / 2.0f;
+		const float y = ys[i] - width / 2.0f;
+		const float z = zs[i] - width / 2.0f;
+		float *v = out + 24 * i;
+		for (uint8_t corner = 0b000; corner <= 0b111; ++corner)
+		{
+			*v++ = corner & 0b001 ? x + width : x;
+			*v++ = corner & 0b010 ? y + width : y;
+			*v++ = corner & 0b100 ? z + width : z;
+		}
+	}
+}
+
+}
+
+#ifdef KERNELS_X86
+
+/*
+ * The vector versions compute the 24 coordinates of the corners of a block of
+ * edges or nodes as 24 vectors, one lane per edge or node, in the order they
+ * are written out. Transposing them in registers turns them into 24 floats per
+ * lane, which are stored contiguously.
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+// SSE versions, 4 positions at a time
+///////////////////////////////////////////////////////////////////////////////
+
+namespace sse {
+
+TARGET_SSE
+static inline void store_corners(__m128 (&c)[24], float *out)
+{
+	for (int group = 0; group < 24; group += 4)
+		_MM_TRANSPOSE4_PS(c[group], c[group + 1], c[group + 2], c[group + 3]);
+	for (int lane = 0; lane < 4; ++lane)
+		for (int group = 0; group < 6; ++group)
+			_mm_storeu_ps(out + 24 * lane + 4 * group, c[4 * group + lane]);
+}
+
+// the corners of the boxes spanned by a and a + b1 + b2, in the vertex order
+TARGET_SSE
+static inline void corners(const __m128 (&a)[3], const __m128 (&b1)[3],
+						   const __m128 (&b2)[3], __m128 *c)
+{
+	for (int k = 0; k < 3; ++k)
+	{
+		c[k] = a[k];
+		c[3 + k] = _mm_add_ps(a[k], b1[k]);
+		c[6 + k] = _mm_add_ps(a[k], b2[k]);
+		c[9 + k] = _mm_add_ps(_mm_add_ps(a[k], b1[k]), b2[k]);
+	}
+}
+
+TARGET_SSE
+static std::size_t contained(const float *xs, const float *ys, const float *zs,
+							 std::size_t n, const glm::vec3 &bl,
+							 const glm::vec3 &tr, uint32_t *hits)
+{
+	const __m128 blx = _mm_set1_ps(bl.x), bly = _mm_set1_ps(bl.y);
+	const __m128 blz = _mm_set1_ps(bl.z), trx = _mm_set1_ps(tr.x);
+	const __m128 try_ = _mm_set1_ps(tr.y), trz = _mm_set1_ps(tr.z);
+
+	std::size_t count = 0, i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		const __m128 x = _mm_loadu_ps(xs + i);
+		const __m128 y = _mm_loadu_ps(ys + i);
+		const __m128 z = _mm_loadu_ps(zs + i);
+		__m128 in = _mm_and_ps(_mm_cmpge_ps(x, blx), _mm_cmple_ps(x, trx));
+		in = _mm_and_ps(in, _mm_and_ps(_mm_cmpge_ps(y, bly),
+									   _mm_cmple_ps(y, try_)));
+		in = _mm_and_ps(in, _mm_and_ps(_mm_cmpge_ps(z, blz),
+									   _mm_cmple_ps(z, trz)));
+		for (int mask = _mm_movemask_ps(in); mask; mask &= mask - 1)
+			hits[count++] = i + __builtin_ctz(mask);
+	}
+	return count + scalar::contained(xs, ys, zs, i, n, bl, tr, hits + count);
+}
+
+TARGET_SSE
+static void edge_prisms(const segments &e, std::size_t n, float width,
+						float *out)
+{
+	const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+	const __m128 half = _mm_set1_ps(0.5f), w = _mm_set1_ps(width);
+
+	std::size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		const __m128 x1 = _mm_loadu_ps(e.x1 + i), x2 = _mm_loadu_ps(e.x2 + i);
+		const __m128 y1 = _mm_loadu_ps(e.y1 + i), y2 = _mm_loadu_ps(e.y2 + i);
+		const __m128 z1 = _mm_loadu_ps(e.z1 + i), z2 = _mm_loadu_ps(e.z2 + i);
+		const __m128 dx = _mm_sub_ps(x2, x1);
+		const __m128 dy = _mm_sub_ps(y2, y1);
+		const __m128 dz = _mm_sub_ps(z2, z1);
+
+		const __m128 use_z = _mm_and_ps(_mm_cmpneq_ps(dx, zero),
+										_mm_cmpneq_ps(dy, zero));
+		__m128 ax = _mm_blendv_ps(zero, _mm_sub_ps(zero, dy), use_z);
+		__m128 ay = _mm_blendv_ps(_mm_sub_ps(zero, dz), dx, use_z);
+		__m128 az = _mm_blendv_ps(dy, zero, use_z);
+		__m128 inv = _mm_div_ps(one, _mm_sqrt_ps(_mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(ax, ax), _mm_mul_ps(ay, ay)),
+				_mm_mul_ps(az, az))));
+		ax = _mm_mul_ps(ax, inv);
+		ay = _mm_mul_ps(ay, inv);
+		az = _mm_mul_ps(az, inv);
+
+		__m128 bx = _mm_sub_ps(_mm_mul_ps(ay, dz), _mm_mul_ps(az, dy));
+		__m128 by = _mm_sub_ps(_mm_mul_ps(az, dx), _mm_mul_ps(ax, dz));
+		__m128 bz = _mm_sub_ps(_mm_mul_ps(ax, dy), _mm_mul_ps(ay, dx));
+		inv = _mm_div_ps(one, _mm_sqrt_ps(_mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(bx, bx), _mm_mul_ps(by, by)),
+				_mm_mul_ps(bz, bz))));
+		const __m128 b[3] = {_mm_mul_ps(_mm_mul_ps(bx, inv), w),
+							 _mm_mul_ps(_mm_mul_ps(by, inv), w),
+							 _mm_mul_ps(_mm_mul_ps(bz, inv), w)};
+		const __m128 a[3] = {_mm_mul_ps(ax, w), _mm_mul_ps(ay, w),
+							 _mm_mul_ps(az, w)};
+
+		const __m128 h[3] = {
+				_mm_add_ps(_mm_mul_ps(a[0], half), _mm_mul_ps(b[0], half)),
+				_mm_add_ps(_mm_mul_ps(a[1], half), _mm_mul_ps(b[1], half)),
+				_mm_add_ps(_mm_mul_ps(a[2], half), _mm_mul_ps(b[2], half))};
+		const __m128 p1[3] = {_mm_sub_ps(x1, h[0]), _mm_sub_ps(y1, h[1]),
+							  _mm_sub_ps(z1, h[2])};
+		const __m128 p2[3] = {_mm_sub_ps(x2, h[0]), _mm_sub_ps(y2, h[1]),
+							  _mm_sub_ps(z2, h[2])};
+
+		__m128 c[24];
+		corners(p1, a, b, c);
+		corners(p2, a, b, c + 12);
+		store_corners(c, out + 24 * i);
+	}
+	scalar::edge_prisms(e, i, n, width, out);
+}
+
+TARGET_SSE
+static void node_cubes(const float *xs, const float *ys, const float *zs,
+					   std::size_t n, float width, float *out)
+{
+	const __m128 half = _mm_set1_ps(width / 2.0f), w = _mm_set1_ps(width);
+
+	std::size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		const __m128 low[3] = {_mm_sub_ps(_mm_loadu_ps(xs + i), half),
+							   _mm_sub_ps(_mm_loadu_ps(ys + i), half),
+							   _mm_sub_ps(_mm_loadu_ps(zs + i), half)};
+		const __m128 high[3] = {_mm_add_ps(low[0], w), _mm_add_ps(low[1], w),
+								_mm_add_ps(low[2], w)};
+
+		// the bits of the corner select the low or high coordinate
+		__m128 c[24];
+		for (int corner = 0; corner < 8; ++corner)
+		{
+			c[3 * corner] = corner & 0b001 ? high[0] : low[0];
+			c[3 * corner + 1] = corner & 0b010 ? high[1] : low[1];
+			c[3 * corner + 2] = corner & 0b100 ? high[2] : low[2];
+		}
+		store_corners(c, out + 24 * i);
+	}
+	scalar::node_cubes(xs, ys, zs, i, n, width, out);
+}
+
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// AVX2 versions, 8 positions at a time
+///////////////////////////////////////////////////////////////////////////////
+
+namespace avx2 {
+
+TARGET_AVX2
+static inline void transpose8(__m256 *r)
+{
+	const __m256 t0 = _mm256_unpacklo_ps(r[0], r[1]);
+	const __m256 t1 = _mm256_unpackhi_ps(r[0], r[1]);
+	const __m256 t2 = _mm256_unpacklo_ps(r[2], r[3]);
+	const __m256 t3 = _mm256_unpackhi_ps(r[2], r[3]);
+	const __m256 t4 = _mm256_unpacklo_ps(r[4], r[5]);
+	const __m256 t5 = _mm256_unpackhi_ps(r[4], r[5]);
+	const __m256 t6 = _mm256_unpacklo_ps(r[6], r[7]);
+	const __m256 t7 = _mm256_unpackhi_ps(r[6], r[7]);
+	const __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+	const __m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+	const __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+	const __m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+	const __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+	const __m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+	const __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+	const __m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+	r[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+	r[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+	r[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+	r[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+	r[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+	r[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+	r[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+	r[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+}
+
+TARGET_AVX2
+static inline void store_corners(__m256 (&c)[24], float *out)
+{
+	transpose8(c);
+	transpose8(c + 8);
+	transpose8(c + 16);
+	for (int lane = 0; lane < 8; ++lane)
+		for (int group = 0; group < 3; ++group)
+			_mm256_storeu_ps(out + 24 * lane + 8 * group, c[8 * group + lane]);
+}
+
+// the corners of the boxes spanned by a and a + b1 + b2, in the vertex order
+TARGET_AVX2
+static inline void corners(const __m256 (&a)[3], const __m256 (&b1)[3],
+						   const __m256 (&b2)[3], __m256 *c)
+{
+	for (int k = 0; k < 3; ++k)
+	{
+		c[k] = a[k];
+		c[3 + k] = _mm256_add_ps(a[k], b1[k]);
+		c[6 + k] = _mm256_add_ps(a[k], b2[k]);
+		c[9 + k] = _mm256_add_ps(_mm256_add_ps(a[k], b1[k]), b2[k]);
+	}
+}
+
+TARGET_AVX2
+static std::size_t contained(const float *xs, const float *ys, const float *zs,
+							 std::size_t n, const glm::vec3 &bl,
+							 const glm::vec3 &tr, uint32_t *hits)
+{
+	const __m256 blx = _mm256_set1_ps(bl.x), bly = _mm256_set1_ps(bl.y);
+	const __m256 blz = _mm256_set1_ps(bl.z), trx = _mm256_set1_ps(tr.x);
+	const __m256 try_ = _mm256_set1_ps(tr.y), trz = _mm256_set1_ps(tr.z);
+
+	std::size_t count = 0, i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		const __m256 x = _mm256_loadu_ps(xs + i);
+		const __m256 y = _mm256_loadu_ps(ys + i);
+		const __m256 z = _mm256_loadu_ps(zs + i);
+		__m256 in = _mm256_and_ps(_mm256_cmp_ps(x, blx, _CMP_GE_OQ),
+								  _mm256_cmp_ps(x, trx, _CMP_LE_OQ));
+		in = _mm256_and_ps(in, _mm256_and_ps(
+				_mm256_cmp_ps(y, bly, _CMP_GE_OQ),
+				_mm256_cmp_ps(y, try_, _CMP_LE_OQ)));
+		in = _mm256_and_ps(in, _mm256_and_ps(
+				_mm256_cmp_ps(z, blz, _CMP_GE_OQ),
+				_mm256_cmp_ps(z, trz, _CMP_LE_OQ)));
+		for (int mask = _mm256_movemask_ps(in); mask; mask &= mask - 1)
+			hits[count++] = i + __builtin_ctz(mask);
+	}
+	return count + scalar::contained(xs, ys, zs, i, n, bl, tr, hits + count);
+}
+
+TARGET_AVX2
+static void edge_prisms(const segments &e, std::size_t n, float width,
+						float *out)
+{
+	const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+	const __m256 half = _mm256_set1_ps(0.5f), w = _mm256_set1_ps(width);
+
+	std::size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		const __m256 x1 = _mm256_loadu_ps(e.x1 + i);
+		const __m256 y1 = _mm256_loadu_ps(e.y1 + i);
+		const __m256 z1 = _mm256_loadu_ps(e.z1 + i);
+		const __m256 x2 = _mm256_loadu_ps(e.x2 + i);
+		const __m256 y2 = _mm256_loadu_ps(e.y2 + i);
+		const __m256 z2 = _mm256_loadu_ps(e.z2 + i);
+		const __m256 dx = _mm256_sub_ps(x2, x1);
+		const __m256 dy = _mm256_sub_ps(y2, y1);
+		const __m256 dz = _mm256_sub_ps(z2, z1);
+
+		const __m256 use_z = _mm256_and_ps(
+				_mm256_cmp_ps(dx, zero, _CMP_NEQ_UQ),
+				_mm256_cmp_ps(dy, zero, _CMP_NEQ_UQ));
+		__m256 ax = _mm256_blendv_ps(zero, _mm256_sub_ps(zero, dy), use_z);
+		__m256 ay = _mm256_blendv_ps(_mm256_sub_ps(zero, dz), dx, use_z);
+		__m256 az = _mm256_blendv_ps(dy, zero, use_z);
+		__m256 inv = _mm256_div_ps(one, _mm256_sqrt_ps(_mm256_add_ps(
+				_mm256_add_ps(_mm256_mul_ps(ax, ax), _mm256_mul_ps(ay, ay)),
+				_mm256_mul_ps(az, az))));
+		ax = _mm256_mul_ps(ax, inv);
+		ay = _mm256_mul_ps(ay, inv);
+		az = _mm256_mul_ps(az, inv);
+
+		__m256 bx = _mm256_sub_ps(_mm256_mul_ps(ay, dz), _mm256_mul_ps(az, dy));
+		__m256 by = _mm256_sub_ps(_mm256_mul_ps(az, dx), _mm256_mul_ps(ax, dz));
+		__m256 bz = _mm256_sub_ps(_mm256_mul_ps(ax, dy), _mm256_mul_ps(ay, dx));
+		inv = _mm256_div_ps(one, _mm256_sqrt_ps(_mm256_add_ps(
+				_mm256_add_ps(_mm256_mul_ps(bx, bx), _mm256_mul_ps(by, by)),
+				_mm256_mul_ps(bz, bz))));
+		const __m256 b[3] = {_mm256_mul_ps(_mm256_mul_ps(bx, inv), w),
+							 _mm256_mul_ps(_mm256_mul_ps(by, inv), w),
+							 _mm256_mul_ps(_mm256_mul_ps(bz, inv), w)};
+		const __m256 a[3] = {_mm256_mul_ps(ax, w), _mm256_mul_ps(ay, w),
+							 _mm256_mul_ps(az, w)};
+
+		const __m256 h[3] = {
+				_mm256_add_ps(_mm256_mul_ps(a[0], half),
+							  _mm256_mul_ps(b[0], half)),
+				_mm256_add_ps(_mm256_mul_ps(a[1], half),
+							  _mm256_mul_ps(b[1], half)),
+				_mm256_add_ps(_mm256_mul_ps(a[2], half),
+							  _mm256_mul_ps(b[2], half))};
+		const __m256 p1[3] = {_mm256_sub_ps(x1, h[0]), _mm256_sub_ps(y1, h[1]),
+							  _mm256_sub_ps(z1, h[2])};
+		const __m256 p2[3] = {_mm256_sub_ps(x2, h[0]), _mm256_sub_ps(y2, h[1]),
+							  _mm256_sub_ps(z2, h[2])};
+
+		__m256 c[24];
+		corners(p1, a, b, c);
+		corners(p2, a, b, c + 12);
+		store_corners(c, out + 24 * i);
+	}
+	scalar::edge_prisms(e, i, n, width, out);
+}
+
+TARGET_AVX2
+static void node_cubes(const float *xs, const float *ys, const float *zs,
+					   std::size_t n, float width, float *out)
+{
+	const __m256 half = _mm256_set1_ps(width / 2.0f);
+	const __m256 w = _mm256_set1_ps(width);
+
+	std::size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		const __m256 low[3] = {_mm256_sub_ps(_mm256_loadu_ps(xs + i), half),
+							   _mm256_sub_ps(_mm256_loadu_ps(ys + i), half),
+							   _mm256_sub_ps(_mm256_loadu_ps(zs + i), half)};
+		const __m256 high[3] = {_mm256_add_ps(low[0], w),
+								_mm256_add_ps(low[1], w),
+								_mm256_add_ps(low[2], w)};
+
+		// the bits of the corner select the low or high coordinate
+		__m256 c[24];
+		for (int corner = 0; corner < 8; ++corner)
+		{
+			c[3 * corner] = corner & 0b001 ? high[0] : low[0];
+			c[3 * corner + 1] = corner & 0b010 ? high[1] : low[1];
+			c[3 * corner + 2] = corner & 0b100 ? high[2] : low[2];
+		}
+		store_corners(c, out + 24 * i);
+	}
+	scalar::node_cubes(xs, ys, zs, i, n, width, out);
+}
+
+}
+
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// Dispatch
+///////////////////////////////////////////////////////////////////////////////
+
+static isa detect()
+{
+#ifdef KERNELS_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return isa::avx2;
+	if (__builtin_cpu_supports("sse4.1"))
+		return isa::sse;
+#endif
+	return isa::scalar;
+}
+
+isa best()
+{
+	static const isa set = detect();
+	return set;
+}
+
+bool supported(isa set)
+{
+	return set <= best();
+}
+
+const char *name(isa set)
+{
+	switch (set)
+	{
+	case isa::scalar: return "scalar";
+	case isa::sse: return "sse4.1";
+	case isa::avx2: return "avx2";
+	default: return "unknown";
+	}
+}
+
+std::size_t contained(const float *xs, const float *ys, const float *zs,
+					  std::size_t n, const glm::vec3 &bottomleft,
+					  const glm::vec3 &topright, uint32_t *hits)
+{
+	return contained(best(), xs, ys, zs, n, bottomleft, topright, hits);
+}
+
+// an instruction set that is not supported falls back to the best one
+std::size_t contained(isa set, const float *xs, const float *ys,
+					  const float *zs, std::size_t n,
+					  const glm::vec3 &bottomleft, const glm::vec3 &topright,
+					  uint32_t *hits)
+{
+	switch (std::min(set, best()))
+	{
+#ifdef KERNELS_X86
+	case isa::avx2:
+		return avx2::contained(xs, ys, zs, n, bottomleft, topright, hits);
+	case isa::sse:
+		return sse::contained(xs, ys, zs, n, bottomleft, topright, hits);
+#endif
+	default:
+		return scalar::contained(xs, ys, zs, 0, n, bottomleft, topright, hits);
+	}
+}
+
+void edge_prisms(const segments &ends, std::size_t n, float width, float *out)
+{
+	edge_prisms(best(), ends, n, width, out);
+}
+
+void edge_prisms(isa set, const segments &ends, std::size_t n, float width,
+				 float *out)
+{
+	switch (std::min(set, best()))
+	{
+#ifdef KERNELS_X86
+	case isa::avx2: avx2::edge_prisms(ends, n, width, out);
+		break;
+	case isa::sse: sse::edge_prisms(ends, n, width, out);
+		break;
+#endif
+	default: scalar::edge_prisms(ends, 0, n, width, out);
+	}
+}
+
+void node_cubes(const float *xs, const float *ys, const float *zs,
+				std::size_t n, float width, float *out)
+{
+	node_cubes(best(), xs, ys, zs, n, width, out);
+}
+
+void node_cubes(isa set, const float *xs, const float *ys, const float *zs,
+				std::size_t n, float width, float *out)
+{
+	switch (std::min(set, best()))
+	{
+#ifdef KERNELS_X86
+	case isa::avx2: avx2::node_cubes(xs, ys, zs, n, width, out);
+		break;
+	case isa::sse: sse::node_cubes(xs, ys, zs, n, width, out);
+		break;
+#endif
+	default: scalar::node_cubes(xs, ys, zs, 0, n, width, out);
+	}
+}
+
+}
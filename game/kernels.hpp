@@ -0,0 +1,116 @@
+/**
+ * @file kernels.hpp
+ * @author Jonah Chen
+ * @brief batch kernels for the per element hot loops of the game: testing
+ * which positions are inside a volume, and building the vertices of the edge
+ * prisms and node cubes that are rendered. Positions are passed as structure
+ * of arrays and processed in blocks with SSE or AVX2 when the processor
+ * supports them, with a scalar fallback otherwise.
+ * @version 1.0
+ * @date 2021-11-24
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+namespace game::kernels {
+
+/**
+ * @brief the instruction sets the kernels are implemented with, from the
+ * narrowest to the widest.
+ */
+enum class isa : uint8_t
+{
+	scalar = 0,
+	sse,
+	avx2
+};
+
+/**
+ * @return isa the widest instruction set supported by the processor. It is
+ * detected once, and used by the functions below that do not take an isa.
+ */
+isa best();
+
+/**
+ * @return true if the processor supports the instruction set.
+ */
+bool supported(isa set);
+
+/**
+ * @return const char* the name of the instruction set.
+ */
+const char *name(isa set);
+
+/**
+ * @brief find the positions contained in the volume specified by two
+ * diagonally opposite corners. Same as testing every position with the IN
+ * macro.
+ *
+ * @param xs x coordinates of the positions.
+ * @param ys y coordinates of the positions.
+ * @param zs z coordinates of the positions.
+ * @param n number of positions.
+ * @param bottomleft corner of the volume with the smallest coordinates.
+ * @param topright corner of the volume with the largest coordinates.
+ * @param hits array of at least n entries, where the indices of the contained
+ * positions are written in increasing order.
+ * @return std::size_t the number of contained positions.
+ */
+std::size_t contained(const float *xs, const float *ys, const float *zs,
+					  std::size_t n, const glm::vec3 &bottomleft,
+					  const glm::vec3 &topright, uint32_t *hits);
+
+std::size_t contained(isa set, const float *xs, const float *ys,
+					  const float *zs, std::size_t n,
+					  const glm::vec3 &bottomleft, const glm::vec3 &topright,
+					  uint32_t *hits);
+
+/**
+ * @brief the end points of a batch of edges, as structure of arrays.
+ */
+struct segments
+{
+	const float *x1, *y1, *z1;
+	const float *x2, *y2, *z2;
+};
+
+/**
+ * @brief build the 8 corners of the square prism drawn for every edge, in the
+ * vertex layout of render::geometry::edges. The sides of the prism are
+ * `width` long and orthogonal to the edge.
+ *
+ * @param ends the end points of the edges.
+ * @param n number of edges.
+ * @param width the width of the prisms.
+ * @param out array of 24 * n floats for the corners.
+ */
+void edge_prisms(const segments &ends, std::size_t n, float width, float *out);
+
+void edge_prisms(isa set, const segments &ends, std::size_t n, float width,
+				 float *out);
+
+/**
+ * @brief build the 8 corners of the cube drawn for every node, in the vertex
+ * layout of render::geometry::nodes. The cubes are centred on the nodes.
+ *
+ * @param xs x coordinates of the nodes.
+ * @param ys y coordinates of the nodes.
+ * @param zs z coordinates of the nodes.
+ * @param n number of nodes.
+ * @param width the width of the cubes.
+ * @param out array of 24 * n floats for the corners.
+ */
+void node_cubes(const float *xs, const float *ys, const float *zs,
+				std::size_t n, float width, float *out);
+
+void node_cubes(isa set, const float *xs, const float *ys, const float *zs,
+				std::size_t n, float width, float *out);
+
+}
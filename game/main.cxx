@@ -21,6 +21,14 @@
 #include "render/camera.hpp"
 #include "render/geometry.hpp"
 #include "game/game.hpp"
+#include "game/opponent.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
 
 /**
  * @brief Initialize the current OpenGL context and GLFW window for the game.
@@ -43,6 +51,51 @@ static int init(GLFWwindow **window);
  */
 static int parse_args(int argc, char **argv, player &player);
 
+/**
+ * @brief read a whole argument as a count, without throwing on anything the
+ * user may type.
+ *
+ * @param arg the argument.
+ * @param max the largest count accepted.
+ * @param count set to the count if the argument is one.
+ * @return true if the argument is a count of at most max.
+ */
+static bool parse_count(const char *arg, unsigned long long max,
+						unsigned long long &count);
+
+/**
+ * @brief find the size of the transposition table given by `--tt [MiB]`, and
+ * remove the flag from the arguments so parse_args does not see it.
+ *
+ * @param argc reference to the number of arguments, which is updated.
+ * @param argv the array of arguments c-strings, which is updated.
+ * @return the size of the table in megabytes, or the default size if the flag
+ * is not given. Exits with a message if the size is not a count.
+ */
+static std::size_t parse_table_size(int &argc, char **argv);
+
+/**
+ * @brief find the time the computer may think about a move given by
+ * `--ai [ms]`, and remove the flag from the arguments so parse_args does not
+ * see it.
+ *
+ * @param argc reference to the number of arguments, which is updated.
+ * @param argv the array of arguments c-strings, which is updated.
+ * @return the time in milliseconds, or 0 if the flag is not given and there is
+ * no computer player. Exits with a message if the time does not fit.
+ */
+static unsigned parse_opponent(int &argc, char **argv);
+
+/**
+ * @brief find the file of the tablebase given by `--tb [file]`, and remove the
+ * flag from the arguments so parse_args does not see it.
+ *
+ * @param argc reference to the number of arguments, which is updated.
+ * @param argv the array of arguments c-strings, which is updated.
+ * @return the file of the table, or null if the flag is not given.
+ */
+static const char *parse_tablebase(int &argc, char **argv);
+
 /**
  * @brief switch the player to the next player, this is usually done in single 
  * player mode when the current player is done with chopping a branch or passes 
@@ -73,9 +126,25 @@ int main(int argc, char *argv[])
 	player player = red_player;     // red goes first if not specified.
 	game::properties cur_state(glm::vec3(0.0f, 0.5f, 0.0f), edge_container);
 	bool playing = true;
+	bool stuck = false; // the player to move has no branch to chop
 	constexpr float render_distance = 15.0f;
+	picker picker; // finds the branch the player is aiming at
 
 	// parse arguments
+	game.set_table_size(parse_table_size(argc, argv));
+	const unsigned budget = parse_opponent(argc, argv);
+	if (const char *filename = parse_tablebase(argc, argv))
+	{
+		// the game is still played without the table, only slower to value
+		try
+		{
+			game.load_tablebase(filename);
+		}
+		catch (const std::runtime_error &e)
+		{
+			std::cerr << e.what() << '\n';
+		}
+	}
 	int parse_code = parse_args(argc, argv, player);
 	if (parse_code)
 		game.load_world(argv[parse_code]);
@@ -86,6 +155,13 @@ int main(int argc, char *argv[])
 	if (init(&window))
 		throw std::runtime_error("Error!");
 
+	// the computer plays the player who moves second, on a thread of its own
+	std::unique_ptr<game::opponent> computer;
+	const enum player computer_player =
+			player == red_player ? blue_player : red_player;
+	if (budget)
+		computer = std::make_unique<game::opponent>(budget);
+
 
 	// create the camera
 	render::camera camera(glm::vec3(0.0f, 0.5f, 0.0f));
@@ -189,10 +265,39 @@ void main()
 
 			cur_state.pos = camera.get_pos();
 
-			cur_state.selected_branch = select(camera, cur_state, cur_inputs,
-											   cur_state.visible_gamestate);
+			// the visible edges are within the viewport, whose corners are at
+			// most sqrt(5) render distances away
+			cur_state.selected_branch = picker.select(
+					camera.get_forward(), camera.get_pos(), game.get_world(),
+					cur_state.visible_gamestate, 3.0f * render_distance);
 
-			if (cur_state.selected_branch and
+			if (computer and player == computer_player)
+			{
+				// the move is made in the frame it arrives, and asked for again
+				// if the world changed while the computer was thinking
+				game::opponent::move move;
+				if (computer->poll(move))
+				{
+					game::edge *edge = game::opponent::resolve(game.get_world(),
+																move);
+					if (edge and game.chop(edge, player))
+					{
+						// the branch aimed at may have fallen with the chop
+						cur_state.selected_branch = nullptr;
+						switch_player(player, crosshair);
+					}
+					else if (move.edge == game::world::npos and
+							 move.root == game::world::npos)
+					{
+						std::cout << "The computer has no branch to chop.\n";
+						switch_player(player, crosshair);
+					}
+				}
+				else if (!computer->is_thinking())
+					computer->think(game.get_world(), player == blue_player ?
+													  game::blue : game::red);
+			}
+			else if (cur_state.selected_branch and
 				DOWN(LMB, cur_inputs, prev_inputs) and
 				game.chop(cur_state.selected_branch, player))
 			{
@@ -204,8 +309,20 @@ void main()
 			if (DOWN(K_P, cur_inputs, prev_inputs))
 				switch_player(player, crosshair);
 
+			// told once, as the player may still pass or the world may change
+			if (game.can_move(player))
+				stuck = false;
+			else if (!stuck)
+			{
+				stuck = true;
+				std::cout << (player == red_player ? "Red" : "Blue")
+						  << " has no branch to chop. "
+						  << (player == red_player ? "Blue" : "Red")
+						  << " wins.\n";
+			}
+
 			game.get_visible_edges(cur_state.visible_gamestate, bottomleft,
-								   topright);
+								   topright, camera.get_frustum(render_distance));
 
 			camera.set_view_projection(basic_shader);
 			ground.update(cur_state);
@@ -232,6 +349,8 @@ void main()
 
 
 	// terminate
+	if (computer)
+		computer->report();
 	glfwTerminate();
 	return 0;
 }
@@ -311,11 +430,18 @@ static int parse_args(int argc, char **argv, player &player)
 		if (strcmp(argv[1], "--help") == 0 or strcmp(argv[1], "-h") == 0)
 		{
 			std::cout << "Usage: hackenbush [world_file] [first_player: "
-						 "-R/-B]\n"
+						 "-R/-B] [--tt MiB] [--ai ms] [--tb file]\n"
                          "- If the world specified is 0, an empty world will be"
                          " generated\n"
 						 "- If no world file is specified, a default world will "
-						 "be generated.\n";
+						 "be generated.\n"
+						 "- --tt sets the size of the transposition table used "
+						 "to evaluate the world, in megabytes.\n"
+						 "- --ai lets the computer play the player who moves "
+						 "second, thinking for at most the given milliseconds "
+						 "per move.\n"
+						 "- --tb looks the small components of the world up in "
+						 "a tablebase built by the tablebase tool.\n";
 			exit(0);
 		}
 		else if (strcmp(argv[1], "-R") == 0)
@@ -337,6 +463,98 @@ static int parse_args(int argc, char **argv, player &player)
 	}
 }
 
+static bool parse_count(const char *arg, unsigned long long max,
+						unsigned long long &count)
+{
+	if (!isdigit((unsigned char) arg[0]))
+		return false;
+	char *end;
+	errno = 0;
+	count = std::strtoull(arg, &end, 10);
+	return errno == 0 and *end == '\0' and count <= max;
+}
+
+static std::size_t parse_table_size(int &argc, char **argv)
+{
+	std::size_t megabytes = game::transposition_table::DEFAULT_MEGABYTES;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--tt") != 0)
+			continue;
+		if (i + 1 == argc)
+		{
+			std::cerr << "--tt needs the size of the table in megabytes\n";
+			exit(1);
+		}
+
+		// the size in bytes must fit, with room to round it
+		unsigned long long count;
+		if (!parse_count(argv[i + 1], SIZE_MAX >> 21, count))
+		{
+			std::cerr << "--tt needs the size of the table in megabytes, not "
+					  << argv[i + 1] << '\n';
+			exit(1);
+		}
+		megabytes = count;
+		for (int j = i + 2; j <= argc; ++j)
+			argv[j - 2] = argv[j];
+		argc -= 2;
+		break;
+	}
+	return megabytes;
+}
+
+static unsigned parse_opponent(int &argc, char **argv)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--ai") != 0)
+			continue;
+
+		// the budget is optional
+		unsigned budget = game::opponent::DEFAULT_BUDGET_MS;
+		int taken = 1;
+		if (i + 1 < argc and isdigit((unsigned char) argv[i + 1][0]))
+		{
+			unsigned long long count;
+			if (!parse_count(argv[i + 1], UINT_MAX, count))
+			{
+				std::cerr << "--ai needs the budget in milliseconds, not "
+						  << argv[i + 1] << '\n';
+				exit(1);
+			}
+			budget = count;
+			taken = 2;
+		}
+		for (int j = i + taken; j <= argc; ++j)
+			argv[j - taken] = argv[j];
+		argc -= taken;
+		return std::max(budget, 1u);
+	}
+	return 0;
+}
+
+static const char *parse_tablebase(int &argc, char **argv)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--tb") != 0)
+			continue;
+		if (i + 1 == argc)
+		{
+			std::cerr << "--tb needs the file of the tablebase\n";
+			exit(1);
+		}
+
+		const char *filename = argv[i + 1];
+		for (int j = i + 2; j <= argc; ++j)
+			argv[j - 2] = argv[j];
+		argc -= 2;
+		return filename;
+	}
+	return nullptr;
+}
+
 static inline void switch_player(player &player, render::geometry::crosshair
 &crosshair)
 {
@@ -1,4 +1,5 @@
 #include "nodes.hpp"
+#include "kernels.hpp"
 
 /**
  * @pre each of the 3 coordinates of BOT_L must be less than the corresponding 
@@ -19,36 +20,21 @@
 
 namespace game::nodes {
 
-/**
- * @details use a recursive (depth first) traversal of the bree with a maximum
- * depth to search for the all the nodes attached to this node. 
- */
-void normal::operator()(container &nodes, const glm::vec3 &bottomleft,
-						const glm::vec3 &topright, int32_t max_depth)
+// the traversal context keeps track of the visited nodes
+void normal::visit(container &nodes, const glm::vec3 &bottomleft,
+				   const glm::vec3 &topright, traversal &ctx)
 {
-	(IN(pos_, bottomleft, topright) ? nodes : nodes_discard).insert(this);
+	if (IN(pos_, bottomleft, topright))
+		nodes.insert(this);
 
-	if (max_depth)
-	{
-		for (edge *edge: edges_)
-		{
-			node *other = edge->get_other(this);
-			if (nodes.find(other) == nodes.end() and nodes_discard.find
-					(other) == nodes_discard.end())    //
-				// when other node not
-				// visited
-				(*other)(nodes, bottomleft, topright, max_depth - 1);
-		}
-	}
-	if (max_depth == DEFAULT_MAX_DEPTH)
-		nodes_discard.clear();
+	for (edge *edge: edges_)
+		ctx.push(edge->get_other(this));
 }
 
-// add the edges attached to this node using std::set_union
+// add the edges attached to this node
 void normal::render(edge::container &edges, int32_t max_breadth)
 {
-	std::set_union(edges.begin(), edges.end(), edges_.begin(), edges_.end(),
-				   std::inserter(edges, edges.begin()));
+	edges.insert(edges_.begin(), edges_.end());
 }
 
 void normal::log(std::ostream &os, uint8_t layers, uint8_t counter) const
@@ -76,22 +62,26 @@ void normal::log(std::ostream &os, uint8_t layers, uint8_t counter) const
 // allowed to be inserted. 
 bool normal::attach(edge *e)
 {
-	edges_.insert(e);
+	edges_.push_back(e);
 	return true;
 }
 
-// set erase method automatically error checks
+// swap the edge with the last one and pop it, order of edges does not matter
 void normal::detach(edge *e)
 {
-	edges_.erase(e);
+	auto it = std::find(edges_.begin(), edges_.end(), e);
+	if (it == edges_.end())
+		return;
+	*it = edges_.back();
+	edges_.pop_back();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 // Implementation of the stacked nodes
 ///////////////////////////////////////////////////////////////////////////////
 
-void stack::operator()(node::container &nodes, const glm::vec3 &bottomleft,
-					   const glm::vec3 &topright, int32_t max_depth)
+void stack::visit(node::container &nodes, const glm::vec3 &bottomleft,
+				  const glm::vec3 &topright, traversal &ctx)
 {
 	throw std::logic_error("not implemented because stack objects should not "
 						   "be called!");
@@ -149,6 +139,8 @@ stack_root::stack_root(const glm::vec3 &pos, const glm::vec3 &vec_kwargs,
 
 stack_root::~stack_root()
 {
+	for (auto &branch: branches_)
+		delete branch.second;
 	for (auto &child: children_)
 		delete child.second;
 	delete kwargs_;
@@ -156,30 +148,34 @@ stack_root::~stack_root()
 
 edge *stack_root::__render(int32_t order, stack *ptr, bool next)
 {
-
 	if (!ptr) // when nullptr, default behavior
-	{
-		game::branch_type type = tgen_(1, kwargs_);
-
-		auto branch = children_.find(1);
-		if (branch != children_.end())
-			return game::attach(type, this, branch->second);
-	}
-	else
-	{
-		game::branch_type type = tgen_(order + (int) next - 1, kwargs_);
+		return branch(0);
+	return branch(next ? order : order - 1);
+}
 
-		auto branch = children_.find(next ? order + 1 : order - 1);
-		if (branch != children_.end())
-			return game::attach(type, ptr, branch->second);
-		// return game::attach(type, ptr, children_[next ? order+1 : order-1]);
-	}
-	return nullptr; // one of the nodes are not created
+// create the branch the first time it is needed, and reuse it afterwards
+edge *stack_root::branch(int64_t order)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto cached = branches_.find(order);
+	if (cached != branches_.end())
+		return cached->second;
+
+	auto lower = children_.find(order);
+	auto upper = children_.find(order + 1);
+	if (lower == children_.end() or upper == children_.end())
+		return nullptr; // one of the nodes are not created
+
+	edge *e = game::attach(tgen_(order, kwargs_), lower->second,
+						   upper->second);
+	branches_[order] = e;
+	return e;
 }
 
 // will add the created object to the children, if it is not already there
 stack *stack_root::operator[](std::size_t i)
 {
+	std::lock_guard<std::mutex> lock(mutex_);
 	if (cap_ != INF and (int64_t) i >= cap_)
 		return nullptr;
 
@@ -194,28 +190,44 @@ stack *stack_root::operator[](std::size_t i)
 	return child_node;
 }
 
-void stack_root::operator()(node::container &nodes,
-							const glm::vec3 &bottomleft,
-							const glm::vec3 &topright, int32_t max_depth)
+// the node at the limit is visited even when the stack is out of the volume
+void stack_root::visit(node::container &nodes, const glm::vec3 &bottomleft,
+					   const glm::vec3 &topright, traversal &ctx)
+{
+	if (grandchild_)
+		ctx.push(grandchild_);
+
+	collect(nodes, bottomleft, topright);
+}
+
+void stack_root::collect(node::container &nodes, const glm::vec3 &bottomleft,
+						 const glm::vec3 &topright, int32_t max_breadth)
 {
 	int64_t first = sgen_.a_(bottomleft, topright, pos_, vec_kwargs_);
 
-	if (first == NOT_FOUND) // if this entire stack is not in the region,
-		return;             // then we don't need to do anything
+	if (first == NOT_FOUND)
+		return;
 
-	// deal with grandchildren later
-	if (grandchild_)
+	// generate the positions of the children in blocks, and test them together
+	constexpr int64_t BLOCK = 64;
+	float xs[BLOCK], ys[BLOCK], zs[BLOCK];
+	uint32_t hits[BLOCK];
+	for (int64_t block = first; block < first + max_breadth; block += BLOCK)
 	{
-		max_depth /= 2;
-		(*grandchild_)(nodes, bottomleft, topright, max_depth);
-	}
+		const int64_t n = std::min(BLOCK, first + max_breadth - block);
+		for (int64_t i = 0; i < n; ++i)
+		{
+			glm::vec3 child_pos = sgen_.a(block + i, pos_, vec_kwargs_);
+			xs[i] = child_pos.x;
+			ys[i] = child_pos.y;
+			zs[i] = child_pos.z;
+		}
 
-	for (int32_t child_ord = first; child_ord < max_depth + first; ++child_ord)
-	{
-		glm::vec3 child_pos = sgen_.a(child_ord, pos_, vec_kwargs_);
-		if (IN(child_pos, bottomleft, topright))
+		const std::size_t count = kernels::contained(xs, ys, zs, n, bottomleft,
+													 topright, hits);
+		for (std::size_t h = 0; h < count; ++h)
 		{
-			stack *child_node = (*this)[child_ord];
+			stack *child_node = (*this)[block + hits[h]];
 			if (child_node) nodes.insert(child_node);
 			else return;
 		}
@@ -224,7 +236,7 @@ void stack_root::operator()(node::container &nodes,
 
 void stack_root::render(edge::container &edges, int32_t max_breadth)
 {
-	edge *next = root_->__render();
+	edge *next = __render();
 	if (next) edges.insert(next);
 }
 
@@ -232,7 +244,8 @@ void stack_root::log(std::ostream &os, uint8_t layers, uint8_t counter) const
 {
 	os << "stack_root ";
 	os << "@(" << pos_.x << "," << pos_.y << "," << pos_.z << ")";
-	os << " with " << children_.size() << " generated children";
+	os << " with " << children_.size() << " generated children and "
+	   << branches_.size() << " branches";
 	if (layers)
 	{
 		os << std::endl;
@@ -251,7 +264,8 @@ bool stack_root::attach(edge *e)
 	if (e->p1 == this or e->p2 == this)
 	{
 		node *candidate = e->get_other(this);
-		if (candidate->get_pos() == grandchild_->get_pos())
+		if (grandchild_ and candidate != grandchild_ and
+			candidate->get_pos() == grandchild_->get_pos())
 		{
 			node *tmp = grandchild_;
 			grandchild_ = candidate;
@@ -273,18 +287,32 @@ void stack_root::detach(int64_t order)
 {
 	// if the order is greater than the current order, do nothing
 	// not sure if this check is necessary.
+	std::lock_guard<std::mutex> lock(mutex_);
 	if (cap_ != INF and order > cap_)
 		return;
 
 	cap_ = order; // not sure if i need a -1 here
 
-	auto it = children_.find(order);
-	for (auto j = children_.find(order); j != children_.end(); ++j)
+	// the branch from order - 1 to order is gone along with everything above
+	auto b = branches_.lower_bound(order - 1);
+	for (auto j = b; j != branches_.end(); ++j)
+		delete j->second;
+	branches_.erase(b, branches_.end());
+
+	auto it = children_.lower_bound(order);
+	for (auto j = it; j != children_.end(); ++j)
 		delete j->second;
 	children_.erase(it, children_.end());
 	grandchild_ = nullptr;
 }
 
+void stack_root::restore(int64_t cap, node *grandchild)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	cap_ = cap;
+	grandchild_ = grandchild;
+}
+
 node *stack_root::get_grandchild() const
 {
 	return grandchild_;
@@ -16,8 +16,10 @@
 #pragma once
 
 #include "common/constants.hpp"
+#include "common/hash.hpp"
 
 #include <map>
+#include <mutex>
 #include <cmath>
 #include <limits>
 #include <unordered_map>
@@ -29,7 +31,7 @@ struct std::hash<std::pair<int32_t, int32_t>>
 {
 	size_t operator()(const std::pair<int32_t, int32_t> &p) const
 	{
-		return hash<int32_t>()(p.first) ^ hash<int32_t>()(p.second);
+		return hashing::combine(p.first, p.second);
 	}
 };
 
@@ -47,10 +49,11 @@ class stack_root;
  * unconventional nodes/branches that are used in this implementation of
  * hackenbush.
  * 
- * @details the node is implemented using an container of all edges that are
- * attached to the node. As game::edges contain both the nodes the edge 
+ * @details the node is implemented using a small contiguous list of all edges
+ * that are attached to the node. As game::edges contain both the nodes the edge
  * connects, this allows the node to be attach to another type (possibly 
- * infinite sequence) of node as well.
+ * infinite sequence) of node as well. Nodes rarely have more than a handful of
+ * edges, so a linear scan of a vector beats hashing into a set.
  * 
  */
 class normal : public node
@@ -70,25 +73,16 @@ public:
 
 
 	/**
-	 * @brief get the nodes that are contained in the volume specified by two
-	 * diagonally opposite corners.
+	 * @brief add this node to the nodes if it is contained in the volume, and
+	 * push the nodes at the other end of its edges onto the traversal context.
 	 *
+	 * @param nodes: container of the nodes contained in the volume.
 	 * @param bottomleft: 3d position of the bottom left corner of the volume.
-	 * @note the top left corner is the corner with the smallest x, y, and z
-	 * values.
 	 * @param topright: 3d position the top right corner of the volume.
-	 * @note the bottom right corner is the corner with the largest x, y, and z
-	 * values.
-	 * @param max_depth: 32-bit integer of the maximum number depth to search.
-	 * Defaults to DEFAULT_MAX_DEPTH.
-	 *
-	 * @return a container of references to all the nodes contained in the
-	 * volume which can be used to render branches to the screen and interact
-	 * with the player.
+	 * @param ctx: the traversal context.
 	 */
-	void operator()(container &nodes, const glm::vec3 &bottomleft,
-					const glm::vec3 &topright,
-					int32_t max_depth = DEFAULT_MAX_DEPTH) override;
+	void visit(container &nodes, const glm::vec3 &bottomleft,
+			   const glm::vec3 &topright, traversal &ctx) override;
 
 
 	/**
@@ -137,7 +131,7 @@ public:
 	void detach(edge *e) override;
 
 private:
-	edge::container edges_;
+	std::vector<edge *> edges_;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -156,10 +150,10 @@ namespace generators {
  * node of order `order` and a node of order `order + 1`.
  * 
  * @details the methods implemented in this namespace are:
- * - red: return red branch no matter what (+omega)
- * - green: return green branch no matter what (*)
- * - blue: return blue branch no matter what (-omega)
- * - num: return branch corresponding to the number given in kwargs.
+ * - red: return red branch no matter what (-omega)
+ * - green: return green branch no matter what (*omega)
+ * - blue: return blue branch no matter what (+omega)
+ * - fraction: return branch corresponding to the fraction given in kwargs.
  * -
  */
 namespace F {
@@ -252,6 +246,20 @@ int64_t c_geometric(const glm::vec3 &bottomleft, const glm::vec3 &topright,
 
 using type_gen = branch_type (*)(const int64_t, void *);
 
+/**
+ * @brief find the first branch of a colour made by a type generator, worked
+ * out from the generator instead of generating the branches one by one. A
+ * fraction has its integral part plus one branches of the colour of its sign
+ * before the first branch of the other colour, by Berlekamp's rule.
+ *
+ * @param tgen the type generator.
+ * @param kwargs the kwargs of the generator.
+ * @param type the colour of the branch.
+ * @return int64_t the order of the first branch of the colour.
+ * @return NOT_FOUND if the generator never makes a branch of the colour.
+ */
+int64_t first(type_gen tgen, void *kwargs, branch_type type);
+
 struct step_gen
 {
 private:
@@ -273,6 +281,8 @@ public:
  *  that is NOT attached to any other node outside the stack.
  * 
  * @warning this class is not meant to be used directly.
+ * @warning the branches between stack nodes are owned by the stack root. They
+ * must be removed with stack_root::detach(order), not game::detach.
  * 
  */
 class stack : public node
@@ -289,12 +299,12 @@ public:
 	stack &operator=(const stack &) = delete;
 
 	/**
-	 * @brief THIS METHOD SHOULD NOT BE CALLED!
+	 * @brief THIS METHOD SHOULD NOT BE CALLED! The children of a stack are
+	 * collected by their stack root.
 	 * @throw not implemented error.
 	 */
-	void operator()(node::container &nodes,
-					const glm::vec3 &bottomleft, const glm::vec3 &topright,
-					int32_t max_depth = DEFAULT_MAX_DEPTH) override;
+	void visit(node::container &nodes, const glm::vec3 &bottomleft,
+			   const glm::vec3 &topright, traversal &ctx) override;
 
 
 	void render(edge::container &edges,
@@ -309,6 +319,12 @@ public:
 
 	void detach(edge *e) override;
 
+	inline stack_root *get_root() const
+	{ return root_; }
+
+	inline int64_t get_order() const
+	{ return order_; }
+
 protected:
 	int64_t order_; // The order or index or id of this node.
 	stack_root *root_;  // Pointer to the root of the stack.
@@ -351,11 +367,78 @@ public:
 
 	edge *__render(int32_t order = 0, stack *ptr = nullptr, bool next = true);
 
+	/**
+	 * @brief get the branch between the children of order `order` and
+	 * `order + 1`. The branch is created the first time it is requested, and
+	 * the same edge is returned afterwards until the stack is cut below it.
+	 *
+	 * @param order the order of the lower child of the branch.
+	 * @return edge pointer to the branch, owned by this stack root.
+	 * @return nullptr if one of the children is not generated.
+	 */
+	edge *branch(int64_t order);
+
 	node *get_grandchild() const;
 
-	void operator()(node::container &nodes,
-					const glm::vec3 &bottomleft, const glm::vec3 &topright,
-					int32_t max_depth = DEFAULT_MAX_DEPTH) override;
+	/**
+	 * @return int64_t the order of the lowest child removed by the last cut
+	 * of the stack, INF if it was never cut.
+	 */
+	inline int64_t get_cap() const
+	{ return cap_; }
+
+	/**
+	 * @brief undo detach(order): put back the cap and the node at the limit
+	 * the stack had before it was cut. The children and branches removed are
+	 * generated again when they are asked for.
+	 *
+	 * @param cap the cap before the cut, from get_cap().
+	 * @param grandchild the node at the limit before the cut, from
+	 * get_grandchild().
+	 */
+	void restore(int64_t cap, node *grandchild);
+
+	/**
+	 * @return int64_t the number of branches left in the stack, INF if it is
+	 * infinite. A stack cut with detach(order) keeps order - 1 branches.
+	 */
+	inline int64_t size() const
+	{ return cap_ == INF ? INF : std::max<int64_t>(cap_ - 1, 0); }
+
+	/**
+	 * @return branch_type the colour of the branch between the children of
+	 * order `order` and `order + 1`, whether it is generated or not.
+	 */
+	inline branch_type get_type(int64_t order) const
+	{ return tgen_(order, kwargs_); }
+
+	inline generators::type_gen get_type_gen() const
+	{ return tgen_; }
+
+	inline void *get_kwargs() const
+	{ return kwargs_; }
+
+	/**
+	 * @brief collect the children of this stack that are contained in the
+	 * volume, and push the node at the limit of the stack onto the traversal
+	 * context.
+	 */
+	void visit(node::container &nodes, const glm::vec3 &bottomleft,
+			   const glm::vec3 &topright, traversal &ctx) override;
+
+	/**
+	 * @brief collect the generated children of this stack that are contained
+	 * in the volume, without visiting the grandchild. Used by game::world,
+	 * which walks to the grandchild through its own adjacency.
+	 *
+	 * @param nodes container where the children in the volume are added to.
+	 * @param bottomleft 3d position of the bottom left corner of the volume.
+	 * @param topright 3d position of the top right corner of the volume.
+	 * @param max_breadth maximum number of children to generate.
+	 */
+	void collect(node::container &nodes,
+				 const glm::vec3 &bottomleft, const glm::vec3 &topright,
+				 int32_t max_breadth = DEFAULT_MAX_DEPTH);
 
 	void render(edge::container &edges,
 				int32_t max_breadth = DEFAULT_MAX_BREADTH) override;
@@ -367,10 +450,17 @@ public:
 
 	void detach(edge *e) override;
 
+	/**
+	 * @brief cut the stack at the branch between the children of order
+	 * `order - 1` and `order`. The children and branches above are deleted.
+	 *
+	 * @param order the order of the lowest child to remove.
+	 */
 	void detach(int64_t order);
 
 private:
 	container children_;
+	std::map<int64_t, edge *> branches_; // branch from order to order + 1
 	node *grandchild_; // this is just a normal node.
 	generators::type_gen tgen_;
 	generators::step_gen sgen_;
@@ -378,6 +468,8 @@ private:
 	glm::vec3 vec_kwargs_;
 	void *kwargs_;// Optional arguments to be passed to the generator
 	// functions.
+	std::mutex mutex_; // guards the children and branches generated lazily
+	// by concurrent traversals.
 };
 
 
@@ -0,0 +1,923 @@
+/**
+ * @file opponent.cpp
+ * @author Jonah Chen
+ * @brief implement the computer opponent specified in opponent.hpp
+ * @version 1.0
+ * @date 2021-12-08
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include "opponent.hpp"
+#include "generators.hpp"
+#include <algorithm>
+#include <cmath>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+namespace game {
+
+// scores of the search, for the player who moves. A position won or lost for
+// sure scores more than WIN in magnitude, plus the size of its value, so the
+// winner keeps the most it can and the loser gives away the least.
+static constexpr double WIN = 1e9;
+static constexpr double MAX_MARGIN = 1e6;
+static constexpr double LOSS = -(WIN + MAX_MARGIN);
+static constexpr double UNBOUNDED = 2 * (WIN + MAX_MARGIN);
+static constexpr double HEURISTIC_LIMIT = 1e8;
+
+// most branches of a stack counted by its edges
+static constexpr int64_t MAX_MATERIAL = 64;
+
+static constexpr uint32_t npos = no_id;
+
+// the size of a value, as a score
+static double magnitude(const surreal &x)
+{
+	if (x.is_infinite())
+		return x.sign() * MAX_MARGIN;
+	return x.get_real().to_double() +
+		   (double) x.get_residue() / (double) x.get_modulus();
+}
+
+static uint8_t colours_of(nodes::generators::type_gen tgen)
+{
+	if (tgen == ALL_GREEN)
+		return 0b010;
+	if (tgen == ALL_BLUE or tgen == ALL_RED or tgen == FRACTION)
+		return 0b001;
+	return 0b100;
+}
+
+opponent::opponent(unsigned budget_ms) :
+		budget_(std::chrono::milliseconds(budget_ms)),
+		worker_(&opponent::run, this)
+{}
+
+opponent::~opponent()
+{
+	stop_.store(true, std::memory_order_relaxed);
+	state_.store(QUIT, std::memory_order_release);
+	state_.notify_one();
+	worker_.join();
+}
+
+bool opponent::think(const world &w, branch_type player)
+{
+	if (state_.load(std::memory_order_acquire) != IDLE)
+		return false;
+	load(w, player);
+	asked_ = clock::now();
+	stop_.store(false, std::memory_order_relaxed);
+	state_.store(THINKING, std::memory_order_release);
+	state_.notify_one();
+	return true;
+}
+
+bool opponent::poll(move &m)
+{
+	if (state_.load(std::memory_order_acquire) != READY)
+		return false;
+	m = result_;
+	latencies_.push_back(std::chrono::duration<double, std::milli>(
+			clock::now() - asked_).count());
+	depths_.push_back(m.depth);
+	state_.store(IDLE, std::memory_order_release);
+	return true;
+}
+
+opponent::move opponent::choose(const world &w, branch_type player)
+{
+	load(w, player);
+	asked_ = clock::now();
+	stop_.store(false, std::memory_order_relaxed);
+	const move m = search();
+	latencies_.push_back(std::chrono::duration<double, std::milli>(
+			clock::now() - asked_).count());
+	depths_.push_back(m.depth);
+	return m;
+}
+
+void opponent::run()
+{
+	for (;;)
+	{
+		const uint32_t state = state_.load(std::memory_order_acquire);
+		if (state == QUIT)
+			return;
+		if (state != THINKING)
+		{
+			state_.wait(state, std::memory_order_acquire);
+			continue;
+		}
+
+		result_ = search();
+
+		// the opponent may be quitting, which the move must not hide
+		uint32_t thinking = THINKING;
+		state_.compare_exchange_strong(thinking, READY,
+									   std::memory_order_acq_rel);
+	}
+}
+
+edge *opponent::resolve(const world &w, const move &m)
+{
+	if (m.version != w.get_version())
+		return nullptr;
+	if (m.edge != world::npos)
+		return m.edge < w.num_edges() and w.is_alive(m.edge) ?
+			   w.get_edge(m.edge) : nullptr;
+	if (m.root >= w.num_nodes() or !w.is_present(m.root) or
+		w.get_kind(m.root) != node_kind::stack_root)
+		return nullptr;
+
+	auto *root = static_cast<nodes::stack_root *>(w.get_node(m.root));
+	if (m.order < 0 or (root->size() != INF and m.order >= root->size()))
+		return nullptr;
+	if (!(*root)[m.order] or !(*root)[m.order + 1])
+		return nullptr;
+	return root->branch(m.order);
+}
+
+void opponent::report(std::ostream &os) const
+{
+	if (latencies_.empty())
+	{
+		os << "the opponent has not moved\n";
+		return;
+	}
+
+	std::vector<double> sorted(latencies_);
+	std::sort(sorted.begin(), sorted.end());
+	const auto percentile = [&sorted](double q)
+	{ return sorted[(std::size_t) (q * (sorted.size() - 1) + 0.5)]; };
+	double total = 0.0, depth = 0.0;
+	for (double ms: latencies_)
+		total += ms;
+	for (int d: depths_)
+		depth += d;
+
+	os << latencies_.size() << " moves, latency (ms): mean "
+	   << total / latencies_.size() << ", p50 " << percentile(0.5) << ", p90 "
+	   << percentile(0.9) << ", p99 " << percentile(0.99) << ", max "
+	   << sorted.back() << ", average depth " << depth / depths_.size()
+	   << '\n';
+}
+
+void opponent::load(const world &w, branch_type player)
+{
+	player_ = player;
+	version_ = w.get_version();
+	edges_.clear();
+	piles_.clear();
+	ground_piles_.clear();
+	dropped_.clear();
+	cut_.clear();
+
+	local_.assign(w.num_nodes(), npos);
+	uint32_t num_nodes = 1;
+	const auto local_id = [&](world::id_t n)
+	{
+		if (w.is_grounded(n))
+			return (uint32_t) 0;
+		if (local_[n] == npos)
+			local_[n] = num_nodes++;
+		return local_[n];
+	};
+
+	// the stacks, with a copy of the kwargs of a fraction, as the stack root
+	// may be freed while the copy is searched
+	for (world::id_t n = 0; n < w.num_nodes(); ++n)
+	{
+		if (!w.is_present(n) or w.get_kind(n) != node_kind::stack_root)
+			continue;
+		const auto *root = static_cast<const nodes::stack_root *>(w.get_node(n));
+		pile p{n, local_id(n), npos, root->get_type_gen(), root->get_kwargs(),
+			   {0, 0}, root->size()};
+		if (p.tgen == FRACTION and p.kwargs)
+		{
+			p.fraction[0] = ((const int32_t *) p.kwargs)[0];
+			p.fraction[1] = ((const int32_t *) p.kwargs)[1];
+		}
+		piles_.push_back(p);
+	}
+	for (pile &p: piles_)
+		if (p.tgen == FRACTION and p.kwargs)
+			p.kwargs = p.fraction;
+
+	std::unordered_map<world::id_t, uint32_t> links;
+	for (uint32_t i = 0; i < piles_.size(); ++i)
+	{
+		const world::id_t link = w.get_link(piles_[i].root);
+		if (link != world::npos)
+			links[link] = i;
+	}
+	for (world::id_t e = 0; e < w.num_edges(); ++e)
+	{
+		if (!w.is_alive(e))
+			continue;
+		local_edge le{local_id(w.get_p1(e)), local_id(w.get_p2(e)),
+					  w.get_type(e), npos, e, w.get_key(e)};
+		auto link = links.find(e);
+		if (link != links.end())
+		{
+			le.pile = link->second;
+			piles_[le.pile].link = edges_.size();
+		}
+		edges_.push_back(le);
+	}
+
+	pile_at_.assign(num_nodes, npos);
+	for (uint32_t i = 0; i < piles_.size(); ++i)
+	{
+		if (piles_[i].node)
+			pile_at_[piles_[i].node] = i;
+		else
+			ground_piles_.push_back(i);
+	}
+
+	// adjacency of the local nodes, in one array
+	adj_begin_.assign(num_nodes + 1, 0);
+	for (const local_edge &le: edges_)
+	{
+		++adj_begin_[le.p1 + 1];
+		++adj_begin_[le.p2 + 1];
+	}
+	for (uint32_t n = 0; n < num_nodes; ++n)
+		adj_begin_[n + 1] += adj_begin_[n];
+	adj_.resize(adj_begin_[num_nodes]);
+	std::vector<uint32_t> next(adj_begin_.begin(), adj_begin_.end() - 1);
+	for (uint32_t j = 0; j < edges_.size(); ++j)
+	{
+		adj_[next[edges_[j].p1]++] = {j, edges_[j].p2};
+		adj_[next[edges_[j].p2]++] = {j, edges_[j].p1};
+	}
+
+	alive_.assign(edges_.size(), 1);
+	moves_.resize(MAX_DEPTH + 2);
+	history_.assign(edges_.size() + piles_.size(), 0);
+	marks_.assign(num_nodes, 0);
+	epoch_ = 0;
+	parent_.resize(num_nodes);
+	part_.resize(num_nodes);
+	above_.resize(num_nodes);
+	nim_.resize(num_nodes);
+}
+
+opponent::move opponent::hint(const world &w, branch_type player)
+{
+	load(w, player);
+	move result;
+	result.version = version_;
+	choice c;
+	if (!hottest(player, c))
+	{
+		std::vector<choice> moves;
+		generate(player, moves);
+		if (moves.empty())
+			return result;
+		c = moves.front();
+	}
+	describe(c, result);
+	return result;
+}
+
+opponent::move opponent::search()
+{
+	move result;
+	result.version = version_;
+	positions_ = 0;
+	deadline_ = clock::now() + budget_;
+
+	std::vector<choice> root;
+	generate(player_, root);
+	if (root.empty())
+		return result;
+
+	// the move in the hottest component is searched first
+	choice hot;
+	if (hottest(player_, hot))
+	{
+		const auto same = [&hot](const choice &c)
+		{
+			return c.edge == hot.edge and c.pile == hot.pile and
+				   c.order == hot.order;
+		};
+		const auto found = std::find_if(root.begin(), root.end(), same);
+		if (found != root.end())
+			std::rotate(root.begin(), found, found + 1);
+	}
+
+	const branch_type other = player_ == blue ? red : blue;
+	std::vector<double> scores(root.size(), LOSS);
+	std::vector<uint32_t> ranks(root.size());
+	choice best = root.front();
+	for (int depth = 1; depth <= MAX_DEPTH; ++depth)
+	{
+		horizon_ = false;
+		double alpha = -UNBOUNDED, found = -UNBOUNDED;
+		std::size_t searched = 0;
+		choice chosen = best;
+		for (std::size_t i = 0; i < root.size(); ++i)
+		{
+			const std::size_t dropped = dropped_.size(), cut = cut_.size();
+			play(root[i]);
+			const double score = -negamax(other, depth - 1, 1, -UNBOUNDED, -alpha);
+			undo(dropped, cut);
+			if (stop_.load(std::memory_order_relaxed))
+				break;
+
+			++searched;
+			scores[i] = score;
+			if (score > found)
+			{
+				found = score;
+				chosen = root[i];
+			}
+			alpha = std::max(alpha, score);
+		}
+
+		// the move that was best before is searched first, so whatever beats
+		// it is better at this depth
+		if (searched)
+		{
+			best = chosen;
+			result.depth = depth;
+			result.score = found;
+		}
+		if (stop_.load(std::memory_order_relaxed) or !horizon_ or
+			std::abs(found) >= WIN)
+			break;
+
+		for (uint32_t i = 0; i < ranks.size(); ++i)
+			ranks[i] = i;
+		std::stable_sort(ranks.begin(), ranks.end(), [&scores](uint32_t a,
+															   uint32_t b)
+		{ return scores[a] > scores[b]; });
+		std::vector<choice> sorted(root.size());
+		std::vector<double> sorted_scores(root.size());
+		for (std::size_t i = 0; i < ranks.size(); ++i)
+		{
+			sorted[i] = root[ranks[i]];
+			sorted_scores[i] = scores[ranks[i]];
+		}
+		root.swap(sorted);
+		scores.swap(sorted_scores);
+	}
+
+	describe(best, result);
+	result.positions = positions_;
+	return result;
+}
+
+double opponent::negamax(branch_type player, int depth, int ply, double alpha,
+						 double beta)
+{
+	if ((++positions_ & 255) == 0 and clock::now() > deadline_)
+		stop_.store(true, std::memory_order_relaxed);
+	if (stop_.load(std::memory_order_relaxed))
+		return 0.0;
+
+	double score;
+	if (evaluate(player, score))
+		return score;
+
+	std::vector<choice> &moves = moves_[ply];
+	generate(player, moves);
+	if (moves.empty())
+		return LOSS;
+	if (depth == 0)
+	{
+		horizon_ = true;
+		return score;
+	}
+
+	std::stable_sort(moves.begin(), moves.end(), [this](const choice &a,
+														const choice &b)
+	{ return history(a) > history(b); });
+
+	const branch_type other = player == blue ? red : blue;
+	double best = -UNBOUNDED;
+	for (const choice &c: moves)
+	{
+		const std::size_t dropped = dropped_.size(), cut = cut_.size();
+		play(c);
+		score = -negamax(other, depth - 1, ply + 1, -beta, -alpha);
+		undo(dropped, cut);
+		if (stop_.load(std::memory_order_relaxed))
+			return 0.0;
+
+		best = std::max(best, score);
+		alpha = std::max(alpha, score);
+		if (alpha >= beta)
+		{
+			history(c) += depth * depth;
+			break;
+		}
+	}
+	return best;
+}
+
+/**
+ * @details the nodes are walked breadth first from the ground, and every node
+ * joins the part of the node it was reached from, or a part of its own when
+ * it was reached from the ground.
+ */
+void opponent::split()
+{
+	next_epoch();
+	order_.assign(1, 0);
+	marks_[0] = epoch_;
+	parts_.clear();
+	for (std::size_t i = 0; i < order_.size(); ++i)
+	{
+		const uint32_t v = order_[i];
+		for (uint32_t a = adj_begin_[v]; a < adj_begin_[v + 1]; ++a)
+		{
+			const half_edge &h = adj_[a];
+			if (!alive_[h.edge] or marks_[h.other] == epoch_)
+				continue;
+			marks_[h.other] = epoch_;
+			parent_[h.other] = h.edge;
+			if (v == 0)
+			{
+				part_[h.other] = parts_.size();
+				parts_.push_back({0, 0, 0, true, 0.0, surreal(), 0});
+			}
+			else
+				part_[h.other] = part_[v];
+			above_[h.other] = 0;
+			nim_[h.other] = 0;
+			order_.push_back(h.other);
+		}
+	}
+	for (std::size_t i = 1; i < order_.size(); ++i)
+		++parts_[part_[order_[i]]].nodes;
+}
+
+/**
+ * @details a part is a tree when it has as many edges as nodes, and its trees
+ * are valued bottom up.
+ */
+bool opponent::evaluate(branch_type player, double &score)
+{
+	split();
+	surreal number;
+	uint64_t nimber = 0;
+	double material = 0.0;
+	bool exact = true;
+	const auto pile_material = [](const pile &p)
+	{
+		const double height = (double) std::min(p.size, MAX_MATERIAL);
+		return p.tgen == ALL_BLUE ? height : p.tgen == ALL_RED ? -height : 0.0;
+	};
+
+	// a stack without its link stands on its own, on the ground or above the
+	// node of its root
+	const auto lone = [&](const pile &p)
+	{
+		try
+		{
+			if (colours_of(p.tgen) == 0b001)
+			{
+				number += stack_value(p.tgen, p.kwargs, p.size);
+				return;
+			}
+			if (p.tgen == ALL_GREEN and p.size != INF)
+			{
+				nimber ^= p.size;
+				return;
+			}
+		}
+		catch (const std::exception &)
+		{}
+		exact = false;
+		material += pile_material(p);
+	};
+	for (uint32_t i: ground_piles_)
+	{
+		const pile &p = piles_[i];
+		if (p.size and (p.link == npos or !alive_[p.link]))
+			lone(p);
+	}
+
+	for (uint32_t j = 0; j < edges_.size(); ++j)
+	{
+		if (!alive_[j])
+			continue;
+		const local_edge &le = edges_[j];
+		const uint32_t owner = le.p1 ? le.p1 : le.p2;
+		if (!owner)
+		{
+			// an edge between two nodes on the ground is a part on its own
+			if (le.type == invalid)
+				lone(piles_[le.pile]);
+			else if (le.type == green)
+				nimber ^= 1;
+			else
+				number += le.type == blue ? 1 : -1;
+			continue;
+		}
+
+		part &pt = parts_[part_[owner]];
+		++pt.edges;
+		if (le.type == invalid)
+		{
+			pt.colours |= colours_of(piles_[le.pile].tgen);
+			pt.material += pile_material(piles_[le.pile]);
+		}
+		else
+		{
+			pt.colours |= le.type == green ? 0b010 : 0b001;
+			pt.material += le.type == blue ? 1.0 : le.type == red ? -1.0 : 0.0;
+		}
+	}
+	for (std::size_t i = 1; i < order_.size(); ++i)
+	{
+		const uint32_t v = order_[i];
+		if (pile_at_[v] == npos)
+			continue;
+		const pile &p = piles_[pile_at_[v]];
+		if (!p.size or (p.link != npos and alive_[p.link]))
+			continue;
+		part &pt = parts_[part_[v]];
+		pt.colours |= colours_of(p.tgen);
+		pt.material += pile_material(p);
+		if (colours_of(p.tgen) != 0b001 and
+			!(p.tgen == ALL_GREEN and p.size != INF))
+			pt.closed = false;
+	}
+	for (part &pt: parts_)
+		pt.closed = pt.closed and pt.nodes == pt.edges and
+					(pt.colours == 0b001 or pt.colours == 0b010);
+
+	// the trees bottom up, with the stacks above their roots at the start
+	for (std::size_t i = order_.size(); i-- > 1;)
+	{
+		const uint32_t v = order_[i];
+		part &pt = parts_[part_[v]];
+		if (!pt.closed)
+			continue;
+		const bool red_blue = pt.colours == 0b001;
+		try
+		{
+			if (pile_at_[v] != npos)
+			{
+				const pile &p = piles_[pile_at_[v]];
+				if (p.size and (p.link == npos or !alive_[p.link]))
+				{
+					if (red_blue)
+						above_[v] += stack_value(p.tgen, p.kwargs, p.size);
+					else
+						nim_[v] ^= p.size;
+				}
+			}
+
+			const local_edge &le = edges_[parent_[v]];
+			const uint32_t u = le.p1 == v ? le.p2 : le.p1;
+			if (le.type == invalid and le.p1 != u)
+				throw std::domain_error("the stack hangs from its limit");
+			const pile *p = le.type == invalid ? &piles_[le.pile] : nullptr;
+			if (red_blue)
+			{
+				const surreal above = p ? stack_value(p->tgen, p->kwargs,
+													  p->size, above_[v]) :
+									  graft(le.type, above_[v]);
+				if (u)
+					above_[u] += above;
+				else
+					pt.value += above;
+			}
+			else
+			{
+				if (p and p->size == INF)
+					throw std::domain_error("the stack is worth *ω");
+				const uint64_t above = nim_[v] + (p ? p->size : 1);
+				if (u)
+					nim_[u] ^= above;
+				else
+					pt.nimber ^= above;
+			}
+		}
+		catch (const std::exception &)
+		{
+			pt.closed = false;
+		}
+	}
+
+	for (const part &pt: parts_)
+	{
+		if (!pt.closed)
+		{
+			exact = false;
+			material += pt.material;
+		}
+		else if (pt.colours == 0b001)
+			number += pt.value;
+		else
+			nimber ^= pt.nimber;
+	}
+
+	const int side = player == blue ? 1 : -1;
+	if (!exact)
+	{
+		const double h = std::clamp(magnitude(number) + material,
+									-HEURISTIC_LIMIT, HEURISTIC_LIMIT);
+		score = side * h;
+		return false;
+	}
+
+	// a number decides the game on its own, and a zero number is won by the
+	// player who moves if the nimber is not zero
+	if (!number.sign())
+		score = nimber ? WIN : -WIN;
+	else
+	{
+		const double margin = std::min(std::abs(magnitude(number)), MAX_MARGIN);
+		score = number.sign() == side ? WIN + margin : -(WIN + margin);
+	}
+	return true;
+}
+
+/**
+ * @details a part whose edges are all red, green or blue, and whose nodes hold
+ * no stacks, is valued by its canonical form. An edge between two nodes on the
+ * ground is a part on its own.
+ */
+bool opponent::hottest(branch_type player, choice &best)
+{
+	split();
+	std::vector<uint32_t> grounded;
+	for (uint32_t j = 0; j < edges_.size(); ++j)
+		if (alive_[j] and !edges_[j].p1 and !edges_[j].p2 and
+			edges_[j].type != invalid)
+			grounded.push_back(j);
+	const std::size_t num_parts = parts_.size() + grounded.size();
+	part_edges_.resize(std::max(part_edges_.size(), num_parts));
+	for (std::size_t p = 0; p < parts_.size(); ++p)
+		part_edges_[p].clear();
+	for (std::size_t i = 0; i < grounded.size(); ++i)
+		part_edges_[parts_.size() + i].assign(1, grounded[i]);
+
+	std::vector<uint8_t> valued(num_parts, 1);
+	const auto holds_stack = [this](uint32_t v)
+	{ return v and pile_at_[v] != npos and piles_[pile_at_[v]].size; };
+	for (uint32_t j = 0; j < edges_.size(); ++j)
+	{
+		const local_edge &le = edges_[j];
+		const uint32_t owner = le.p1 ? le.p1 : le.p2;
+		if (!alive_[j] or !owner)
+			continue;
+		const uint32_t p = part_[owner];
+		part_edges_[p].push_back(j);
+		if (le.type == invalid or holds_stack(le.p1) or holds_stack(le.p2))
+			valued[p] = 0;
+	}
+
+	const branch_type other = player == blue ? red : blue;
+	std::optional<dyadic> hottest;
+	uint32_t chosen = npos;
+	for (uint32_t p = 0; p < num_parts; ++p)
+	{
+		const std::vector<uint32_t> &edges = part_edges_[p];
+		if (!valued[p] or edges.size() > MAX_FORM_EDGES or
+			std::none_of(edges.begin(), edges.end(), [&](uint32_t j)
+			{ return edges_[j].type != other; }))
+			continue;
+		try
+		{
+			const dyadic &t = thermographs_.temperature(form_of(edges));
+			if (!hottest or t > *hottest)
+			{
+				hottest = t;
+				chosen = p;
+			}
+		}
+		catch (const std::exception &)
+		{}
+	}
+	if (chosen == npos)
+		return false;
+
+	// the option whose wall is best for the player at the temperature, and
+	// the coldest of those, which leaves the other player the least to gain
+	const std::vector<uint32_t> &edges = part_edges_[chosen];
+	std::optional<std::pair<dyadic, dyadic>> found;
+	for (uint32_t j: edges)
+	{
+		if (edges_[j].type == other)
+			continue;
+		const std::size_t dropped = dropped_.size(), cut = cut_.size();
+		play({j, npos, 0});
+		try
+		{
+			const thermograph &graph = thermographs_(form_of(edges));
+			const std::pair<dyadic, dyadic> score =
+					player == blue ?
+					std::make_pair(graph.right(*hottest), -graph.temperature) :
+					std::make_pair(-graph.left(*hottest), -graph.temperature);
+			if (!found or score > *found)
+			{
+				found = score;
+				best = {j, npos, 0};
+			}
+		}
+		catch (const std::exception &)
+		{}
+		undo(dropped, cut);
+	}
+	return found.has_value();
+}
+
+/**
+ * @details the options of the edges left in the part are found by playing
+ * every move and undoing it, so the edges the move drops are left out of
+ * the option.
+ */
+forms::id_t opponent::form_of(const std::vector<uint32_t> &edges)
+{
+	uint64_t key = 0;
+	bool empty = true;
+	for (uint32_t j: edges)
+	{
+		if (!alive_[j])
+			continue;
+		key ^= edges_[j].key;
+		empty = false;
+	}
+	if (empty)
+		return forms::zero;
+	const auto found = part_forms_.find(key);
+	if (found != part_forms_.end())
+		return found->second;
+
+	std::vector<forms::id_t> left, right;
+	for (uint32_t j: edges)
+	{
+		if (!alive_[j])
+			continue;
+		const branch_type type = edges_[j].type;
+		const std::size_t dropped = dropped_.size(), cut = cut_.size();
+		play({j, npos, 0});
+		forms::id_t option;
+		try
+		{
+			option = form_of(edges);
+		}
+		catch (...)
+		{
+			undo(dropped, cut);
+			throw;
+		}
+		undo(dropped, cut);
+		if (type != red)
+			left.push_back(option);
+		if (type != blue)
+			right.push_back(option);
+	}
+	const forms::id_t g = forms_.make(std::move(left), std::move(right));
+	part_forms_.emplace(key, g);
+	return g;
+}
+
+void opponent::describe(const choice &c, move &m) const
+{
+	m.version = version_;
+	if (c.edge != npos)
+		m.edge = edges_[c.edge].id;
+	else
+	{
+		m.root = piles_[c.pile].root;
+		m.order = c.order;
+	}
+}
+
+void opponent::generate(branch_type player, std::vector<choice> &moves) const
+{
+	moves.clear();
+	const branch_type other = player == blue ? red : blue;
+	for (uint32_t j = 0; j < edges_.size(); ++j)
+		if (alive_[j] and edges_[j].type != invalid and edges_[j].type != other)
+			moves.push_back({j, npos, 0});
+
+	for (uint32_t i = 0; i < piles_.size(); ++i)
+	{
+		const pile &p = piles_[i];
+		if (!p.size)
+			continue;
+		const int64_t low = p.size == INF ? STACK_WINDOW :
+							std::min(p.size, STACK_WINDOW);
+		for (int64_t order = 0; order < low; ++order)
+			if (branch(p, order) != other)
+				moves.push_back({npos, i, order});
+		if (p.size == INF)
+			continue;
+		for (int64_t order = std::max(low, p.size - STACK_WINDOW);
+			 order < p.size; ++order)
+			if (branch(p, order) != other)
+				moves.push_back({npos, i, order});
+	}
+}
+
+void opponent::play(const choice &c)
+{
+	if (c.edge != npos)
+	{
+		alive_[c.edge] = 0;
+		dropped_.push_back(c.edge);
+		drop(edges_[c.edge].p1);
+		drop(edges_[c.edge].p2);
+		return;
+	}
+
+	// chopping a branch keeps the branches below it, and cuts the link
+	pile &p = piles_[c.pile];
+	cut_.emplace_back(c.pile, p.size);
+	p.size = c.order;
+	if (p.link != npos and alive_[p.link])
+	{
+		alive_[p.link] = 0;
+		dropped_.push_back(p.link);
+		drop(edges_[p.link].p2);
+	}
+}
+
+void opponent::undo(std::size_t dropped, std::size_t cut)
+{
+	while (dropped_.size() > dropped)
+	{
+		alive_[dropped_.back()] = 1;
+		dropped_.pop_back();
+	}
+	while (cut_.size() > cut)
+	{
+		piles_[cut_.back().first].size = cut_.back().second;
+		cut_.pop_back();
+	}
+}
+
+void opponent::drop(uint32_t from)
+{
+	if (!from)
+		return;
+
+	// search from the node for the ground, and drop everything reached if it
+	// is not found
+	next_epoch();
+	queue_.assign(1, from);
+	marks_[from] = epoch_;
+	for (std::size_t i = 0; i < queue_.size(); ++i)
+	{
+		const uint32_t v = queue_[i];
+		for (uint32_t a = adj_begin_[v]; a < adj_begin_[v + 1]; ++a)
+		{
+			const half_edge &h = adj_[a];
+			if (!alive_[h.edge] or marks_[h.other] == epoch_)
+				continue;
+			if (!h.other)
+				return;
+			marks_[h.other] = epoch_;
+			queue_.push_back(h.other);
+		}
+	}
+
+	for (uint32_t v: queue_)
+	{
+		for (uint32_t a = adj_begin_[v]; a < adj_begin_[v + 1]; ++a)
+		{
+			if (!alive_[adj_[a].edge])
+				continue;
+			alive_[adj_[a].edge] = 0;
+			dropped_.push_back(adj_[a].edge);
+		}
+		if (pile_at_[v] != npos and piles_[pile_at_[v]].size)
+		{
+			cut_.emplace_back(pile_at_[v], piles_[pile_at_[v]].size);
+			piles_[pile_at_[v]].size = 0;
+		}
+	}
+}
+
+uint32_t &opponent::history(const choice &c)
+{
+	return history_[c.edge != npos ? c.edge : edges_.size() + c.pile];
+}
+
+branch_type opponent::branch(const pile &p, int64_t order) const
+{
+	return p.tgen(order, p.kwargs);
+}
+
+void opponent::next_epoch()
+{
+	if (++epoch_ == 0)
+	{
+		std::fill(marks_.begin(), marks_.end(), 0);
+		epoch_ = 1;
+	}
+}
+
+}
@@ -0,0 +1,334 @@
+/**
+ * @file opponent.hpp
+ * @author Jonah Chen
+ * @brief a computer opponent for the single player mode. It thinks on a thread
+ * of its own, so the render loop never waits for it, and picks the branch to
+ * chop with an iterative deepening alpha-beta search within a time budget,
+ * valuing the positions whose components all have a closed form exactly.
+ * The move in the hottest component is tried first, and is also given as a
+ * hint without searching at all.
+ * @version 1.0
+ * @date 2021-12-08
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#pragma once
+
+#include "prereqs.hpp"
+#include "nodes.hpp"
+#include "world.hpp"
+#include "value.hpp"
+#include "canonical.hpp"
+#include "thermograph.hpp"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace game {
+
+/**
+ * @brief a computer player.
+ *
+ * @details
+ * - think() copies the position of the world into the opponent and wakes its
+ *   worker thread, which searches the copy, so the world can be rendered while
+ *   the opponent thinks. The chosen move is handed back through a single slot
+ *   mailbox guarded by an atomic state, which the render loop checks every
+ *   frame with poll(). Neither thread ever takes a lock.
+ * - The search is a negamax alpha-beta search, deepened one move at a time
+ *   until the budget runs out. The moves at the root are tried in the order of
+ *   their scores in the last iteration, and the other moves by the history
+ *   heuristic. An iteration cut short by the budget still counts once the move
+ *   that was best in the iteration before is searched.
+ * - Every position is first valued like game::evaluator does: red-blue trees
+ *   with their stacks by graft() and stack_value(), and green trees by the
+ *   colon principle. When every component has a closed form, the value is
+ *   exact and decides who wins, and the search stops there. Components with
+ *   cycles or mixed colours are scored by their edges, blue minus red.
+ * - Chopping an edge drops what is no longer held up by searching from the
+ *   ends of the edge, so a move only costs the size of its component, and is
+ *   undone from a journal of the edges dropped and the stacks cut.
+ * - A stack is a pile of branches above its root, and its link holds up the
+ *   node at its limit. Only the lowest and highest STACK_WINDOW branches of a
+ *   stack are tried as moves.
+ * - Before searching, the components of at most MAX_FORM_EDGES edges without
+ *   stacks are valued by their canonical forms, found by playing out their
+ *   positions, and their temperatures by their thermographs. The player moves
+ *   in the hottest component, to the option whose wall is best for them at
+ *   that temperature. Numbers are colder than infinitesimals and nimbers, and
+ *   numbers with larger denominators are hotter, so this avoids numbers and
+ *   plays in the number it changes the least. The forms are kept by the
+ *   zobrist keys of the edges left in the component, and the thermographs by
+ *   the forms, so both are worked out once for the whole game. The move is
+ *   searched first, and is the move played if the budget runs out before the
+ *   first iteration is done.
+ */
+class opponent
+{
+public:
+	static constexpr unsigned DEFAULT_BUDGET_MS = 500;
+
+	// branches at the bottom and at the top of a stack that are tried as moves
+	static constexpr int64_t STACK_WINDOW = 8;
+
+	// deepest iteration of the search
+	static constexpr int MAX_DEPTH = 64;
+
+	// largest component valued by its canonical form to find its temperature
+	static constexpr std::size_t MAX_FORM_EDGES = 12;
+
+	/**
+	 * @brief a branch to chop, which is an edge of the world or a branch of a
+	 * stack, and how it was found.
+	 */
+	struct move
+	{
+		world::id_t edge = world::npos; // edge of the world, or npos
+		world::id_t root = world::npos; // root of the stack of the branch
+		int64_t order = 0; // order of the lower child of the branch
+		uint64_t version = 0; // version of the world the move is for
+
+		int depth = 0; // depth of the last iteration that was searched
+		double score = 0.0; // score for the player who moves
+		uint64_t positions = 0; // positions visited by the search
+	};
+
+	/**
+	 * @brief create an opponent and start its worker thread.
+	 *
+	 * @param budget_ms the time it may think about a move, in milliseconds.
+	 */
+	explicit opponent(unsigned budget_ms = DEFAULT_BUDGET_MS);
+
+	opponent(const opponent &) = delete;
+
+	opponent &operator=(const opponent &) = delete;
+
+	/**
+	 * @brief stop the search in progress and join the worker thread.
+	 */
+	~opponent();
+
+	/**
+	 * @brief start thinking about the move of a player. The position is copied,
+	 * so the world may be read and rendered while the opponent thinks.
+	 *
+	 * @param w the world.
+	 * @param player the player to move, blue or red.
+	 * @return true if the opponent started thinking.
+	 * @return false if it is still thinking about, or holding, another move.
+	 */
+	bool think(const world &w, branch_type player);
+
+	/**
+	 * @brief take the move out of the mailbox, if it is there.
+	 *
+	 * @param m reference to the move, which stores the move found.
+	 * @return true if a move was taken. Its edge is npos and its root is npos
+	 * if the player had no move.
+	 */
+	bool poll(move &m);
+
+	/**
+	 * @brief find the move of a player on the calling thread, without waking
+	 * the worker.
+	 *
+	 * @pre the opponent is not thinking.
+	 */
+	move choose(const world &w, branch_type player);
+
+	/**
+	 * @brief find the move of a player in the hottest component, without
+	 * searching, which takes milliseconds on worlds far too large to search.
+	 *
+	 * @pre the opponent is not thinking.
+	 * @return move the move, with depth 0. When no component could be valued,
+	 * it is the first legal move of the player.
+	 */
+	move hint(const world &w, branch_type player);
+
+	/**
+	 * @brief ask the search in progress to return the best move it has now.
+	 */
+	inline void hurry()
+	{ stop_.store(true, std::memory_order_relaxed); }
+
+	inline bool is_thinking() const
+	{ return state_.load(std::memory_order_acquire) == THINKING; }
+
+	/**
+	 * @pre the opponent is not thinking.
+	 */
+	inline void set_budget(unsigned budget_ms)
+	{ budget_ = std::chrono::milliseconds(budget_ms); }
+
+	/**
+	 * @brief find the edge to give hackenbush::chop for a move.
+	 *
+	 * @details a branch of a stack is generated with its children if it is not
+	 * generated yet.
+	 * @return edge pointer to the edge or branch to chop.
+	 * @return nullptr if the world changed since the move was found, or the
+	 * player had no move.
+	 */
+	static edge *resolve(const world &w, const move &m);
+
+	/**
+	 * @return the time from think() or choose() to each move being taken, in
+	 * milliseconds, in the order the moves were made.
+	 */
+	inline const std::vector<double> &get_latencies() const
+	{ return latencies_; }
+
+	/**
+	 * @brief print the number of moves, the distribution of their latencies
+	 * and the average depth of the search.
+	 */
+	void report(std::ostream &os = std::cout) const;
+
+private:
+	enum : uint32_t
+	{
+		IDLE = 0, THINKING, READY, QUIT
+	};
+
+	// an edge of the copy of the world, with local node ids (0 is the ground)
+	struct local_edge
+	{
+		uint32_t p1, p2;
+		branch_type type; // invalid for the link of a stack
+		uint32_t pile; // the stack of a link, npos otherwise
+		world::id_t id;
+		uint64_t key; // zobrist key of the edge in the world
+	};
+
+	// a stack of the copy of the world
+	struct pile
+	{
+		world::id_t root;
+		uint32_t node; // local id of the root
+		uint32_t link; // local id of the link, npos if it has none
+		nodes::generators::type_gen tgen;
+		void *kwargs;
+		int32_t fraction[2]; // copy of the kwargs of a fraction
+		int64_t size; // branches left, INF if infinite
+	};
+
+	// a move of the search: an edge, or the branch `order` of a pile
+	struct choice
+	{
+		uint32_t edge;
+		uint32_t pile;
+		int64_t order;
+	};
+
+	struct half_edge
+	{
+		uint32_t edge;
+		uint32_t other;
+	};
+
+	using clock = std::chrono::steady_clock;
+
+	// the position being searched
+	std::vector<local_edge> edges_;
+	std::vector<pile> piles_;
+	std::vector<uint32_t> adj_begin_; // offsets into adj_, by local node
+	std::vector<half_edge> adj_;
+	std::vector<uint32_t> pile_at_; // pile rooted at a local node, or npos
+	std::vector<uint32_t> ground_piles_; // piles rooted on the ground
+	std::vector<uint8_t> alive_;
+	branch_type player_ = blue;
+	uint64_t version_ = 0;
+
+	// journal of the moves played: edges dropped, and piles with their sizes
+	// before they were cut
+	std::vector<uint32_t> dropped_;
+	std::vector<std::pair<uint32_t, int64_t>> cut_;
+
+	// a component of a position, with the ground fused into a single vertex
+	struct part
+	{
+		uint32_t nodes, edges;
+		uint8_t colours; // 1 for red or blue, 2 for green, 4 for unknown stacks
+		bool closed; // whether it is a tree with a closed form
+		double material; // blue edges minus red edges
+		surreal value; // value of a red-blue tree
+		uint64_t nimber; // value of a green tree
+	};
+
+	// buffers of the search
+	std::vector<std::vector<choice>> moves_; // legal moves, by ply
+	std::vector<uint32_t> history_; // by edge, then by pile
+	std::vector<uint32_t> marks_; // by local node
+	uint32_t epoch_ = 0;
+	std::vector<uint32_t> queue_; // nodes to visit when dropping
+	std::vector<uint32_t> order_; // breadth first from the ground
+	std::vector<uint32_t> parent_; // edge every node was reached by
+	std::vector<uint32_t> part_; // part of every node
+	std::vector<part> parts_;
+	std::vector<surreal> above_; // value above every node of a red-blue tree
+	std::vector<uint64_t> nim_; // value above every node of a green tree
+	std::vector<uint32_t> local_; // local id of every node, by node id
+	uint64_t positions_ = 0;
+	bool horizon_ = false; // whether a position was scored by its edges
+	std::vector<std::vector<uint32_t>> part_edges_; // by part, for hottest()
+
+	// canonical forms of components by the keys of their edges, and their
+	// thermographs, kept for the whole game
+	forms forms_;
+	thermographs thermographs_{forms_};
+	std::unordered_map<uint64_t, forms::id_t> part_forms_;
+
+	clock::time_point deadline_;
+	clock::duration budget_;
+	std::atomic<bool> stop_{false};
+
+	// the mailbox and the worker
+	std::atomic<uint32_t> state_{IDLE};
+	move result_;
+	clock::time_point asked_;
+	std::vector<double> latencies_;
+	std::vector<int> depths_;
+	std::thread worker_;
+
+	void run();
+
+	void load(const world &w, branch_type player);
+
+	move search();
+
+	double negamax(branch_type player, int depth, int ply, double alpha,
+				   double beta);
+
+	bool evaluate(branch_type player, double &score);
+
+	void split();
+
+	bool hottest(branch_type player, choice &best);
+
+	forms::id_t form_of(const std::vector<uint32_t> &edges);
+
+	void describe(const choice &c, move &m) const;
+
+	void generate(branch_type player, std::vector<choice> &moves) const;
+
+	void play(const choice &c);
+
+	void undo(std::size_t dropped, std::size_t cut);
+
+	void drop(uint32_t from);
+
+	uint32_t &history(const choice &c);
+
+	branch_type branch(const pile &p, int64_t order) const;
+
+	void next_epoch();
+};
+
+}
@@ -0,0 +1,497 @@
+/**
+ * @file partition.cpp
+ * @author Jonah Chen
+ * @brief implement the partition of the world specified in partition.hpp
+ * @version 1.0
+ * @date 2021-12-01
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include "partition.hpp"
+#include "canonical.hpp"
+#include <algorithm>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace game {
+
+partition::partition(transposition_table *table, int threads) :
+		own_table_(table ? nullptr : new transposition_table())
+{
+	if (!table)
+		table = own_table_.get();
+#ifdef _OPENMP
+	if (threads <= 0)
+		threads = omp_get_max_threads();
+#endif
+	threads = std::max(threads, 1);
+	for (int t = 0; t < threads; ++t)
+		evaluators_.emplace_back(new evaluator(table));
+}
+
+void partition::set_tablebase(const tablebase *t)
+{
+	for (auto &e: evaluators_)
+		e->set_tablebase(t);
+}
+
+uint32_t partition::allocate()
+{
+	uint32_t p;
+	if (free_.empty())
+	{
+		p = parts_.size();
+		parts_.emplace_back();
+	}
+	else
+	{
+		p = free_.back();
+		free_.pop_back();
+	}
+	part &pt = parts_[p];
+	pt.nodes.clear();
+	pt.reached_by.clear();
+	pt.edges.clear();
+	pt.value = evaluation();
+	pt.mixed = false;
+	pt.tree = false;
+	pt.pending = false;
+	pt.dropped = 0;
+	fresh_.push_back(p);
+	return p;
+}
+
+void partition::release(uint32_t p)
+{
+	part &pt = parts_[p];
+	if (!pt.pending)
+		add(pt.value, true);
+	pt.pending = false;
+	free_.push_back(p);
+}
+
+void partition::alone(world::id_t root)
+{
+	const uint32_t p = allocate();
+	node_part_[root] = p;
+	parts_[p].nodes.push_back(root);
+	parts_[p].reached_by.push_back(world::npos);
+}
+
+void partition::grow(const world &w, world::id_t first, world::id_t by)
+{
+	const uint32_t p = allocate();
+	part &pt = parts_[p];
+	node_part_[first] = p;
+	pt.nodes.push_back(first);
+	pt.reached_by.push_back(by);
+
+	// everything reached without passing through the ground, collecting
+	// every edge at a reached node once
+	uint8_t colours = 0;
+	for (std::size_t i = 0; i < pt.nodes.size(); ++i)
+	{
+		const world::id_t v = pt.nodes[i];
+		for (auto *h = w.adj_begin(v); h != w.adj_end(v); ++h)
+		{
+			if (edge_part_[h->edge] != p)
+			{
+				edge_part_[h->edge] = p;
+				pt.edges.push_back(h->edge);
+				const branch_type type = w.get_type(h->edge);
+				if (type == green)
+					colours |= 0b10;
+				else if (type == red or type == blue)
+					colours |= 0b01;
+			}
+			if (w.is_grounded(h->other) or node_part_[h->other] == p)
+				continue;
+			node_part_[h->other] = p;
+			pt.nodes.push_back(h->other);
+			pt.reached_by.push_back(h->edge);
+		}
+	}
+	pt.mixed = colours == 0b11;
+}
+
+void partition::forget(uint32_t p, std::vector<world::id_t> &edges)
+{
+	part &pt = parts_[p];
+	for (world::id_t n: pt.nodes)
+		node_part_[n] = none;
+	for (world::id_t x: pt.edges)
+	{
+		edge_part_[x] = none;
+		edges.push_back(x);
+	}
+	release(p);
+}
+
+void partition::regrow(const world &w, const std::vector<world::id_t> &edges)
+{
+	// every edge left is held up, so growing from the edges that touch the
+	// ground finds every piece
+	for (world::id_t x: edges)
+	{
+		if (!w.is_alive(x) or edge_part_[x] != none)
+			continue;
+		const world::id_t p1 = w.get_p1(x), p2 = w.get_p2(x);
+		const bool g1 = w.is_grounded(p1), g2 = w.is_grounded(p2);
+		if (g1 and g2)
+		{
+			edge_part_[x] = allocate();
+			parts_[edge_part_[x]].edges.push_back(x);
+		}
+		else if (g1 or g2)
+			grow(w, g1 ? p2 : p1, x);
+	}
+}
+
+void partition::build(const world &w)
+{
+	parts_.clear();
+	free_.clear();
+	fresh_.clear();
+	pending_.clear();
+	total_ = evaluation();
+	node_part_.assign(w.num_nodes(), none);
+	edge_part_.assign(w.num_edges(), none);
+	hung_by_.assign(w.num_nodes(), world::npos);
+	above_.assign(w.num_nodes(), 0);
+	nim_above_.assign(w.num_nodes(), 0);
+
+	for (world::id_t g = 0; g < w.num_nodes(); ++g)
+	{
+		if (!w.is_present(g) or !w.is_grounded(g))
+			continue;
+
+		// a stack on the ground that is not linked to anything is a component
+		// on its own
+		if (w.get_kind(g) == node_kind::stack_root and
+			w.get_link(g) == world::npos)
+			alone(g);
+
+		for (auto *h = w.adj_begin(g); h != w.adj_end(g); ++h)
+		{
+			if (w.is_grounded(h->other))
+			{
+				// an edge between two nodes on the ground is a component on
+				// its own
+				if (edge_part_[h->edge] == none)
+				{
+					edge_part_[h->edge] = allocate();
+					parts_[edge_part_[h->edge]].edges.push_back(h->edge);
+				}
+			}
+			else if (node_part_[h->other] == none)
+				grow(w, h->other, h->edge);
+		}
+	}
+	revalue(w, fresh_);
+}
+
+void partition::update(const world &w, world::id_t e,
+					   const world::fallout *fallen)
+{
+	if (e >= edge_part_.size() or edge_part_[e] == none or
+		node_part_.size() != w.num_nodes() or
+		edge_part_.size() != w.num_edges())
+	{
+		build(w);
+		return;
+	}
+	if (prune(w, e, fallen))
+		return;
+
+	std::vector<world::id_t> edges;
+	forget(edge_part_[e], edges);
+	fresh_.clear();
+	regrow(w, edges);
+
+	// the stack whose link was cut may be left on the ground on its own
+	const world::id_t n = w.get_p1(e);
+	if (w.get_type(e) == invalid and w.is_present(n) and w.is_grounded(n))
+		alone(n);
+	defer(w);
+}
+
+void partition::restore(const world &w, world::id_t e,
+						const world::fallout &fallen)
+{
+	if (e >= edge_part_.size() or node_part_.size() != w.num_nodes() or
+		edge_part_.size() != w.num_edges())
+	{
+		build(w);
+		return;
+	}
+
+	// the edge joins the components at its ends, which may be a stack on the
+	// ground on its own, and what fell comes back with it
+	std::vector<world::id_t> edges(fallen.edges);
+	edges.push_back(e);
+	for (world::id_t n: {w.get_p1(e), w.get_p2(e)})
+		if (node_part_[n] != none)
+			forget(node_part_[n], edges);
+	fresh_.clear();
+	regrow(w, edges);
+
+	// growing from the edges never reaches the ground, so a stack on the
+	// ground without its link is put back on its own
+	for (world::id_t n: {w.get_p1(e), w.get_p2(e)})
+		if (w.is_present(n) and w.is_grounded(n) and
+			w.get_kind(n) == node_kind::stack_root and
+			w.get_link(n) == world::npos and node_part_[n] == none)
+			alone(n);
+	defer(w);
+}
+
+void partition::restack(const world &w, world::id_t root)
+{
+	if (root >= node_part_.size() or node_part_[root] == none)
+	{
+		build(w);
+		return;
+	}
+	const uint32_t p = node_part_[root];
+	if (!parts_[p].pending)
+		add(parts_[p].value, true);
+	parts_[p].value = evaluation();
+	parts_[p].tree = false;
+	fresh_.assign(1, p);
+	defer(w);
+}
+
+const evaluation &partition::get_value(const world &w)
+{
+	// a part may be listed twice, or freed since, so only the ones still
+	// pending are valued
+	now_.clear();
+	for (uint32_t p: pending_)
+	{
+		if (!parts_[p].pending)
+			continue;
+		parts_[p].pending = false;
+		now_.push_back(p);
+	}
+	pending_.clear();
+	revalue(w, now_);
+	return total_;
+}
+
+// the trees have closed forms and are valued right away, which also lets the
+// next chop in them graft down the chopped path
+void partition::defer(const world &w)
+{
+	now_.clear();
+	for (uint32_t p: fresh_)
+	{
+		part &pt = parts_[p];
+		if (pt.nodes.size() == pt.edges.size() and !pt.mixed)
+		{
+			pt.pending = false;
+			now_.push_back(p);
+		}
+		else
+		{
+			pt.pending = true;
+			pending_.push_back(p);
+		}
+	}
+	revalue(w, now_);
+}
+
+void partition::revalue(const world &w, const std::vector<uint32_t> &parts)
+{
+	// the mixed components are left to the first evaluator, as the canonical
+	// forms of an evaluator are not thread safe
+	const int threads = evaluators_.size();
+#pragma omp parallel for schedule(dynamic) num_threads(threads) \
+        if (threads > 1 and parts.size() > 1)
+	for (std::size_t i = 0; i < parts.size(); ++i)
+	{
+		part &pt = parts_[parts[i]];
+		if (pt.mixed)
+			continue;
+		int t = 0;
+#ifdef _OPENMP
+		t = omp_get_thread_num();
+#endif
+		pt.value = (*evaluators_[t])(w, pt.nodes, pt.reached_by, pt.edges);
+		plant(w, parts[i]);
+	}
+
+	for (uint32_t p: parts)
+	{
+		part &pt = parts_[p];
+		if (pt.mixed)
+			pt.value = (*evaluators_[0])(w, pt.nodes, pt.reached_by, pt.edges);
+		add(pt.value, false);
+	}
+}
+
+void partition::plant(const world &w, uint32_t p)
+{
+	// only the trees valued by their closed form or their nim value, which
+	// have no stacks and lost no edges to an overflow
+	part &pt = parts_[p];
+	pt.tree = pt.nodes.size() == pt.edges.size() and
+			  pt.value.trees + pt.value.green == 1;
+	if (!pt.tree)
+		return;
+
+	const bool green_tree = pt.value.green;
+	for (std::size_t i = 0; i < pt.nodes.size(); ++i)
+	{
+		const world::id_t v = pt.nodes[i];
+		hung_by_[v] = pt.reached_by[i];
+		above_[v] = 0;
+		nim_above_[v] = 0;
+	}
+
+	// like evaluator::tree(), keeping the value above every node
+	for (std::size_t i = pt.nodes.size(); i-- > 1;)
+	{
+		const world::id_t v = pt.nodes[i], e = pt.reached_by[i];
+		const world::id_t below = w.get_p1(e) == v ? w.get_p2(e) : w.get_p1(e);
+		if (green_tree)
+			nim_above_[below] ^= nim_above_[v] + 1;
+		else
+			above_[below] += graft(w.get_type(e), above_[v]);
+	}
+}
+
+bool partition::prune(const world &w, world::id_t e,
+					  const world::fallout *fallen)
+{
+	const uint32_t p = edge_part_[e];
+	part &pt = parts_[p];
+	if (!pt.tree)
+		return false;
+
+	// the node the edge held up, which fell with everything above it
+	const world::id_t p1 = w.get_p1(e), p2 = w.get_p2(e);
+	const bool first = node_part_[p1] == p and hung_by_[p1] == e;
+	const world::id_t upper = first ? p1 : p2, lower = first ? p2 : p1;
+
+	if (fallen)
+	{
+		for (world::id_t n: fallen->nodes)
+			node_part_[n] = none;
+		for (world::id_t x: fallen->edges)
+			edge_part_[x] = none;
+		edge_part_[e] = none;
+		pt.dropped += fallen->nodes.size() + fallen->edges.size() + 1;
+		if (pt.dropped > pt.nodes.size())
+			tidy(p);
+	}
+	else
+	{
+		for (world::id_t n: pt.nodes)
+			if (!w.is_present(n))
+				node_part_[n] = none;
+		for (world::id_t x: pt.edges)
+			if (!w.is_alive(x))
+				edge_part_[x] = none;
+		tidy(p);
+	}
+
+	fresh_.clear();
+	if (w.is_grounded(lower))
+	{
+		// the whole tree fell
+		release(p);
+		return true;
+	}
+	fresh_.push_back(p);
+
+	// graft the new value above every node down to the ground, until one
+	// does not change
+	if (pt.value.green)
+	{
+		uint64_t old_branch = nim_above_[upper] + 1, new_branch = 0;
+		for (world::id_t v = lower; old_branch != new_branch;)
+		{
+			const uint64_t before = nim_above_[v];
+			nim_above_[v] ^= old_branch ^ new_branch;
+			old_branch = before + 1;
+			new_branch = nim_above_[v] + 1;
+			const world::id_t by = hung_by_[v];
+			v = w.get_p1(by) == v ? w.get_p2(by) : w.get_p1(by);
+			if (w.is_grounded(v))
+			{
+				total_.nimber ^= old_branch ^ new_branch;
+				pt.value.nimber = new_branch;
+				break;
+			}
+		}
+		return true;
+	}
+
+	dyadic old_branch = graft(w.get_type(e), above_[upper]), new_branch;
+	for (world::id_t v = lower; old_branch != new_branch;)
+	{
+		const dyadic before = above_[v];
+		above_[v] = above_[v] - old_branch + new_branch;
+		const world::id_t by = hung_by_[v];
+		old_branch = graft(w.get_type(by), before);
+		new_branch = graft(w.get_type(by), above_[v]);
+		v = w.get_p1(by) == v ? w.get_p2(by) : w.get_p1(by);
+		if (w.is_grounded(v))
+		{
+			total_.number = total_.number - old_branch + new_branch;
+			pt.value.number = new_branch;
+			break;
+		}
+	}
+	return true;
+}
+
+void partition::tidy(uint32_t p)
+{
+	part &pt = parts_[p];
+	std::size_t kept = 0;
+	for (std::size_t i = 0; i < pt.nodes.size(); ++i)
+	{
+		if (node_part_[pt.nodes[i]] != p)
+			continue;
+		pt.nodes[kept] = pt.nodes[i];
+		pt.reached_by[kept++] = pt.reached_by[i];
+	}
+	pt.nodes.resize(kept);
+	pt.reached_by.resize(kept);
+	pt.edges.erase(std::remove_if(pt.edges.begin(), pt.edges.end(),
+								  [this, p](world::id_t x)
+								  { return edge_part_[x] != p; }),
+				   pt.edges.end());
+	pt.dropped = 0;
+}
+
+void partition::add(const evaluation &v, bool remove)
+{
+	total_.number = remove ? total_.number - v.number : total_.number + v.number;
+	if (!v.stacks.is_zero())
+		total_.stacks = remove ? total_.stacks - v.stacks : total_.stacks + v.stacks;
+	total_.nimber ^= v.nimber;
+	if (v.form != forms::zero)
+	{
+		forms &f = evaluators_[0]->get_forms();
+		total_.form = f.add(total_.form, remove ? f.neg(v.form) : v.form);
+	}
+
+	const auto count = [remove](std::size_t &total, std::size_t n)
+	{ total = remove ? total - n : total + n; };
+	count(total_.components, v.components);
+	count(total_.trees, v.trees);
+	count(total_.searched, v.searched);
+	count(total_.tabled, v.tabled);
+	count(total_.green, v.green);
+	count(total_.canonical, v.canonical);
+	count(total_.stacked, v.stacked);
+	count(total_.unsupported, v.unsupported);
+	count(total_.infinite, v.infinite);
+}
+
+}
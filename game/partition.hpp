@@ -0,0 +1,217 @@
+/**
+ * @file partition.hpp
+ * @author Jonah Chen
+ * @brief keep the world split into its components, with the ground fused into
+ * a single vertex, and the value of every component cached. The world is the
+ * disjoint sum of its components, so a chop only changes the value of the
+ * component it was made in, and only that component is valued again.
+ * @version 1.0
+ * @date 2021-12-01
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#pragma once
+
+#include "value.hpp"
+#include "transposition.hpp"
+#include <memory>
+#include <vector>
+
+namespace game {
+
+/**
+ * @brief the components of a world and their values, kept up to date as
+ * edges are chopped.
+ *
+ * @details
+ * - build() splits the whole world like game::evaluator does, and values
+ *   every component. The components are valued in parallel, each thread with
+ *   an evaluator of its own, all sharing one transposition table. Mixed
+ *   components are valued afterwards by the first evaluator, whose canonical
+ *   forms hold the sum of all of them.
+ * - update() is called after an edge is cut. The component the edge was in is
+ *   split again from the ground, which finds the pieces it breaks into and
+ *   drops what fell, and only those pieces are valued. The other components
+ *   keep their cached values.
+ * - The pieces that are trees are valued right away, by their closed forms.
+ *   The pieces with cycles or mixed colours may be searched, which can take
+ *   seconds, so they are left pending and valued when get_value() is called.
+ *   A chop made on the render thread never waits for a search.
+ * - Trees are not split again. Every node of a red-blue or green tree keeps
+ *   the value of what hangs above it, a number or a nimber, so a chop takes
+ *   the branch that fell off the node below it and grafts the new values
+ *   down the path to the ground. The walk stops as soon as a value does not
+ *   change, so a chop costs at most the depth of the edge.
+ * - The total value is kept as the sum of the cached values: the value of the
+ *   old component is subtracted and the values of its pieces are added, so
+ *   the cost of a chop does not depend on the number of components.
+ */
+class partition
+{
+public:
+	static constexpr uint32_t none = ~(uint32_t) 0;
+
+	/**
+	 * @brief create an empty partition.
+	 *
+	 * @param table the transposition table shared by the evaluators. When it
+	 * is null, the partition allocates a table of its own.
+	 * @param threads the number of threads valuing components. 0 uses every
+	 * core.
+	 */
+	explicit partition(transposition_table *table = nullptr, int threads = 0);
+
+	partition(const partition &) = delete;
+
+	partition &operator=(const partition &) = delete;
+
+	/**
+	 * @brief split the whole world into components and value all of them.
+	 */
+	void build(const world &w);
+
+	/**
+	 * @brief split and value again the component of an edge that was cut.
+	 *
+	 * @param w the world, after the cut.
+	 * @param e the edge that was cut.
+	 * @param fallen what fell with the edge, as world::cut() reported it. When
+	 * it is null, what fell from a tree is found by looking through the tree.
+	 */
+	void update(const world &w, world::id_t e,
+				const world::fallout *fallen = nullptr);
+
+	/**
+	 * @brief split and value again the components joined by an edge that was
+	 * put back with world::uncut(), along with what fell when it was cut.
+	 *
+	 * @param w the world, after the edge was put back.
+	 * @param e the edge put back.
+	 * @param fallen what fell when the edge was cut.
+	 */
+	void restore(const world &w, world::id_t e, const world::fallout &fallen);
+
+	/**
+	 * @brief value again the component of a stack root after its stack was
+	 * cut, when the cut does not remove an edge from the world because the
+	 * stack has no link left.
+	 */
+	void restack(const world &w, world::id_t root);
+
+	/**
+	 * @brief value the components left pending since the last call, and get
+	 * the value of the world.
+	 *
+	 * @param w the world the partition was built or updated with.
+	 * @return const evaluation& the sum of the values of the components. Its
+	 * form belongs to the forms of get_evaluator().
+	 */
+	const evaluation &get_value(const world &w);
+
+	/**
+	 * @return true if some components are not valued yet.
+	 */
+	inline bool is_pending() const
+	{ return !pending_.empty(); }
+
+	/**
+	 * @return the evaluator that valued the mixed components, to print the
+	 * value or find its outcome class.
+	 */
+	inline evaluator &get_evaluator()
+	{ return *evaluators_[0]; }
+
+	/**
+	 * @brief look the small components up in a tablebase before searching
+	 * them, from the next call to build() or update() on.
+	 */
+	void set_tablebase(const tablebase *t);
+
+	/**
+	 * @return uint32_t the component of a live edge, none if it has none.
+	 */
+	inline uint32_t get_component(world::id_t e) const
+	{ return e < edge_part_.size() ? edge_part_[e] : none; }
+
+	/**
+	 * @return const evaluation& the cached value of a component, which is
+	 * empty while the component is pending.
+	 */
+	inline const evaluation &get_component_value(uint32_t c) const
+	{ return parts_[c].value; }
+
+	/**
+	 * @return const std::vector<world::id_t>& the edges of a component. The
+	 * edges that fell from a tree may still be listed until the tree is
+	 * tidied, and have no component.
+	 */
+	inline const std::vector<world::id_t> &get_component_edges(uint32_t c) const
+	{ return parts_[c].edges; }
+
+	inline std::size_t num_components() const
+	{ return parts_.size() - free_.size(); }
+
+	/**
+	 * @return std::size_t the number of components made by the last call to
+	 * build(), update(), restore() or restack(), counting a tree valued down
+	 * the chopped path, whether they were valued or left pending.
+	 */
+	inline std::size_t get_revalued() const
+	{ return fresh_.size(); }
+
+private:
+	struct part
+	{
+		std::vector<world::id_t> nodes; // breadth first from the ground
+		std::vector<world::id_t> reached_by; // edge each node was reached by
+		std::vector<world::id_t> edges;
+		evaluation value;
+		bool mixed; // whether it mixes green with red or blue edges
+		bool tree; // whether it is valued down the chopped path
+		bool pending; // whether it is left to value in get_value()
+		std::size_t dropped; // fallen nodes and edges still listed
+	};
+
+	std::unique_ptr<transposition_table> own_table_;
+	std::vector<std::unique_ptr<evaluator>> evaluators_; // one per thread
+	std::vector<part> parts_;
+	std::vector<uint32_t> free_; // parts not in use
+	std::vector<uint32_t> node_part_; // part of every node, by node id, and of
+	// every stack on the ground that is a part on its own
+	std::vector<uint32_t> edge_part_; // part of every edge, by edge id
+	std::vector<uint32_t> fresh_; // parts made by the last split
+	std::vector<uint32_t> pending_; // parts left to value, some may be stale
+	std::vector<uint32_t> now_; // parts to value right away
+	std::vector<world::id_t> hung_by_; // edge below every node of a tree
+	std::vector<dyadic> above_; // value above every node of a red-blue tree
+	std::vector<uint64_t> nim_above_; // same, for the green trees
+	evaluation total_;
+
+	uint32_t allocate();
+
+	void release(uint32_t p);
+
+	void alone(world::id_t root);
+
+	void grow(const world &w, world::id_t first, world::id_t by);
+
+	void forget(uint32_t p, std::vector<world::id_t> &edges);
+
+	void regrow(const world &w, const std::vector<world::id_t> &edges);
+
+	void revalue(const world &w, const std::vector<uint32_t> &parts);
+
+	void defer(const world &w);
+
+	void plant(const world &w, uint32_t p);
+
+	bool prune(const world &w, world::id_t e, const world::fallout *fallen);
+
+	void tidy(uint32_t p);
+
+	void add(const evaluation &v, bool remove);
+};
+
+}
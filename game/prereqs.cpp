@@ -2,7 +2,62 @@
 
 namespace game {
 
-node::container node::nodes_discard;
+void traversal::begin()
+{
+	pending_.clear();
+	loose_.clear();
+	if (!++epoch_)
+	{
+		std::fill(marks_.begin(), marks_.end(), 0);
+		epoch_ = 1;
+	}
+}
+
+void traversal::push(node *n)
+{
+	const uint32_t id = n->get_id();
+	if (id == no_id)
+	{
+		if (std::find(loose_.begin(), loose_.end(), n) != loose_.end())
+			return;
+		loose_.push_back(n);
+	}
+	else
+	{
+		if (id >= marks_.size())
+			marks_.resize(std::max<std::size_t>(id + 1, 2 * marks_.size()));
+		if (marks_[id] == epoch_)
+			return;
+		marks_[id] = epoch_;
+	}
+	pending_.push_back(n);
+}
+
+node *traversal::pop()
+{
+	if (pending_.empty())
+		return nullptr;
+	node *n = pending_.back();
+	pending_.pop_back();
+	return n;
+}
+
+// depth first, with the nodes left to visit on the stack of the context
+void node::operator()(container &nodes, const glm::vec3 &bottomleft,
+					  const glm::vec3 &topright, traversal &ctx)
+{
+	ctx.begin();
+	ctx.push(this);
+	while (node *n = ctx.pop())
+		n->visit(nodes, bottomleft, topright, ctx);
+}
+
+void node::operator()(container &nodes, const glm::vec3 &bottomleft,
+					  const glm::vec3 &topright)
+{
+	traversal ctx;
+	(*this)(nodes, bottomleft, topright, ctx);
+}
 
 glm::vec4 branch_color(branch_type branch)
 {
@@ -33,16 +88,45 @@ edge *attach(branch_type type, node *node1, node *node2)
 	return nullptr;
 }
 
+edge *attach(branch_type type, node *node1, node *node2, arena<edge> &edges)
+{
+	edge *e = edges.create(type, node1, node2);
+
+	bool success1 = node1->attach(e);
+	bool success2 = node2->attach(e);
+
+	if (success1)
+		return e;
+
+	if (success2)
+		node2->detach(e);
+
+	edges.destroy(e);
+	return nullptr;
+}
+
 void detach(edge *e)
 {
 	soft_detach(e);
 	delete e;
 }
 
+void detach(edge *e, arena<edge> &edges)
+{
+	soft_detach(e);
+	edges.destroy(e);
+}
+
 void soft_detach(edge *e)
 {
 	e->p1->detach(e);
 	e->p2->detach(e);
 }
 
+void reattach(edge *e)
+{
+	e->p1->attach(e);
+	e->p2->attach(e);
+}
+
 }
\ No newline at end of file
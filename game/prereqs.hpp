@@ -16,18 +16,23 @@
 #pragma once
 
 #include "common/constants.hpp"
+#include "arena.hpp"
 
 #include <iostream>
 #include <vector>
 #include <set>
 #include <unordered_set>
 #include <algorithm>
+#include <limits>
 #include <glm/glm.hpp>
 
 namespace game {
 
 class node; // forward decloration
 
+// id of a node or edge that is not stored in a game::world.
+constexpr uint32_t no_id = std::numeric_limits<uint32_t>::max();
+
 /**
  * @brief types of branches in the game
  * - red:   1
@@ -60,9 +65,10 @@ struct edge
 	node *p1;
 	node *p2;
 	branch_type type;
+	uint32_t id; // dense id of the edge in the world, or no_id.
 
 	edge(branch_type type, node *p1, node *p2)
-			: p1(p1), p2(p2), type(type)
+			: p1(p1), p2(p2), type(type), id(no_id)
 	{}
 
 	edge(const edge &e) = delete;
@@ -74,12 +80,58 @@ struct edge
 };
 
 
+/**
+ * @brief the state of a traversal of the nodes: the nodes left to visit and the
+ * marks of the nodes already visited. Every traversal uses its own context, so
+ * any number of traversals can run at the same time, for example one per
+ * viewport or one per AI worker.
+ *
+ * @details
+ * - Nodes stored in a world are marked in an array indexed by their dense id.
+ *   A node is marked when its entry equals the current epoch, so starting a new
+ *   traversal only increments the epoch.
+ * - The few nodes that are not stored in a world are marked by remembering
+ *   them in a list, which is cleared when the next traversal begins.
+ * - The context keeps its memory between traversals, so reusing one context
+ *   for many queries does not allocate.
+ */
+class traversal
+{
+public:
+	/**
+	 * @brief start a new traversal, so no node is marked.
+	 */
+	void begin();
+
+	/**
+	 * @brief schedule a node to be visited, unless it was already scheduled
+	 * during this traversal.
+	 *
+	 * @param n pointer to the node.
+	 */
+	void push(node *n);
+
+	/**
+	 * @brief take the next node to visit.
+	 *
+	 * @return node* pointer to the node, or nullptr when the traversal is done.
+	 */
+	node *pop();
+
+private:
+	std::vector<node *> pending_;
+	std::vector<uint32_t> marks_;
+	std::vector<const node *> loose_; // marked nodes that are not in a world
+	uint32_t epoch_ = 0;
+};
+
+
 /**
  * @brief the abstract class node describes the any type of node that exists in 
  * this implementation of hackenbush. Instances of this class are must
  * 
- * @implements the call operator to recursively collect other nodes that it 
- * directly or indirectly connects to.
+ * @implements the visit method used by the call operator to collect other
+ * nodes that it directly or indirectly connects to.
  * @implements the render method to collect all the edges it is directly 
  * connected to.
  * @implements the log method to print relevant information about the node.
@@ -120,7 +172,9 @@ public:
 
 	/**
 	 * @brief get the nodes that are contained in the volume specified by two
-	 * diagonally opposite corners.
+	 * diagonally opposite corners, among all the nodes this node directly or
+	 * indirectly connects to. The nodes are visited iteratively, so there is
+	 * no limit on the depth of the graph.
 	 *
 	 * @param nodes: a container where  all the nodes contained in the volume
 	 * will be added to by this method. The nodes then can be used to render
@@ -131,12 +185,33 @@ public:
 	 * @param topright: 3d position the top right corner of the volume.
 	 * @note the bottom right corner is the corner with the largest x, y, and z
 	 * values.
-	 * @param max_depth: 32-bit integer of the maximum number depth to search.
-	 * Defaults to DEFAULT_MAX_DEPTH.
+	 * @param ctx: the traversal context to use. Concurrent traversals must use
+	 * different contexts.
 	 */
-	virtual void operator()(container &nodes, const glm::vec3 &bottomleft,
-							const glm::vec3 &topright,
-							int32_t max_depth = DEFAULT_MAX_DEPTH) = 0;
+	void operator()(container &nodes, const glm::vec3 &bottomleft,
+					const glm::vec3 &topright, traversal &ctx);
+
+	/**
+	 * @brief same as above, using a temporary traversal context.
+	 */
+	void operator()(container &nodes, const glm::vec3 &bottomleft,
+					const glm::vec3 &topright);
+
+
+	/**
+	 * @brief visit this node during a traversal: add it to the nodes if it is
+	 * contained in the volume, and push the nodes it connects to onto the
+	 * traversal context.
+	 *
+	 * @warning this method is not meant to be called explicitly.
+	 *
+	 * @param nodes: container of the nodes contained in the volume.
+	 * @param bottomleft: 3d position of the bottom left corner of the volume.
+	 * @param topright: 3d position the top right corner of the volume.
+	 * @param ctx: the traversal context.
+	 */
+	virtual void visit(container &nodes, const glm::vec3 &bottomleft,
+					   const glm::vec3 &topright, traversal &ctx) = 0;
 
 
 	/**
@@ -205,12 +280,21 @@ public:
 	inline glm::vec3 get_pos() const
 	{ return pos_; }
 
+
+	/**
+	 * @brief return the dense id of the node in the world it is stored in.
+	 *
+	 * @return uint32_t id of the node, or no_id if it is not in a world.
+	 */
+	inline uint32_t get_id() const
+	{ return id_; }
+
+	inline void set_id(uint32_t id)
+	{ id_ = id; }
+
 protected:
 	glm::vec3 pos_; // 3D position of the node.
-
-	static container nodes_discard; // container for nodes that are outside
-	// render volume but marked as 'visited'
-	// by graph traversal.
+	uint32_t id_ = no_id; // dense id of the node in the world.
 };
 
 /**
@@ -228,6 +312,19 @@ protected:
  */
 edge *attach(branch_type type, node *node1, node *node2);
 
+/**
+ * @brief attach the two nodes to each other via an edge allocated in an arena,
+ * and return a pointer to the edge.
+ *
+ * @param type the type of the edge connecting the two nodes.
+ * @param node1 the first node to attach.
+ * @param node2 the second node to attach.
+ * @param edges the arena to allocate the edge in.
+ *
+ * @return edge pointer to the edge between the two nodes, owned by the arena.
+ */
+edge *attach(branch_type type, node *node1, node *node2, arena<edge> &edges);
+
 
 /**
  * @brief detach a edge from each node it is connected to, and deallocate the 
@@ -239,6 +336,15 @@ edge *attach(branch_type type, node *node1, node *node2);
  */
 void detach(edge *e);
 
+/**
+ * @brief detach a edge from each node it is connected to, and give the memory
+ * used by the edge back to the arena it was allocated in.
+ *
+ * @param e a pointer to the edge to be detached.
+ * @param edges the arena the edge was allocated in.
+ */
+void detach(edge *e, arena<edge> &edges);
+
 
 /**
  * @brief detach a edge from each node it is connected to, but do NOT deallocate
@@ -250,6 +356,13 @@ void detach(edge *e);
  */
 void soft_detach(edge *e);
 
+/**
+ * @brief attach an edge taken off with soft_detach to its nodes again.
+ *
+ * @param e a pointer to the edge to be attached again.
+ */
+void reattach(edge *e);
+
 
 struct properties
 {
@@ -0,0 +1,306 @@
+/**
+ * @file solver.cpp
+ * @author Jonah Chen
+ * @brief implement the parallel solver specified in solver.hpp
+ * @version 1.0
+ * @date 2021-11-29
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include "solver.hpp"
+#include "common/hash.hpp"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace game {
+
+// keys of the parts of a position that are not edges
+static constexpr uint64_t HEAP_SALT = 0x6a09e667f3bcc908ull;
+static constexpr uint64_t LEFT_SALT = 0xbb67ae8584caa73bull;
+static constexpr uint64_t RIGHT_SALT = 0x3c6ef372fe94f82bull;
+
+// the number of edges on a board, and the lowest of them
+static inline int count(uint64_t b)
+{
+	return __builtin_popcountll(b);
+}
+
+static inline int count(unsigned __int128 b)
+{
+	return count((uint64_t) b) + count((uint64_t) (b >> 64));
+}
+
+static inline uint32_t lowest(uint64_t b)
+{
+	return __builtin_ctzll(b);
+}
+
+static inline uint32_t lowest(unsigned __int128 b)
+{
+	return (uint64_t) b ? lowest((uint64_t) b) :
+		   64 + lowest((uint64_t) (b >> 64));
+}
+
+solver::solver(transposition_table *table, int threads) :
+		own_table_(table ? nullptr : new transposition_table()),
+		table_(table ? table : own_table_.get()), evaluate_(table_),
+		threads_(threads)
+{
+	// the search plays in the mixed components, so they are left to it
+	evaluate_.set_canonical_edges(0);
+}
+
+solution solver::operator()(const world &w)
+{
+	solution result;
+	result.exact = evaluate_(w);
+	if (result.exact.exact())
+	{
+		result.result = evaluate_.outcome_of(result.exact);
+		result.solved = true;
+		return result;
+	}
+
+	// an infinite number outweighs the finite components left to search
+	const surreal &stacks = result.exact.stacks;
+	if (stacks.is_infinite())
+	{
+		result.result = stacks.sign() > 0 ? outcome::left : outcome::right;
+		result.solved = true;
+		return result;
+	}
+
+	const std::vector<world::id_t> &edges = evaluate_.get_unsupported();
+	if (result.exact.infinite or !stacks.is_dyadic() or
+		edges.size() > MAX_EDGES or result.exact.nimber > MAX_HEAP)
+		return result;
+
+	localize(w, edges);
+	int threads = threads_;
+#ifdef _OPENMP
+	if (threads <= 0)
+		threads = omp_get_max_threads();
+#endif
+	team_ = std::max(threads, 1);
+
+	// the narrow board does the work of most searches in half the words
+	positions_.store(0, std::memory_order_relaxed);
+	bool left_first = false, right_first = false;
+	if (edges.size() <= 64)
+		search<uint64_t>(result, left_first, right_first);
+	else
+		search<wide>(result, left_first, right_first);
+
+	if (left_first)
+		result.result = right_first ? outcome::next : outcome::left;
+	else
+		result.result = right_first ? outcome::right : outcome::previous;
+	result.solved = true;
+	result.searched_edges = edges.size();
+	result.positions = positions_.load(std::memory_order_relaxed);
+	return result;
+}
+
+void solver::localize(const world &w, const std::vector<world::id_t> &edges)
+{
+	local_.assign(w.num_nodes(), no_id);
+	uint32_t num_nodes = 1;
+	const auto local_id = [&](world::id_t n)
+	{
+		if (w.is_grounded(n))
+			return (uint32_t) 0;
+		if (local_[n] == no_id)
+			local_[n] = num_nodes++;
+		return local_[n];
+	};
+
+	edges_.resize(edges.size());
+	keys_.resize(edges.size());
+	for (std::size_t j = 0; j < edges.size(); ++j)
+	{
+		edges_[j] = {local_id(w.get_p1(edges[j])), local_id(w.get_p2(edges[j])),
+					 w.get_type(edges[j])};
+		keys_[j] = w.get_key(edges[j]);
+	}
+
+	incident_.assign(num_nodes, 0);
+	for (std::size_t j = 0; j < edges_.size(); ++j)
+	{
+		incident_[edges_[j].p1] |= (wide) 1 << j;
+		incident_[edges_[j].p2] |= (wide) 1 << j;
+	}
+
+	// the ground is left out of the masks, so a flood only crosses the nodes
+	// in the air
+	ground_ = incident_[0];
+	touching_.resize(edges_.size());
+	for (std::size_t j = 0; j < edges_.size(); ++j)
+	{
+		const local_edge &le = edges_[j];
+		touching_[j] = (le.p1 ? incident_[le.p1] : 0) |
+					   (le.p2 ? incident_[le.p2] : 0);
+	}
+}
+
+template <typename board>
+void solver::search(const solution &result, bool &left_first,
+					 bool &right_first)
+{
+	const std::size_t n = edges_.size();
+	state<board> root{n == sizeof(board) * 8 ? ~(board) 0 :
+					  ((board) 1 << n) - 1, 0, result.exact.nimber,
+					  result.exact.number + result.exact.stacks.get_real()};
+	for (uint64_t key: keys_)
+		root.key ^= key;
+
+#pragma omp parallel num_threads(team_)
+#pragma omp single
+	{
+#pragma omp task shared(left_first, root)
+		left_first = wins(root, blue, 0);
+#pragma omp task shared(right_first, root)
+		right_first = wins(root, red, 0);
+#pragma omp taskwait
+	}
+}
+
+template <typename board>
+board solver::grounded(board alive) const
+{
+	// every wave holds the edges first reached from the wave before it
+	board kept = (board) ground_ & alive;
+	for (board wave = kept; wave;)
+	{
+		board reach = 0;
+		for (board rest = wave; rest; rest &= rest - 1)
+			reach |= (board) touching_[lowest(rest)];
+		wave = reach & alive & ~kept;
+		kept |= wave;
+	}
+	return kept;
+}
+
+/**
+ * @details the moves are numbered: [0, MAX_EDGES) chop the edge with that
+ * local id, [MAX_EDGES, MAX_EDGES + heap) take the heap down to
+ * i - MAX_EDGES, and MAX_EDGES + heap moves in the number.
+ */
+template <typename board>
+bool solver::move(const state<board> &s, branch_type player, uint32_t i,
+				  state<board> &after) const
+{
+	after = s;
+	if (i < MAX_EDGES)
+	{
+		const board bit = (board) 1 << i;
+		const branch_type type = edges_[i].type;
+		if (!(s.alive & bit) or type == (player == blue ? red : blue))
+			return false;
+
+		// the key loses the chopped edge and every edge that falls with it
+		after.alive = grounded(s.alive & ~bit);
+		for (board gone = s.alive ^ after.alive; gone; gone &= gone - 1)
+			after.key ^= keys_[lowest(gone)];
+		return true;
+	}
+	if (i < MAX_EDGES + s.heap)
+	{
+		after.heap = i - MAX_EDGES;
+		return true;
+	}
+
+	// the canonical options of an integer n are n - 1 for Left when n > 0,
+	// and n + 1 for Right when n < 0. Those of m / 2^k are m / 2^k -+ 2^-k.
+	const dyadic step = dyadic(1).ldexp(-(int64_t) s.number.exp());
+	if (s.number.is_integer() and s.number.sign() != (player == blue ? 1 : -1))
+		return false;
+	after.number = player == blue ? s.number - step : s.number + step;
+	return true;
+}
+
+template <typename board>
+bool solver::wins(const state<board> &s, branch_type player, int depth)
+{
+	positions_.fetch_add(1, std::memory_order_relaxed);
+	const bool left = player == blue;
+	const branch_type opponent = left ? red : blue;
+
+	// the opponent can make at most one move per edge and per token of the
+	// heap, so a number larger than that wins on its own
+	const int64_t moves = count(s.alive) + (int64_t) s.heap;
+	if (s.number > moves)
+		return left;
+	if (s.number < -moves)
+		return !left;
+	if (!s.alive)
+	{
+		if (s.number.sign())
+			return (s.number.sign() > 0) == left;
+		return s.heap != 0;
+	}
+
+	const uint64_t key = s.key ^ hashing::mix(s.heap ^ HEAP_SALT) ^
+						 s.number.hash() ^ (left ? LEFT_SALT : RIGHT_SALT);
+	dyadic cached;
+	if (table_->probe(key, cached))
+		return cached == 1;
+
+	uint32_t legal[MAX_EDGES + MAX_HEAP + 1];
+	uint32_t num_legal = 0;
+	for (board rest = s.alive; rest; rest &= rest - 1)
+	{
+		const uint32_t i = lowest(rest);
+		if (edges_[i].type != opponent)
+			legal[num_legal++] = i;
+	}
+	for (uint32_t i = MAX_EDGES; i < MAX_EDGES + s.heap; ++i)
+		legal[num_legal++] = i;
+	legal[num_legal++] = MAX_EDGES + s.heap;
+
+	// young brothers wait: the eldest move is searched on its own, and its
+	// brothers only when it does not win
+	state<board> after;
+	bool won = false;
+	uint32_t m = 0;
+	for (; m < num_legal; ++m)
+	{
+		if (move(s, player, legal[m], after))
+		{
+			won = !wins(after, opponent, depth + 1);
+			++m;
+			break;
+		}
+	}
+
+	if (!won and m < num_legal and depth < SPLIT_DEPTH and team_ > 1)
+	{
+		std::atomic<bool> found{false};
+		for (; m < num_legal; ++m)
+		{
+#pragma omp task shared(found, s, legal) firstprivate(m)
+			{
+				state<board> brother;
+				if (!found.load(std::memory_order_relaxed) and
+					move(s, player, legal[m], brother) and
+					!wins(brother, opponent, depth + 1))
+					found.store(true, std::memory_order_relaxed);
+			}
+		}
+#pragma omp taskwait
+		won = found.load(std::memory_order_relaxed);
+	}
+	else
+	{
+		for (; m < num_legal and !won; ++m)
+			if (move(s, player, legal[m], after))
+				won = !wins(after, opponent, depth + 1);
+	}
+
+	table_->store(key, dyadic(won ? 1 : 0), count(s.alive));
+	return won;
+}
+
+}
@@ -0,0 +1,165 @@
+/**
+ * @file solver.hpp
+ * @author Jonah Chen
+ * @brief find who wins a world that can not be valued exactly. Components that
+ * mix green with red or blue edges are not numbers or nimbers, and have no
+ * closed form, so the solver searches the game tree of all of them together,
+ * in parallel, on top of the exact value of the rest of the world.
+ * @version 1.0
+ * @date 2021-11-29
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#pragma once
+
+#include "value.hpp"
+#include "canonical.hpp"
+#include "transposition.hpp"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace game {
+
+/**
+ * @brief the result of solving a world.
+ */
+struct solution
+{
+	// who wins the world, valid when solved is true.
+	outcome result = outcome::previous;
+
+	// false if the world has stacks that are not numbers, infinite stacks of
+	// fractions next to components to search, or too many edges to search.
+	bool solved = false;
+
+	// the value of the components that were valued exactly.
+	evaluation exact;
+
+	// number of edges in the components that were searched.
+	std::size_t searched_edges = 0;
+
+	// number of positions visited by the search.
+	uint64_t positions = 0;
+};
+
+/**
+ * @brief solves the outcome class of a world.
+ *
+ * @details
+ * - The world is first evaluated with game::evaluator. The components it can
+ *   not value, and every mixed component, are searched together as one
+ *   position, with the exact number x and nimber *n of the other components
+ *   added to it.
+ * - The nimber is searched as a heap of nim, and the number by its canonical
+ *   options, x - 2^-k and x + 2^-k for x = m / 2^k. A player can make at most
+ *   one move per edge and one per token of the heap, so when |x| is more than
+ *   that, the sign of x decides the game without searching. An infinite
+ *   number from the stacks of the world decides it the same way.
+ * - Positions are bitboards of the edges left, in 64 bits when at most 64
+ *   edges are searched and in 128 bits otherwise. Every edge has a mask of
+ *   the edges sharing an end with it off the ground, so the edges still held
+ *   up after a chop are found by flooding the masks out from the ground, a
+ *   word at a time.
+ * - Whether the player to move wins is stored in the transposition table, as
+ *   the value 1 or 0, under the zobrist key of the edges left XOR the keys of
+ *   the heap, the number and the player. These keys never meet the keys of
+ *   the positions valued by the evaluator.
+ * - The search is parallel with young brothers wait: at the first
+ *   SPLIT_DEPTH levels, the first move is searched alone, and only when it
+ *   does not win are the other moves searched as OpenMP tasks, which idle
+ *   threads steal. The threads share the transposition table.
+ */
+class solver
+{
+public:
+	// edges that can be searched, as positions are sets of edges in 128 bits
+	static constexpr std::size_t MAX_EDGES = 128;
+
+	// largest nimber that is searched as a heap
+	static constexpr uint64_t MAX_HEAP = 64;
+
+	// number of levels of the tree whose moves are searched in parallel
+	static constexpr int SPLIT_DEPTH = 2;
+
+	/**
+	 * @brief create a solver.
+	 *
+	 * @param table the transposition table used by the search and by the
+	 * evaluator. When it is null, the solver allocates a table of its own.
+	 * @param threads the number of threads of the search. 0 uses every core.
+	 */
+	explicit solver(transposition_table *table = nullptr, int threads = 0);
+
+	solver(const solver &) = delete;
+
+	solver &operator=(const solver &) = delete;
+
+	/**
+	 * @brief solve the world.
+	 *
+	 * @param w the world.
+	 * @return solution who wins the world, and how it was found.
+	 */
+	solution operator()(const world &w);
+
+	inline void set_threads(int threads)
+	{ threads_ = threads; }
+
+	inline void set_tablebase(const tablebase *t)
+	{ evaluate_.set_tablebase(t); }
+
+private:
+	using wide = unsigned __int128;
+
+	// a position of the search, with the edges left in a board of 64 or 128
+	// bits
+	template <typename board>
+	struct state
+	{
+		board alive; // local edges left
+		uint64_t key; // zobrist key of the edges left
+		uint64_t heap; // size of the nim heap
+		dyadic number;
+	};
+
+	struct local_edge
+	{
+		uint32_t p1, p2;
+		branch_type type;
+	};
+
+	std::unique_ptr<transposition_table> own_table_;
+	transposition_table *table_;
+	evaluator evaluate_;
+	int threads_;
+	int team_ = 1; // threads of the search in progress
+
+	// the edges searched, with local node ids (0 is the ground)
+	std::vector<local_edge> edges_;
+	std::vector<wide> incident_; // edges at every local node
+	std::vector<wide> touching_; // edges sharing a node off the ground
+	wide ground_ = 0; // edges at the ground
+	std::vector<uint64_t> keys_; // zobrist key of every local edge
+	std::vector<uint32_t> local_; // local id of every node, by node id
+	std::atomic<uint64_t> positions_{0};
+
+	void localize(const world &w, const std::vector<world::id_t> &edges);
+
+	template <typename board>
+	void search(const solution &result, bool &left_first, bool &right_first);
+
+	template <typename board>
+	board grounded(board alive) const;
+
+	template <typename board>
+	bool move(const state<board> &s, branch_type player, uint32_t i,
+			  state<board> &after) const;
+
+	template <typename board>
+	bool wins(const state<board> &s, branch_type player, int depth);
+};
+
+}
@@ -0,0 +1,285 @@
+/**
+ * @file tablebase.cpp
+ * @author Jonah Chen
+ * @brief implement the memory mapped table specified in tablebase.hpp
+ * @version 1.0
+ * @date 2021-12-09
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include "tablebase.hpp"
+#include "common/hash.hpp"
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace game {
+
+// colour of the ground in the refinement, which no other node starts with
+static constexpr uint64_t GROUND = 0x510e527fade682d1ull;
+
+tablebase::tablebase(const char *filename)
+{
+	const int fd = open(filename, O_RDONLY);
+	if (fd < 0)
+		throw std::runtime_error(std::string("can not open ") + filename);
+	struct stat st;
+	if (fstat(fd, &st) != 0 or st.st_size < (off_t) sizeof(header))
+	{
+		close(fd);
+		throw std::runtime_error(std::string(filename) + " is not a table");
+	}
+
+	void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		throw std::runtime_error(std::string("can not map ") + filename);
+	data_ = (const uint8_t *) data;
+	bytes_ = st.st_size;
+
+	header_ = (const header *) data_;
+	const std::size_t expected = sizeof(header) +
+								 displacements_bytes(header_->num_buckets) +
+								 header_->num_slots * sizeof(slot);
+	if (!std::equal(MAGIC, MAGIC + 8, header_->magic) or
+		header_->version != VERSION or !header_->num_buckets or
+		!header_->num_slots or bytes_ != expected)
+	{
+		munmap(data, bytes_);
+		throw std::runtime_error(std::string(filename) + " is not a table");
+	}
+	displacements_ = (const uint32_t *) (data_ + sizeof(header));
+	slots_ = (const slot *) (data_ + sizeof(header) +
+							 displacements_bytes(header_->num_buckets));
+}
+
+tablebase::~tablebase()
+{
+	munmap((void *) data_, bytes_);
+}
+
+bool tablebase::probe(const edge *edges, std::size_t n, dyadic &value) const
+{
+	if (n > header_->max_edges)
+		return false;
+	const code_t code = canonical(edges, n);
+	return code and probe(code, value);
+}
+
+bool tablebase::probe(code_t code, dyadic &value) const
+{
+	const uint64_t h = hash(code);
+	const slot &s = slots_[place(h, displacements_[h % header_->num_buckets],
+								 header_->num_slots)];
+	if (s.low != (uint64_t) code or s.high != (uint64_t) (code >> 64))
+		return false;
+	value = dyadic::fraction(s.num, s.exp);
+	return true;
+}
+
+/**
+ * @details the nodes are coloured by the colours of their edges and of their
+ * neighbours, until the number of colours stops growing. The colours depend on
+ * nothing but the shape of the component, so sorting the nodes by colour gives
+ * the same order in any numbering, up to the nodes of the same colour, which
+ * are tried in every order.
+ */
+tablebase::code_t tablebase::canonical(const edge *edges, std::size_t n)
+{
+	if (!n or n > MAX_EDGES)
+		return 0;
+	uint32_t k = 0;
+	for (std::size_t j = 0; j < n; ++j)
+	{
+		const edge &e = edges[j];
+		if (e.p1 == e.p2 or e.p1 > MAX_NODES or e.p2 > MAX_NODES or
+			(e.type != blue and e.type != red))
+			return 0;
+		k = std::max({k, e.p1, e.p2});
+	}
+
+	uint64_t colour[MAX_NODES + 1] = {GROUND}, next[MAX_NODES + 1];
+	uint32_t classes = 1;
+	for (uint32_t round = 0; round < k; ++round)
+	{
+		for (uint32_t v = 0; v <= k; ++v)
+			next[v] = hashing::mix(colour[v]);
+		for (std::size_t j = 0; j < n; ++j)
+		{
+			const edge &e = edges[j];
+			const uint64_t b = e.type == blue;
+			next[e.p1] += hashing::mix(colour[e.p2] * 2 + b);
+			next[e.p2] += hashing::mix(colour[e.p1] * 2 + b);
+		}
+		next[0] = GROUND;
+
+		uint64_t sorted[MAX_NODES];
+		std::copy(next + 1, next + k + 1, sorted);
+		std::sort(sorted, sorted + k);
+		const uint32_t found = std::unique(sorted, sorted + k) - sorted;
+		if (found <= classes)
+			break;
+		classes = found;
+		std::copy(next, next + k + 1, colour);
+	}
+
+	// the nodes by colour, in cells of the same colour
+	uint32_t order[MAX_NODES], cells[MAX_NODES + 1];
+	for (uint32_t i = 0; i < k; ++i)
+		order[i] = i + 1;
+	std::sort(order, order + k, [&colour](uint32_t a, uint32_t b)
+	{ return colour[a] != colour[b] ? colour[a] < colour[b] : a < b; });
+	uint32_t num_cells = 0;
+	uint64_t labelings = 1;
+	for (uint32_t i = 0; i < k; ++i)
+	{
+		if (i == 0 or colour[order[i]] != colour[order[i - 1]])
+			cells[num_cells++] = i;
+		labelings *= i - cells[num_cells - 1] + 1;
+		if (labelings > MAX_LABELINGS)
+			return 0;
+	}
+	cells[num_cells] = k;
+
+	code_t best = 0;
+	uint32_t label[MAX_NODES + 1] = {0};
+	uint32_t packed[MAX_EDGES];
+	for (;;)
+	{
+		for (uint32_t i = 0; i < k; ++i)
+			label[order[i]] = i + 1;
+		for (std::size_t j = 0; j < n; ++j)
+		{
+			const uint32_t a = label[edges[j].p1], b = label[edges[j].p2];
+			packed[j] = std::min(a, b) << 5 | std::max(a, b) << 1 |
+						(edges[j].type == blue);
+		}
+		std::sort(packed, packed + n);
+		code_t code = (code_t) n << 120;
+		for (std::size_t j = 0; j < n; ++j)
+			code |= (code_t) packed[j] << (9 * (n - 1 - j));
+		if (!best or code < best)
+			best = code;
+
+		// the next order of the nodes of the same colour, like an odometer
+		uint32_t c = 0;
+		while (c < num_cells and
+			   !std::next_permutation(order + cells[c], order + cells[c + 1]))
+			++c;
+		if (c == num_cells)
+			break;
+	}
+	return best;
+}
+
+std::size_t tablebase::decode(code_t code, edge *edges)
+{
+	const std::size_t n = (std::size_t) (code >> 120);
+	for (std::size_t j = 0; j < n; ++j)
+	{
+		const uint32_t packed = (uint32_t) (code >> (9 * (n - 1 - j))) & 511;
+		edges[j] = {packed >> 5, packed >> 1 & 15, packed & 1 ? blue : red};
+	}
+	return n;
+}
+
+void tablebase::write(const char *filename, const std::vector<entry> &entries,
+					  uint32_t max_edges)
+{
+	header h{};
+	std::copy(MAGIC, MAGIC + 8, h.magic);
+	h.version = VERSION;
+	h.max_edges = max_edges;
+	h.num_entries = entries.size();
+	h.num_buckets = std::max<uint64_t>(1, entries.size() / BUCKET_LOAD);
+	h.num_slots = std::max<uint64_t>(1, entries.size() + entries.size() / 8);
+
+	// the largest buckets are placed first, while most slots are free
+	std::vector<uint64_t> hashes(entries.size());
+	std::vector<std::vector<uint32_t>> buckets(h.num_buckets);
+	for (uint32_t i = 0; i < entries.size(); ++i)
+	{
+		hashes[i] = hash(entries[i].code);
+		buckets[hashes[i] % h.num_buckets].push_back(i);
+	}
+	std::vector<uint32_t> by_size(h.num_buckets);
+	for (uint32_t b = 0; b < h.num_buckets; ++b)
+		by_size[b] = b;
+	std::stable_sort(by_size.begin(), by_size.end(), [&buckets](uint32_t a,
+																uint32_t b)
+	{ return buckets[a].size() > buckets[b].size(); });
+
+	std::vector<uint32_t> displacements(h.num_buckets, 0);
+	std::vector<slot> slots(h.num_slots, slot{0, 0, 0, 0, 0});
+	std::vector<uint8_t> taken(h.num_slots, 0);
+	std::vector<uint64_t> places;
+	for (uint32_t b: by_size)
+	{
+		if (buckets[b].empty())
+			break;
+		for (uint32_t d = 0;; ++d)
+		{
+			if (d == UINT32_MAX)
+				throw std::runtime_error("the perfect hash can not be built");
+			places.clear();
+			for (uint32_t i: buckets[b])
+			{
+				const uint64_t s = place(hashes[i], d, h.num_slots);
+				if (taken[s] or
+					std::find(places.begin(), places.end(), s) != places.end())
+					break;
+				places.push_back(s);
+			}
+			if (places.size() != buckets[b].size())
+				continue;
+
+			displacements[b] = d;
+			for (std::size_t j = 0; j < places.size(); ++j)
+			{
+				const entry &e = entries[buckets[b][j]];
+				if (!e.value.is_narrow())
+					throw std::runtime_error("the value is too large to store");
+				taken[places[j]] = 1;
+				slots[places[j]] = {(uint64_t) e.code, (uint64_t) (e.code >> 64),
+									e.value.num(), e.value.exp(), 0};
+			}
+			break;
+		}
+	}
+
+	std::ofstream file(filename, std::ios::binary);
+	if (!file)
+		throw std::runtime_error(std::string("can not write ") + filename);
+	displacements.resize(displacements_bytes(h.num_buckets) / sizeof(uint32_t));
+	file.write((const char *) &h, sizeof(h));
+	file.write((const char *) displacements.data(),
+			   displacements.size() * sizeof(uint32_t));
+	file.write((const char *) slots.data(), slots.size() * sizeof(slot));
+	if (!file)
+		throw std::runtime_error(std::string("can not write ") + filename);
+}
+
+uint64_t tablebase::hash(code_t code)
+{
+	return hashing::mix((uint64_t) code ^ hashing::mix((uint64_t) (code >> 64)));
+}
+
+uint64_t tablebase::place(uint64_t h, uint32_t displacement, uint64_t slots)
+{
+	return hashing::mix(h + displacement * 0x9e3779b97f4a7c15ull) % slots;
+}
+
+std::size_t tablebase::displacements_bytes(uint64_t buckets)
+{
+	// the slots start on a cache line
+	return (buckets * sizeof(uint32_t) + 63) / 64 * 64;
+}
+
+}
@@ -0,0 +1,172 @@
+/**
+ * @file tablebase.hpp
+ * @author Jonah Chen
+ * @brief a table of the values of every small red-blue component with cycles,
+ * built offline by worldgen/tablebase.cxx and memory mapped at runtime, so the
+ * evaluator looks a component up instead of searching it. Components are
+ * keyed by a canonical code that does not depend on how their nodes are
+ * numbered, so the same component is found in any world.
+ * @version 1.0
+ * @date 2021-12-09
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#pragma once
+
+#include "prereqs.hpp"
+#include "value.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace game {
+
+/**
+ * @brief a read only table of component values in a memory mapped file.
+ *
+ * @details
+ * - A component is given as its edges, with the ground as node 0 and the
+ *   other nodes numbered from 1. Its canonical code is the smallest packing
+ *   of its sorted edges over every numbering of its nodes that keeps them in
+ *   the order of their colour refinement, which is found from the colours of
+ *   the edges and the neighbours of every node alone. Nodes the refinement
+ *   can not tell apart are tried in every order, so components with more than
+ *   MAX_LABELINGS such orders have no code.
+ * - An edge packs into 9 bits, its two nodes in 4 bits each and its colour in
+ *   one, and a code packs at most MAX_EDGES of them with their number on top,
+ *   in 128 bits.
+ * - The file is a header, the displacements of a perfect hash and the slots.
+ *   A code is hashed to a bucket, whose displacement moves every code of the
+ *   bucket to a slot of its own, so a lookup reads one displacement and one
+ *   slot, straight from the mapped pages. The slot holds the code, so codes
+ *   not in the table are told apart from the one found in their slot.
+ */
+class tablebase
+{
+public:
+	// largest component, in edges, that has a code
+	static constexpr uint32_t MAX_EDGES = 12;
+
+	// largest node id that fits in a code
+	static constexpr uint32_t MAX_NODES = 15;
+
+	// most numberings tried to find a code
+	static constexpr uint64_t MAX_LABELINGS = 40320;
+
+	using code_t = unsigned __int128;
+
+	struct edge
+	{
+		uint32_t p1, p2;
+		branch_type type;
+	};
+
+	struct entry
+	{
+		code_t code;
+		dyadic value;
+	};
+
+	/**
+	 * @brief map a table into memory.
+	 *
+	 * @param filename the file written by write().
+	 * @throw std::runtime_error if the file can not be mapped or is not a
+	 * table.
+	 */
+	explicit tablebase(const char *filename);
+
+	tablebase(const tablebase &) = delete;
+
+	tablebase &operator=(const tablebase &) = delete;
+
+	~tablebase();
+
+	/**
+	 * @brief look up the value of a component.
+	 *
+	 * @param edges the red and blue edges of the component.
+	 * @param n the number of edges.
+	 * @param value set to the value of the component if it is found.
+	 * @return true if the component is found.
+	 */
+	bool probe(const edge *edges, std::size_t n, dyadic &value) const;
+
+	/**
+	 * @brief look up the value of a component by its canonical code.
+	 */
+	bool probe(code_t code, dyadic &value) const;
+
+	inline uint32_t max_edges() const
+	{ return header_->max_edges; }
+
+	inline std::size_t size() const
+	{ return header_->num_entries; }
+
+	inline std::size_t bytes() const
+	{ return bytes_; }
+
+	/**
+	 * @return code_t the canonical code of a component, 0 if it has none.
+	 */
+	static code_t canonical(const edge *edges, std::size_t n);
+
+	/**
+	 * @brief the edges of a canonical code, numbered like the code.
+	 *
+	 * @return std::size_t the number of edges.
+	 */
+	static std::size_t decode(code_t code, edge *edges);
+
+	/**
+	 * @brief build the perfect hash of the entries and write the table.
+	 *
+	 * @param filename the file to write.
+	 * @param entries the codes and their values, every code once.
+	 * @param max_edges the largest component of the table, in edges.
+	 * @throw std::runtime_error if the file can not be written.
+	 */
+	static void write(const char *filename, const std::vector<entry> &entries,
+					  uint32_t max_edges);
+
+private:
+	struct header
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t max_edges;
+		uint64_t num_entries;
+		uint64_t num_buckets;
+		uint64_t num_slots;
+		uint64_t reserved[3];
+	};
+
+	struct slot
+	{
+		uint64_t low, high; // the code, 0 when the slot is empty
+		int64_t num;
+		uint32_t exp;
+		uint32_t unused;
+	};
+
+	static constexpr char MAGIC[8] = {'H', 'K', 'B', 'T', 'A', 'B', 'L', 'E'};
+	static constexpr uint32_t VERSION = 1;
+
+	// average number of codes in a bucket of the perfect hash
+	static constexpr uint64_t BUCKET_LOAD = 4;
+
+	const uint8_t *data_ = nullptr;
+	std::size_t bytes_ = 0;
+	const header *header_ = nullptr;
+	const uint32_t *displacements_ = nullptr;
+	const slot *slots_ = nullptr;
+
+	static uint64_t hash(code_t code);
+
+	static uint64_t place(uint64_t h, uint32_t displacement, uint64_t slots);
+
+	static std::size_t displacements_bytes(uint64_t buckets);
+};
+
+}
@@ -0,0 +1,253 @@
+/**
+ * @file thermograph.cpp
+ * @author Jonah Chen
+ * @brief implement the thermographs specified in thermograph.hpp
+ * @version 1.0
+ * @date 2021-12-10
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include "thermograph.hpp"
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+
+namespace game {
+
+// x * k for the small slopes of the walls
+static dyadic scale(const dyadic &x, int k)
+{
+	dyadic result;
+	for (int i = 0; i < std::abs(k); ++i)
+		result += x;
+	return k < 0 ? -result : result;
+}
+
+// x / d for the differences of the slopes of two walls, which are at most 2
+static dyadic divide(const dyadic &x, int d)
+{
+	if (d == 0 or std::abs(d) > 2)
+		throw std::logic_error("the walls have slopes that are not -1, 0 or 1");
+	const dyadic result = std::abs(d) == 2 ? x.half() : x;
+	return d < 0 ? -result : result;
+}
+
+trajectory::trajectory(const dyadic &x) : segments_{{-1, x, 0}}
+{}
+
+dyadic trajectory::operator()(const dyadic &t) const
+{
+	std::size_t i = segments_.size() - 1;
+	while (i and t < segments_[i].start)
+		--i;
+	const segment &s = segments_[i];
+	return s.value + scale(t - s.start, s.slope);
+}
+
+trajectory trajectory::tilt(int slope) const
+{
+	trajectory result(*this);
+	for (segment &s: result.segments_)
+	{
+		s.value += scale(s.start, slope);
+		s.slope += slope;
+	}
+	return result;
+}
+
+trajectory trajectory::mast(const dyadic &t) const
+{
+	trajectory result((*this)(t));
+	if (t <= -1)
+		return result;
+	result.segments_.clear();
+	for (const segment &s: segments_)
+	{
+		if (s.start >= t)
+			break;
+		result.extend(s.start, s.value, s.slope);
+	}
+	result.extend(t, (*this)(t), 0);
+	return result;
+}
+
+dyadic trajectory::meet(const trajectory &a, const trajectory &b)
+{
+	const std::vector<dyadic> starts = breakpoints(a, b);
+	for (std::size_t i = 0; i < starts.size(); ++i)
+	{
+		const dyadic &s = starts[i];
+		const dyadic gap = a(s) - b(s);
+		if (gap.sign() <= 0)
+			return s;
+
+		// the gap closes at the rate the slopes differ, if it closes at all
+		const int rate = b.slope_at(s) - a.slope_at(s);
+		if (rate <= 0)
+			continue;
+		const dyadic t = s + divide(gap, rate);
+		if (i + 1 == starts.size() or t <= starts[i + 1])
+			return t;
+	}
+	throw std::logic_error("the walls never meet");
+}
+
+trajectory trajectory::max(const trajectory &a, const trajectory &b)
+{
+	return merge(a, b, true);
+}
+
+trajectory trajectory::min(const trajectory &a, const trajectory &b)
+{
+	return merge(a, b, false);
+}
+
+bool trajectory::operator==(const trajectory &other) const
+{
+	return segments_ == other.segments_;
+}
+
+trajectory trajectory::merge(const trajectory &a, const trajectory &b,
+							 bool larger)
+{
+	const std::vector<dyadic> starts = breakpoints(a, b);
+	const int sign = larger ? 1 : -1;
+	trajectory result;
+	result.segments_.clear();
+	for (std::size_t i = 0; i < starts.size(); ++i)
+	{
+		const dyadic &s = starts[i];
+		const dyadic va = a(s), vb = b(s);
+		const int sa = a.slope_at(s), sb = b.slope_at(s);
+
+		// the wall on top at the start, or the one that stays on top when
+		// they start together
+		const bool first = va != vb ? (va > vb) == larger :
+						   sign * sa >= sign * sb;
+		const dyadic &top = first ? va : vb, &other = first ? vb : va;
+		const int top_slope = first ? sa : sb, other_slope = first ? sb : sa;
+		result.extend(s, top, top_slope);
+
+		// the other wall crosses it before the next breakpoint if it gains
+		const int rate = sign * (other_slope - top_slope);
+		if (top == other or rate <= 0)
+			continue;
+		const dyadic t = s + divide(sign > 0 ? top - other : other - top, rate);
+		if (i + 1 == starts.size() or t < starts[i + 1])
+			result.extend(t, other + scale(t - s, other_slope), other_slope);
+	}
+	return result;
+}
+
+std::vector<dyadic> trajectory::breakpoints(const trajectory &a,
+											const trajectory &b)
+{
+	std::vector<dyadic> starts;
+	for (const segment &s: a.segments_)
+		starts.push_back(s.start);
+	for (const segment &s: b.segments_)
+		starts.push_back(s.start);
+	std::sort(starts.begin(), starts.end());
+	starts.erase(std::unique(starts.begin(), starts.end()), starts.end());
+	return starts;
+}
+
+int trajectory::slope_at(const dyadic &t) const
+{
+	std::size_t i = segments_.size() - 1;
+	while (i and t < segments_[i].start)
+		--i;
+	return segments_[i].slope;
+}
+
+void trajectory::extend(const dyadic &start, const dyadic &value, int slope)
+{
+	if (!segments_.empty())
+	{
+		const segment &last = segments_.back();
+		if (last.slope == slope and
+			last.value + scale(start - last.start, last.slope) == value)
+			return;
+	}
+	segments_.push_back({start, value, slope});
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Thermographs
+///////////////////////////////////////////////////////////////////////////////
+
+const thermograph &thermographs::operator()(forms::id_t g)
+{
+	const auto found = graphs_.find(g);
+	if (found != graphs_.end())
+		return found->second;
+
+	if (forms_.is_number(g))
+	{
+		const dyadic x = forms_.get_number(g);
+		const dyadic t = x.is_integer() ? dyadic(-1) :
+						 -dyadic::fraction(1, x.exp());
+		return graphs_.emplace(g, thermograph{x, x, x, t}).first->second;
+	}
+
+	// a canonical game that is not a number has options for both players
+	std::optional<trajectory> left, right;
+	for (const forms::id_t *o = forms_.left_begin(g); o != forms_.left_end(g);
+		 ++o)
+	{
+		const trajectory scaffold = (*this)(*o).right.tilt(-1);
+		left = left ? trajectory::max(*left, scaffold) : scaffold;
+	}
+	for (const forms::id_t *o = forms_.right_begin(g);
+		 o != forms_.right_end(g); ++o)
+	{
+		const trajectory scaffold = (*this)(*o).left.tilt(1);
+		right = right ? trajectory::min(*right, scaffold) : scaffold;
+	}
+
+	// the scaffolds meet where neither player gains by moving first any more.
+	// If they are apart from the start, the mast is the simplest number
+	// between them.
+	const dyadic t = trajectory::meet(*left, *right);
+	const dyadic l = (*left)(t), r = (*right)(t);
+	const dyadic mast = l == r ? l : simplest(l, r);
+	const thermograph graph{left->mast(t), right->mast(t), mast, t};
+	return graphs_.emplace(g, graph).first->second;
+}
+
+forms::id_t thermographs::cool(forms::id_t g, const dyadic &t)
+{
+	if (t.sign() < 0)
+		throw std::domain_error("a game is cooled by a negative temperature");
+	if (forms_.is_number(g))
+		return g;
+	const auto key = std::make_pair(g, t);
+	const auto found = cooled_.find(key);
+	if (found != cooled_.end())
+		return found->second;
+
+	const thermograph &graph = (*this)(g);
+	forms::id_t result;
+	if (t > graph.temperature)
+		result = forms_.number(graph.mast);
+	else
+	{
+		// the options are copied, as cooling them interns new games
+		const std::vector<forms::id_t> al(forms_.left_begin(g),
+										  forms_.left_end(g));
+		const std::vector<forms::id_t> ar(forms_.right_begin(g),
+										  forms_.right_end(g));
+		std::vector<forms::id_t> left, right;
+		for (forms::id_t o: al)
+			left.push_back(forms_.add(cool(o, t), forms_.number(-t)));
+		for (forms::id_t o: ar)
+			right.push_back(forms_.add(cool(o, t), forms_.number(t)));
+		result = forms_.make(std::move(left), std::move(right));
+	}
+	cooled_.emplace(key, result);
+	return result;
+}
+
+}
@@ -0,0 +1,175 @@
+/**
+ * @file thermograph.hpp
+ * @author Jonah Chen
+ * @brief thermographs of games in canonical form, which say how hot a game
+ * is: how much a player gains by moving in it first. A world too large to
+ * solve is played well by moving in its hottest component, so the temperature
+ * of every component is found from its thermograph, and the thermographs are
+ * kept by the ids of the games, so every component is only worked out once.
+ * @version 1.0
+ * @date 2021-12-10
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#pragma once
+
+#include "value.hpp"
+#include "canonical.hpp"
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace game {
+
+/**
+ * @brief a wall of a thermograph, a continuous function of the temperature
+ * t >= -1 that is linear between its breakpoints.
+ *
+ * @details the walls of thermographs only have slopes -1, 0 and 1, so the
+ * breakpoints where two walls cross are dyadic, and the walls are exact.
+ */
+class trajectory
+{
+public:
+	/**
+	 * @brief the wall that is x at every temperature.
+	 */
+	trajectory(const dyadic &x = 0);
+
+	/**
+	 * @return dyadic the value of the wall at temperature t.
+	 */
+	dyadic operator()(const dyadic &t) const;
+
+	/**
+	 * @return trajectory the wall plus slope * t.
+	 */
+	trajectory tilt(int slope) const;
+
+	/**
+	 * @return trajectory the wall up to temperature t, and the value it has
+	 * there at every temperature above.
+	 */
+	trajectory mast(const dyadic &t) const;
+
+	/**
+	 * @return dyadic the lowest temperature t >= -1 where a(t) <= b(t), for
+	 * a wall a that never rises and a wall b that never falls.
+	 * @throw std::logic_error if a stays above b.
+	 */
+	static dyadic meet(const trajectory &a, const trajectory &b);
+
+	static trajectory max(const trajectory &a, const trajectory &b);
+
+	static trajectory min(const trajectory &a, const trajectory &b);
+
+	bool operator==(const trajectory &other) const;
+
+private:
+	// a piece of the wall, from its start to the start of the next piece
+	struct segment
+	{
+		dyadic start, value; // the value of the wall at the start
+		int slope;
+
+		bool operator==(const segment &other) const = default;
+	};
+
+	std::vector<segment> segments_; // the first starts at -1
+
+	static trajectory merge(const trajectory &a, const trajectory &b,
+							bool larger);
+
+	static std::vector<dyadic> breakpoints(const trajectory &a,
+										   const trajectory &b);
+
+	int slope_at(const dyadic &t) const;
+
+	void extend(const dyadic &start, const dyadic &value, int slope);
+};
+
+/**
+ * @brief the thermograph of a game, with its walls cut off at the mast.
+ */
+struct thermograph
+{
+	// the left wall, which the blue player gets by moving first in the game
+	// cooled by t, and the right wall, which the red player gets
+	trajectory left, right;
+
+	// the value of the walls above the temperature, which is the mean value
+	// of the game
+	dyadic mast;
+
+	// where the walls meet. Numbers are colder than every other game, with
+	// the temperature -1/2^k when their denominator is 2^k.
+	dyadic temperature;
+};
+
+/**
+ * @brief the thermographs of the games of a store of canonical forms.
+ *
+ * @details
+ * - The thermograph of a number x is a mast at x. The walls of any other game
+ *   G are found from the walls of its options: the left scaffold is the
+ *   largest right wall of a left option minus t, and the right scaffold the
+ *   smallest left wall of a right option plus t. The scaffolds meet at the
+ *   temperature of G, and above it the walls are the mast.
+ * - Cooling G by t gives {G^L_t - t | G^R_t + t}, except that G cooled past
+ *   its temperature is its mast.
+ * - Thermographs and cooled games are memoized by the ids of the games, so the
+ *   thermograph of a component is worked out once, however often it is asked
+ *   for. Like the store of forms, the thermographs are not thread safe.
+ */
+class thermographs
+{
+public:
+	explicit thermographs(forms &f) : forms_(f)
+	{}
+
+	thermographs(const thermographs &) = delete;
+
+	thermographs &operator=(const thermographs &) = delete;
+
+	/**
+	 * @return const thermograph& the thermograph of a game of the store. The
+	 * reference stays valid while the thermographs live.
+	 */
+	const thermograph &operator()(forms::id_t g);
+
+	inline const dyadic &temperature(forms::id_t g)
+	{ return (*this)(g).temperature; }
+
+	inline const dyadic &mean(forms::id_t g)
+	{ return (*this)(g).mast; }
+
+	/**
+	 * @brief cool a game by t, which taxes every move by t.
+	 *
+	 * @param g the game.
+	 * @param t the temperature, at least 0.
+	 * @return forms::id_t the cooled game.
+	 * @throw std::domain_error if t is negative.
+	 */
+	forms::id_t cool(forms::id_t g, const dyadic &t);
+
+	inline forms &get_forms()
+	{ return forms_; }
+
+	/**
+	 * @return std::size_t the number of thermographs worked out.
+	 */
+	inline std::size_t size() const
+	{ return graphs_.size(); }
+
+private:
+	forms &forms_;
+	std::unordered_map<forms::id_t, thermograph> graphs_;
+	std::map<std::pair<forms::id_t, dyadic>, forms::id_t> cooled_;
+};
+
+}
@@ -0,0 +1,157 @@
+/**
+ * @file transposition.cpp
+ * @author Jonah Chen
+ * @brief implement the transposition table specified in transposition.hpp
+ * @version 1.0
+ * @date 2021-11-28
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include "transposition.hpp"
+#include <algorithm>
+
+namespace game {
+
+transposition_table::transposition_table(std::size_t megabytes)
+{
+	resize(megabytes);
+}
+
+void transposition_table::resize(std::size_t megabytes)
+{
+	std::size_t buckets = 1;
+	while (buckets * 2 * sizeof(bucket) <= megabytes << 20)
+		buckets *= 2;
+
+	buckets_.reset(new bucket[buckets]);
+	mask_ = buckets - 1;
+	clear();
+}
+
+void transposition_table::clear()
+{
+	for (std::size_t i = 0; i <= mask_; ++i)
+	{
+		for (entry &e: buckets_[i].entries)
+		{
+			e.check.store(0, std::memory_order_relaxed);
+			e.data.store(0, std::memory_order_relaxed);
+		}
+	}
+	generation_.store(0, std::memory_order_relaxed);
+	for (counters &c: counters_)
+	{
+		c.probes.store(0, std::memory_order_relaxed);
+		c.hits.store(0, std::memory_order_relaxed);
+		c.stores.store(0, std::memory_order_relaxed);
+		c.collisions.store(0, std::memory_order_relaxed);
+		c.rejected.store(0, std::memory_order_relaxed);
+	}
+}
+
+// the threads are given the stripes in turn, the same stripe in every table
+transposition_table::counters &transposition_table::local() const
+{
+	static std::atomic<std::size_t> next{0};
+	thread_local const std::size_t stripe =
+			next.fetch_add(1, std::memory_order_relaxed) % COUNTER_STRIPES;
+	return counters_[stripe];
+}
+
+void transposition_table::age()
+{
+	generation_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool transposition_table::probe(uint64_t key, dyadic &value) const
+{
+	counters &c = local();
+	c.probes.fetch_add(1, std::memory_order_relaxed);
+	const bucket &b = buckets_[key & mask_];
+	for (const entry &e: b.entries)
+	{
+		const uint64_t data = e.data.load(std::memory_order_relaxed);
+		if (!data or (e.check.load(std::memory_order_relaxed) ^ data) != key)
+			continue;
+
+		// the numerator is in the top bits, so an arithmetic shift restores
+		// its sign
+		const int64_t num = (int64_t) data >> NUM_SHIFT;
+		const uint32_t exp = data >> EXP_SHIFT & ((1u << EXP_BITS) - 1);
+		value = dyadic::fraction(num, exp);
+		c.hits.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+	return false;
+}
+
+void transposition_table::store(uint64_t key, const dyadic &value,
+								uint32_t edges)
+{
+	constexpr int64_t max_num = (int64_t) 1 << (63 - NUM_SHIFT);
+	counters &c = local();
+	if (!value.is_narrow() or value.num() >= max_num or
+		value.num() < -max_num or value.exp() >= (1u << EXP_BITS))
+	{
+		c.rejected.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	// the data of a stored entry is never 0, as it counts at least one edge
+	const uint64_t generation = generation_.load(std::memory_order_relaxed) &
+								((1u << GENERATION_BITS) - 1);
+	const uint64_t data = (uint64_t) value.num() << NUM_SHIFT |
+						  (uint64_t) value.exp() << EXP_SHIFT |
+						  generation << GENERATION_SHIFT |
+						  std::clamp<uint32_t>(edges, 1, (1u << EDGES_BITS) - 1);
+
+	// overwrite the position if it is already stored, otherwise take an empty
+	// entry or the one that is cheapest to lose
+	bucket &b = buckets_[key & mask_];
+	entry *victim = nullptr;
+	uint64_t victim_cost = ~(uint64_t) 0;
+	for (entry &e: b.entries)
+	{
+		const uint64_t old = e.data.load(std::memory_order_relaxed);
+		if (!old or (e.check.load(std::memory_order_relaxed) ^ old) == key)
+		{
+			victim = &e;
+			victim_cost = 0;
+			break;
+		}
+
+		const bool current = (old >> GENERATION_SHIFT &
+							  ((1u << GENERATION_BITS) - 1)) == generation;
+		const uint64_t cost = (current ? 1u << EDGES_BITS : 0) +
+							  (old & ((1u << EDGES_BITS) - 1));
+		if (cost < victim_cost)
+		{
+			victim = &e;
+			victim_cost = cost;
+		}
+	}
+
+	if (victim_cost)
+		c.collisions.fetch_add(1, std::memory_order_relaxed);
+	c.stores.fetch_add(1, std::memory_order_relaxed);
+	victim->data.store(data, std::memory_order_relaxed);
+	victim->check.store(key ^ data, std::memory_order_relaxed);
+}
+
+transposition_table::stats transposition_table::get_stats() const
+{
+	stats s;
+	for (const counters &c: counters_)
+	{
+		s.probes += c.probes.load(std::memory_order_relaxed);
+		s.hits += c.hits.load(std::memory_order_relaxed);
+		s.stores += c.stores.load(std::memory_order_relaxed);
+		s.collisions += c.collisions.load(std::memory_order_relaxed);
+		s.rejected += c.rejected.load(std::memory_order_relaxed);
+	}
+	return s;
+}
+
+}
@@ -0,0 +1,166 @@
+/**
+ * @file transposition.hpp
+ * @author Jonah Chen
+ * @brief a fixed size transposition table for searching hackenbush positions.
+ * Chopping edge a then edge b reaches the same position as chopping b then a,
+ * so a search keeps reaching positions it has already valued. The table maps
+ * the zobrist key of a position (see world::get_key) to its value, and is
+ * shared by every thread searching without any locks.
+ * @version 1.0
+ * @date 2021-11-28
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#pragma once
+
+#include "value.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace game {
+
+/**
+ * @brief a lock-free transposition table of fixed size.
+ *
+ * @details
+ * - The table is an array of buckets of BUCKET_SIZE entries, each bucket
+ *   filling a cache line. A key is stored in the bucket given by its low bits,
+ *   in any of its entries.
+ * - An entry is two 64 bit words: the data, which packs the value with the
+ *   number of edges of the position and the generation it was stored in, and
+ *   the key XOR the data. Both words are written and read with relaxed
+ *   atomics. When two threads race on an entry, the words may come from
+ *   different writes, but then the key XOR the data does not match the key,
+ *   and the entry is treated as a miss. No entry is ever read half written.
+ * - When a bucket is full, the entry of the smallest position from an older
+ *   generation is replaced first, then the entry of the smallest position.
+ *   Small positions are the cheapest to search again.
+ * - The counters are kept in stripes, each on a cache line of its own, and
+ *   every thread counts in the stripe it was given the first time it used a
+ *   table. The threads never write to the same line to count, and
+ *   get_stats() sums the stripes.
+ * - Values whose numerator does not fit in 44 bits, or whose exponent does not
+ *   fit in 6 bits, are not stored. Positions of at most
+ *   evaluator::MAX_SEARCH_EDGES edges always fit.
+ */
+class transposition_table
+{
+public:
+	static constexpr std::size_t BUCKET_SIZE = 4;
+	static constexpr std::size_t COUNTER_STRIPES = 64;
+	static constexpr std::size_t DEFAULT_MEGABYTES = 16;
+
+	/**
+	 * @brief how the table was used since it was created or cleared.
+	 */
+	struct stats
+	{
+		uint64_t probes = 0; // lookups of a key
+		uint64_t hits = 0; // lookups that found the key
+		uint64_t stores = 0; // values stored
+		uint64_t collisions = 0; // stores that replaced another position
+		uint64_t rejected = 0; // values too large to be stored
+
+		inline double hit_rate() const
+		{ return probes ? (double) hits / probes : 0.0; }
+	};
+
+	/**
+	 * @brief allocate an empty table.
+	 *
+	 * @param megabytes the size of the table, rounded down to a power of two
+	 * buckets. At least one bucket is allocated.
+	 */
+	explicit transposition_table(std::size_t megabytes = DEFAULT_MEGABYTES);
+
+	transposition_table(const transposition_table &) = delete;
+
+	transposition_table &operator=(const transposition_table &) = delete;
+
+	/**
+	 * @brief reallocate the table with another size, dropping every entry.
+	 * @warning not thread safe, no thread may be using the table.
+	 */
+	void resize(std::size_t megabytes);
+
+	/**
+	 * @brief drop every entry and reset the counters.
+	 * @warning not thread safe, no thread may be using the table.
+	 */
+	void clear();
+
+	/**
+	 * @brief start a new generation. Entries stored before are replaced before
+	 * the entries stored after, whatever the size of their positions.
+	 */
+	void age();
+
+	/**
+	 * @brief look up the value of a position.
+	 *
+	 * @param key the zobrist key of the position.
+	 * @param value set to the value of the position if it is found.
+	 * @return true if the position is found.
+	 */
+	bool probe(uint64_t key, dyadic &value) const;
+
+	/**
+	 * @brief store the value of a position.
+	 *
+	 * @param key the zobrist key of the position.
+	 * @param value the value of the position.
+	 * @param edges the number of edges of the position, which is how much work
+	 * it took to value it.
+	 */
+	void store(uint64_t key, const dyadic &value, uint32_t edges);
+
+	/**
+	 * @return stats the counters of the table. Other threads may be updating
+	 * them, so the counters are only consistent when the table is idle.
+	 */
+	stats get_stats() const;
+
+	inline std::size_t num_buckets() const
+	{ return mask_ + 1; }
+
+	inline std::size_t megabytes() const
+	{ return num_buckets() * sizeof(bucket) >> 20; }
+
+private:
+	struct entry
+	{
+		std::atomic<uint64_t> check; // the key XOR the data
+		std::atomic<uint64_t> data;
+	};
+
+	struct alignas(64) bucket
+	{
+		entry entries[BUCKET_SIZE];
+	};
+
+	// a stripe of the counters, kept away from the buckets and the other
+	// stripes on a cache line of its own
+	struct alignas(64) counters
+	{
+		std::atomic<uint64_t> probes{0}, hits{0}, stores{0};
+		std::atomic<uint64_t> collisions{0}, rejected{0};
+	};
+
+	// layout of the data word
+	static constexpr int EDGES_BITS = 8, GENERATION_BITS = 6, EXP_BITS = 6;
+	static constexpr int GENERATION_SHIFT = EDGES_BITS;
+	static constexpr int EXP_SHIFT = GENERATION_SHIFT + GENERATION_BITS;
+	static constexpr int NUM_SHIFT = EXP_SHIFT + EXP_BITS;
+
+	std::unique_ptr<bucket[]> buckets_;
+	std::size_t mask_ = 0;
+	std::atomic<uint32_t> generation_{0};
+	mutable counters counters_[COUNTER_STRIPES];
+
+	counters &local() const;
+};
+
+}
@@ -0,0 +1,1399 @@
+/**
+ * @file value.cpp
+ * @author Jonah Chen
+ * @brief implement the evaluation of the world specified in value.hpp.
+ * @version 1.0
+ * @date 2021-11-26
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include "value.hpp"
+#include "transposition.hpp"
+#include "canonical.hpp"
+#include "tablebase.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <numeric>
+#include <limits>
+#include <stdexcept>
+
+namespace game {
+
+///////////////////////////////////////////////////////////////////////////////
+// Arithmetic on the magnitudes of wide numerators, stored low limb first
+///////////////////////////////////////////////////////////////////////////////
+
+using limbs_t = std::vector<uint64_t>;
+
+static void trim(limbs_t &a)
+{
+	while (!a.empty() and !a.back())
+		a.pop_back();
+}
+
+static int compare(const limbs_t &a, const limbs_t &b)
+{
+	if (a.size() != b.size())
+		return a.size() < b.size() ? -1 : 1;
+	for (std::size_t i = a.size(); i-- > 0;)
+		if (a[i] != b[i])
+			return a[i] < b[i] ? -1 : 1;
+	return 0;
+}
+
+static void add_to(limbs_t &a, const limbs_t &b)
+{
+	a.resize(std::max(a.size(), b.size()) + 1, 0);
+	unsigned __int128 carry = 0;
+	for (std::size_t i = 0; i < a.size(); ++i)
+	{
+		carry += (unsigned __int128) a[i] + (i < b.size() ? b[i] : 0);
+		a[i] = (uint64_t) carry;
+		carry >>= 64;
+	}
+	trim(a);
+}
+
+// a -= b, where a >= b
+static void subtract_from(limbs_t &a, const limbs_t &b)
+{
+	uint64_t borrow = 0;
+	for (std::size_t i = 0; i < a.size(); ++i)
+	{
+		const uint64_t sub = i < b.size() ? b[i] : 0;
+		const uint64_t result = a[i] - sub - borrow;
+		borrow = a[i] < sub or (a[i] == sub and borrow) ? 1 : 0;
+		a[i] = result;
+	}
+	trim(a);
+}
+
+static void shift_left(limbs_t &a, uint64_t bits)
+{
+	if (a.empty() or !bits)
+		return;
+	const std::size_t words = bits / 64, rest = bits % 64;
+	a.insert(a.begin(), words, 0);
+	if (rest)
+	{
+		a.push_back(0);
+		for (std::size_t i = a.size(); i-- > words + 1;)
+			a[i] = a[i] << rest | a[i - 1] >> (64 - rest);
+		a[words] <<= rest;
+	}
+	trim(a);
+}
+
+static void shift_right(limbs_t &a, uint64_t bits)
+{
+	const std::size_t words = bits / 64, rest = bits % 64;
+	if (words >= a.size())
+	{
+		a.clear();
+		return;
+	}
+	a.erase(a.begin(), a.begin() + words);
+	if (rest)
+	{
+		for (std::size_t i = 0; i + 1 < a.size(); ++i)
+			a[i] = a[i] >> rest | a[i + 1] << (64 - rest);
+		a.back() >>= rest;
+	}
+	trim(a);
+}
+
+static uint64_t trailing_zeros(const limbs_t &a)
+{
+	uint64_t zeros = 0;
+	for (uint64_t limb: a)
+	{
+		if (limb)
+			return zeros + __builtin_ctzll(limb);
+		zeros += 64;
+	}
+	return zeros;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Dyadic rationals
+///////////////////////////////////////////////////////////////////////////////
+
+dyadic dyadic::normalize(__int128 num, uint32_t exp)
+{
+	while (exp > 0 and !(num & 1))
+	{
+		num >>= 1;
+		--exp;
+	}
+	if (num > std::numeric_limits<int64_t>::max() or
+		num < std::numeric_limits<int64_t>::min())
+	{
+		const unsigned __int128 mag = num < 0 ? -(unsigned __int128) num :
+									  (unsigned __int128) num;
+		return normalize(num < 0, {(uint64_t) mag, (uint64_t) (mag >> 64)},
+						 exp);
+	}
+
+	dyadic d;
+	d.num_ = (int64_t) num;
+	d.exp_ = exp;
+	return d;
+}
+
+dyadic dyadic::normalize(bool negative, limbs_t limbs, uint64_t exp)
+{
+	trim(limbs);
+	if (limbs.empty())
+		return 0;
+
+	const uint64_t shift = std::min(trailing_zeros(limbs), exp);
+	shift_right(limbs, shift);
+	exp -= shift;
+	if (exp > std::numeric_limits<uint32_t>::max())
+		throw std::overflow_error("dyadic exponent does not fit in 32 bits");
+
+	dyadic d;
+	d.exp_ = exp;
+	const uint64_t top = (uint64_t) 1 << 63;
+	if (limbs.size() == 1 and
+		(limbs[0] < top or (negative and limbs[0] == top)))
+		d.num_ = negative ? (int64_t) (0 - limbs[0]) : (int64_t) limbs[0];
+	else
+	{
+		d.num_ = negative ? -1 : 1;
+		d.wide_ = std::move(limbs);
+	}
+	return d;
+}
+
+limbs_t dyadic::limbs() const
+{
+	if (!wide_.empty())
+		return wide_;
+	if (!num_)
+		return {};
+	return {num_ < 0 ? 0 - (uint64_t) num_ : (uint64_t) num_};
+}
+
+dyadic dyadic::fraction(int64_t num, uint32_t exp)
+{
+	return normalize(num, exp);
+}
+
+int64_t dyadic::floor() const
+{
+	if (wide_.empty())
+	{
+		if (exp_ < 64)
+			return num_ >> exp_;
+		return num_ < 0 ? -1 : 0;
+	}
+
+	// the numerator is odd when exp > 0, so a negative value with a
+	// fractional part rounds down
+	limbs_t whole = wide_;
+	shift_right(whole, exp_);
+	if (whole.size() > 1 or (!whole.empty() and whole[0] >> 63))
+		throw std::overflow_error("integer part does not fit in 64 bits");
+	const int64_t magnitude = whole.empty() ? 0 : (int64_t) whole[0];
+	return num_ < 0 ? -magnitude - (exp_ > 0) : magnitude;
+}
+
+dyadic dyadic::ldexp(int64_t k) const
+{
+	if (k <= 0 or k <= exp_)
+	{
+		const uint64_t exp = (uint64_t) ((int64_t) exp_ - k);
+		if (wide_.empty() and exp <= std::numeric_limits<uint32_t>::max())
+			return normalize(num_, exp);
+		return normalize(num_ < 0, limbs(), exp);
+	}
+
+	// the numerator grows by the part of the shift the exponent can not take
+	const uint64_t shift = k - exp_;
+	if (wide_.empty() and shift <= 62)
+		return normalize((__int128) num_ << shift, 0);
+	limbs_t l = limbs();
+	shift_left(l, shift);
+	return normalize(num_ < 0, std::move(l), 0);
+}
+
+double dyadic::to_double() const
+{
+	if (wide_.empty())
+		return std::ldexp((double) num_, -(int) exp_);
+	double mag = 0.0;
+	for (std::size_t i = wide_.size(); i-- > 0;)
+		mag = std::ldexp(mag, 64) + (double) wide_[i];
+	return num_ * std::ldexp(mag, -(int64_t) exp_);
+}
+
+dyadic dyadic::operator+(const dyadic &other) const
+{
+	const uint32_t exp = std::max(exp_, other.exp_);
+	if (wide_.empty() and other.wide_.empty() and
+		exp - std::min(exp_, other.exp_) <= 62)
+	{
+		// the aligned numerators fit in 126 bits
+		const __int128 a = (__int128) num_ << (exp - exp_);
+		const __int128 b = (__int128) other.num_ << (exp - other.exp_);
+		return normalize(a + b, exp);
+	}
+
+	limbs_t a = limbs(), b = other.limbs();
+	shift_left(a, exp - exp_);
+	shift_left(b, exp - other.exp_);
+	if (sign() == other.sign() or !other.sign())
+	{
+		add_to(a, b);
+		return normalize(num_ < 0, std::move(a), exp);
+	}
+	if (!sign())
+		return other;
+	if (compare(a, b) >= 0)
+	{
+		subtract_from(a, b);
+		return normalize(num_ < 0, std::move(a), exp);
+	}
+	subtract_from(b, a);
+	return normalize(other.num_ < 0, std::move(b), exp);
+}
+
+dyadic dyadic::operator-(const dyadic &other) const
+{
+	return *this + -other;
+}
+
+dyadic dyadic::operator-() const
+{
+	if (wide_.empty())
+		return normalize(-(__int128) num_, exp_);
+	return normalize(num_ > 0, wide_, exp_);
+}
+
+bool dyadic::operator<(const dyadic &other) const
+{
+	if (sign() != other.sign())
+		return sign() < other.sign();
+	if (wide_.empty() and other.wide_.empty())
+	{
+		const uint32_t exp = std::max(exp_, other.exp_);
+		if (exp - std::min(exp_, other.exp_) <= 62)
+			return ((__int128) num_ << (exp - exp_)) <
+				   ((__int128) other.num_ << (exp - other.exp_));
+	}
+	return (*this - other).sign() < 0;
+}
+
+uint64_t dyadic::hash() const
+{
+	uint64_t h = hashing::combine((uint32_t) ((uint64_t) num_ >> 32),
+								  (uint32_t) num_, exp_);
+	for (uint64_t limb: wide_)
+		h = hashing::mix(h ^ limb);
+	return h;
+}
+
+std::ostream &operator<<(std::ostream &os, const dyadic &d)
+{
+	if (d.wide_.empty())
+		os << d.num_;
+	else
+	{
+		// print the magnitude in chunks of 19 decimal digits
+		static constexpr uint64_t chunk = 10000000000000000000ull;
+		limbs_t mag = d.wide_;
+		std::vector<uint64_t> chunks;
+		while (!mag.empty())
+		{
+			unsigned __int128 rem = 0;
+			for (std::size_t i = mag.size(); i-- > 0;)
+			{
+				rem = rem << 64 | mag[i];
+				mag[i] = (uint64_t) (rem / chunk);
+				rem %= chunk;
+			}
+			chunks.push_back((uint64_t) rem);
+			trim(mag);
+		}
+		if (d.num_ < 0)
+			os << '-';
+		os << chunks.back();
+		const char fill = os.fill('0');
+		for (std::size_t i = chunks.size() - 1; i-- > 0;)
+		{
+			os.width(19);
+			os << chunks[i];
+		}
+		os.fill(fill);
+	}
+
+	if (d.exp_ > 63)
+		os << "/2^" << d.exp_;
+	else if (d.exp_)
+		os << '/' << ((uint64_t) 1 << d.exp_);
+	return os;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Rules for numbers
+///////////////////////////////////////////////////////////////////////////////
+
+dyadic simplest(const std::optional<dyadic> &left,
+				const std::optional<dyadic> &right)
+{
+	if (left and right and !(*left < *right))
+		throw std::invalid_argument("the position is not a number");
+
+	if ((!left or *left < 0) and (!right or *right > 0))
+		return 0;
+
+	// the negative case is the mirror image of the positive one
+	if (right and *right <= 0)
+	{
+		std::optional<dyadic> mirror_left = -*right, mirror_right;
+		if (left)
+			mirror_right = -*left;
+		return -simplest(mirror_left, mirror_right);
+	}
+
+	// 0 <= left, so the simplest integer is the smallest one above left
+	const dyadic n = left->floor() + 1;
+	if (!right or n < *right)
+		return n;
+
+	// otherwise, halve the interval between the integers around left until
+	// its midpoint is between left and right
+	dyadic low = n - 1, high = n;
+	while (true)
+	{
+		const dyadic mid = (low + high).half();
+		if (mid <= *left)
+			low = mid;
+		else if (mid >= *right)
+			high = mid;
+		else
+			return mid;
+	}
+}
+
+dyadic string_value(const branch_type *types, std::size_t n)
+{
+	dyadic value, step = 1;
+	bool changed = false;
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		if (types[i] != blue and types[i] != red)
+			throw std::invalid_argument("the string is not red-blue");
+
+		// after the first change of colour, every edge is worth half as much
+		changed = changed or types[i] != types[0];
+		if (changed)
+			step = step.half();
+		value += types[i] == blue ? step : -step;
+	}
+	return value;
+}
+
+dyadic graft(branch_type type, const dyadic &x)
+{
+	if (type == red)
+		return -graft(blue, -x);
+	if (type != blue)
+		throw std::invalid_argument("the edge is not red or blue");
+
+	// the smallest integer n >= 1 with x + n > 1
+	const int64_t n = std::max<int64_t>(1, (dyadic(1) - x).floor() + 1);
+	return (x + n).ldexp(-(n - 1));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Surreal numbers in Conway normal form
+///////////////////////////////////////////////////////////////////////////////
+
+// d * m for m >= 0, by doubling
+static dyadic times(const dyadic &d, int64_t m)
+{
+	dyadic result, power = d;
+	for (; m; m >>= 1, power += power)
+		if (m & 1)
+			result += power;
+	return result;
+}
+
+static __int128 gcd(__int128 a, __int128 b)
+{
+	if (a < 0)
+		a = -a;
+	while (b)
+	{
+		const __int128 r = a % b;
+		a = b;
+		b = r;
+	}
+	return a;
+}
+
+surreal surreal::omega(const dyadic &coefficient, int32_t exponent)
+{
+	surreal s;
+	if (coefficient.sign())
+		s.terms_.push_back({exponent, coefficient});
+	return s;
+}
+
+surreal surreal::fraction(int64_t num, int64_t den)
+{
+	if (!den)
+		throw std::invalid_argument("the denominator is 0");
+	if (den < 0)
+	{
+		num = -num;
+		den = -den;
+	}
+	const int64_t common = std::gcd(num, den);
+	num /= common;
+	den /= common;
+
+	// split the powers of 2 off the denominator, and the whole part off what
+	// is left of the fraction
+	const int shift = std::countr_zero((uint64_t) den);
+	den >>= shift;
+	int64_t whole = num / den, rest = num % den;
+	if (rest < 0)
+	{
+		rest += den;
+		--whole;
+	}
+	surreal s(whole);
+	s.residue_ = rest;
+	s.modulus_ = rest ? den : 1;
+	return s.ldexp(-shift);
+}
+
+dyadic surreal::coefficient(int32_t exponent) const
+{
+	for (const term &t: terms_)
+		if (t.exponent == exponent)
+			return t.coefficient;
+	return 0;
+}
+
+int surreal::sign() const
+{
+	if (!terms_.empty())
+		return terms_.front().coefficient.sign();
+	if (!residue_)
+		return real_.sign();
+
+	// real + residue / modulus, where 0 < residue / modulus < 1
+	if (real_.sign() >= 0)
+		return 1;
+	return dyadic(residue_) > times(-real_, modulus_) ? 1 : -1;
+}
+
+int64_t surreal::floor() const
+{
+	const int64_t whole = real_.floor();
+	if (!residue_)
+		return whole;
+
+	// the fractional part of real and the residue add up to less than 2, and
+	// never to exactly 1 as the residue is not dyadic
+	const dyadic fractional = real_ - whole;
+	return times(dyadic(1) - fractional, modulus_) < residue_ ? whole + 1 : whole;
+}
+
+surreal surreal::ldexp(int64_t k) const
+{
+	surreal s;
+	for (const term &t: terms_)
+		s.terms_.push_back({t.exponent, t.coefficient.ldexp(k)});
+	if (!residue_)
+	{
+		s.real_ = real_.ldexp(k);
+		return s;
+	}
+	if (k > MAX_SHIFT or k < -MAX_SHIFT)
+		throw std::overflow_error("the shift of a rational is too large");
+
+	// shift the residue one bit at a time, and carry the whole parts that
+	// come out of it into the real part
+	__int128 residue = residue_;
+	dyadic carry;
+	if (k > 0)
+	{
+		// 2 (d + p / m) = 2 d + (2 p - m) / m when 2 p >= m
+		for (int64_t i = 0; i < k; ++i)
+		{
+			residue <<= 1;
+			carry += carry;
+			if (residue >= modulus_)
+			{
+				residue -= modulus_;
+				carry += 1;
+			}
+		}
+		s.real_ = real_.ldexp(k) + carry;
+	}
+	else
+	{
+		// (d + p / m) / 2 = (d - 1) / 2 + ((p + m) / 2) / m when p is odd
+		for (int64_t i = 0; i < -k; ++i)
+		{
+			if (residue & 1)
+			{
+				residue = (residue + modulus_) >> 1;
+				carry += dyadic(1).ldexp(i);
+			}
+			else
+				residue >>= 1;
+		}
+		s.real_ = (real_ - carry).ldexp(k);
+	}
+	s.residue_ = (int64_t) residue;
+	s.modulus_ = modulus_;
+	return s;
+}
+
+dyadic surreal::nearby(uint32_t exp) const
+{
+	if (!residue_)
+		return real_;
+
+	// round down on a grid fine enough for the exponent and for the real
+	// part, then move half a step up, off every point of the grid
+	const uint32_t bits = std::max(exp, real_.exp());
+	dyadic below;
+	unsigned __int128 remainder = residue_;
+	for (uint32_t done = 0; done < bits;)
+	{
+		const uint32_t step = std::min<uint32_t>(62, bits - done);
+		remainder <<= step;
+		below = below.ldexp(step) + (int64_t) (remainder / modulus_);
+		remainder %= modulus_;
+		done += step;
+	}
+	return real_ + below.ldexp(-(int64_t) bits) +
+		   dyadic(1).ldexp(-(int64_t) bits - 1);
+}
+
+surreal surreal::operator+(const surreal &other) const
+{
+	surreal s;
+
+	// merge the terms by decreasing exponent
+	auto a = terms_.begin(), b = other.terms_.begin();
+	while (a != terms_.end() or b != other.terms_.end())
+	{
+		if (b == other.terms_.end() or
+			(a != terms_.end() and a->exponent > b->exponent))
+			s.terms_.push_back(*a++);
+		else if (a == terms_.end() or b->exponent > a->exponent)
+			s.terms_.push_back(*b++);
+		else
+		{
+			const dyadic c = a->coefficient + b->coefficient;
+			if (c.sign())
+				s.terms_.push_back({a->exponent, c});
+			++a;
+			++b;
+		}
+	}
+	s.real_ = real_ + other.real_;
+	if (!residue_ and !other.residue_)
+		return s;
+
+	// p / m + q / n = (p n + q m) / (m n), reduced, with the whole part
+	// carried into the real part
+	__int128 num = (__int128) residue_ * other.modulus_ +
+				   (__int128) other.residue_ * modulus_;
+	__int128 den = (__int128) modulus_ * other.modulus_;
+	const __int128 common = gcd(num, den);
+	num /= common;
+	den /= common;
+	if (den > std::numeric_limits<int64_t>::max())
+		throw std::overflow_error("the denominator does not fit in 64 bits");
+	if (num >= den)
+	{
+		num -= den;
+		s.real_ += 1;
+	}
+	s.residue_ = (int64_t) num;
+	s.modulus_ = num ? (int64_t) den : 1;
+	return s;
+}
+
+surreal surreal::operator-(const surreal &other) const
+{
+	return *this + -other;
+}
+
+surreal surreal::operator-() const
+{
+	surreal s;
+	for (const term &t: terms_)
+		s.terms_.push_back({t.exponent, -t.coefficient});
+	s.real_ = -real_;
+	if (residue_)
+	{
+		s.real_ = s.real_ - 1;
+		s.residue_ = modulus_ - residue_;
+		s.modulus_ = modulus_;
+	}
+	return s;
+}
+
+std::ostream &operator<<(std::ostream &os, const surreal &s)
+{
+	// the signs go between the terms, and in front of the first one
+	bool first = true;
+	const auto sign = [&](bool negative)
+	{
+		if (!first)
+			os << (negative ? " - " : " + ");
+		else if (negative)
+			os << '-';
+		first = false;
+	};
+
+	for (const surreal::term &t: s.terms_)
+	{
+		const bool negative = t.coefficient.sign() < 0;
+		sign(negative);
+		os << "ω";
+		if (t.exponent != 1)
+			os << '^' << t.exponent;
+		const dyadic magnitude = negative ? -t.coefficient : t.coefficient;
+		if (magnitude != 1)
+			os << "·" << magnitude;
+	}
+
+	if (!s.residue_)
+	{
+		if (s.real_.sign() or first)
+		{
+			sign(s.real_.sign() < 0);
+			os << (s.real_.sign() < 0 ? -s.real_ : s.real_);
+		}
+		return os;
+	}
+
+	// the real part as a single fraction (real m + residue) / m
+	const dyadic num = times(s.real_, s.modulus_) + s.residue_;
+	sign(num.sign() < 0);
+	const dyadic magnitude = num.sign() < 0 ? -num : num;
+	if (magnitude.is_narrow() and
+		magnitude.exp() + std::bit_width((uint64_t) s.modulus_) < 64)
+		os << magnitude.num() << '/' << (s.modulus_ << magnitude.exp());
+	else
+		os << '(' << magnitude << ")/" << s.modulus_;
+	return os;
+}
+
+surreal graft(branch_type type, const surreal &x)
+{
+	if (type == red)
+		return -graft(blue, -x);
+	if (type != blue)
+		throw std::invalid_argument("the edge is not red or blue");
+	if (x.is_dyadic())
+		return graft(blue, x.get_real());
+
+	if (x.is_infinite())
+	{
+		// the ω pluses a positive infinite value starts with absorb the edge
+		if (x.sign() > 0)
+			return x;
+		throw std::domain_error("the value is infinitesimal");
+	}
+
+	// the smallest integer n >= 1 with x + n > 1
+	const int64_t n = std::max<int64_t>(1, (surreal(1) - x).floor() + 1);
+	return (x + n).ldexp(-(n - 1));
+}
+
+surreal stack_value(const nodes::stack_root &stack, const surreal &above)
+{
+	return stack_value(stack.get_type_gen(), stack.get_kwargs(), stack.size(),
+					   above);
+}
+
+surreal stack_value(nodes::generators::type_gen tgen, void *kwargs,
+					int64_t size, const surreal &above)
+{
+	using nodes::generators::type_gen;
+	namespace F = nodes::generators::F;
+
+	if (tgen == (type_gen) F::green)
+		throw std::domain_error("a green stack is not a number");
+	const bool blue_only = tgen == (type_gen) F::blue;
+	const bool red_only = tgen == (type_gen) F::red;
+
+	if (size != INF)
+	{
+		if (above.is_zero() and (blue_only or red_only))
+			return surreal(blue_only ? size : -size);
+		surreal x = above;
+		for (int64_t order = size; order-- > 0;)
+		{
+			const branch_type type = tgen(order, kwargs);
+			if (type != blue and type != red)
+				throw std::domain_error("the stack is not red-blue");
+			x = graft(type, x);
+		}
+		return x;
+	}
+
+	if (blue_only or red_only)
+	{
+		// the stack puts one sign in front of the signs of the coefficient of
+		// ω, which are each repeated ω times
+		for (const surreal::term &t: above.get_terms())
+			if (t.exponent != 1)
+				throw std::domain_error("the value is not a multiple of ω");
+		const dyadic d = above.coefficient(1);
+		return surreal::omega(graft(blue_only ? blue : red, d)) +
+			   (above - surreal::omega(d));
+	}
+
+	if (tgen == (type_gen) F::fraction and kwargs)
+	{
+		// the sign expansion of the fraction takes all ω branches, and
+		// anything after them is worth an infinitesimal
+		if (!above.is_zero())
+			throw std::domain_error("the value is infinitesimal");
+		const int32_t *fraction = (const int32_t *) kwargs;
+		return surreal::fraction(fraction[0], fraction[1]);
+	}
+	throw std::domain_error("the value of the generator is not known");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Evaluator
+///////////////////////////////////////////////////////////////////////////////
+
+static constexpr uint32_t no_component = std::numeric_limits<uint32_t>::max();
+
+evaluator::evaluator(transposition_table *table) : table_(table),
+		forms_(new forms())
+{}
+
+evaluator::~evaluator() = default;
+
+void evaluator::split(const world &w)
+{
+	comp_.assign(w.num_nodes(), no_component);
+	order_.clear();
+	reached_by_.clear();
+	components_.clear();
+
+	// every edge from the ground into a node without a component starts a new
+	// component, which is everything reached from it without passing through
+	// the ground
+	for (world::id_t g = 0; g < w.num_nodes(); ++g)
+	{
+		if (!w.is_present(g) or !w.is_grounded(g))
+			continue;
+
+		// a stack on the ground that is not linked to anything is a component
+		// on its own, with the root as its only node
+		if (w.get_kind(g) == node_kind::stack_root and
+			w.get_link(g) == world::npos)
+		{
+			components_.push_back({(uint32_t) order_.size(), 1, 0, 0, 0, true});
+			order_.push_back(g);
+			reached_by_.push_back(world::npos);
+		}
+
+		for (auto *h = w.adj_begin(g); h != w.adj_end(g); ++h)
+		{
+			if (w.is_grounded(h->other) or comp_[h->other] != no_component)
+				continue;
+
+			const uint32_t c = components_.size();
+			component comp{(uint32_t) order_.size(), 0, 0, 0, 0, false};
+			comp_[h->other] = c;
+			order_.push_back(h->other);
+			reached_by_.push_back(h->edge);
+			for (std::size_t i = comp.first_node; i < order_.size(); ++i)
+			{
+				const world::id_t v = order_[i];
+				if (w.get_kind(v) == node_kind::stack_root)
+					comp.infinite = true;
+				for (auto *h2 = w.adj_begin(v); h2 != w.adj_end(v); ++h2)
+				{
+					if (w.is_grounded(h2->other) or
+						comp_[h2->other] != no_component)
+						continue;
+					comp_[h2->other] = c;
+					order_.push_back(h2->other);
+					reached_by_.push_back(h2->edge);
+				}
+			}
+			comp.num_nodes = order_.size() - comp.first_node;
+			components_.push_back(comp);
+		}
+	}
+
+	// group the edges by component. An edge between two nodes on the ground
+	// is a component on its own.
+	edge_comp_.assign(w.num_edges(), no_component);
+	for (world::id_t e = 0; e < w.num_edges(); ++e)
+	{
+		if (!w.is_alive(e))
+			continue;
+
+		const world::id_t p1 = w.get_p1(e), p2 = w.get_p2(e);
+		if (w.is_grounded(p1) and w.is_grounded(p2))
+		{
+			edge_comp_[e] = components_.size();
+			components_.push_back({0, 0, 0, 0, 0, false});
+		}
+		else
+			edge_comp_[e] = comp_[w.is_grounded(p1) ? p2 : p1];
+
+		component &comp = components_[edge_comp_[e]];
+		++comp.num_edges;
+		switch (w.get_type(e))
+		{
+		case blue:
+		case red: comp.colours |= red_blue;
+			break;
+		case game::green: comp.colours |= green_only;
+			break;
+		default: comp.infinite = true; // the link of a stack
+		}
+	}
+
+	uint32_t offset = 0;
+	for (component &comp: components_)
+	{
+		comp.first_edge = offset;
+		offset += comp.num_edges;
+		comp.num_edges = 0;
+	}
+	edges_.resize(offset);
+	for (world::id_t e = 0; e < w.num_edges(); ++e)
+	{
+		if (edge_comp_[e] == no_component)
+			continue;
+		component &comp = components_[edge_comp_[e]];
+		edges_[comp.first_edge + comp.num_edges++] = e;
+	}
+}
+
+dyadic evaluator::tree(const world &w, const component &c)
+{
+	const uint32_t first = c.first_node, last = first + c.num_nodes;
+	for (uint32_t i = first; i < last; ++i)
+		values_[order_[i]] = 0;
+
+	// the breadth first order is the tree itself, so every node is done
+	// before the node it hangs from
+	for (uint32_t i = last; i-- > first;)
+	{
+		const world::id_t v = order_[i], e = reached_by_[i];
+		const dyadic above = graft(w.get_type(e), values_[v]);
+		if (i == first)
+			return above;
+		const world::id_t parent = w.get_p1(e) == v ? w.get_p2(e) : w.get_p1(e);
+		values_[parent] += above;
+	}
+	return 0;
+}
+
+surreal evaluator::stacks(const world &w, const component &c)
+{
+	if (c.colours & green_only)
+		throw std::domain_error("the component is not red-blue");
+	const auto root = [&w](world::id_t n) -> const nodes::stack_root &
+	{ return *static_cast<const nodes::stack_root *>(w.get_node(n)); };
+
+	// a stack on the ground on its own, linked or not
+	if (!c.num_nodes)
+		return stack_value(root(w.get_p1(edges_[c.first_edge])));
+	if (!c.num_edges)
+		return stack_value(root(order_[c.first_node]));
+	if (c.num_edges != c.num_nodes)
+		throw std::domain_error("the component has cycles");
+
+	if (above_.size() < w.num_nodes())
+		above_.resize(w.num_nodes());
+	const uint32_t first = c.first_node, last = first + c.num_nodes;
+	for (uint32_t i = first; i < last; ++i)
+	{
+		// a stack that was cut hangs from its root with nothing above it
+		const world::id_t v = order_[i];
+		above_[v] = 0;
+		if (w.get_kind(v) == node_kind::stack_root and
+			w.get_link(v) == world::npos)
+			above_[v] = stack_value(root(v));
+	}
+
+	// like tree(), with the link of a stack standing for its branches
+	for (uint32_t i = last; i-- > first;)
+	{
+		const world::id_t v = order_[i], e = reached_by_[i];
+		const world::id_t parent = w.get_p1(e) == v ? w.get_p2(e) : w.get_p1(e);
+		surreal above;
+		if (w.get_type(e) != invalid)
+			above = graft(w.get_type(e), above_[v]);
+		else if (w.get_p1(e) == parent)
+			above = stack_value(root(parent), above_[v]);
+		else
+			throw std::domain_error("the stack hangs from its limit");
+		if (i == first)
+			return above;
+		above_[parent] += above;
+	}
+	return 0;
+}
+
+void evaluator::localize(const world &w, const component &c)
+{
+	for (uint32_t i = 0; i < c.num_nodes; ++i)
+		local_[order_[c.first_node + i]] = i + 1;
+
+	local_edges_.resize(c.num_edges);
+	for (uint32_t j = 0; j < c.num_edges; ++j)
+	{
+		const world::id_t e = edges_[c.first_edge + j];
+		const world::id_t p1 = w.get_p1(e), p2 = w.get_p2(e);
+		local_edge &le = local_edges_[j];
+		le.p1 = w.is_grounded(p1) ? 0 : local_[p1];
+		le.p2 = w.is_grounded(p2) ? 0 : local_[p2];
+		le.type = w.get_type(e);
+	}
+}
+
+uint64_t evaluator::index(const world &w, const component &c)
+{
+	localize(w, c);
+	incident_.assign(c.num_nodes + 1, 0);
+	keys_.resize(c.num_edges);
+	uint64_t key = 0;
+	for (uint32_t j = 0; j < c.num_edges; ++j)
+	{
+		incident_[local_edges_[j].p1] |= (uint64_t) 1 << j;
+		incident_[local_edges_[j].p2] |= (uint64_t) 1 << j;
+		keys_[j] = w.get_key(edges_[c.first_edge + j]);
+		key ^= keys_[j];
+	}
+	return key;
+}
+
+dyadic evaluator::search(const world &w, const component &c)
+{
+	const uint64_t key = index(w, c);
+	if (!table_)
+	{
+		own_table_ = std::make_unique<transposition_table>();
+		table_ = own_table_.get();
+	}
+	const uint64_t all = c.num_edges == 64 ? ~(uint64_t) 0 :
+						 ((uint64_t) 1 << c.num_edges) - 1;
+	return search(all, key);
+}
+
+dyadic evaluator::search(uint64_t alive, uint64_t key)
+{
+	if (!alive)
+		return 0;
+	dyadic value;
+	if (table_->probe(key, value))
+		return value;
+
+	std::optional<dyadic> left, right;
+	for (uint64_t rest = alive; rest; rest &= rest - 1)
+	{
+		// the key loses the chopped edge and every edge that falls with it
+		const int j = __builtin_ctzll(rest);
+		const uint64_t after = grounded(alive & ~((uint64_t) 1 << j));
+		uint64_t after_key = key;
+		for (uint64_t gone = alive ^ after; gone; gone &= gone - 1)
+			after_key ^= keys_[__builtin_ctzll(gone)];
+
+		const dyadic option = search(after, after_key);
+		if (local_edges_[j].type == blue)
+			left = left ? std::max(*left, option) : option;
+		else
+			right = right ? std::min(*right, option) : option;
+	}
+
+	value = simplest(left, right);
+	table_->store(key, value, __builtin_popcountll(alive));
+	return value;
+}
+
+bool evaluator::lookup(const world &w, const component &c, dyadic &value)
+{
+	if (!tablebase_ or c.num_edges > tablebase_->max_edges() or
+		c.num_nodes > tablebase::MAX_NODES)
+		return false;
+	localize(w, c);
+	tablebase::edge edges[tablebase::MAX_EDGES];
+	for (uint32_t j = 0; j < c.num_edges; ++j)
+		edges[j] = {local_edges_[j].p1, local_edges_[j].p2,
+					local_edges_[j].type};
+	return tablebase_->probe(edges, c.num_edges, value);
+}
+
+uint32_t evaluator::canonical(const world &w, const component &c)
+{
+	const uint64_t key = index(w, c);
+	return canonical(((uint64_t) 1 << c.num_edges) - 1, key);
+}
+
+uint32_t evaluator::canonical(uint64_t alive, uint64_t key)
+{
+	if (!alive)
+		return forms::zero;
+	const auto found = positions_.find(key);
+	if (found != positions_.end())
+		return found->second;
+
+	// blue chops blue and green edges, red chops red and green edges
+	std::vector<forms::id_t> left, right;
+	for (uint64_t rest = alive; rest; rest &= rest - 1)
+	{
+		const int j = __builtin_ctzll(rest);
+		const uint64_t after = grounded(alive & ~((uint64_t) 1 << j));
+		uint64_t after_key = key;
+		for (uint64_t gone = alive ^ after; gone; gone &= gone - 1)
+			after_key ^= keys_[__builtin_ctzll(gone)];
+
+		const forms::id_t option = canonical(after, after_key);
+		if (local_edges_[j].type != red)
+			left.push_back(option);
+		if (local_edges_[j].type != blue)
+			right.push_back(option);
+	}
+
+	const forms::id_t g = forms_->make(std::move(left), std::move(right));
+	positions_.emplace(key, g);
+	return g;
+}
+
+uint64_t evaluator::grounded(uint64_t alive) const
+{
+	// flood the local nodes from the ground, every edge at a reached node is
+	// still held up
+	uint64_t reached = 1, kept = 0;
+	uint32_t stack[64];
+	int top = 0;
+	stack[top++] = 0;
+	while (top)
+	{
+		const uint32_t v = stack[--top];
+		const uint64_t fresh = incident_[v] & alive & ~kept;
+		kept |= fresh;
+		for (uint64_t rest = fresh; rest; rest &= rest - 1)
+		{
+			const local_edge &le = local_edges_[__builtin_ctzll(rest)];
+			const uint32_t other = le.p1 == v ? le.p2 : le.p1;
+			if (!(reached >> other & 1))
+			{
+				reached |= (uint64_t) 1 << other;
+				stack[top++] = other;
+			}
+		}
+	}
+	return kept;
+}
+
+uint64_t evaluator::green(const world &w, const component &c)
+{
+	static constexpr uint32_t unseen = std::numeric_limits<uint32_t>::max();
+
+	localize(w, c);
+	const uint32_t n = c.num_nodes + 1;
+
+	// adjacency lists of the local nodes, without the loops on the ground
+	offsets_.assign(n + 1, 0);
+	for (const local_edge &le: local_edges_)
+	{
+		if (le.p1 == le.p2)
+			continue;
+		++offsets_[le.p1 + 1];
+		++offsets_[le.p2 + 1];
+	}
+	for (uint32_t v = 0; v < n; ++v)
+		offsets_[v + 1] += offsets_[v];
+	adj_.resize(offsets_[n]);
+	next_.assign(offsets_.begin(), offsets_.end() - 1);
+	for (uint32_t j = 0; j < c.num_edges; ++j)
+	{
+		const local_edge &le = local_edges_[j];
+		if (le.p1 == le.p2)
+			continue;
+		adj_[next_[le.p1]++] = {j, le.p2};
+		adj_[next_[le.p2]++] = {j, le.p1};
+	}
+
+	// depth first search from the ground for the lowlinks, iterative so there
+	// is no limit on the depth of the component
+	disc_.assign(n, unseen);
+	low_.assign(n, unseen);
+	tree_edge_.assign(n, unseen);
+	next_.assign(offsets_.begin(), offsets_.end() - 1);
+	preorder_.clear();
+	dfs_.clear();
+
+	disc_[0] = low_[0] = 0;
+	preorder_.push_back(0);
+	dfs_.push_back(0);
+	while (!dfs_.empty())
+	{
+		const uint32_t v = dfs_.back();
+		if (next_[v] < offsets_[v + 1])
+		{
+			const local_half_edge h = adj_[next_[v]++];
+			if (h.edge == tree_edge_[v])
+				continue;
+			if (disc_[h.other] == unseen)
+			{
+				disc_[h.other] = low_[h.other] = preorder_.size();
+				tree_edge_[h.other] = h.edge;
+				preorder_.push_back(h.other);
+				dfs_.push_back(h.other);
+			}
+			else
+				low_[v] = std::min(low_[v], disc_[h.other]);
+			continue;
+		}
+
+		dfs_.pop_back();
+		if (v)
+		{
+			const local_edge &le = local_edges_[tree_edge_[v]];
+			const uint32_t parent = le.p1 == v ? le.p2 : le.p1;
+			low_[parent] = std::min(low_[parent], low_[v]);
+		}
+	}
+
+	// every edge that is not in the tree of the search closes a cycle, so it
+	// becomes a loop worth *1
+	nim_.assign(n, 0);
+	for (uint32_t j = 0; j < c.num_edges; ++j)
+	{
+		const local_edge &le = local_edges_[j];
+		if (tree_edge_[le.p1] != j and tree_edge_[le.p2] != j)
+			nim_[le.p1] ^= 1;
+	}
+
+	// children are done before their parents. A bridge hangs a branch off its
+	// parent, and any other tree edge fuses the child into its parent and
+	// becomes a loop.
+	for (uint32_t i = preorder_.size(); i-- > 1;)
+	{
+		const uint32_t v = preorder_[i];
+		const local_edge &le = local_edges_[tree_edge_[v]];
+		const uint32_t parent = le.p1 == v ? le.p2 : le.p1;
+		if (low_[v] > disc_[parent])
+			nim_[parent] ^= nim_[v] + 1;
+		else
+			nim_[parent] ^= nim_[v] ^ 1;
+	}
+	return nim_[0];
+}
+
+void evaluator::value(const world &w, const component &c, bool closed_forms,
+					  evaluation &result)
+{
+	const auto skip = [&]()
+	{
+		++result.unsupported;
+		if (c.infinite)
+			++result.infinite;
+		else
+			unsupported_.insert(unsupported_.end(),
+								edges_.begin() + c.first_edge,
+								edges_.begin() + c.first_edge + c.num_edges);
+	};
+
+	if (c.infinite)
+	{
+		// red-blue trees with stacks are numbers, which may be infinite
+		try
+		{
+			const surreal v = stacks(w, c);
+			if (v.is_dyadic())
+				result.number += v.get_real();
+			else
+				result.stacks += v;
+			++result.stacked;
+		}
+		catch (const std::domain_error &)
+		{
+			skip();
+		}
+		catch (const std::overflow_error &)
+		{
+			skip();
+		}
+		return;
+	}
+	if (c.colours == mixed)
+	{
+		if (c.num_edges <= canonical_edges_)
+		{
+			result.form = forms_->add(result.form, canonical(w, c));
+			++result.canonical;
+		}
+		else
+			skip();
+		return;
+	}
+	if (c.colours == green_only)
+	{
+		result.nimber ^= green(w, c);
+		++result.green;
+		return;
+	}
+
+	// components whose values do not fit are left out of the sum
+	try
+	{
+		if (closed_forms and c.num_edges == c.num_nodes)
+		{
+			result.number += tree(w, c);
+			++result.trees;
+		}
+		else if (dyadic found; lookup(w, c, found))
+		{
+			result.number += found;
+			++result.tabled;
+		}
+		else if (c.num_edges <= MAX_SEARCH_EDGES)
+		{
+			result.number += search(w, c);
+			++result.searched;
+		}
+		else
+			skip();
+	}
+	catch (const std::overflow_error &)
+	{
+		skip();
+	}
+}
+
+evaluation evaluator::operator()(const world &w, bool closed_forms)
+{
+	split(w);
+	values_.resize(w.num_nodes());
+	local_.resize(w.num_nodes());
+	unsupported_.clear();
+
+	evaluation result;
+	result.components = components_.size();
+	for (const component &c: components_)
+		value(w, c, closed_forms, result);
+	return result;
+}
+
+evaluation evaluator::operator()(const world &w,
+								 const std::vector<world::id_t> &nodes,
+								 const std::vector<world::id_t> &reached_by,
+								 const std::vector<world::id_t> &edges)
+{
+	order_ = nodes;
+	reached_by_ = reached_by;
+	edges_ = edges;
+	if (values_.size() < w.num_nodes())
+	{
+		values_.resize(w.num_nodes());
+		local_.resize(w.num_nodes());
+	}
+	unsupported_.clear();
+
+	component c{0, (uint32_t) nodes.size(), 0, (uint32_t) edges.size(), 0,
+				false};
+	for (world::id_t n: nodes)
+		c.infinite = c.infinite or w.get_kind(n) == node_kind::stack_root;
+	for (world::id_t e: edges)
+	{
+		switch (w.get_type(e))
+		{
+		case blue:
+		case red: c.colours |= red_blue;
+			break;
+		case game::green: c.colours |= green_only;
+			break;
+		default: c.infinite = true; // the link of a stack
+		}
+	}
+	// a component without edges is a stack on the ground linked to nothing,
+	// which is already marked by its root
+
+	evaluation result;
+	result.components = 1;
+	value(w, c, true, result);
+	return result;
+}
+
+outcome evaluator::outcome_of(const evaluation &e)
+{
+	// an infinite number outweighs every finite game
+	if (e.stacks.is_infinite())
+		return e.stacks.sign() > 0 ? outcome::left : outcome::right;
+
+	const surreal x = e.stacks + e.number;
+	if (e.form == forms::zero)
+	{
+		if (x.sign() > 0)
+			return outcome::left;
+		if (x.sign() < 0)
+			return outcome::right;
+		return e.nimber ? outcome::next : outcome::previous;
+	}
+
+	// no number in the form lies between x and the dyadic standing for it, so
+	// the form plays the same against both
+	const forms::id_t g = forms_->add(e.form, forms_->nimber(e.nimber));
+	return forms_->outcome_of(g, x.nearby(forms_->birthday(g)));
+}
+
+void evaluator::print(std::ostream &os, const evaluation &e)
+{
+	if (!e.stacks.is_zero())
+	{
+		// the forms print dyadic numbers only, so the numbers go first
+		os << e.stacks + e.number;
+		if (e.nimber <= forms::MAX_NIMBER)
+		{
+			const forms::id_t g = forms_->add(e.form, forms_->nimber(e.nimber));
+			if (g != forms::zero)
+			{
+				os << " + ";
+				forms_->print(os, g);
+			}
+		}
+		else
+		{
+			os << " + ";
+			if (e.form != forms::zero)
+			{
+				forms_->print(os, e.form);
+				os << " + ";
+			}
+			os << '*' << e.nimber;
+		}
+	}
+	else if (e.nimber <= forms::MAX_NIMBER)
+		forms_->print(os, forms_->add(e.form, forms_->nimber(e.nimber)),
+					  e.number);
+	else
+	{
+		forms_->print(os, e.form, e.number);
+		os << " + *" << e.nimber;
+	}
+	if (!e.exact())
+		os << " + ?";
+}
+
+}
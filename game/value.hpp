@@ -0,0 +1,651 @@
+/**
+ * @file value.hpp
+ * @author Jonah Chen
+ * @brief compute the exact value of the world in the sense of combinatorial
+ * game theory. Blue (the blue player) is Left and counts as positive, red is
+ * Right and counts as negative. The world is a sum of independent components,
+ * the parts of the world that are connected without passing through the
+ * ground, and its value is the sum of the values of its components. Red-blue
+ * components are numbers, green components are nimbers, and small components
+ * mixing the colours are kept as canonical forms. Red-blue components with
+ * infinite stacks are surreal numbers like ω or 22/7.
+ * @version 1.0
+ * @date 2021-11-26
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#pragma once
+
+#include "prereqs.hpp"
+#include "world.hpp"
+#include "common/hash.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace game {
+
+class transposition_table; // forward declaration, see transposition.hpp
+class forms; // forward declaration, see canonical.hpp
+class tablebase; // forward declaration, see tablebase.hpp
+enum class outcome : uint8_t; // forward declaration, see canonical.hpp
+
+/**
+ * @brief an exact dyadic rational num / 2^exp, which is the value of every
+ * finite red-blue hackenbush position.
+ *
+ * @details the value is kept normalized, so the numerator is odd unless the
+ * exponent is 0. Numerators that fit in 64 bits are stored inline, and the
+ * arithmetic on them is done with 128 bit integers. Larger numerators, which
+ * deep trees with many colour changes produce, are stored as an array of 64
+ * bit limbs, so the value is always exact.
+ */
+class dyadic
+{
+public:
+	constexpr dyadic(int64_t integer = 0) : num_(integer), exp_(0)
+	{}
+
+	/**
+	 * @brief the dyadic rational num / 2^exp.
+	 */
+	static dyadic fraction(int64_t num, uint32_t exp);
+
+	/**
+	 * @return true if the numerator fits in 64 bits, so num() is valid.
+	 */
+	inline bool is_narrow() const
+	{ return wide_.empty(); }
+
+	/**
+	 * @pre the numerator fits in 64 bits.
+	 */
+	inline int64_t num() const
+	{ return num_; }
+
+	inline uint32_t exp() const
+	{ return exp_; }
+
+	inline bool is_integer() const
+	{ return exp_ == 0; }
+
+	/**
+	 * @return int the sign of the value: -1, 0 or 1.
+	 */
+	inline int sign() const
+	{ return num_ > 0 ? 1 : num_ < 0 ? -1 : 0; }
+
+	/**
+	 * @return int64_t the largest integer less than or equal to the value.
+	 * @throw std::overflow_error if it does not fit in 64 bits.
+	 */
+	int64_t floor() const;
+
+	/**
+	 * @return dyadic the value multiplied by 2^k.
+	 */
+	dyadic ldexp(int64_t k) const;
+
+	/**
+	 * @return dyadic half of the value.
+	 */
+	inline dyadic half() const
+	{ return ldexp(-1); }
+
+	double to_double() const;
+
+	dyadic operator+(const dyadic &other) const;
+
+	dyadic operator-(const dyadic &other) const;
+
+	dyadic operator-() const;
+
+	inline dyadic &operator+=(const dyadic &other)
+	{ return *this = *this + other; }
+
+	bool operator==(const dyadic &other) const
+	{ return num_ == other.num_ and exp_ == other.exp_ and wide_ == other.wide_; }
+
+	bool operator!=(const dyadic &other) const
+	{ return !(*this == other); }
+
+	bool operator<(const dyadic &other) const;
+
+	bool operator>(const dyadic &other) const
+	{ return other < *this; }
+
+	bool operator<=(const dyadic &other) const
+	{ return !(other < *this); }
+
+	bool operator>=(const dyadic &other) const
+	{ return !(*this < other); }
+
+	/**
+	 * @return uint64_t a hash of the value, for keys made of several values.
+	 */
+	uint64_t hash() const;
+
+	friend std::ostream &operator<<(std::ostream &os, const dyadic &d);
+
+private:
+	int64_t num_; // the numerator, or its sign when it is wide
+	uint32_t exp_;
+	std::vector<uint64_t> wide_; // magnitude of a wide numerator, low limb first
+
+	static dyadic normalize(__int128 num, uint32_t exp);
+
+	static dyadic normalize(bool negative, std::vector<uint64_t> limbs,
+							uint64_t exp);
+
+	std::vector<uint64_t> limbs() const;
+};
+
+std::ostream &operator<<(std::ostream &os, const dyadic &d);
+
+/**
+ * @brief the simplest number strictly between the options of a position, which
+ * is the value of the position when every option is a number and every left
+ * option is less than every right option.
+ *
+ * @param left the best option of the blue player, if any.
+ * @param right the best option of the red player, if any.
+ * @return dyadic the number born earliest that is greater than left and less
+ * than right. 0 if neither player can move.
+ * @throw std::invalid_argument if left is not less than right.
+ */
+dyadic simplest(const std::optional<dyadic> &left,
+				const std::optional<dyadic> &right);
+
+/**
+ * @brief the value of a string of red and blue edges by Berlekamp's sign
+ * expansion rule: every edge up to the first change of colour counts as one,
+ * and every edge after it counts half as much as the one below it.
+ *
+ * @param types the colours of the edges, starting from the ground.
+ * @param n the number of edges.
+ * @return dyadic the value of the string.
+ */
+dyadic string_value(const branch_type *types, std::size_t n);
+
+/**
+ * @brief the value of a position of value x held up by a single edge, which is
+ * how the value of a tree is built from the values of its branches.
+ *
+ * @details for a blue edge, find the smallest integer n >= 1 with x + n > 1,
+ * and the value is (x + n) / 2^(n - 1). A red edge is the mirror image. On a
+ * string of edges this is the same as the sign expansion rule.
+ *
+ * @param type the colour of the edge, red or blue.
+ * @param x the value of the position above the edge.
+ * @return dyadic the value of the edge with the position above it.
+ */
+dyadic graft(branch_type type, const dyadic &x);
+
+/**
+ * @brief a surreal number in Conway normal form, which is the value of a
+ * red-blue position with infinite stacks. It is a finite sum of terms
+ * ω^exponent · coefficient with positive exponents and dyadic coefficients,
+ * plus a real part.
+ *
+ * @details the real part is real + residue / modulus with an odd modulus and
+ * 0 <= residue < modulus, so every value has a single representation. The
+ * modulus is 1 unless the value has a rational part that is not dyadic, like
+ * the 22/7 of an infinite stack of that fraction. The terms are kept in
+ * decreasing order of exponent, and none of their coefficients is 0.
+ */
+class surreal
+{
+public:
+	struct term
+	{
+		int32_t exponent;
+		dyadic coefficient;
+
+		bool operator==(const term &other) const
+		{ return exponent == other.exponent and coefficient == other.coefficient; }
+	};
+
+	surreal(const dyadic &x = 0) : real_(x)
+	{}
+
+	surreal(int64_t x) : real_(x)
+	{}
+
+	/**
+	 * @return surreal ω^exponent · coefficient.
+	 * @pre exponent is positive.
+	 */
+	static surreal omega(const dyadic &coefficient = 1, int32_t exponent = 1);
+
+	/**
+	 * @return surreal the rational num / den.
+	 * @throw std::invalid_argument if den is 0.
+	 */
+	static surreal fraction(int64_t num, int64_t den);
+
+	inline const std::vector<term> &get_terms() const
+	{ return terms_; }
+
+	/**
+	 * @return dyadic the coefficient of ω^exponent, 0 if there is no such term.
+	 */
+	dyadic coefficient(int32_t exponent) const;
+
+	inline const dyadic &get_real() const
+	{ return real_; }
+
+	inline int64_t get_residue() const
+	{ return residue_; }
+
+	inline int64_t get_modulus() const
+	{ return modulus_; }
+
+	inline bool is_infinite() const
+	{ return !terms_.empty(); }
+
+	/**
+	 * @return true if the value is a dyadic rational, which is get_real().
+	 */
+	inline bool is_dyadic() const
+	{ return terms_.empty() and modulus_ == 1; }
+
+	inline bool is_zero() const
+	{ return is_dyadic() and real_.sign() == 0; }
+
+	/**
+	 * @return int the sign of the value: -1, 0 or 1.
+	 */
+	int sign() const;
+
+	/**
+	 * @return int64_t the largest integer less than or equal to the value.
+	 * @pre the value is finite.
+	 * @throw std::overflow_error if it does not fit in 64 bits.
+	 */
+	int64_t floor() const;
+
+	/**
+	 * @return surreal the value multiplied by 2^k.
+	 * @throw std::overflow_error if the value is not dyadic and k is more than
+	 * MAX_SHIFT away from 0.
+	 */
+	surreal ldexp(int64_t k) const;
+
+	/**
+	 * @brief a dyadic that stands for a finite value in comparisons with the
+	 * numbers of exponent at most exp: none of them lies between the two, and
+	 * the dyadic is not one of them unless it is the value itself.
+	 *
+	 * @pre the value is finite.
+	 */
+	dyadic nearby(uint32_t exp) const;
+
+	surreal operator+(const surreal &other) const;
+
+	surreal operator-(const surreal &other) const;
+
+	surreal operator-() const;
+
+	inline surreal &operator+=(const surreal &other)
+	{ return *this = *this + other; }
+
+	inline surreal &operator-=(const surreal &other)
+	{ return *this = *this - other; }
+
+	bool operator==(const surreal &other) const
+	{
+		return terms_ == other.terms_ and real_ == other.real_ and
+			   residue_ == other.residue_ and modulus_ == other.modulus_;
+	}
+
+	bool operator!=(const surreal &other) const
+	{ return !(*this == other); }
+
+	bool operator<(const surreal &other) const
+	{ return (*this - other).sign() < 0; }
+
+	bool operator>(const surreal &other) const
+	{ return other < *this; }
+
+	bool operator<=(const surreal &other) const
+	{ return !(other < *this); }
+
+	bool operator>=(const surreal &other) const
+	{ return !(*this < other); }
+
+	friend std::ostream &operator<<(std::ostream &os, const surreal &s);
+
+	// the largest shift of a value that is not dyadic, which is done one bit
+	// at a time
+	static constexpr int64_t MAX_SHIFT = 1 << 16;
+
+private:
+	std::vector<term> terms_;
+	dyadic real_;
+	int64_t residue_ = 0, modulus_ = 1;
+};
+
+/**
+ * @brief print the value like ω·2 - 1 + 22/7 or -ω·1/2.
+ */
+std::ostream &operator<<(std::ostream &os, const surreal &s);
+
+/**
+ * @brief the value of a position of value x held up by a single edge, like
+ * graft() for dyadic values. An edge under an infinite value of its own colour
+ * adds nothing, as 1 + ω = ω.
+ *
+ * @throw std::domain_error if x is infinite and of the other colour, as the
+ * value is then infinitesimal, which a surreal does not hold.
+ */
+surreal graft(branch_type type, const surreal &x);
+
+/**
+ * @brief the value of a stack with a position of value `above` at its limit,
+ * found from its type generator and its kwargs rather than its branches.
+ *
+ * @details
+ * - A stack of ω blue branches under x = ω·d + r is the sign expansion of x
+ *   with ω pluses in front of the signs of d, which is ω·graft(blue, d) + r.
+ *   On its own it is worth ω, and ω·2 under another one. Red is the mirror.
+ * - An infinite stack of the fraction p/q is worth exactly p/q.
+ * - A stack cut with stack_root::detach(order) is a finite string, which is
+ *   worth its height when it has one colour and is grafted edge by edge
+ *   otherwise.
+ *
+ * @throw std::domain_error if the stack has green branches, or something above
+ * an infinite fraction, or the value is infinitesimal.
+ */
+surreal stack_value(const nodes::stack_root &stack, const surreal &above = 0);
+
+/**
+ * @brief the value of a stack of `size` branches made by a type generator, like
+ * above, for a stack that is not built, such as one in a search.
+ *
+ * @param tgen the type generator of the stack.
+ * @param kwargs the kwargs of the generator.
+ * @param size the number of branches, INF if the stack is infinite.
+ * @param above the value of the position at the limit of the stack.
+ */
+surreal stack_value(nodes::generators::type_gen tgen, void *kwargs,
+					int64_t size, const surreal &above = 0);
+
+/**
+ * @brief the result of evaluating a world, which is worth
+ * number + stacks + *nimber + form.
+ */
+struct evaluation
+{
+	// sum of the values of the red-blue components.
+	dyadic number;
+
+	// sum of the values of the red-blue components with stacks that are not
+	// dyadic, like ω or 22/7.
+	surreal stacks;
+
+	// nim sum of the values of the green components.
+	uint64_t nimber = 0;
+
+	// sum of the values of the mixed components, as a game of the forms of
+	// the evaluator that made it. 0 is forms::zero.
+	uint32_t form = 0;
+
+	// number of components in the world.
+	std::size_t components = 0;
+
+	// number of components valued by the closed form for trees.
+	std::size_t trees = 0;
+
+	// number of components with cycles valued by searching their positions.
+	std::size_t searched = 0;
+
+	// number of components with cycles found in the tablebase instead.
+	std::size_t tabled = 0;
+
+	// number of green components valued by their nim value.
+	std::size_t green = 0;
+
+	// number of mixed components valued by their canonical form.
+	std::size_t canonical = 0;
+
+	// number of red-blue components with stacks valued by stack_value().
+	std::size_t stacked = 0;
+
+	// number of components that could not be valued, because they have
+	// stacks that are not numbers, or have too many edges to search.
+	std::size_t unsupported = 0;
+
+	// number of the unsupported components that have stacks.
+	std::size_t infinite = 0;
+
+	/**
+	 * @return true if every component was valued, so the world is worth
+	 * exactly number + stacks + *nimber + form.
+	 */
+	inline bool exact() const
+	{ return unsupported == 0; }
+};
+
+/**
+ * @brief evaluates the world by splitting it into components, with the ground
+ * fused into a single vertex.
+ *
+ * @details
+ * - A red-blue component that is a tree hanging off the ground is valued
+ *   bottom up in linear time with graft().
+ * - A red-blue component with cycles is valued by searching the positions
+ *   reachable by chopping its edges. The values of the positions are kept in a
+ *   transposition table by their zobrist keys, which are updated as edges are
+ *   chopped or fall. The keys do not depend on the component or the world the
+ *   position is in, so positions searched once are found again when the world
+ *   is evaluated after a chop elsewhere. Only components of at most
+ *   MAX_SEARCH_EDGES edges are searched. With a tablebase, the components
+ *   small enough to be in it are looked up first, see game::tablebase.
+ * - A green component is valued in linear time, whatever its shape. By the
+ *   fusion principle, the nodes of every cycle can be fused into one node,
+ *   turning the edges of the cycle into loops, which are worth *1 each. What
+ *   is left is a tree of bridges, which is valued by the colon principle: a
+ *   node is worth the nim sum of its loops and of (value + 1) of every branch
+ *   hanging off it. The bridges are found with a depth first search.
+ * - A red-blue tree with stacks in it is valued bottom up like other trees,
+ *   with every stack valued by stack_value() from its generator, so a world
+ *   of infinite stacks is valued in linear time. A stack is held in the world
+ *   by a link from its root to the node at its limit, and a stack on the
+ *   ground without a link is a component on its own.
+ * - A component mixing green with red or blue edges is valued by building the
+ *   canonical forms of its positions bottom up, see game::forms. The forms of
+ *   the positions are kept by their zobrist keys, and the forms themselves
+ *   are shared by every evaluation. Only components of at most
+ *   MAX_CANONICAL_EDGES edges are valued this way, as the number of their
+ *   positions grows exponentially and hot positions have large forms.
+ * - The evaluator keeps its buffers between calls, so evaluating the world
+ *   after every chop does not allocate.
+ */
+class evaluator
+{
+public:
+	static constexpr std::size_t MAX_SEARCH_EDGES = 40;
+
+	static constexpr std::size_t MAX_CANONICAL_EDGES = 16;
+
+	/**
+	 * @brief create an evaluator.
+	 *
+	 * @param table the transposition table used by the searches, which may be
+	 * shared with other evaluators on other threads. When it is null, the
+	 * evaluator allocates a table of its own the first time it searches.
+	 */
+	explicit evaluator(transposition_table *table = nullptr);
+
+	evaluator(const evaluator &) = delete;
+
+	evaluator &operator=(const evaluator &) = delete;
+
+	~evaluator();
+
+	/**
+	 * @brief evaluate the world.
+	 *
+	 * @param w the world.
+	 * @param closed_forms whether trees are valued with the closed form. When
+	 * false, trees are searched like any other component, which is only
+	 * useful to check the closed form.
+	 * @return evaluation the value of the world and how it was found.
+	 */
+	evaluation operator()(const world &w, bool closed_forms = true);
+
+	/**
+	 * @brief evaluate a single component of the world, as found by
+	 * game::partition.
+	 *
+	 * @param w the world.
+	 * @param nodes the nodes of the component that are not on the ground, in
+	 * breadth first order from the ground. A component without edges is a
+	 * stack on the ground that is not linked, and its root is its only node.
+	 * @param reached_by the edge every node was first reached by.
+	 * @param edges every edge of the component.
+	 * @return evaluation the value of the component.
+	 */
+	evaluation operator()(const world &w, const std::vector<world::id_t> &nodes,
+						  const std::vector<world::id_t> &reached_by,
+						  const std::vector<world::id_t> &edges);
+
+	/**
+	 * @return the edges of the finite components the last evaluation could
+	 * not value, grouped by component. They can still be searched as a whole,
+	 * see game::solver.
+	 */
+	inline const std::vector<world::id_t> &get_unsupported() const
+	{ return unsupported_; }
+
+	/**
+	 * @brief the outcome class of an exact evaluation made by this evaluator.
+	 *
+	 * @pre e.exact() is true.
+	 * @throw std::overflow_error if e has a form and a nimber larger than
+	 * forms::MAX_NIMBER.
+	 */
+	outcome outcome_of(const evaluation &e);
+
+	/**
+	 * @brief print the value of an evaluation made by this evaluator, like
+	 * 3/4 + ↑*. The components it could not value are printed as ?.
+	 */
+	void print(std::ostream &os, const evaluation &e);
+
+	/**
+	 * @brief set the largest mixed component valued by its canonical form.
+	 * Larger ones are unsupported. 0 leaves every mixed component to be
+	 * searched by game::solver.
+	 */
+	inline void set_canonical_edges(std::size_t edges)
+	{ canonical_edges_ = std::min(edges, MAX_CANONICAL_EDGES); }
+
+	/**
+	 * @brief look red-blue components with cycles up in a tablebase before
+	 * searching them. The tablebase is not owned, and null stops the lookups.
+	 */
+	inline void set_tablebase(const tablebase *t)
+	{ tablebase_ = t; }
+
+	inline forms &get_forms()
+	{ return *forms_; }
+
+private:
+	// the colours of the edges of a component
+	enum colours : uint8_t
+	{
+		red_blue = 0b01,
+		green_only = 0b10,
+		mixed = 0b11
+	};
+
+	// a component, as ranges of the node and edge buffers
+	struct component
+	{
+		uint32_t first_node, num_nodes;
+		uint32_t first_edge, num_edges;
+		uint8_t colours; // bits of the colours enum
+		bool infinite; // whether it contains a stack
+	};
+
+	// the nodes of each component in breadth first order from the ground,
+	// with the edge each node was reached by
+	std::vector<world::id_t> order_;
+	std::vector<world::id_t> reached_by_;
+	std::vector<uint32_t> comp_; // component of every node
+	std::vector<world::id_t> edges_; // edges grouped by component
+	std::vector<uint32_t> edge_comp_; // component of every edge
+	std::vector<component> components_;
+	std::vector<dyadic> values_; // value above every node, by node id
+	std::vector<surreal> above_; // same, for the trees with stacks
+	std::vector<world::id_t> unsupported_; // edges of unsupported components
+
+	// the component being searched, with local node ids (0 is the ground)
+	struct local_edge
+	{
+		uint32_t p1, p2;
+		branch_type type;
+	};
+	std::vector<local_edge> local_edges_;
+	std::vector<uint32_t> local_; // local id of every node, by node id
+	std::vector<uint64_t> incident_; // edges at every local node
+	std::vector<uint64_t> keys_; // zobrist key of every local edge
+	transposition_table *table_;
+	std::unique_ptr<transposition_table> own_table_;
+	const tablebase *tablebase_ = nullptr;
+
+	// the canonical forms of the mixed components and of their positions
+	std::unique_ptr<forms> forms_;
+	std::unordered_map<uint64_t, uint32_t> positions_; // form by zobrist key
+	std::size_t canonical_edges_ = MAX_CANONICAL_EDGES;
+
+	// the green component being valued, as an adjacency list of local ids
+	struct local_half_edge
+	{
+		uint32_t edge, other;
+	};
+	std::vector<uint32_t> offsets_;
+	std::vector<local_half_edge> adj_;
+	std::vector<uint32_t> disc_, low_; // discovery time and lowlink
+	std::vector<uint32_t> next_; // next half edge to explore at every node
+	std::vector<uint32_t> dfs_; // stack of the depth first search
+	std::vector<uint32_t> preorder_; // local nodes in the order discovered
+	std::vector<uint32_t> tree_edge_; // edge each local node was reached by
+	std::vector<uint64_t> nim_; // nim value gathered at every local node
+
+	void split(const world &w);
+
+	void value(const world &w, const component &c, bool closed_forms,
+			   evaluation &result);
+
+	dyadic tree(const world &w, const component &c);
+
+	surreal stacks(const world &w, const component &c);
+
+	dyadic search(const world &w, const component &c);
+
+	bool lookup(const world &w, const component &c, dyadic &value);
+
+	dyadic search(uint64_t alive, uint64_t key);
+
+	uint32_t canonical(const world &w, const component &c);
+
+	uint32_t canonical(uint64_t alive, uint64_t key);
+
+	uint64_t index(const world &w, const component &c);
+
+	uint64_t grounded(uint64_t alive) const;
+
+	void localize(const world &w, const component &c);
+
+	uint64_t green(const world &w, const component &c);
+};
+
+}
@@ -0,0 +1,682 @@
+/**
+ * @file world.cpp
+ * @author Jonah Chen
+ * @brief implement the world graph specified in world.hpp
+ * @version 1.0
+ * @date 2021-11-20
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include "world.hpp"
+#include <unordered_set>
+
+namespace game {
+
+world::id_t world::add_node(node *n, node_kind kind)
+{
+	const id_t id = nodes_.size();
+	const glm::vec3 pos = n->get_pos();
+
+	xs_.push_back(pos.x);
+	ys_.push_back(pos.y);
+	zs_.push_back(pos.z);
+	kinds_.push_back(kind);
+	nodes_.push_back(n);
+	present_.push_back(true);
+	grounded_.push_back(pos.y == 0.0f);
+	parent_.push_back(npos);
+	marks_.push_back(0);
+	slots_.push_back(0);
+	stack_slots_[0].push_back(npos);
+	stack_slots_[1].push_back(npos);
+	file(id);
+	if (kind == node_kind::stack_root)
+	{
+		stacks_.push_back(id);
+		list_stack(id);
+	}
+
+	// reserve the initial range at the end of the pool
+	ranges_.push_back({(uint32_t) pool_.size(), 0, INITIAL_CAPACITY});
+	pool_.resize(pool_.size() + INITIAL_CAPACITY);
+
+	n->set_id(id);
+	++version_;
+	return id;
+}
+
+world::id_t world::add_edge(edge *e)
+{
+	if (!e)
+		return npos;
+
+	const id_t p1 = e->p1->get_id();
+	const id_t p2 = e->p2->get_id();
+	if (p1 == npos or p2 == npos)
+		return npos;
+
+	e->id = insert_edge(e, e->type, p1, p2);
+	return e->id;
+}
+
+world::id_t world::add_link(id_t root, id_t limit)
+{
+	return insert_edge(nullptr, invalid, root, limit);
+}
+
+world::id_t world::get_link(id_t root) const
+{
+	for (const half_edge *h = adj_begin(root); h != adj_end(root); ++h)
+		if (types_[h->edge] == invalid and ends_[h->edge].p1 == root)
+			return h->edge;
+	return npos;
+}
+
+world::id_t world::insert_edge(edge *e, branch_type type, id_t p1, id_t p2)
+{
+	const id_t id = edges_.size();
+
+	if (e)
+		reach_ = std::max(reach_, glm::length(get_pos(p1) - get_pos(p2)));
+
+	ends_.push_back({p1, p2});
+	types_.push_back(type);
+	edges_.push_back(e);
+	alive_.push_back(true);
+	keys_.push_back(edge_key(p1, p2, type));
+	key_ ^= keys_.back();
+	move_slots_[0].push_back(npos);
+	move_slots_[1].push_back(npos);
+	list_edge(id);
+
+	push_half_edge(p1, {id, p2});
+	push_half_edge(p2, {id, p1});
+	++version_;
+	return id;
+}
+
+void world::remove_edge(id_t e)
+{
+	if (!alive_[e])
+		return;
+
+	alive_[e] = false;
+	key_ ^= keys_[e];
+	unlist_edge(e);
+	erase_half_edge(ends_[e].p1, e);
+	erase_half_edge(ends_[e].p2, e);
+	++version_;
+}
+
+void world::restore_edge(id_t e)
+{
+	if (alive_[e])
+		return;
+
+	alive_[e] = true;
+	key_ ^= keys_[e];
+	list_edge(e);
+	push_half_edge(ends_[e].p1, {e, ends_[e].p2});
+	push_half_edge(ends_[e].p2, {e, ends_[e].p1});
+	++version_;
+}
+
+// an edge is a move for the players of its colour, and green for both
+void world::list_edge(id_t e)
+{
+	if (types_[e] == invalid)
+		return;
+	if (types_[e] != red)
+		enlist(moves_[side(blue)], move_slots_[side(blue)], e);
+	if (types_[e] != blue)
+		enlist(moves_[side(red)], move_slots_[side(red)], e);
+}
+
+void world::unlist_edge(id_t e)
+{
+	for (int s = 0; s < 2; ++s)
+		if (move_slots_[s][e] != npos)
+			delist(moves_[s], move_slots_[s], e);
+}
+
+// any branch left in the stack may be chopped, which keeps those below it, so
+// the player has a move if their first branch or green branch is left
+void world::list_stack(id_t n)
+{
+	const auto *root = static_cast<const nodes::stack_root *>(nodes_[n]);
+	const int64_t size = root->size();
+	for (branch_type player: {blue, red})
+	{
+		for (branch_type type: {player, green})
+		{
+			const int64_t order = nodes::generators::first(
+					root->get_type_gen(), root->get_kwargs(), type);
+			if (order != NOT_FOUND and (size == INF or order < size))
+			{
+				enlist(stack_moves_[side(player)], stack_slots_[side(player)],
+					   n);
+				break;
+			}
+		}
+	}
+}
+
+void world::unlist_stack(id_t n)
+{
+	for (int s = 0; s < 2; ++s)
+		if (stack_slots_[s][n] != npos)
+			delist(stack_moves_[s], stack_slots_[s], n);
+}
+
+void world::enlist(std::vector<id_t> &list, std::vector<uint32_t> &slots,
+				   id_t x)
+{
+	slots[x] = list.size();
+	list.push_back(x);
+}
+
+// swap with the last of the list
+void world::delist(std::vector<id_t> &list, std::vector<uint32_t> &slots,
+				   id_t x)
+{
+	const uint32_t slot = slots[x];
+	list[slot] = list.back();
+	slots[list[slot]] = slot;
+	list.pop_back();
+	slots[x] = npos;
+}
+
+void world::restack(id_t root)
+{
+	unlist_stack(root);
+	if (present_[root])
+		list_stack(root);
+}
+
+// keep the capacity of the arrays so the next world does not reallocate them
+void world::clear()
+{
+	xs_.clear();
+	ys_.clear();
+	zs_.clear();
+	kinds_.clear();
+	nodes_.clear();
+	ranges_.clear();
+	present_.clear();
+	grounded_.clear();
+	parent_.clear();
+	marks_.clear();
+	epoch_ = 0;
+	cells_.clear();
+	slots_.clear();
+	stacks_.clear();
+	for (int s = 0; s < 2; ++s)
+	{
+		moves_[s].clear();
+		stack_moves_[s].clear();
+		move_slots_[s].clear();
+		stack_slots_[s].clear();
+	}
+	reach_ = 0.0f;
+	++version_; // never goes back, so old versions are not seen again
+	pool_.clear();
+	tombstones_ = 0;
+	ends_.clear();
+	types_.clear();
+	edges_.clear();
+	alive_.clear();
+	keys_.clear();
+	key_ = 0;
+}
+
+// the key depends on the positions of the nodes but not on their order, so
+// the key of an edge does not depend on its id or on how it was attached
+uint64_t world::edge_key(id_t p1, id_t p2, branch_type type) const
+{
+	uint64_t a = hashing::combine(hashing::bits(xs_[p1]),
+								  hashing::bits(ys_[p1]),
+								  hashing::bits(zs_[p1]));
+	uint64_t b = hashing::combine(hashing::bits(xs_[p2]),
+								  hashing::bits(ys_[p2]),
+								  hashing::bits(zs_[p2]));
+	if (a > b)
+		std::swap(a, b);
+	return hashing::mix(a ^ hashing::mix(b + (uint8_t) type));
+}
+
+// append to the range of the node, moving it to the end of the pool when full
+void world::push_half_edge(id_t n, half_edge h)
+{
+	range &r = ranges_[n];
+	if (r.size == r.capacity)
+	{
+		const uint32_t begin = pool_.size();
+		pool_.resize(pool_.size() + 2 * r.capacity);
+		std::copy(pool_.begin() + r.begin, pool_.begin() + r.begin + r.size,
+				  pool_.begin() + begin);
+
+		tombstones_ += r.capacity;
+		r.begin = begin;
+		r.capacity *= 2;
+	}
+	pool_[r.begin + r.size++] = h;
+
+	if (tombstones_ * 2 > pool_.size())
+		compact();
+}
+
+// order of the half edges does not matter, so swap with the last one
+void world::erase_half_edge(id_t n, id_t e)
+{
+	range &r = ranges_[n];
+	half_edge *first = pool_.data() + r.begin;
+	half_edge *last = first + r.size;
+	for (half_edge *h = first; h != last; ++h)
+	{
+		if (h->edge == e)
+		{
+			*h = *(last - 1);
+			--r.size;
+			return;
+		}
+	}
+}
+
+// rebuild the pool so the ranges are contiguous in node order
+void world::compact()
+{
+	std::vector<half_edge> pool;
+	pool.reserve(pool_.size() - tombstones_);
+
+	for (range &r: ranges_)
+	{
+		const uint32_t begin = pool.size();
+		pool.insert(pool.end(), pool_.begin() + r.begin,
+					pool_.begin() + r.begin + r.capacity);
+		r.begin = begin;
+	}
+
+	pool_.swap(pool);
+	tombstones_ = 0;
+}
+
+// start a new traversal, so every node is unmarked
+void world::next_epoch()
+{
+	if (!++epoch_)
+	{
+		std::fill(marks_.begin(), marks_.end(), 0);
+		epoch_ = 1;
+	}
+}
+
+/**
+ * @details breadth first search from the nodes on the ground that were added
+ * since `first`, which sets the parent of every node it reaches.
+ */
+void world::settle(id_t first, fallout &out)
+{
+	next_epoch();
+	std::vector<id_t> queue;
+	for (id_t n = first; n < nodes_.size(); ++n)
+	{
+		if (grounded_[n] and present_[n])
+		{
+			marks_[n] = epoch_;
+			queue.push_back(n);
+		}
+	}
+
+	for (std::size_t i = 0; i < queue.size(); ++i)
+	{
+		for (const half_edge *h = adj_begin(queue[i]);
+			 h != adj_end(queue[i]); ++h)
+		{
+			if (marks_[h->other] != epoch_ and !grounded_[h->other])
+			{
+				marks_[h->other] = epoch_;
+				parent_[h->other] = h->edge;
+				queue.push_back(h->other);
+			}
+		}
+	}
+
+	std::vector<id_t> unsupported;
+	for (id_t n = first; n < nodes_.size(); ++n)
+		if (present_[n] and marks_[n] != epoch_)
+			unsupported.push_back(n);
+	drop(unsupported, out);
+}
+
+void world::cut(id_t e, fallout &out)
+{
+	if (!alive_[e])
+		return;
+
+	const id_t p1 = ends_[e].p1;
+	const id_t p2 = ends_[e].p2;
+	const id_t child = parent_[p1] == e ? p1 : parent_[p2] == e ? p2 : npos;
+	remove_edge(e);
+
+	if (child == npos) // not in the spanning forest, nothing falls
+		return;
+
+	// mark the subtree hanging off the edge, using the forest edges only
+	next_epoch();
+	std::vector<id_t> subtree{child};
+	marks_[child] = epoch_;
+	for (std::size_t i = 0; i < subtree.size(); ++i)
+	{
+		for (const half_edge *h = adj_begin(subtree[i]);
+			 h != adj_end(subtree[i]); ++h)
+		{
+			if (parent_[h->other] == h->edge)
+			{
+				marks_[h->other] = epoch_;
+				subtree.push_back(h->other);
+			}
+		}
+	}
+
+	// every node outside the subtree is held up by the ground, so any edge
+	// leaving the subtree can replace the edge that was cut.
+	for (id_t n: subtree)
+	{
+		for (const half_edge *h = adj_begin(n); h != adj_end(n); ++h)
+		{
+			if (marks_[h->other] == epoch_)
+				continue;
+
+			// rehang the subtree from the replacement by reversing the parents
+			// on the path from n up to the old child.
+			id_t edge = h->edge;
+			id_t cur = n;
+			while (true)
+			{
+				const id_t up = parent_[cur];
+				out.parents.emplace_back(cur, up);
+				parent_[cur] = edge;
+				if (cur == child)
+					return;
+				edge = up;
+				cur = ends_[up].p1 == cur ? ends_[up].p2 : ends_[up].p1;
+			}
+		}
+	}
+
+	drop(subtree, out);
+}
+
+// the nodes first, so the edges have both ends to be put back at
+void world::uncut(id_t e, const fallout &fallen)
+{
+	for (id_t n: fallen.nodes)
+	{
+		if (present_[n])
+			continue;
+		present_[n] = true;
+		file(n);
+		if (kinds_[n] == node_kind::stack_root)
+		{
+			stacks_.push_back(n);
+			list_stack(n);
+		}
+	}
+	for (auto it = fallen.edges.rbegin(); it != fallen.edges.rend(); ++it)
+		restore_edge(*it);
+	restore_edge(e);
+	for (auto it = fallen.parents.rbegin(); it != fallen.parents.rend(); ++it)
+		parent_[it->first] = it->second;
+}
+
+// remove the nodes and every edge attached to them
+void world::drop(const std::vector<id_t> &nodes, fallout &out)
+{
+	for (id_t n: nodes)
+	{
+		while (ranges_[n].size)
+		{
+			const id_t e = pool_[ranges_[n].begin + ranges_[n].size - 1].edge;
+			out.edges.push_back(e);
+			remove_edge(e);
+		}
+		present_[n] = false;
+		out.parents.emplace_back(n, parent_[n]);
+		parent_[n] = npos;
+		unfile(n);
+		if (kinds_[n] == node_kind::stack_root)
+		{
+			stacks_.erase(std::find(stacks_.begin(), stacks_.end(), n));
+			unlist_stack(n);
+		}
+		out.nodes.push_back(n);
+	}
+}
+
+void world::file(id_t n)
+{
+	cell &c = cells_[cell_key(cell_of(xs_[n]), cell_of(ys_[n]),
+							  cell_of(zs_[n]))];
+	slots_[n] = c.ids.size();
+	c.ids.push_back(n);
+	c.xs.push_back(xs_[n]);
+	c.ys.push_back(ys_[n]);
+	c.zs.push_back(zs_[n]);
+}
+
+// swap with the last node of the cell, and drop the cell once it is empty
+void world::unfile(id_t n)
+{
+	auto it = cells_.find(cell_key(cell_of(xs_[n]), cell_of(ys_[n]),
+								   cell_of(zs_[n])));
+	cell &c = it->second;
+	const uint32_t slot = slots_[n];
+	c.ids[slot] = c.ids.back();
+	c.xs[slot] = c.xs.back();
+	c.ys[slot] = c.ys.back();
+	c.zs[slot] = c.zs.back();
+	slots_[c.ids[slot]] = slot;
+	c.ids.pop_back();
+	c.xs.pop_back();
+	c.ys.pop_back();
+	c.zs.pop_back();
+	if (c.ids.empty())
+		cells_.erase(it);
+}
+
+// the edges of a node inside the volume, links are not rendered
+void world::collect(edge::container &edges, id_t n, const frustum *view) const
+{
+	for (const half_edge *h = adj_begin(n); h != adj_end(n); ++h)
+	{
+		if (!edges_[h->edge])
+			continue;
+		if (!view or view->intersects(get_pos(n), get_pos(h->other),
+									  CULL_MARGIN))
+			edges.insert(edges_[h->edge]);
+	}
+}
+
+/**
+ * @details every node in the world is held up by the ground, so the nodes are
+ * taken straight from the cells of the grid. When the volume spans more cells
+ * than are occupied, the occupied cells are scanned instead.
+ */
+void world::visible(edge::container &edges, const glm::vec3 &bottomleft,
+					const glm::vec3 &topright) const
+{
+	visible(edges, bottomleft, topright, nullptr);
+}
+
+void world::visible(edge::container &edges, const glm::vec3 &bottomleft,
+					const glm::vec3 &topright, const frustum &view) const
+{
+	visible(edges, bottomleft, topright, &view);
+}
+
+void world::visible(edge::container &edges, const glm::vec3 &bottomleft,
+					const glm::vec3 &topright, const frustum *view) const
+{
+	edge::container branches;
+	for (id_t n: stacks_)
+	{
+		node::container children;
+		static_cast<nodes::stack_root *>(nodes_[n])->collect(
+				children, bottomleft, topright);
+		for (node *child: children)
+			child->render(branches);
+	}
+	for (edge *e: branches)
+		if (!view or view->intersects(e->p1->get_pos(), e->p2->get_pos(),
+									  CULL_MARGIN))
+			edges.insert(e);
+
+	std::vector<uint32_t> hits;
+	auto search = [&](const cell &c) {
+		hits.resize(c.ids.size());
+		const std::size_t count = kernels::contained(
+				c.xs.data(), c.ys.data(), c.zs.data(), c.ids.size(),
+				bottomleft, topright, hits.data());
+		for (std::size_t i = 0; i < count; ++i)
+			collect(edges, c.ids[hits[i]], view);
+	};
+
+	const int32_t x0 = cell_of(bottomleft.x), x1 = cell_of(topright.x);
+	const int32_t y0 = cell_of(bottomleft.y), y1 = cell_of(topright.y);
+	const int32_t z0 = cell_of(bottomleft.z), z1 = cell_of(topright.z);
+	const double num_cells = (double) (x1 - x0 + 1) * (y1 - y0 + 1) *
+							 (z1 - z0 + 1);
+	const float reach = reach_ + CULL_MARGIN;
+
+	if (num_cells > (double) cells_.size())
+	{
+		for (const auto &c: cells_)
+			search(c.second);
+		return;
+	}
+
+	for (int32_t x = x0; x <= x1; ++x)
+	{
+		for (int32_t y = y0; y <= y1; ++y)
+		{
+			for (int32_t z = z0; z <= z1; ++z)
+			{
+				auto c = cells_.find(cell_key(x, y, z));
+				if (c == cells_.end())
+					continue;
+
+				// the edges of a node reach outside its cell, so the cell is
+				// grown by the length of the longest edge before culling it
+				const glm::vec3 corner(x * CELL_SIZE, y * CELL_SIZE,
+									   z * CELL_SIZE);
+				const glm::vec3 grow(reach, reach, reach);
+				if (view and !view->intersects_box(
+						corner - grow,
+						corner + glm::vec3(CELL_SIZE, CELL_SIZE, CELL_SIZE) +
+						grow))
+					continue;
+				search(c->second);
+			}
+		}
+	}
+}
+
+/**
+ * @return the distance between the line through `origin` along `dir` and the
+ * segment from p1 to p2.
+ */
+static float line_distance(const glm::vec3 &origin, const glm::vec3 &dir,
+						   const glm::vec3 &p1, const glm::vec3 &p2)
+{
+	// components perpendicular to the line
+	glm::vec3 a = p1 - origin;
+	glm::vec3 b = p2 - p1;
+	a -= dir * glm::dot(a, dir);
+	b -= dir * glm::dot(b, dir);
+
+	const float bb = glm::dot(b, b);
+	const float t = bb > FLOAT_EPSILON
+					? glm::clamp(-glm::dot(a, b) / bb, 0.0f, 1.0f) : 0.0f;
+	return glm::length(a + b * t);
+}
+
+/**
+ * @details the ray is cut into pieces one cell long. Every edge within the
+ * radius of the ray has an end within `reach_ + radius` of it, so the cells
+ * overlapping the box around each piece grown by that much are searched.
+ */
+void world::pick(std::vector<edge *> &edges, const glm::vec3 &origin,
+				 const glm::vec3 &dir, float radius, float range) const
+{
+	const std::size_t first = edges.size();
+	const float grow = reach_ + radius;
+	const glm::vec3 g(grow, grow, grow);
+
+	// the closest point of an edge that starts in front may be behind
+	const glm::vec3 start = origin - dir * grow;
+	const glm::vec3 end = origin + dir * range;
+
+	auto near = [&](const glm::vec3 &p1, const glm::vec3 &p2) {
+		return line_distance(origin, dir, p1, p2) < radius;
+	};
+
+	edge::container branches;
+	for (id_t n: stacks_)
+	{
+		node::container children;
+		static_cast<nodes::stack_root *>(nodes_[n])->collect(
+				children, glm::min(start, end) - glm::vec3(radius, radius, radius),
+				glm::max(start, end) + glm::vec3(radius, radius, radius));
+		for (node *child: children)
+			child->render(branches);
+	}
+	for (edge *e: branches)
+		if (near(e->p1->get_pos(), e->p2->get_pos()))
+			edges.push_back(e);
+
+	std::unordered_set<uint64_t> seen;
+	const int pieces = (int) std::ceil((range + grow) / CELL_SIZE);
+	for (int i = 0; i < pieces; ++i)
+	{
+		const glm::vec3 a = start + dir * (i * CELL_SIZE);
+		const glm::vec3 b = start + dir * std::min((i + 1) * CELL_SIZE,
+												   range + grow);
+		const glm::vec3 lo = glm::min(a, b) - g;
+		const glm::vec3 hi = glm::max(a, b) + g;
+
+		for (int32_t x = cell_of(lo.x); x <= cell_of(hi.x); ++x)
+		{
+			for (int32_t y = cell_of(lo.y); y <= cell_of(hi.y); ++y)
+			{
+				for (int32_t z = cell_of(lo.z); z <= cell_of(hi.z); ++z)
+				{
+					const uint64_t key = cell_key(x, y, z);
+					if (!seen.insert(key).second)
+						continue;
+					auto c = cells_.find(key);
+					if (c == cells_.end())
+						continue;
+
+					for (id_t n: c->second.ids)
+					{
+						for (const half_edge *h = adj_begin(n);
+							 h != adj_end(n); ++h)
+						{
+							if (edges_[h->edge] and
+								near(get_pos(n), get_pos(h->other)))
+								edges.push_back(edges_[h->edge]);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	// an edge is found from both of its ends when both are near the ray
+	std::sort(edges.begin() + first, edges.end());
+	edges.erase(std::unique(edges.begin() + first, edges.end()), edges.end());
+}
+
+}
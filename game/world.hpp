@@ -0,0 +1,496 @@
+/**
+ * @file world.hpp
+ * @author Jonah Chen
+ * @brief compact storage of the world graph used by the hot loops of the game.
+ * Nodes are given dense ids, their positions are stored as structure of arrays
+ * and the adjacency of every node is a small contiguous range inside a single
+ * pool, so traversing the world does not chase pointers or hash anything.
+ * @version 1.0
+ * @date 2021-11-20
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#pragma once
+
+#include "prereqs.hpp"
+#include "nodes.hpp"
+#include "frustum.hpp"
+#include "kernels.hpp"
+#include "common/hash.hpp"
+#include <cmath>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace game {
+
+/**
+ * @brief the kind of a node stored in the world. The hot loops switch on this
+ * tag instead of going through the virtual methods of game::node.
+ * - normal:     a game::nodes::normal node.
+ * - stack_root: a game::nodes::stack_root node, which generates its children.
+ */
+enum class node_kind : uint8_t
+{
+	normal = 0,
+	stack_root
+};
+
+/**
+ * @brief The world graph. It mirrors the nodes and edges owned by the game, and
+ * is updated whenever edges are attached or detached.
+ *
+ * @details
+ * - Node positions are stored in three arrays (x, y, z) indexed by node id.
+ * - Every node owns a range [begin, begin + capacity) of the adjacency pool,
+ *   of which the first `size` half edges are used. When a range is full it is
+ *   moved to the end of the pool with double the capacity. The abandoned slots
+ *   are tombstones that are reclaimed by compacting the pool once they make up
+ *   more than half of it.
+ * - Edges are stored by id. Removed edges are marked dead but keep their id,
+ *   so ids held elsewhere never point to a different edge.
+ * - The link between a stack root and the node at the limit of its stack is
+ *   stored as an edge without a game::edge, so it is traversed but never
+ *   rendered.
+ * - Every node that is held up by the ground stores the edge to its parent in
+ *   a spanning forest rooted at the nodes on the ground (y = 0). Nodes that
+ *   lose their connection to the ground are removed from the world right away,
+ *   so every node in the world is held up by the ground.
+ * - The nodes are also filed into a uniform grid of cubic cells, hashed by
+ *   their integer coordinates. A node is filed when it is added and unfiled
+ *   when it falls, so a query of a volume only looks at the cells overlapping
+ *   it. Stack roots are also kept in a separate list, as their stacks can
+ *   reach far outside the cell of the root.
+ * - Every edge has a zobrist key that depends only on the positions of its
+ *   nodes and its colour, and the key of the world is the XOR of the keys of
+ *   the edges in it. The key is updated whenever an edge is added or removed,
+ *   so positions reached by chopping the same edges in any order have the
+ *   same key, in this world or any other.
+ * - The edges each player may chop, blue and green edges for blue and red and
+ *   green edges for red, are kept in a list per player along with the slot of
+ *   every edge in it. An edge is listed when it is added or put back and
+ *   swapped out when it is removed, so the moves are listed without a
+ *   traversal. The stack roots with a branch the player may chop are listed
+ *   the same way, and looked at again with restack() when their stack is cut.
+ *
+ * @warning the world does not own the nodes or edges it refers to.
+ */
+class world
+{
+public:
+	using id_t = uint32_t;
+	static constexpr id_t npos = no_id;
+
+	/**
+	 * @brief an entry of the adjacency pool: the edge and the node on the other
+	 * side of it.
+	 */
+	struct half_edge
+	{
+		id_t edge;
+		id_t other;
+	};
+
+	/**
+	 * @brief the nodes and edges that lost their connection to the ground, and
+	 * were removed from the world because of it.
+	 */
+	struct fallout
+	{
+		std::vector<id_t> nodes;
+		std::vector<id_t> edges;
+
+		// every node whose edge towards the ground changed, with the edge it
+		// had, in the order they changed
+		std::vector<std::pair<id_t, id_t>> parents;
+
+		inline void clear()
+		{
+			nodes.clear();
+			edges.clear();
+			parents.clear();
+		}
+	};
+
+	world() = default;
+
+	world(const world &) = delete;
+
+	world &operator=(const world &) = delete;
+
+	world(world &&) = default;
+
+	world &operator=(world &&) = default;
+
+	/**
+	 * @brief add a node to the world and assign it the next dense id.
+	 *
+	 * @param n pointer to the node to add.
+	 * @param kind the kind of the node.
+	 * @return id_t the id assigned to the node.
+	 */
+	id_t add_node(node *n, node_kind kind);
+
+	/**
+	 * @brief add an edge between two nodes that are already in the world.
+	 *
+	 * @param e pointer to the edge returned by game::attach.
+	 * @return id_t the id assigned to the edge, which is also written to e->id.
+	 * @return npos if the edge is null, as game::attach returns when a node
+	 * refuses it, or if one of the nodes of the edge is not in the world.
+	 */
+	id_t add_edge(edge *e);
+
+	/**
+	 * @brief add the link between a stack root and the node at the limit of
+	 * its stack.
+	 *
+	 * @param root id of the stack root.
+	 * @param limit id of the node at the limit of the stack.
+	 * @return id_t the id of the link.
+	 */
+	id_t add_link(id_t root, id_t limit);
+
+	/**
+	 * @brief remove an edge or link from the world. Does nothing if the edge
+	 * is already removed.
+	 *
+	 * @param e id of the edge.
+	 */
+	void remove_edge(id_t e);
+
+	/**
+	 * @brief connect the nodes added since `first` to the ground. Must be
+	 * called after a batch of nodes and edges is added. Nodes that are not
+	 * connected to the ground are removed along with their edges.
+	 *
+	 * @param first id of the first node that was added.
+	 * @param out the nodes and edges that were removed.
+	 */
+	void settle(id_t first, fallout &out);
+
+	/**
+	 * @brief remove an edge or link that is chopped, along with everything that
+	 * loses its connection to the ground because of it.
+	 *
+	 * @details when the edge is not in the spanning forest, nothing falls. When
+	 * it is, the subtree hanging off it is searched for another edge connecting
+	 * it to the rest of the world. If one is found, the subtree is rehung from
+	 * that edge, otherwise the whole subtree falls. The cost is proportional to
+	 * the size of the subtree, never to the size of the world.
+	 *
+	 * @param e id of the edge.
+	 * @param out the nodes and edges that fell, excluding e itself.
+	 */
+	void cut(id_t e, fallout &out);
+
+	/**
+	 * @brief undo cut(): put back an edge or link along with everything that
+	 * fell with it, and the spanning forest as it was. The cost is
+	 * proportional to what fell.
+	 *
+	 * @pre nothing was cut after e, or everything cut after it was put back.
+	 *
+	 * @param e id of the edge.
+	 * @param fallen what cut() reported for e.
+	 */
+	void uncut(id_t e, const fallout &fallen);
+
+	/**
+	 * @brief look at the stack of a stack root again for the lists of moves,
+	 * after it was cut with stack_root::detach() or put back with
+	 * stack_root::restore().
+	 *
+	 * @param root id of the stack root.
+	 */
+	void restack(id_t root);
+
+	/**
+	 * @brief remove every node and edge from the world.
+	 */
+	void clear();
+
+	inline std::size_t num_nodes() const
+	{ return nodes_.size(); }
+
+	inline std::size_t num_edges() const
+	{ return edges_.size(); }
+
+	inline glm::vec3 get_pos(id_t n) const
+	{ return glm::vec3(xs_[n], ys_[n], zs_[n]); }
+
+	inline node_kind get_kind(id_t n) const
+	{ return kinds_[n]; }
+
+	inline node *get_node(id_t n) const
+	{ return nodes_[n]; }
+
+	inline edge *get_edge(id_t e) const
+	{ return edges_[e]; }
+
+	inline bool is_alive(id_t e) const
+	{ return alive_[e]; }
+
+	inline bool is_present(id_t n) const
+	{ return present_[n]; }
+
+	inline bool is_grounded(id_t n) const
+	{ return grounded_[n]; }
+
+	/**
+	 * @return id_t the edge from the node towards the ground in the spanning
+	 * forest, or npos for nodes on the ground.
+	 */
+	inline id_t get_parent(id_t n) const
+	{ return parent_[n]; }
+
+	inline branch_type get_type(id_t e) const
+	{ return types_[e]; }
+
+	inline id_t get_p1(id_t e) const
+	{ return ends_[e].p1; }
+
+	inline id_t get_p2(id_t e) const
+	{ return ends_[e].p2; }
+
+	/**
+	 * @return pointer to the first half edge of the node.
+	 */
+	inline const half_edge *adj_begin(id_t n) const
+	{ return pool_.data() + ranges_[n].begin; }
+
+	/**
+	 * @return pointer past the last half edge of the node.
+	 */
+	inline const half_edge *adj_end(id_t n) const
+	{ return pool_.data() + ranges_[n].begin + ranges_[n].size; }
+
+	/**
+	 * @return the edges a player may chop, in no particular order.
+	 *
+	 * @param player the player, blue or red.
+	 */
+	inline const std::vector<id_t> &get_moves(branch_type player) const
+	{ return moves_[side(player)]; }
+
+	/**
+	 * @return the stack roots whose stacks have a branch a player may chop, in
+	 * no particular order.
+	 *
+	 * @param player the player, blue or red.
+	 */
+	inline const std::vector<id_t> &get_stack_moves(branch_type player) const
+	{ return stack_moves_[side(player)]; }
+
+	/**
+	 * @return std::size_t the number of edges and stacks a player may chop
+	 * from.
+	 */
+	inline std::size_t num_moves(branch_type player) const
+	{ return moves_[side(player)].size() + stack_moves_[side(player)].size(); }
+
+	/**
+	 * @return true if a player has a branch to chop.
+	 * @return false if the game is over when it is their turn.
+	 */
+	inline bool has_move(branch_type player) const
+	{ return num_moves(player) != 0; }
+
+	/**
+	 * @return id_t the link from a stack root to the node at the limit of its
+	 * stack, npos if the stack was cut or the node is not a stack root.
+	 */
+	id_t get_link(id_t root) const;
+
+	/**
+	 * @brief collect the edges that should be rendered in a volume given by
+	 * two diagonally opposite corners. The edges of nodes inside the volume are
+	 * collected. Stack roots contribute the generated branches of their stacks.
+	 * Only the cells of the grid overlapping the volume are visited, so the
+	 * cost does not depend on the size of the world.
+	 *
+	 * @param edges container to add the visible edges to.
+	 * @param bottomleft 3d position of the bottom left corner of the volume.
+	 * @param topright 3d position of the top right corner of the volume.
+	 */
+	void visible(edge::container &edges, const glm::vec3 &bottomleft,
+				 const glm::vec3 &topright) const;
+
+	/**
+	 * @brief same as above, but also skip the cells and edges that are
+	 * outside the view frustum of the camera.
+	 *
+	 * @param edges container to add the visible edges to.
+	 * @param bottomleft 3d position of the bottom left corner of the volume.
+	 * @param topright 3d position of the top right corner of the volume.
+	 * @param view the view frustum of the camera.
+	 */
+	void visible(edge::container &edges, const glm::vec3 &bottomleft,
+				 const glm::vec3 &topright, const frustum &view) const;
+
+	/**
+	 * @brief collect the edges that pass within a distance of a ray, by
+	 * walking the cells of the grid along the ray. Stack roots contribute the
+	 * generated branches of their stacks near the ray.
+	 *
+	 * @details every edge whose distance to the line of the ray is less than
+	 * the radius is collected, as long as it is within `range` of the origin
+	 * along the ray. Edges that are further away may be collected as well.
+	 *
+	 * @param edges vector to add the edges to, each edge is added once.
+	 * @param origin 3d position of the origin of the ray.
+	 * @param dir normalized direction of the ray.
+	 * @param radius maximum distance of the edges from the line of the ray.
+	 * @param range maximum distance along the ray.
+	 */
+	void pick(std::vector<edge *> &edges, const glm::vec3 &origin,
+			  const glm::vec3 &dir, float radius, float range) const;
+
+	/**
+	 * @return uint64_t a number that changes every time a node or edge is
+	 * added to or removed from the world.
+	 */
+	inline uint64_t get_version() const
+	{ return version_; }
+
+	/**
+	 * @return uint64_t the zobrist key of an edge, which is the same for every
+	 * edge between the same positions with the same colour.
+	 */
+	inline uint64_t get_key(id_t e) const
+	{ return keys_[e]; }
+
+	/**
+	 * @return uint64_t the zobrist key of the world, the XOR of the keys of the
+	 * edges in it.
+	 * @warning two edges between the same nodes with the same colour cancel
+	 * out, so the world must not have parallel edges, as game::attach requires.
+	 */
+	inline uint64_t get_key() const
+	{ return key_; }
+
+private:
+	struct range
+	{
+		uint32_t begin;
+		uint32_t size;
+		uint32_t capacity;
+	};
+
+	struct endpoints
+	{
+		id_t p1;
+		id_t p2;
+	};
+
+	static constexpr uint32_t INITIAL_CAPACITY = 4;
+
+	// edge length of a cell of the grid
+	static constexpr float CELL_SIZE = 4.0f;
+
+	// distance outside the frustum an edge may reach, as edges and nodes are
+	// drawn with a width
+	static constexpr float CULL_MARGIN = 0.2f;
+
+	// nodes
+	std::vector<float> xs_, ys_, zs_;
+	std::vector<node_kind> kinds_;
+	std::vector<node *> nodes_;
+	std::vector<range> ranges_;
+	std::vector<uint8_t> present_;
+	std::vector<uint8_t> grounded_;
+	std::vector<id_t> parent_;
+
+	// visited marks of the traversals, a node is marked when its entry is epoch_
+	std::vector<uint32_t> marks_;
+	uint32_t epoch_ = 0;
+
+	// adjacency pool and the number of tombstones in it
+	std::vector<half_edge> pool_;
+	std::size_t tombstones_ = 0;
+
+	// the nodes of a cell of the grid, with copies of their positions so the
+	// cell can be tested with the batch kernels
+	struct cell
+	{
+		std::vector<id_t> ids;
+		std::vector<float> xs, ys, zs;
+	};
+
+	// the cells of the grid, and the slot of every node in its cell. Stack
+	// roots are also listed on their own.
+	std::unordered_map<uint64_t, cell> cells_;
+	std::vector<uint32_t> slots_;
+	std::vector<id_t> stacks_;
+	float reach_ = 0.0f; // length of the longest edge ever added
+	uint64_t version_ = 0;
+
+	// edges
+	std::vector<endpoints> ends_;
+	std::vector<branch_type> types_;
+	std::vector<edge *> edges_;
+	std::vector<uint8_t> alive_;
+	std::vector<uint64_t> keys_;
+	uint64_t key_ = 0;
+
+	// the edges and stacks the players may chop, blue first, and the slot of
+	// every edge and stack root in them, npos if it is not listed
+	std::vector<id_t> moves_[2], stack_moves_[2];
+	std::vector<uint32_t> move_slots_[2], stack_slots_[2];
+
+	id_t insert_edge(edge *e, branch_type type, id_t p1, id_t p2);
+
+	void restore_edge(id_t e);
+
+	void push_half_edge(id_t n, half_edge h);
+
+	void erase_half_edge(id_t n, id_t e);
+
+	void compact();
+
+	void list_edge(id_t e);
+
+	void unlist_edge(id_t e);
+
+	void list_stack(id_t n);
+
+	void unlist_stack(id_t n);
+
+	static void enlist(std::vector<id_t> &list, std::vector<uint32_t> &slots,
+					   id_t x);
+
+	static void delist(std::vector<id_t> &list, std::vector<uint32_t> &slots,
+					   id_t x);
+
+	inline static int side(branch_type player)
+	{ return player == blue ? 0 : 1; }
+
+	uint64_t edge_key(id_t p1, id_t p2, branch_type type) const;
+
+	void next_epoch();
+
+	void drop(const std::vector<id_t> &nodes, fallout &out);
+
+	void file(id_t n);
+
+	void unfile(id_t n);
+
+	void visible(edge::container &edges, const glm::vec3 &bottomleft,
+				 const glm::vec3 &topright, const frustum *view) const;
+
+	void collect(edge::container &edges, id_t n, const frustum *view) const;
+
+	inline static int32_t cell_of(float x)
+	{ return (int32_t) std::floor(x / CELL_SIZE); }
+
+	// pack the coordinates of a cell into 21 bits each
+	inline static uint64_t cell_key(int32_t x, int32_t y, int32_t z)
+	{
+		return ((uint64_t) (x & 0x1fffff) << 42) |
+			   ((uint64_t) (y & 0x1fffff) << 21) | (uint64_t) (z & 0x1fffff);
+	}
+};
+
+}
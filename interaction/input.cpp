@@ -1,46 +1,5 @@
 #include "input.hpp"
 
-/**
- * @brief calculate the minimum distance between a ray and a line segment. The 
- * ray is defined by the forward and position vectors, and the line segment is 
- * described by the two endpoints p1 and p2.
- * 
- * @param forward a vec3 describing the normalized forward vector of the camera.
- * @param position a vec3 describing the position of the camera.
- * @param p1 a vec3 describing the position of one endpoint of a branch.
- * @param p2 a vec3 describing the position of the other endpoint of a branch.
- * @return a float describing the minimum distance between the ray of the 
- * forward vector and the branch.
- * @return infinity if the branch is behind the player.
- */
-static float calc_min_distance(const glm::vec3 &forward, const glm::vec3 &pos,
-							   const glm::vec3 &p1, const glm::vec3 &p2)
-{
-	// check if the line segment is in behind of the camera
-	const glm::vec3 to_p1 = p1 - pos;
-	const glm::vec3 to_p2 = p2 - pos;
-
-	if (glm::dot(forward, to_p2) <= 0 and glm::dot(forward, to_p1) <= 0)
-		return std::numeric_limits<float>::infinity();
-
-	const float min_dist_to_p1 = glm::length(glm::cross(forward, to_p1));
-	const float min_dist_to_p2 = glm::length(glm::cross(forward, to_p2));
-	const float min_dist_to_endpoint = glm::min(min_dist_to_p1, min_dist_to_p2);
-	const float dist_to_midpoint = glm::length(glm::cross(forward,
-														  (to_p2 + to_p1) *
-														  0.5f));
-
-	const glm::vec3 normal = glm::cross(forward, p2 - p1);
-	const float line_min_dist = glm::abs(
-			glm::dot(pos - p1, normal) / glm::length
-					(normal));
-
-	return min_dist_to_endpoint < line_min_dist or
-		   min_dist_to_endpoint < dist_to_midpoint
-		   ? min_dist_to_endpoint
-		   : line_min_dist;
-}
-
 user_inputs user_inputs::fetch(GLFWwindow *window)
 {
 	user_inputs inputs;
@@ -124,20 +83,5 @@ execute_movement(render::camera &camera, const game::properties &properties,
 game::edge *select(const render::camera &camera, const game::properties
 &properties, const user_inputs &inputs, const game::edge::container &candidates)
 {
-	float min_dist = MIN_WACK_DISTANCE;
-	game::edge *selected = nullptr;
-	for (game::edge *candidate: candidates)
-	{
-		const glm::vec3 p1 = candidate->p1->get_pos();
-		const glm::vec3 p2 = candidate->p2->get_pos();
-		const float dist = calc_min_distance(camera.get_forward(),
-											 camera.get_pos(), p1, p2);
-		if (dist < min_dist)
-		{
-			min_dist = dist;
-			selected = candidate;
-		}
-	}
-	return selected;
+	return select_linear(camera.get_forward(), camera.get_pos(), candidates);
 }
-
@@ -19,6 +19,7 @@
 #include <sstream>
 #include <GLFW/glfw3.h>
 #include "game/game.hpp"
+#include "pick.hpp"
 
 #define     YPOS(IN) ( ((IN).fp)[1] )
 #define     XPOS(IN) ( ((IN).fp)[0] )
@@ -36,7 +37,6 @@
 
 #define DOWN(KEY, CUR, PREV) (KEY(CUR) and !KEY(PREV))
 
-#define MIN_WACK_DISTANCE 0.17f
 
 /**
  * @brief class storing the use input data at a given frame. Members should not 
@@ -0,0 +1,100 @@
+#include "pick.hpp"
+#include <functional>
+
+float calc_min_distance(const glm::vec3 &forward, const glm::vec3 &pos,
+						const glm::vec3 &p1, const glm::vec3 &p2)
+{
+	// check if the line segment is in behind of the camera
+	const glm::vec3 to_p1 = p1 - pos;
+	const glm::vec3 to_p2 = p2 - pos;
+
+	if (glm::dot(forward, to_p2) <= 0 and glm::dot(forward, to_p1) <= 0)
+		return std::numeric_limits<float>::infinity();
+
+	const float min_dist_to_p1 = glm::length(glm::cross(forward, to_p1));
+	const float min_dist_to_p2 = glm::length(glm::cross(forward, to_p2));
+	const float min_dist_to_endpoint = glm::min(min_dist_to_p1, min_dist_to_p2);
+	const float dist_to_midpoint = glm::length(glm::cross(forward,
+														  (to_p2 + to_p1) *
+														  0.5f));
+
+	const glm::vec3 normal = glm::cross(forward, p2 - p1);
+	const float line_min_dist = glm::abs(
+			glm::dot(pos - p1, normal) / glm::length
+					(normal));
+
+	return min_dist_to_endpoint < line_min_dist or
+		   min_dist_to_endpoint < dist_to_midpoint
+		   ? min_dist_to_endpoint
+		   : line_min_dist;
+}
+
+/**
+ * @brief whether a candidate at distance `dist` should replace the selected
+ * edge. Edges sharing the node closest to the ray are equally close, so ties
+ * go to the edge at the lower address, independent of the order of the
+ * candidates.
+ */
+static inline bool closer(float dist, game::edge *candidate, float min_dist,
+						  game::edge *selected)
+{
+	return dist < min_dist or (dist == min_dist and selected and
+							   std::less<game::edge *>()(candidate, selected));
+}
+
+game::edge *select_linear(const glm::vec3 &forward, const glm::vec3 &pos,
+						  const game::edge::container &candidates)
+{
+	float min_dist = MIN_WACK_DISTANCE;
+	game::edge *selected = nullptr;
+	for (game::edge *candidate: candidates)
+	{
+		const glm::vec3 p1 = candidate->p1->get_pos();
+		const glm::vec3 p2 = candidate->p2->get_pos();
+		const float dist = calc_min_distance(forward, pos, p1, p2);
+		if (closer(dist, candidate, min_dist, selected))
+		{
+			min_dist = dist;
+			selected = candidate;
+		}
+	}
+	return selected;
+}
+
+game::edge *picker::select(const glm::vec3 &forward, const glm::vec3 &pos,
+						   const game::world &world,
+						   const game::edge::container &candidates,
+						   float range)
+{
+	if (forward == forward_ and pos == pos_ and
+		world.get_version() == version_ and
+		candidates.size() == num_candidates_)
+		return selected_;
+
+	forward_ = forward;
+	pos_ = pos;
+	version_ = world.get_version();
+	num_candidates_ = candidates.size();
+
+	// the rounding of calc_min_distance may differ slightly from the world's
+	near_.clear();
+	world.pick(near_, pos, forward, MIN_WACK_DISTANCE * 1.01f + FLOAT_EPSILON,
+			   range);
+
+	float min_dist = MIN_WACK_DISTANCE;
+	selected_ = nullptr;
+	for (game::edge *candidate: near_)
+	{
+		if (!candidates.count(candidate))
+			continue;
+		const float dist = calc_min_distance(forward, pos,
+											 candidate->p1->get_pos(),
+											 candidate->p2->get_pos());
+		if (closer(dist, candidate, min_dist, selected_))
+		{
+			min_dist = dist;
+			selected_ = candidate;
+		}
+	}
+	return selected_;
+}
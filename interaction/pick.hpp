@@ -0,0 +1,95 @@
+/**
+ * @file pick.hpp
+ * @author Jonah Chen
+ * @brief find the branch the player is aiming at. Kept apart from input.hpp so
+ * it can be used without a window.
+ * @version 1.0
+ * @date 2021-11-23
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#pragma once
+
+#include "game/prereqs.hpp"
+#include "game/world.hpp"
+#include <limits>
+#include <vector>
+
+#define MIN_WACK_DISTANCE 0.17f
+
+/**
+ * @brief calculate the minimum distance between a ray and a line segment. The
+ * ray is defined by the forward and position vectors, and the line segment is
+ * described by the two endpoints p1 and p2.
+ *
+ * @param forward a vec3 describing the normalized forward vector of the camera.
+ * @param position a vec3 describing the position of the camera.
+ * @param p1 a vec3 describing the position of one endpoint of a branch.
+ * @param p2 a vec3 describing the position of the other endpoint of a branch.
+ * @return a float describing the minimum distance between the ray of the
+ * forward vector and the branch.
+ * @return infinity if the branch is behind the player.
+ */
+float calc_min_distance(const glm::vec3 &forward, const glm::vec3 &pos,
+						const glm::vec3 &p1, const glm::vec3 &p2);
+
+/**
+ * @brief Find the selected edge by testing every candidate. The selected edge
+ * is the edge closest to the direction the player is facing, and must be
+ * within MIN_WACK_DISTANCE of it. Ties go to the edge at the lower address.
+ *
+ * @param forward normalized direction the player is facing.
+ * @param pos position of the player.
+ * @param candidates a collection of edges that are currently rendered on the
+ * screen.
+ * @return a pointer to the selected edge.
+ * @return nullptr if no edge should be selected.
+ */
+game::edge *select_linear(const glm::vec3 &forward, const glm::vec3 &pos,
+						  const game::edge::container &candidates);
+
+/**
+ * @brief Find the selected edge with the grid of the world, and remember it
+ * until the player moves or the world changes.
+ *
+ * @details the world is asked for the edges near the ray the player is facing.
+ * Only those are measured with calc_min_distance, which is never less than the
+ * distance between the line of the ray and the edge. So the same edge is
+ * selected as by select_linear.
+ */
+class picker
+{
+public:
+	/**
+	 * @brief Find the selected edge.
+	 *
+	 * @param forward normalized direction the player is facing.
+	 * @param pos position of the player.
+	 * @param world the world the candidates are taken from.
+	 * @param candidates a collection of edges that are currently rendered on
+	 * the screen. Only these can be selected.
+	 * @param range distance from the player beyond which there are no
+	 * candidates.
+	 * @return a pointer to the selected edge.
+	 * @return nullptr if no edge should be selected.
+	 */
+	game::edge *select(const glm::vec3 &forward, const glm::vec3 &pos,
+					   const game::world &world,
+					   const game::edge::container &candidates, float range);
+
+	/**
+	 * @brief forget the cached selection.
+	 */
+	inline void invalidate()
+	{ version_ = std::numeric_limits<uint64_t>::max(); }
+
+private:
+	glm::vec3 forward_;
+	glm::vec3 pos_;
+	uint64_t version_ = std::numeric_limits<uint64_t>::max();
+	std::size_t num_candidates_ = 0;
+	game::edge *selected_ = nullptr;
+	std::vector<game::edge *> near_;
+};
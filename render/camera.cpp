@@ -18,7 +18,8 @@ camera::camera(const glm::vec3 &pos,
 			   const glm::vec3 &up,
 			   float fov, float aspect, float znear, float zfar,
 			   float ground_level)
-		: pos_(pos), ground_level_(ground_level)
+		: fov_(fov), aspect_(aspect), near_(znear), pos_(pos),
+		  ground_level_(ground_level)
 {
 	projection_ = glm::perspective(fov, aspect, znear, zfar);
 	forward_ = glm::normalize(forward);
@@ -58,6 +59,13 @@ void camera::translate(float forward, float up, float right)
 		pos_.y = ground_level_;
 }
 
+game::frustum camera::get_frustum(float render_distance) const
+{
+	return game::frustum(
+			glm::perspective(fov_, aspect_, near_, render_distance) *
+			glm::lookAt(pos_, pos_ + forward_, up_));
+}
+
 void camera::set_view_projection(shader &shader) const
 {
 	shader.set_uniform("u_view", glm::lookAt(pos_, pos_ + forward_, up_));
@@ -17,6 +17,7 @@
 
 #include "common/constants.hpp"
 #include "game/prereqs.hpp"
+#include "game/frustum.hpp"
 #include "shader.hpp"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -54,6 +55,15 @@ public:
 					  const game::properties &cur_state,
 					  float render_distance_) const;
 
+	/**
+	 * @brief get the view frustum of the camera, with the far plane at the
+	 * render distance instead of the far plane of the projection.
+	 *
+	 * @param render_distance distance to the far plane.
+	 * @return game::frustum the planes of the view frustum.
+	 */
+	game::frustum get_frustum(float render_distance) const;
+
 	/**
 	 * @brief
 	 *
@@ -68,6 +78,9 @@ public:
 
 private:
 	glm::mat4 projection_;
+	float fov_;
+	float aspect_;
+	float near_;
 	glm::vec3 pos_;
 	glm::vec3 forward_;
 	glm::vec3 up_;
@@ -1,4 +1,5 @@
 #include "geometry.hpp"
+#include "game/kernels.hpp"
 
 /**
  * @brief Calculate the indices for multiple cubes, which acts as nodes to 
@@ -128,23 +129,23 @@ void nodes::__update(const game::properties &cur_state)
 
 	count_ = num_nodes * 6 * 6; // 6 faces, 6 vertices per quad
 
-	std::vector<float> vertices;
-	vertices.reserve(num_nodes * 3 * 8);
+	// gather the positions, then build the cubes in blocks
+	std::vector<float> xs, ys, zs;
+	xs.reserve(num_nodes);
+	ys.reserve(num_nodes);
+	zs.reserve(num_nodes);
 	for (game::node *n: nodes)
 	{
 		glm::vec3 pos = n->get_pos();
-		pos.x -= width_ / 2.0f;
-		pos.y -= width_ / 2.0f;
-		pos.z -= width_ / 2.0f;
-
-		for (uint8_t corner = 0b000; corner <= 0b111; ++corner)
-		{
-			vertices.push_back(pos.x + (bool) (corner & 0b001) * width_);
-			vertices.push_back(pos.y + (bool) (corner & 0b010) * width_);
-			vertices.push_back(pos.z + (bool) (corner & 0b100) * width_);
-		}
+		xs.push_back(pos.x);
+		ys.push_back(pos.y);
+		zs.push_back(pos.z);
 	}
 
+	std::vector<float> vertices(num_nodes * 3 * 8);
+	game::kernels::node_cubes(xs.data(), ys.data(), zs.data(), num_nodes,
+							  width_, vertices.data());
+
 	glBufferSubData(GL_ARRAY_BUFFER, 0x0, vertices.size() * sizeof(float),
 					vertices.data());
 }
@@ -172,45 +173,39 @@ void edges::__update(const game::properties &cur_state)
 
 	count_ = num_edges * 4 * 6; // 4 faces, 6 vertices per quad
 
-	std::vector<vertex> vertices;
-	vertices.reserve(count_); // 7 floats per vertex
-
-
+	// gather the end points, then build the prisms in blocks
+	std::vector<float> ends(num_edges * 6);
+	float *x1 = ends.data(), *y1 = x1 + num_edges, *z1 = y1 + num_edges;
+	float *x2 = z1 + num_edges, *y2 = x2 + num_edges, *z2 = y2 + num_edges;
+	std::size_t i = 0;
 	for (game::edge *e: edges)
 	{
 		glm::vec3 p1 = e->p1->get_pos();
 		glm::vec3 p2 = e->p2->get_pos();
-		glm::vec4 color = branch_color(e->type);
-
-		glm::vec3 dir = p2 - p1;
-		// find 2 orthogonal vectors to dir
-		glm::vec3 test_vector;
-		if (dir.x and dir.y) test_vector.z = 1.0f;
-		else test_vector.x = 1.0f;
-
-		glm::vec3 ortho1 = glm::normalize(glm::cross(test_vector, dir));
-		glm::vec3 ortho2 = glm::normalize(glm::cross(ortho1, dir)) * width_;
-		ortho1 *= width_;
-
-		// get the "bottomleft" vertex position
-		p1 -= ortho1 / 2.0f + ortho2 / 2.0f;
-		p2 -= ortho1 / 2.0f + ortho2 / 2.0f;
-
-		// bottom vertices
-		vertices.push_back({p1, color});
-		vertices.push_back({p1 + ortho1, color});
-		vertices.push_back({p1 + ortho2, color});
-		vertices.push_back({p1 + ortho1 + ortho2, color});
-
-		// top vertices
-		vertices.push_back({p2, color});
-		vertices.push_back({p2 + ortho1, color});
-		vertices.push_back({p2 + ortho2, color});
-		vertices.push_back({p2 + ortho1 + ortho2, color});
+		x1[i] = p1.x;
+		y1[i] = p1.y;
+		z1[i] = p1.z;
+		x2[i] = p2.x;
+		y2[i] = p2.y;
+		z2[i] = p2.z;
+		++i;
 	}
 
-	glBufferSubData(GL_ARRAY_BUFFER, 0x0, vertices.size() * sizeof(vertex),
-					vertices.data());
+	// the positions and colours are stored in separate regions of the buffer,
+	// so the prisms are written contiguously
+	std::vector<float> positions(num_edges * 8 * 3);
+	game::kernels::edge_prisms({x1, y1, z1, x2, y2, z2}, num_edges, width_,
+							   positions.data());
+
+	std::vector<glm::vec4> colors;
+	colors.reserve(num_edges * 8);
+	for (game::edge *e: edges)
+		colors.insert(colors.end(), 8, branch_color(e->type));
+
+	glBufferSubData(GL_ARRAY_BUFFER, 0x0, positions.size() * sizeof(float),
+					positions.data());
+	glBufferSubData(GL_ARRAY_BUFFER, max_edges_ * 8 * 3 * sizeof(float),
+					colors.size() * sizeof(glm::vec4), colors.data());
 }
 
 
@@ -282,15 +277,15 @@ edges::edges(shader &shader, float width, std::size_t max_edges)
 				 indices.data(), GL_STATIC_DRAW);
 
 	// allocate memory for the vertex buffer
-	// 8 vertices per node * 7 floats per vertex
-
-	glBufferData(GL_ARRAY_BUFFER, max_edges * 8 * sizeof(vertex), nullptr,
+	// 8 vertices per edge * 3 floats for the positions, followed by
+	// 8 vertices per edge * 4 floats for the colors
+	glBufferData(GL_ARRAY_BUFFER, max_edges * 8 * 7 * sizeof(float), nullptr,
 				 GL_DYNAMIC_DRAW);
 
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(vertex),
-						  (void *) offsetof(vertex, pos));
-	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(vertex),
-						  (void *) offsetof(vertex, color));
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float),
+						  (void *) 0x0);
+	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float),
+						  (void *) (max_edges * 8 * 3 * sizeof(float)));
 
 	unbind();
 }
@@ -135,12 +135,6 @@ public:
 				   RENDER_LIMIT);
 
 private:
-	struct vertex
-	{
-		glm::vec3 pos;
-		glm::vec4 color;
-	};
-
 	std::size_t max_edges_;
 	float width_;
 
@@ -0,0 +1,110 @@
+/**
+ * @file bench_forest.cxx
+ * @author Jonah Chen
+ * @brief time random chops on a large forest of red-blue and green trees, whose
+ * values game::partition keeps up to date down the chopped path instead of
+ * valuing the chopped tree again. Valuing the whole forest once is timed for
+ * scale, and checks the value left after the last chop.
+ *
+ * Usage: bench_forest [number of edges] [number of chops] [edges per tree]
+ * @version 1.0
+ * @date 2021-12-11
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include "game/prereqs.hpp"
+#include "game/nodes.hpp"
+#include "game/world.hpp"
+#include "game/value.hpp"
+#include "game/partition.hpp"
+#include "tests/fixture.hpp"
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using clk = std::chrono::steady_clock;
+
+struct bench_world : test_world
+{
+	// trees of the given size hanging from one ground node each, every node
+	// hanging from a random earlier one. Every third tree is green.
+	void build(std::size_t total, std::size_t size, std::mt19937 &rng)
+	{
+		nodes.reserve(total + total / size + 1);
+		edges.reserve(total);
+		for (std::size_t t = 0; t * size < total; ++t)
+		{
+			const float x = 2.0f * t;
+			std::vector<game::world::id_t> ids{node(x, 0.0f), node(x, 1.0f)};
+			edge(t % 3 == 2 ? game::green : game::blue, ids[0], ids[1]);
+			for (std::size_t i = 2; i <= size; ++i)
+			{
+				ids.push_back(node(x + 1.0f / i, (float) i));
+				const game::world::id_t below = ids[1 + rng() % (ids.size() - 2)];
+				edge(t % 3 == 2 ? game::green :
+					 rng() % 2 ? game::blue : game::red, below, ids.back());
+			}
+		}
+		game::world::fallout fallen;
+		world.settle(0, fallen);
+	}
+};
+
+int main(int argc, char **argv)
+{
+	const std::size_t total = argc > 1 ? std::stoul(argv[1]) : 1000000;
+	const int chops = argc > 2 ? std::stoi(argv[2]) : 10000;
+	const std::size_t size = argc > 3 ? std::stoul(argv[3]) : 1000;
+
+	std::mt19937 rng(21);
+	bench_world w;
+	w.build(total, size, rng);
+
+	game::partition parts;
+	auto start = clk::now();
+	parts.build(w.world);
+	const double built = std::chrono::duration<double>(clk::now() -
+													   start).count();
+
+	// the edges are drawn from every edge there was, skipping the dead ones
+	const game::world::id_t edges = w.world.num_edges();
+	double chopped = 0.0;
+	std::size_t fell = 0;
+	int done = 0;
+	for (game::world::fallout fallen; done < chops and fell < edges; ++done)
+	{
+		game::world::id_t e;
+		do
+			e = rng() % edges;
+		while (!w.world.is_alive(e));
+
+		fallen.clear();
+		start = clk::now();
+		w.world.cut(e, fallen);
+		parts.update(w.world, e, &fallen);
+		chopped += std::chrono::duration<double>(clk::now() - start).count();
+		fell += fallen.edges.size() + 1;
+	}
+
+	game::evaluator evaluate;
+	start = clk::now();
+	const game::evaluation expected = evaluate(w.world);
+	const double full = std::chrono::duration<double>(clk::now() -
+													  start).count();
+	const game::evaluation &got = parts.get_value(w.world);
+	assert(got.number == expected.number and got.nimber == expected.nimber);
+
+	std::cout << edges << " edges in trees of " << size << ", " << done
+			  << " chops, " << (double) fell / done << " edges fell per chop\n"
+			  << "build the partition:      " << built * 1e3 << " ms\n"
+			  << "evaluate the whole world: " << full * 1e3 << " ms\n"
+			  << "cut and update:           " << chopped / done * 1e6
+			  << " us per chop\n";
+	return 0;
+}
@@ -0,0 +1,139 @@
+/**
+ * @file bench_frustum.cxx
+ * @author Jonah Chen
+ * @brief count the edges submitted to the renderer per frame with the axis
+ * aligned viewport alone and with view frustum culling, while a camera walks
+ * and looks around a forest of trees like the ones in testworld.hkb.
+ *
+ * Usage: bench_frustum [number of trees] [frames]
+ * @version 1.0
+ * @date 2021-11-22
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include "game/prereqs.hpp"
+#include "game/nodes.hpp"
+#include "game/world.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <string>
+
+using clk = std::chrono::high_resolution_clock;
+
+int main(int argc, char **argv)
+{
+	const int num_trees = argc > 1 ? std::stoi(argv[1]) : 2000;
+	const int frames = argc > 2 ? std::stoi(argv[2]) : 1000;
+	constexpr float render_distance = 15.0f; // same as main.cxx
+
+	std::mt19937 rng(3);
+	std::uniform_real_distribution<float> coord(-80.0f, 80.0f);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+	// trees of 5 to 20 branches, each branch ending 1 unit higher
+	std::vector<std::unique_ptr<game::nodes::normal>> nodes;
+	std::vector<std::unique_ptr<game::edge>> edges;
+	game::world world;
+	for (int t = 0; t < num_trees; ++t)
+	{
+		const std::size_t root = nodes.size();
+		nodes.emplace_back(new game::nodes::normal(
+				glm::vec3(coord(rng), 0.0f, coord(rng))));
+		world.add_node(nodes.back().get(), game::node_kind::normal);
+
+		const int branches = 5 + rng() % 16;
+		for (int b = 0; b < branches; ++b)
+		{
+			game::nodes::normal *parent =
+					nodes[root + rng() % (nodes.size() - root)].get();
+			nodes.emplace_back(new game::nodes::normal(
+					parent->get_pos() + glm::vec3(unit(rng), 1.0f, unit(rng))));
+			world.add_node(nodes.back().get(), game::node_kind::normal);
+			edges.emplace_back(game::attach(
+					(game::branch_type) (rng() % 3 - 1), parent,
+					nodes.back().get()));
+			world.add_edge(edges.back().get());
+		}
+	}
+	game::world::fallout fallen;
+	world.settle(0, fallen);
+
+	const glm::mat4 projection = glm::perspective(1.4f, 16.0f / 9.0f, 0.1f,
+												  render_distance);
+	std::size_t box_edges = 0, frustum_edges = 0;
+	std::chrono::duration<double> t_box(0), t_frustum(0);
+
+	glm::vec3 pos(0.0f, 0.5f, 0.0f);
+	float yaw = 0.0f;
+	for (int f = 0; f < frames; ++f)
+	{
+		// walk forward while turning, and look up and down
+		yaw += 0.01f;
+		const float pitch = 0.6f * std::sin(f * 0.05f);
+		const glm::vec3 forward(std::cos(yaw) * std::cos(pitch),
+								std::sin(pitch),
+								std::sin(yaw) * std::cos(pitch));
+		const glm::vec3 flat(std::cos(yaw), 0.0f, std::sin(yaw));
+		const glm::vec3 right(-flat.z, 0.0f, flat.x);
+		const glm::vec3 up = glm::cross(right, forward);
+		pos += flat * 0.1f;
+
+		// the viewport computed by render::camera::get_viewport
+		const float x_min = std::min(std::min(right.x, -right.x),
+									 std::min(flat.x + right.x,
+											  flat.x - right.x));
+		const float x_max = std::max(std::max(right.x, -right.x),
+									 std::max(flat.x + right.x,
+											  flat.x - right.x));
+		const float z_min = std::min(std::min(right.z, -right.z),
+									 std::min(flat.z + right.z,
+											  flat.z - right.z));
+		const float z_max = std::max(std::max(right.z, -right.z),
+									 std::max(flat.z + right.z,
+											  flat.z - right.z));
+		const glm::vec3 bottomleft = pos + glm::vec3(x_min, -1.0f, z_min) *
+										   render_distance;
+		const glm::vec3 topright = pos + glm::vec3(x_max, 1.0f, z_max) *
+										 render_distance;
+
+		game::edge::container in_box, in_frustum;
+		auto start = clk::now();
+		world.visible(in_box, bottomleft, topright);
+		t_box += clk::now() - start;
+
+		start = clk::now();
+		const game::frustum view(projection *
+								 glm::lookAt(pos, pos + forward, up));
+		world.visible(in_frustum, bottomleft, topright, view);
+		t_frustum += clk::now() - start;
+
+		box_edges += in_box.size();
+		frustum_edges += in_frustum.size();
+
+		// culling never drops an edge with an end clearly inside the frustum
+		for (game::edge *e: in_box)
+		{
+			bool inside = true;
+			for (int i = 0; i < 6; ++i)
+				inside = inside and view.distance(i, e->p1->get_pos()) > 0.0f;
+			assert(!inside or in_frustum.count(e));
+		}
+		for (game::edge *e: in_frustum)
+			assert(in_box.count(e));
+	}
+
+	std::cout << edges.size() << " edges, " << frames << " frames\n"
+			  << "viewport only:   " << (double) box_edges / frames
+			  << " edges/frame, " << t_box.count() / frames * 1e6
+			  << " us/frame\n"
+			  << "frustum culling: " << (double) frustum_edges / frames
+			  << " edges/frame, " << t_frustum.count() / frames * 1e6
+			  << " us/frame\n";
+	return 0;
+}
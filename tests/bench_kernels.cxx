@@ -0,0 +1,82 @@
+/**
+ * @file bench_kernels.cxx
+ * @author Jonah Chen
+ * @brief measure the throughput of the batch kernels with every instruction
+ * set supported by the processor.
+ *
+ * Usage: bench_kernels [number of edges] [iterations]
+ * @version 1.0
+ * @date 2021-11-24
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include "game/kernels.hpp"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using clk = std::chrono::high_resolution_clock;
+using game::kernels::isa;
+
+template<typename F>
+static double time_per_element(std::size_t n, int iterations, F &&f)
+{
+	f(); // warm up
+	const auto start = clk::now();
+	for (int i = 0; i < iterations; ++i)
+		f();
+	const std::chrono::duration<double> t = clk::now() - start;
+	return t.count() / iterations / n * 1e9;
+}
+
+int main(int argc, char **argv)
+{
+	const std::size_t n = argc > 1 ? std::stoul(argv[1]) : 100000;
+	const int iterations = argc > 2 ? std::stoi(argv[2]) : 100;
+
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> coord(-100.0f, 100.0f);
+	std::vector<float> x1(n), y1(n), z1(n), x2(n), y2(n), z2(n);
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		x1[i] = coord(rng);
+		y1[i] = coord(rng);
+		z1[i] = coord(rng);
+		x2[i] = coord(rng);
+		y2[i] = coord(rng);
+		z2[i] = coord(rng);
+	}
+	const game::kernels::segments ends{x1.data(), y1.data(), z1.data(),
+									   x2.data(), y2.data(), z2.data()};
+	const glm::vec3 bl(-15.0f, -15.0f, -15.0f), tr(15.0f, 15.0f, 15.0f);
+
+	std::vector<uint32_t> hits(n);
+	std::vector<float> prisms(n * 24), cubes(n * 24);
+
+	std::cout << n << " edges, ns per element\n"
+			  << "isa      contained  edge_prisms  node_cubes\n";
+	for (isa set: {isa::scalar, isa::sse, isa::avx2})
+	{
+		if (!game::kernels::supported(set))
+			continue;
+
+		const double t_in = time_per_element(n, iterations, [&]() {
+			game::kernels::contained(set, x1.data(), y1.data(), z1.data(), n,
+									 bl, tr, hits.data());
+		});
+		const double t_prism = time_per_element(n, iterations, [&]() {
+			game::kernels::edge_prisms(set, ends, n, 0.1f, prisms.data());
+		});
+		const double t_cube = time_per_element(n, iterations, [&]() {
+			game::kernels::node_cubes(set, x1.data(), y1.data(), z1.data(), n,
+									  0.2f, cubes.data());
+		});
+		std::cout << game::kernels::name(set) << "\t " << t_in << "\t    "
+				  << t_prism << "\t " << t_cube << "\n";
+	}
+	return 0;
+}
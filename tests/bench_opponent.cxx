@@ -0,0 +1,103 @@
+/**
+ * @file bench_opponent.cxx
+ * @author Jonah Chen
+ * @brief time the moves of the computer opponent as it plays a world out
+ * against itself, through the mailbox like the render loop does, and print
+ * the distribution of their latencies. The world has red-blue trees, which
+ * are valued exactly, and ladders mixing all three colours, which are
+ * searched until the budget runs out.
+ *
+ * Usage: bench_opponent [number of components] [budget in ms]
+ * @version 1.0
+ * @date 2021-12-08
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include "game/prereqs.hpp"
+#include "game/nodes.hpp"
+#include "game/world.hpp"
+#include "game/opponent.hpp"
+#include "tests/fixture.hpp"
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+
+struct bench_world : test_world
+{
+	void build(int components, std::mt19937 &rng)
+	{
+		const game::branch_type types[] = {game::red, game::green, game::blue};
+		for (int c = 0; c < components; ++c)
+		{
+			const float x = 4.0f * c;
+			if (c % 2 == 0)
+			{
+				// a ladder of 3 rungs with both rails on the ground
+				game::world::id_t below[2] = {node(x, 0.0f), node(x + 1.0f, 0.0f)};
+				for (int rung = 1; rung <= 3; ++rung)
+				{
+					game::world::id_t above[2];
+					for (int side = 0; side < 2; ++side)
+					{
+						above[side] = node(x + side, rung);
+						edge(types[rng() % 3], below[side], above[side]);
+						below[side] = above[side];
+					}
+					edge(types[rng() % 3], above[0], above[1]);
+				}
+				continue;
+			}
+
+			// a red-blue tree of 8 edges
+			std::vector<game::world::id_t> ids{node(x, 0.0f)};
+			for (int i = 1; i <= 8; ++i)
+			{
+				ids.push_back(node(x + 0.1f * i, (float) i));
+				edge(rng() % 2 ? game::blue : game::red,
+					 ids[rng() % (ids.size() - 1)], ids.back());
+			}
+		}
+		game::world::fallout fallen;
+		world.settle(0, fallen);
+	}
+};
+
+int main(int argc, char **argv)
+{
+	const int components = argc > 1 ? std::stoi(argv[1]) : 8;
+	const unsigned budget = argc > 2 ? std::stoul(argv[2]) : 100;
+
+	std::mt19937 rng(18);
+	bench_world w;
+	w.build(components, rng);
+
+	game::opponent ai(budget);
+	game::branch_type player = game::red;
+	uint64_t positions = 0;
+	for (;;)
+	{
+		ai.think(w.world, player);
+		game::opponent::move m;
+		while (!ai.poll(m))
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		game::edge *e = game::opponent::resolve(w.world, m);
+		if (!e)
+			break;
+		positions += m.positions;
+
+		game::world::fallout fallen;
+		w.world.cut(m.edge, fallen);
+		player = player == game::blue ? game::red : game::blue;
+	}
+
+	std::cout << components << " components, budget " << budget << " ms, "
+			  << positions << " positions searched\n";
+	ai.report();
+	std::cout << (player == game::blue ? "red" : "blue") << " made the last "
+			  << "move\n";
+	return 0;
+}
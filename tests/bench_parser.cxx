@@ -0,0 +1,116 @@
+/**
+ * @file bench_parser.cxx
+ * @author Jonah Chen
+ * @brief time loading a cubic lattice world, which is the worst case for
+ * hashing positions with the XOR of their coordinates: every permutation of a
+ * position collides. Writes the lattice to a file, then times deduplicating its
+ * end points with the old hash, the mixed hash and worldgen::position_map, and
+ * parsing the whole file.
+ *
+ * Usage: bench_parser [nodes per side] [file]
+ * The default of 70 nodes per side is about 1M edges.
+ * @version 1.0
+ * @date 2021-11-25
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include "worldgen/parser.hpp"
+#include "worldgen/position_map.hpp"
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+using clk = std::chrono::high_resolution_clock;
+
+// the hash used by the parser before the position map
+struct xor_hash
+{
+	size_t operator()(const glm::vec3 &vec) const
+	{
+		return std::hash<float>()(vec.x) ^ std::hash<float>()(vec.y) ^
+			   std::hash<float>()(vec.z);
+	}
+};
+
+template<typename Map>
+static double dedup(const std::vector<glm::vec3> &ends, std::size_t &count)
+{
+	const auto start = clk::now();
+	Map ids;
+	int32_t id = 0;
+	for (const glm::vec3 &p: ends)
+		if (ids.emplace(p, id).second)
+			++id;
+	count = ids.size();
+	return std::chrono::duration<double>(clk::now() - start).count();
+}
+
+int main(int argc, char **argv)
+{
+	const int side = argc > 1 ? std::stoi(argv[1]) : 70;
+	const std::string filename = argc > 2 ? argv[2] : "bench_parser.hkb";
+
+	// edges between neighbours of the lattice along every axis
+	std::vector<glm::vec3> ends;
+	{
+		std::ofstream file(filename);
+		const char colors[] = {'r', 'g', 'b'};
+		for (int x = 0; x < side; ++x)
+			for (int y = 0; y < side; ++y)
+				for (int z = 0; z < side; ++z)
+				{
+					const glm::vec3 p(x, y, z);
+					const glm::vec3 steps[] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+					for (int axis = 0; axis < 3; ++axis)
+					{
+						const glm::vec3 q = p + steps[axis];
+						if (q[axis] >= side)
+							continue;
+						file << "b " << colors[(x + y + z) % 3] << ' ' << p.x
+							 << ' ' << p.y << ' ' << p.z << " -- " << q.x
+							 << ' ' << q.y << ' ' << q.z << '\n';
+						ends.push_back(p);
+						ends.push_back(q);
+					}
+				}
+	}
+	const std::size_t num_nodes = (std::size_t) side * side * side;
+	std::cout << side << "^3 lattice: " << num_nodes << " nodes, "
+			  << ends.size() / 2 << " edges\n";
+
+	std::size_t count;
+	double t = dedup<std::unordered_map<glm::vec3, int32_t, xor_hash>>(ends,
+																	   count);
+	assert(count == num_nodes);
+	std::cout << "xor hash:     " << t * 1e3 << " ms\n";
+
+	t = dedup<std::unordered_map<glm::vec3, int32_t>>(ends, count);
+	assert(count == num_nodes);
+	std::cout << "mixed hash:   " << t * 1e3 << " ms\n";
+
+	{
+		const auto start = clk::now();
+		worldgen::position_map ids;
+		int32_t id = 0;
+		for (const glm::vec3 &p: ends)
+			if (ids.insert(p, id).second)
+				++id;
+		t = std::chrono::duration<double>(clk::now() - start).count();
+		assert(ids.size() == num_nodes);
+	}
+	std::cout << "position map: " << t * 1e3 << " ms\n";
+
+	worldgen::lut_t node_pos;
+	worldgen::adj_list_t adj_list;
+	const auto start = clk::now();
+	worldgen::parse(filename.c_str(), node_pos, adj_list);
+	t = std::chrono::duration<double>(clk::now() - start).count();
+	assert(node_pos.size() == num_nodes);
+	std::cout << "parse file:   " << t * 1e3 << " ms\n";
+
+	std::remove(filename.c_str());
+	return 0;
+}
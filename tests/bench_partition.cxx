@@ -0,0 +1,122 @@
+/**
+ * @file bench_partition.cxx
+ * @author Jonah Chen
+ * @brief time keeping the value of a world of many components up to date as
+ * edges are chopped: evaluating the whole world after every chop, against
+ * updating the cached values of game::partition. The world has small red-blue
+ * ladders, which are searched, and red-blue and green trees.
+ *
+ * Usage: bench_partition [number of components] [number of chops]
+ * @version 1.0
+ * @date 2021-12-01
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include "game/prereqs.hpp"
+#include "game/nodes.hpp"
+#include "game/world.hpp"
+#include "game/value.hpp"
+#include "game/partition.hpp"
+#include "tests/fixture.hpp"
+#include <cassert>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+
+using clk = std::chrono::high_resolution_clock;
+
+struct bench_world : test_world
+{
+	void build(int components, std::mt19937 &rng)
+	{
+		const auto colour = [&]()
+		{ return rng() % 2 ? game::blue : game::red; };
+		for (int c = 0; c < components; ++c)
+		{
+			const float x = 4.0f * c;
+			if (c % 3 == 0)
+			{
+				// a ladder of 4 rungs with both rails on the ground
+				game::world::id_t below[2] = {node(x, 0.0f), node(x + 1.0f, 0.0f)};
+				for (int rung = 1; rung <= 4; ++rung)
+				{
+					game::world::id_t above[2];
+					for (int side = 0; side < 2; ++side)
+					{
+						above[side] = node(x + side, rung);
+						edge(colour(), below[side], above[side]);
+						below[side] = above[side];
+					}
+					edge(colour(), above[0], above[1]);
+				}
+				continue;
+			}
+
+			// a tree of 12 edges, green in every other one
+			std::vector<game::world::id_t> ids{node(x, 0.0f)};
+			for (int i = 1; i <= 12; ++i)
+			{
+				ids.push_back(node(x + 0.1f * i, (float) i));
+				edge(c % 3 == 1 ? colour() : game::green,
+					 ids[rng() % (ids.size() - 1)], ids.back());
+			}
+		}
+		game::world::fallout fallen;
+		world.settle(0, fallen);
+	}
+};
+
+int main(int argc, char **argv)
+{
+	const int components = argc > 1 ? std::stoi(argv[1]) : 500;
+	const int chops = argc > 2 ? std::stoi(argv[2]) : 1000;
+
+	std::mt19937 rng(16);
+	bench_world w;
+	w.build(components, rng);
+
+	game::transposition_table table;
+	game::evaluator evaluate(&table);
+	game::partition parts(&table);
+	parts.build(w.world);
+	evaluate(w.world);
+
+	double full = 0.0, cached = 0.0;
+	std::size_t revalued = 0;
+	int done = 0;
+	for (; done < chops; ++done)
+	{
+		std::vector<game::world::id_t> alive;
+		for (game::world::id_t e = 0; e < w.world.num_edges(); ++e)
+			if (w.world.is_alive(e))
+				alive.push_back(e);
+		if (alive.empty())
+			break;
+		const game::world::id_t e = alive[rng() % alive.size()];
+		game::world::fallout fallen;
+		w.world.cut(e, fallen);
+
+		auto start = clk::now();
+		const game::evaluation expected = evaluate(w.world);
+		full += std::chrono::duration<double>(clk::now() - start).count();
+
+		start = clk::now();
+		parts.update(w.world, e);
+		const game::evaluation &got = parts.get_value(w.world);
+		cached += std::chrono::duration<double>(clk::now() - start).count();
+		revalued += parts.get_revalued();
+
+		assert(got.number == expected.number and got.nimber == expected.nimber);
+	}
+
+	std::cout << components << " components, " << done << " chops\n"
+			  << "evaluate the whole world: " << full / done * 1e6
+			  << " us per chop\n"
+			  << "update the partition:     " << cached / done * 1e6
+			  << " us per chop, " << (double) revalued / done
+			  << " components valued per chop\n";
+	return 0;
+}
@@ -0,0 +1,106 @@
+/**
+ * @file bench_pick.cxx
+ * @author Jonah Chen
+ * @brief compare selecting the branch the player is aiming at by testing every
+ * visible edge with selecting it through the grid of the world, and check that
+ * both select the same edge.
+ *
+ * Usage: bench_pick [number of trees] [poses]
+ * @version 1.0
+ * @date 2021-11-23
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include "game/prereqs.hpp"
+#include "game/nodes.hpp"
+#include "game/world.hpp"
+#include "interaction/pick.hpp"
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <string>
+
+using clk = std::chrono::high_resolution_clock;
+
+int main(int argc, char **argv)
+{
+	const int num_trees = argc > 1 ? std::stoi(argv[1]) : 4000;
+	const int poses = argc > 2 ? std::stoi(argv[2]) : 500;
+	constexpr float render_distance = 15.0f; // same as main.cxx
+
+	std::mt19937 rng(5);
+	std::uniform_real_distribution<float> coord(-20.0f, 20.0f);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+	// a dense forest, so tens of thousands of edges are visible
+	std::vector<std::unique_ptr<game::nodes::normal>> nodes;
+	std::vector<std::unique_ptr<game::edge>> edges;
+	game::world world;
+	for (int t = 0; t < num_trees; ++t)
+	{
+		const std::size_t root = nodes.size();
+		nodes.emplace_back(new game::nodes::normal(
+				glm::vec3(coord(rng), 0.0f, coord(rng))));
+		world.add_node(nodes.back().get(), game::node_kind::normal);
+
+		for (int b = 0; b < 10; ++b)
+		{
+			game::nodes::normal *parent =
+					nodes[root + rng() % (nodes.size() - root)].get();
+			nodes.emplace_back(new game::nodes::normal(
+					parent->get_pos() + glm::vec3(unit(rng), 1.0f, unit(rng))));
+			world.add_node(nodes.back().get(), game::node_kind::normal);
+			edges.emplace_back(game::attach(game::green, parent,
+											nodes.back().get()));
+			world.add_edge(edges.back().get());
+		}
+	}
+	game::world::fallout fallen;
+	world.settle(0, fallen);
+
+	picker picker;
+	std::size_t num_candidates = 0, num_selected = 0;
+	std::chrono::duration<double> t_linear(0), t_grid(0), t_cached(0);
+	for (int i = 0; i < poses; ++i)
+	{
+		const glm::vec3 pos(coord(rng), 0.5f + std::abs(unit(rng)) * 5.0f,
+							coord(rng));
+		const glm::vec3 forward = glm::normalize(
+				glm::vec3(unit(rng), unit(rng) * 0.5f, unit(rng)));
+		const glm::vec3 extent(render_distance, render_distance,
+							   render_distance);
+
+		game::edge::container candidates;
+		world.visible(candidates, pos - extent, pos + extent);
+		num_candidates += candidates.size();
+
+		auto start = clk::now();
+		game::edge *linear = select_linear(forward, pos, candidates);
+		t_linear += clk::now() - start;
+
+		start = clk::now();
+		game::edge *grid = picker.select(forward, pos, world, candidates,
+										 3.0f * render_distance);
+		t_grid += clk::now() - start;
+
+		start = clk::now();
+		game::edge *cached = picker.select(forward, pos, world, candidates,
+										   3.0f * render_distance);
+		t_cached += clk::now() - start;
+
+		assert(linear == grid and grid == cached);
+		num_selected += linear != nullptr;
+	}
+
+	std::cout << edges.size() << " edges, " << num_candidates / poses
+			  << " visible on average, " << num_selected << " of " << poses
+			  << " poses select an edge\n"
+			  << "linear: " << t_linear.count() / poses * 1e6 << " us/pick\n"
+			  << "grid:   " << t_grid.count() / poses * 1e6 << " us/pick\n"
+			  << "cached: " << t_cached.count() / poses * 1e6 << " us/pick\n";
+	return 0;
+}
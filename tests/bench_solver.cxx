@@ -0,0 +1,93 @@
+/**
+ * @file bench_solver.cxx
+ * @author Jonah Chen
+ * @brief time solving the worlds of a corpus of mixed positions with 1, 2, 4,
+ * 8 and 16 threads, and print the speedup over one thread. Every run starts
+ * with an empty transposition table, and every run must find the same
+ * outcomes.
+ *
+ * Usage: bench_solver [corpus directory]
+ * The default corpus is worldgen/corpus, which holds random worlds of red,
+ * green and blue edges with cycles.
+ * @version 1.0
+ * @date 2021-11-29
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include "game/prereqs.hpp"
+#include "game/nodes.hpp"
+#include "game/world.hpp"
+#include "game/solver.hpp"
+#include "worldgen/parser.hpp"
+#include "tests/fixture.hpp"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+using clk = std::chrono::high_resolution_clock;
+
+struct bench_world : test_world
+{
+	std::string name;
+
+	explicit bench_world(const std::filesystem::path &path) :
+			name(path.filename().string())
+	{
+		load(path.string());
+	}
+};
+
+int main(int argc, char **argv)
+{
+	const std::filesystem::path dir = argc > 1 ? argv[1] : "worldgen/corpus";
+
+	std::vector<std::filesystem::path> paths;
+	for (const auto &entry: std::filesystem::directory_iterator(dir))
+		if (entry.path().extension() == ".hkb")
+			paths.push_back(entry.path());
+	std::sort(paths.begin(), paths.end());
+
+	std::vector<std::unique_ptr<bench_world>> corpus;
+	for (const auto &path: paths)
+		corpus.emplace_back(new bench_world(path));
+
+	std::vector<game::outcome> outcomes;
+	double serial = 0.0;
+	for (int threads: {1, 2, 4, 8, 16})
+	{
+		game::transposition_table table;
+		game::solver solve(&table, threads);
+		uint64_t positions = 0;
+		double total = 0.0;
+		for (std::size_t i = 0; i < corpus.size(); ++i)
+		{
+			const auto start = clk::now();
+			const game::solution s = solve(corpus[i]->world);
+			total += std::chrono::duration<double>(clk::now() - start).count();
+			assert(s.solved);
+			positions += s.positions;
+
+			if (threads == 1)
+			{
+				outcomes.push_back(s.result);
+				std::cout << corpus[i]->name << ": "
+						  << game::outcome_name(s.result) << ", "
+						  << s.searched_edges << " edges searched\n";
+			}
+			else
+				assert(outcomes[i] == s.result);
+		}
+
+		if (threads == 1)
+			serial = total;
+		std::cout << threads << " threads: " << total * 1e3 << " ms, "
+				  << positions << " positions, speedup " << serial / total
+				  << '\n';
+	}
+	return 0;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file bench_tablebase.cxx
+ * @author Jonah Chen
+ * @brief time the lookups of a tablebase built by worldgen/tablebase.cxx. The
+ * components looked up are drawn from the table itself and numbered at random,
+ * so every lookup finds the canonical code of its component first and then
+ * reads its slot from the mapped file.
+ *
+ * Usage: bench_tablebase [table file] [number of lookups]
+ * @version 1.0
+ * @date 2021-12-09
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include "game/tablebase.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+using game::tablebase;
+using clk = std::chrono::steady_clock;
+
+int main(int argc, char **argv)
+{
+	if (argc < 2)
+	{
+		std::cout << "Usage: bench_tablebase [table file] [number of lookups]\n";
+		return 0;
+	}
+	const tablebase table(argv[1]);
+	const std::size_t lookups = argc > 2 ? std::stoul(argv[2]) : 1000000;
+	if (table.max_edges() < 3)
+	{
+		std::cout << "the table has no components with cycles\n";
+		return 0;
+	}
+
+	// components of every size of the table, found by extending a triangle
+	// with an edge at a time and keeping those in the table
+	std::mt19937 rng(19);
+	std::vector<std::vector<tablebase::edge>> components;
+	while (components.size() < 4096)
+	{
+		std::vector<tablebase::edge> edges{{0, 1, game::blue},
+										   {0, 2, game::red},
+										   {1, 2, game::blue}};
+		uint32_t k = 2;
+		const std::size_t n = 3 + rng() % (table.max_edges() - 2);
+		while (edges.size() < n)
+		{
+			const uint32_t a = rng() % (k + 1);
+			const uint32_t b = k < tablebase::MAX_NODES and rng() % 2 ?
+							   k + 1 : rng() % (k + 1);
+			if (a == b or (a == 0 and b == k + 1))
+				continue;
+			k = std::max(k, b);
+			edges.push_back({a, b, rng() % 2 ? game::blue : game::red});
+		}
+		game::dyadic value;
+		if (table.probe(edges.data(), edges.size(), value))
+			components.push_back(edges);
+	}
+
+	// numbered at random, so the lookups do the work of the evaluator
+	for (auto &edges: components)
+	{
+		std::vector<uint32_t> label(tablebase::MAX_NODES + 1);
+		std::iota(label.begin(), label.end(), 0);
+		uint32_t k = 0;
+		for (const tablebase::edge &e: edges)
+			k = std::max({k, e.p1, e.p2});
+		std::shuffle(label.begin() + 1, label.begin() + k + 1, rng);
+		for (tablebase::edge &e: edges)
+			e = {label[e.p1], label[e.p2], e.type};
+		std::shuffle(edges.begin(), edges.end(), rng);
+	}
+
+	std::size_t found = 0;
+	const auto start = clk::now();
+	for (std::size_t i = 0; i < lookups; ++i)
+	{
+		const auto &edges = components[i % components.size()];
+		game::dyadic value;
+		found += table.probe(edges.data(), edges.size(), value);
+	}
+	const double seconds = std::chrono::duration<double>(clk::now() -
+														 start).count();
+
+	std::cout << table.size() << " components of at most " << table.max_edges()
+			  << " edges, " << table.bytes() << " bytes\n"
+			  << lookups << " lookups, " << found << " found, "
+			  << seconds * 1e9 / lookups << " ns per lookup\n";
+	return 0;
+}
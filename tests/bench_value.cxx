@@ -0,0 +1,143 @@
+/**
+ * @file bench_value.cxx
+ * @author Jonah Chen
+ * @brief time evaluating large worlds: a single green component with cycles,
+ * which is valued with the fusion and colon principles, a forest of red-blue
+ * trees, which is valued with the closed form for trees, and many small
+ * red-blue components with cycles, which are searched. The last is evaluated
+ * twice with a shared transposition table, and the counters of the table are
+ * printed.
+ *
+ * Usage: bench_value [number of edges] [iterations]
+ * @version 1.0
+ * @date 2021-11-27
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include "game/prereqs.hpp"
+#include "game/nodes.hpp"
+#include "game/world.hpp"
+#include "game/value.hpp"
+#include "game/transposition.hpp"
+#include "tests/fixture.hpp"
+#include <cassert>
+#include <chrono>
+#include <random>
+#include <string>
+
+using clk = std::chrono::high_resolution_clock;
+
+struct bench_world : test_world
+{
+	using test_world::node;
+
+	game::world::id_t node(const glm::vec3 &pos)
+	{
+		return node(pos.x, pos.y, pos.z);
+	}
+};
+
+static void time(const char *name, const game::world &world, int iterations,
+				 game::transposition_table *table = nullptr)
+{
+	game::evaluator evaluate(table);
+	game::evaluation result;
+	const auto start = clk::now();
+	for (int i = 0; i < iterations; ++i)
+		result = evaluate(world);
+	const std::chrono::duration<double> t = clk::now() - start;
+	assert(result.exact());
+
+	std::cout << name << ": " << t.count() / iterations * 1e3 << " ms, "
+			  << result.components << " components, value " << result.number;
+	if (result.nimber)
+		std::cout << " + *" << result.nimber;
+	std::cout << '\n';
+}
+
+int main(int argc, char **argv)
+{
+	const std::size_t num_edges = argc > 1 ? std::stoul(argv[1]) : 1000000;
+	const int iterations = argc > 2 ? std::stoi(argv[2]) : 5;
+
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> xz(-100.0f, 100.0f);
+
+	// one green component: a random tree on a single node on the ground, with
+	// one edge in ten closing a cycle
+	{
+		bench_world w;
+		std::vector<game::world::id_t> ids{w.node(glm::vec3(0.0f))};
+		while (w.edges.size() < num_edges)
+		{
+			if (ids.size() > 2 and rng() % 10 == 0)
+			{
+				w.edge(game::green, ids[rng() % ids.size()],
+					   ids[1 + rng() % (ids.size() - 1)]);
+				continue;
+			}
+			const game::world::id_t parent = ids[rng() % ids.size()];
+			ids.push_back(w.node(w.world.get_pos(parent) +
+								 glm::vec3(xz(rng) * 0.01f, 1.0f,
+										   xz(rng) * 0.01f)));
+			w.edge(game::green, parent, ids.back());
+		}
+		game::world::fallout fallen;
+		w.world.settle(0, fallen);
+		time("green component", w.world, iterations);
+	}
+
+	// a red-blue forest: every node hangs off a random earlier node
+	{
+		bench_world w;
+		std::vector<game::world::id_t> ids;
+		for (int i = 0; i < 64; ++i)
+			ids.push_back(w.node(glm::vec3(xz(rng), 0.0f, xz(rng))));
+		while (w.edges.size() < num_edges)
+		{
+			const game::world::id_t parent = ids[rng() % ids.size()];
+			ids.push_back(w.node(w.world.get_pos(parent) +
+								 glm::vec3(xz(rng) * 0.01f, 1.0f,
+										   xz(rng) * 0.01f)));
+			w.edge(rng() % 2 ? game::blue : game::red, parent, ids.back());
+		}
+		game::world::fallout fallen;
+		w.world.settle(0, fallen);
+		time("red-blue forest", w.world, iterations);
+	}
+
+	// 20 ladders of 18 red-blue edges with both rails on the ground
+	{
+		bench_world w;
+		for (int l = 0; l < 20; ++l)
+		{
+			const float x = 3.0f * l;
+			game::world::id_t below[2] = {w.node(glm::vec3(x, 0.0f, 0.0f)),
+										  w.node(glm::vec3(x + 1.0f, 0.0f, 0.0f))};
+			for (int rung = 1; rung <= 6; ++rung)
+			{
+				game::world::id_t above[2];
+				for (int side = 0; side < 2; ++side)
+				{
+					above[side] = w.node(glm::vec3(x + side, rung, 0.0f));
+					w.edge(rng() % 2 ? game::blue : game::red, below[side],
+						   above[side]);
+					below[side] = above[side];
+				}
+				w.edge(rng() % 2 ? game::blue : game::red, above[0], above[1]);
+			}
+		}
+		game::world::fallout fallen;
+		w.world.settle(0, fallen);
+
+		game::transposition_table table;
+		time("red-blue ladders, cold table", w.world, 1, &table);
+		const auto cold = table.get_stats();
+		std::cout << "  " << cold.probes << " probes, " << cold.hit_rate() * 100
+				  << "% hits, " << cold.collisions << " collisions\n";
+		time("red-blue ladders, warm table", w.world, iterations, &table);
+	}
+	return 0;
+}
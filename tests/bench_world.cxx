@@ -0,0 +1,121 @@
+/**
+ * @file bench_world.cxx
+ * @author Jonah Chen
+ * @brief compare the traversal used to find the visible edges before and after
+ * the world graph was introduced. The old traversal visits every node through
+ * its virtual methods, the new one walks game::world. Then
+ * time chopping random edges.
+ *
+ * Usage: bench_world [number of edges] [iterations]
+ * @version 1.0
+ * @date 2021-11-20
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include "game/prereqs.hpp"
+#include "game/nodes.hpp"
+#include "game/world.hpp"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <random>
+#include <string>
+
+using clk = std::chrono::high_resolution_clock;
+
+int main(int argc, char **argv)
+{
+	const std::size_t num_edges = argc > 1 ? std::stoul(argv[1]) : 100000;
+	const int iterations = argc > 2 ? std::stoi(argv[2]) : 20;
+
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<float> xz(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> dy(0.2f, 1.0f);
+
+	// a forest where every node hangs off a random node created before it
+	std::vector<game::nodes::normal *> nodes;
+	std::vector<game::edge *> edges;
+	std::vector<game::world::id_t> grounded;
+	game::world world;
+
+	for (int i = 0; i < 64; ++i)
+	{
+		nodes.push_back(new game::nodes::normal(glm::vec3(xz(rng), 0.0f,
+														  xz(rng))));
+		grounded.push_back(world.add_node(nodes.back(),
+										  game::node_kind::normal));
+	}
+	while (edges.size() < num_edges)
+	{
+		game::nodes::normal *parent = nodes[rng() % nodes.size()];
+		glm::vec3 pos = parent->get_pos();
+		pos += glm::vec3(xz(rng) * 0.02f, dy(rng), xz(rng) * 0.02f);
+
+		nodes.push_back(new game::nodes::normal(pos));
+		world.add_node(nodes.back(), game::node_kind::normal);
+		edges.push_back(game::attach((game::branch_type) (rng() % 3 - 1),
+									 parent, nodes.back()));
+		world.add_edge(edges.back());
+	}
+
+	game::world::fallout fallen;
+	world.settle(0, fallen);
+	assert(fallen.nodes.empty());
+
+	const glm::vec3 bottomleft(-15.0f, -15.0f, -15.0f);
+	const glm::vec3 topright(15.0f, 15.0f, 15.0f);
+	game::edge::container before, after;
+
+	auto start = clk::now();
+	for (int i = 0; i < iterations; ++i)
+	{
+		before.clear();
+		game::node::container visible_nodes;
+		for (game::world::id_t g: grounded)
+			(*world.get_node(g))(visible_nodes, bottomleft, topright);
+		for (game::node *n: visible_nodes)
+			n->render(before);
+	}
+	const std::chrono::duration<double> t_before = clk::now() - start;
+
+	start = clk::now();
+	for (int i = 0; i < iterations; ++i)
+	{
+		after.clear();
+		world.visible(after, bottomleft, topright);
+	}
+	const std::chrono::duration<double> t_after = clk::now() - start;
+
+	std::cout << num_edges << " edges, " << after.size() << " visible\n"
+			  << "node traversal:  " << t_before.count() / iterations * 1e3
+			  << " ms/it\n"
+			  << "world traversal: " << t_after.count() / iterations * 1e3
+			  << " ms/it\n";
+
+	// the node traversal does not render the edges of stack roots, so it may
+	// find fewer
+	for (game::edge *e: before)
+		assert(after.count(e));
+
+	// chop random edges, each chop only visits the subtree hanging off it
+	const int chops = std::min<std::size_t>(1000, edges.size());
+	std::size_t num_fallen = 0;
+	start = clk::now();
+	for (int i = 0; i < chops; ++i)
+	{
+		fallen.clear();
+		world.cut(edges[rng() % edges.size()]->id, fallen);
+		num_fallen += fallen.nodes.size();
+	}
+	const std::chrono::duration<double> t_cut = clk::now() - start;
+	std::cout << "cut: " << t_cut.count() / chops * 1e6 << " us/chop, "
+			  << num_fallen << " nodes fell\n";
+
+	for (game::edge *e: edges)
+		delete e;
+	for (game::node *n: nodes)
+		delete n;
+	return 0;
+}
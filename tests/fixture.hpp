@@ -0,0 +1,143 @@
+/**
+ * @file fixture.hpp
+ * @author Jonah Chen
+ * @brief a world built from heap allocated nodes and edges, shared by the
+ * tests and benchmarks of the world and everything that values it.
+ * @version 1.0
+ * @date 2021-12-10
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#pragma once
+
+#include "game/prereqs.hpp"
+#include "game/nodes.hpp"
+#include "game/generators.hpp"
+#include "game/world.hpp"
+#include "worldgen/parser.hpp"
+#include <cassert>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief a world that owns its nodes and edges, which are freed with it.
+ */
+struct test_world
+{
+	game::world world;
+	std::vector<std::unique_ptr<game::node>> nodes;
+	std::vector<std::unique_ptr<game::edge>> edges;
+
+	game::world::id_t node(float x, float y, float z = 0.0f)
+	{
+		nodes.emplace_back(new game::nodes::normal(glm::vec3(x, y, z)));
+		return world.add_node(nodes.back().get(), game::node_kind::normal);
+	}
+
+	game::world::id_t edge(game::branch_type type, game::world::id_t a,
+						   game::world::id_t b)
+	{
+		edges.emplace_back(game::attach(type, world.get_node(a),
+										world.get_node(b)));
+		return world.add_edge(edges.back().get());
+	}
+
+	void settle()
+	{
+		game::world::fallout fallen;
+		world.settle(0, fallen);
+	}
+
+	/**
+	 * @brief add a stack from (x, y) to (x, y + height), linked to the node at
+	 * its limit.
+	 *
+	 * @param limit the node at the limit, a new node when it is npos.
+	 * @return the id of the stack root.
+	 */
+	game::world::id_t stack(float x, float y, float height,
+							game::nodes::generators::type_gen tgen,
+							int32_t *kwargs = nullptr,
+							game::world::id_t limit = game::world::npos)
+	{
+		nodes.emplace_back(new game::nodes::stack_root(
+				glm::vec3(x, y, 0.0f), glm::vec3(0.0f, height, 0.0f), tgen,
+				GEOMETRIC, kwargs));
+		const game::world::id_t root = world.add_node(
+				nodes.back().get(), game::node_kind::stack_root);
+		if (limit == game::world::npos)
+			limit = node(x, y + height);
+		edges.emplace_back(game::attach(game::blue, world.get_node(root),
+										world.get_node(limit)));
+		world.add_link(root, limit);
+		return root;
+	}
+
+	game::nodes::stack_root &root(game::world::id_t n)
+	{
+		return *static_cast<game::nodes::stack_root *>(world.get_node(n));
+	}
+
+	/**
+	 * @brief cut a stack below the child of order `order` the way
+	 * hackenbush::chop does, which also cuts its link.
+	 */
+	void chop(game::world::id_t n, int64_t order)
+	{
+		root(n).detach(order);
+		const game::world::id_t link = world.get_link(n);
+		if (link != game::world::npos)
+		{
+			game::world::fallout fallen;
+			world.cut(link, fallen);
+		}
+	}
+
+	/**
+	 * @brief load a world generation file the way hackenbush::load_world does.
+	 */
+	void load(const std::string &filename)
+	{
+		worldgen::lut_t lut;
+		worldgen::adj_list_t adj_list;
+		const bool parsed = worldgen::parse(filename.c_str(), lut, adj_list);
+		assert(parsed);
+		const game::world::id_t first = world.num_nodes();
+		for (int32_t id = 0; id < (int32_t) lut.size(); ++id)
+		{
+			auto &element = adj_list[id];
+			if (element.ty == worldgen::node_type::stack_root)
+			{
+				auto &front = element.conn.front();
+				nodes.emplace_back(new game::nodes::stack_root(
+						lut[id], front.vec_kwargs, front.type_gen,
+						front.step_gen, front.kwargs));
+				world.add_node(nodes.back().get(),
+							   game::node_kind::stack_root);
+			}
+			else
+				node(lut[id].x, lut[id].y, lut[id].z);
+		}
+		for (int32_t id = 0; id < (int32_t) adj_list.size(); ++id)
+			for (auto &e: adj_list[id].conn)
+				if (adj_list[id].ty == worldgen::node_type::normal)
+					edge(e.type, first + id, first + e.id);
+				else // the stack takes the node at its limit
+					edges.emplace_back(game::attach(
+							e.type, world.get_node(first + id),
+							world.get_node(first + e.id)));
+
+		for (game::world::id_t id = first; id < world.num_nodes(); ++id)
+		{
+			if (world.get_kind(id) != game::node_kind::stack_root)
+				continue;
+			game::node *limit = root(id).get_grandchild();
+			if (limit and limit->get_id() != game::world::npos)
+				world.add_link(id, limit->get_id());
+		}
+		settle();
+	}
+};
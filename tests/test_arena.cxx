@@ -0,0 +1,72 @@
+#include "game/arena.hpp"
+#include "game/prereqs.hpp"
+#include "game/nodes.hpp"
+#include <cassert>
+#include <iostream>
+
+static void test_handles()
+{
+	game::arena<game::nodes::normal> nodes;
+	game::arena<game::edge> edges;
+
+	auto *n1 = nodes.create(glm::vec3(0.0f, 0.0f, 0.0f));
+	auto *n2 = nodes.create(glm::vec3(0.0f, 1.0f, 0.0f));
+	auto *n3 = nodes.create(glm::vec3(0.0f, 2.0f, 0.0f));
+
+	game::edge *e1 = game::attach(game::red, n1, n2, edges);
+	game::edge *e2 = game::attach(game::blue, n2, n3, edges);
+	assert(edges.size() == 2);
+
+	auto h1 = edges.get_handle(e1);
+	auto h2 = edges.get_handle(e2);
+	assert(edges.get(h1) == e1);
+	assert(edges.get(h2) == e2);
+
+	// a destroyed edge is stale, even after its slot is reused
+	game::detach(e1, edges);
+	assert(!edges.get(h1));
+	game::edge *e3 = game::attach(game::green, n1, n2, edges);
+	assert(e3 == e1);
+	assert(!edges.get(h1));
+	assert(edges.get(edges.get_handle(e3)) == e3);
+
+	// every handle is stale after a reset
+	edges.reset();
+	nodes.reset();
+	assert(!edges.get(h2));
+	assert(edges.size() == 0 and nodes.size() == 0);
+}
+
+static void test_reset_cycles()
+{
+	game::arena<game::nodes::normal> nodes;
+	game::arena<game::edge> edges;
+
+	std::size_t capacity = 0;
+	for (int cycle = 0; cycle < 16; ++cycle)
+	{
+		game::nodes::normal *prev = nodes.create(glm::vec3(0.0f));
+		for (int i = 1; i < 5000; ++i)
+		{
+			auto *cur = nodes.create(glm::vec3(0.0f, (float) i, 0.0f));
+			game::attach(game::green, prev, cur, edges);
+			prev = cur;
+		}
+
+		// the slabs of the first world are reused by every other world
+		if (cycle == 0)
+			capacity = nodes.capacity() + edges.capacity();
+		assert(nodes.capacity() + edges.capacity() == capacity);
+
+		edges.reset();
+		nodes.reset();
+	}
+}
+
+int main(int argc, char **argv)
+{
+	test_handles();
+	test_reset_cycles();
+	std::cout << "arena tests passed" << std::endl;
+	return 0;
+}
@@ -0,0 +1,192 @@
+#include "game/prereqs.hpp"
+#include "game/nodes.hpp"
+#include "game/world.hpp"
+#include "game/value.hpp"
+#include "game/canonical.hpp"
+#include "worldgen/parser.hpp"
+#include "tests/fixture.hpp"
+#include <cassert>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using game::dyadic;
+using game::forms;
+using game::outcome;
+
+static std::string show(forms &f, forms::id_t g, const dyadic &x = 0)
+{
+	std::ostringstream os;
+	f.print(os, g, x);
+	return os.str();
+}
+
+// numbers and nimbers have their usual forms, and every game is interned once
+static void test_simple()
+{
+	forms f;
+	const auto one = f.make({forms::zero}, {});
+	assert(one == f.number(1) and f.is_number(one) and f.get_number(one) == 1);
+	assert(f.number(-2) == f.make({}, {f.number(-1)}));
+	assert(f.number(dyadic::fraction(1, 1)) == f.make({forms::zero}, {one}));
+
+	// 0 is dominated by 1/4, and 1/4 reverses through 1/2 to 0
+	const auto quarter = f.number(dyadic::fraction(1, 2));
+	assert(f.make({forms::zero, quarter}, {one}) ==
+		   f.number(dyadic::fraction(1, 1)));
+	assert(f.make({f.number(-3)}, {f.number(5)}) == forms::zero);
+
+	const auto star = f.make({forms::zero}, {forms::zero});
+	assert(star == f.nimber(1) and f.add(star, star) == forms::zero);
+	assert(f.add(f.nimber(2), f.nimber(3)) == star);
+	assert(f.make({forms::zero, star}, {forms::zero, star}) == f.nimber(2));
+
+	const std::size_t size = f.size();
+	assert(f.make({forms::zero}, {f.nimber(1)}) == f.up(1));
+	assert(f.size() == size + 1 and f.birthday(f.up(1)) == 2);
+}
+
+// up is positive but less than every positive number, and confused with star
+static void test_infinitesimals()
+{
+	forms f;
+	const auto up = f.up(1), down = f.up(-1), star = f.nimber(1);
+	assert(f.neg(up) == down and f.add(up, down) == forms::zero);
+	assert(f.le(forms::zero, up) and !f.le(up, forms::zero));
+	assert(f.le(up, f.number(dyadic::fraction(1, 10))));
+	assert(!f.le(up, star) and !f.le(star, up));
+
+	// up star is {0, * | 0}, and double up star is {0 | up}
+	assert(f.add(up, star) == f.make({forms::zero, star}, {forms::zero}));
+	assert(f.add(f.up(2), star) == f.make({forms::zero}, {up}));
+
+	assert(f.outcome_of(up) == outcome::left);
+	assert(f.outcome_of(down) == outcome::right);
+	assert(f.outcome_of(star) == outcome::next);
+	assert(f.outcome_of(f.add(up, star)) == outcome::next);
+	assert(f.outcome_of(forms::zero) == outcome::previous);
+	assert(f.outcome_of(down, dyadic::fraction(1, 6)) == outcome::left);
+	assert(f.outcome_of(f.add(up, star), -1) == outcome::right);
+
+	// a hot game is decided by who moves first
+	const auto hot = f.make({f.number(1)}, {f.number(-1)});
+	assert(f.outcome_of(hot) == outcome::next);
+	assert(f.outcome_of(hot, dyadic::fraction(3, 1)) == outcome::left);
+}
+
+static void test_print()
+{
+	forms f;
+	assert(show(f, forms::zero) == "0");
+	assert(show(f, f.number(dyadic::fraction(-3, 2))) == "-3/4");
+	assert(show(f, f.nimber(1)) == "*");
+	assert(show(f, f.nimber(1), dyadic::fraction(1, 1)) == "1/2 + *");
+	assert(show(f, f.up(1)) == "↑");
+	assert(show(f, f.add(f.up(-1), f.nimber(1))) == "↓*");
+	assert(show(f, f.add(f.up(2), f.nimber(3))) == "⇑*3");
+	assert(show(f, f.add(f.up(3), f.number(2))) == "2 + 3↑");
+	assert(show(f, f.make({f.number(1)}, {f.number(-1)})) == "{1|-1}");
+	assert(show(f, f.make({f.number(1)}, {f.nimber(1)}), 2) == "2 + {1|*}");
+}
+
+// sums are commutative and associative, every game minus itself is 0, and
+// the comparisons agree with the outcomes of differences
+static void test_random(std::mt19937 &rng)
+{
+	forms f;
+	std::vector<forms::id_t> games{forms::zero, f.nimber(1), f.up(1),
+								   f.number(1), f.number(-1)};
+	while (games.size() < 40)
+	{
+		std::vector<forms::id_t> left, right;
+		for (int i = rng() % 3; i > 0; --i)
+			left.push_back(games[rng() % games.size()]);
+		for (int i = rng() % 3; i > 0; --i)
+			right.push_back(games[rng() % games.size()]);
+		games.push_back(f.make(left, right));
+	}
+
+	for (int trial = 0; trial < 200; ++trial)
+	{
+		const auto a = games[rng() % games.size()];
+		const auto b = games[rng() % games.size()];
+		const auto c = games[rng() % games.size()];
+		assert(f.add(a, b) == f.add(b, a));
+		assert(f.add(f.add(a, b), c) == f.add(a, f.add(b, c)));
+		assert(f.add(a, f.neg(a)) == forms::zero);
+
+		const outcome o = f.outcome_of(f.add(b, f.neg(a)));
+		assert(f.le(a, b) == (o == outcome::left or o == outcome::previous));
+		assert((f.le(a, b) and f.le(b, a)) == (a == b));
+	}
+}
+
+// mixed components are valued by their canonical forms
+static void test_evaluator(const std::string &dir)
+{
+	{
+		test_world w;
+		w.load(dir + "up.hkb");
+		game::evaluator evaluate;
+		const game::evaluation e = evaluate(w.world);
+		assert(e.exact() and e.canonical == 1 and e.green == 1);
+		std::ostringstream os;
+		evaluate.print(os, e);
+		assert(os.str() == "↑");
+		assert(evaluate.outcome_of(e) == outcome::left);
+	}
+	{
+		test_world w;
+		w.load(dir + "up.hkb");
+		w.load(dir + "down.hkb");
+		game::evaluator evaluate;
+		const game::evaluation e = evaluate(w.world);
+		assert(e.exact() and e.canonical == 2);
+		assert(evaluate.outcome_of(e) == outcome::previous);
+	}
+
+	// two blue edges on a green edge are {0, ↑* | 0}, which is fuzzy, and a
+	// blue edge next to them leaves the world to blue
+	test_world w;
+	const auto g = w.node(0.0f, 0.0f), a = w.node(0.0f, 1.0f);
+	w.edge(game::green, g, a);
+	w.edge(game::blue, a, w.node(0.0f, 2.0f));
+	w.edge(game::blue, a, w.node(1.0f, 2.0f));
+	w.settle();
+	game::evaluator evaluate;
+	game::evaluation e = evaluate(w.world);
+	assert(evaluate.outcome_of(e) == outcome::next);
+
+	w.edge(game::blue, w.node(3.0f, 0.0f), w.node(3.0f, 1.0f));
+	w.settle();
+	e = evaluate(w.world);
+	std::ostringstream os;
+	evaluate.print(os, e);
+	assert(os.str() == "1 + {0, ↑*|0}");
+	assert(e.exact() and e.canonical == 1 and e.number == 1);
+	assert(evaluate.outcome_of(e) == outcome::left);
+
+	// components too large to value are left unsupported
+	evaluate.set_canonical_edges(2);
+	e = evaluate(w.world);
+	assert(!e.exact() and evaluate.get_unsupported().size() == 3);
+	os.str("");
+	evaluate.print(os, e);
+	assert(os.str() == "1 + ?");
+}
+
+int main(int argc, char **argv)
+{
+	const std::string dir = argc > 1 ? argv[1] : "worldgen/common_games/";
+	std::mt19937 rng(15);
+	test_simple();
+	test_infinitesimals();
+	test_print();
+	test_random(rng);
+	test_evaluator(dir);
+	std::cout << "canonical tests passed\n";
+	return 0;
+}
@@ -0,0 +1,138 @@
+#include "game/kernels.hpp"
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using game::kernels::isa;
+
+static const isa sets[] = {isa::scalar, isa::sse, isa::avx2};
+
+// every instruction set finds the same positions as testing them one by one
+static void test_contained(std::mt19937 &rng)
+{
+	std::uniform_real_distribution<float> coord(-10.0f, 10.0f);
+	for (std::size_t n: {0, 1, 3, 4, 7, 8, 9, 100, 1001})
+	{
+		std::vector<float> xs(n), ys(n), zs(n);
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			xs[i] = coord(rng);
+			ys[i] = coord(rng);
+			zs[i] = i % 5 ? coord(rng) : 2.0f; // exactly on the boundary
+		}
+		const glm::vec3 bl(-4.0f, -6.0f, -2.0f), tr(5.0f, 3.0f, 2.0f);
+
+		std::vector<uint32_t> expected;
+		for (std::size_t i = 0; i < n; ++i)
+			if (xs[i] >= bl.x and xs[i] <= tr.x and ys[i] >= bl.y and
+				ys[i] <= tr.y and zs[i] >= bl.z and zs[i] <= tr.z)
+				expected.push_back(i);
+
+		for (isa set: sets)
+		{
+			std::vector<uint32_t> hits(n);
+			hits.resize(game::kernels::contained(set, xs.data(), ys.data(),
+												 zs.data(), n, bl, tr,
+												 hits.data()));
+			assert(hits == expected);
+		}
+	}
+}
+
+// the prisms match the ones render::geometry::edges built one edge at a time
+static void test_edge_prisms(std::mt19937 &rng)
+{
+	std::uniform_real_distribution<float> coord(-10.0f, 10.0f);
+	const std::size_t n = 203;
+	const float width = 0.1f;
+	std::vector<float> x1(n), y1(n), z1(n), x2(n), y2(n), z2(n);
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		x1[i] = coord(rng);
+		y1[i] = coord(rng);
+		z1[i] = coord(rng);
+		// vertical and axis aligned edges take the other branch
+		x2[i] = i % 3 ? coord(rng) : x1[i];
+		y2[i] = i % 7 ? coord(rng) : y1[i];
+		z2[i] = coord(rng);
+	}
+
+	std::vector<float> expected;
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		glm::vec3 p1(x1[i], y1[i], z1[i]), p2(x2[i], y2[i], z2[i]);
+		glm::vec3 dir = p2 - p1;
+		glm::vec3 test_vector;
+		if (dir.x and dir.y) test_vector.z = 1.0f;
+		else test_vector.x = 1.0f;
+		glm::vec3 ortho1 = glm::normalize(glm::cross(test_vector, dir));
+		glm::vec3 ortho2 = glm::normalize(glm::cross(ortho1, dir)) * width;
+		ortho1 *= width;
+		p1 -= ortho1 / 2.0f + ortho2 / 2.0f;
+		p2 -= ortho1 / 2.0f + ortho2 / 2.0f;
+		for (const glm::vec3 &v: {p1, p1 + ortho1, p1 + ortho2,
+								  p1 + ortho1 + ortho2, p2, p2 + ortho1,
+								  p2 + ortho2, p2 + ortho1 + ortho2})
+			expected.insert(expected.end(), {v.x, v.y, v.z});
+	}
+
+	for (isa set: sets)
+	{
+		std::vector<float> out(n * 24);
+		game::kernels::edge_prisms(set, {x1.data(), y1.data(), z1.data(),
+										 x2.data(), y2.data(), z2.data()},
+								   n, width, out.data());
+		for (std::size_t i = 0; i < out.size(); ++i)
+			assert(std::abs(out[i] - expected[i]) < 1e-5f);
+	}
+}
+
+static void test_node_cubes(std::mt19937 &rng)
+{
+	std::uniform_real_distribution<float> coord(-10.0f, 10.0f);
+	const std::size_t n = 37;
+	const float width = 0.2f;
+	std::vector<float> xs(n), ys(n), zs(n);
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		xs[i] = coord(rng);
+		ys[i] = coord(rng);
+		zs[i] = coord(rng);
+	}
+
+	std::vector<float> expected;
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		glm::vec3 pos(xs[i], ys[i], zs[i]);
+		pos.x -= width / 2.0f;
+		pos.y -= width / 2.0f;
+		pos.z -= width / 2.0f;
+		for (uint8_t corner = 0b000; corner <= 0b111; ++corner)
+		{
+			expected.push_back(pos.x + (bool) (corner & 0b001) * width);
+			expected.push_back(pos.y + (bool) (corner & 0b010) * width);
+			expected.push_back(pos.z + (bool) (corner & 0b100) * width);
+		}
+	}
+
+	for (isa set: sets)
+	{
+		std::vector<float> out(n * 24);
+		game::kernels::node_cubes(set, xs.data(), ys.data(), zs.data(), n,
+								  width, out.data());
+		assert(out == expected);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	std::mt19937 rng(9);
+	test_contained(rng);
+	test_edge_prisms(rng);
+	test_node_cubes(rng);
+	std::cout << "kernel tests passed using up to "
+			  << game::kernels::name(game::kernels::best()) << std::endl;
+	return 0;
+}
@@ -0,0 +1,262 @@
+#include "game/prereqs.hpp"
+#include "game/nodes.hpp"
+#include "game/generators.hpp"
+#include "game/world.hpp"
+#include "game/value.hpp"
+#include "game/canonical.hpp"
+#include "game/opponent.hpp"
+#include "tests/fixture.hpp"
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+// make a move of the opponent the way hackenbush::chop does
+static void play(test_world &w, const game::opponent::move &m,
+				 game::branch_type player)
+{
+	game::edge *e = game::opponent::resolve(w.world, m);
+	assert(e and e->type != (player == game::blue ? game::red : game::blue));
+	game::world::fallout fallen;
+	if (m.edge != game::world::npos)
+	{
+		assert(e->id == m.edge);
+		w.world.cut(m.edge, fallen);
+		return;
+	}
+	auto *root = static_cast<game::nodes::stack_root *>(
+			w.world.get_node(m.root));
+	root->detach(m.order + 1);
+	const game::world::id_t link = w.world.get_link(m.root);
+	if (link != game::world::npos)
+		w.world.cut(link, fallen);
+}
+
+// trees of one colour or of red and blue, hanging from the ground
+static void random_forest(test_world &w, std::mt19937 &rng, int trees,
+						  bool green)
+{
+	for (int t = 0; t < trees; ++t)
+	{
+		const float x = 10.0f * t;
+		std::vector<game::world::id_t> ids{w.node(x, 0.0f)};
+		for (int i = 1, size = 1 + rng() % 5; i <= size; ++i)
+		{
+			ids.push_back(w.node(x + i, (float) i));
+			w.edge(green ? game::green : rng() % 2 ? game::blue : game::red,
+				   ids[rng() % (ids.size() - 1)], ids.back());
+		}
+	}
+	w.settle();
+}
+
+// plays the world out between two opponents, and returns the player who made
+// the last move
+static game::branch_type play_out(test_world &w, game::opponent &ai,
+								  game::branch_type player)
+{
+	game::branch_type last = game::invalid;
+	for (;;)
+	{
+		const game::opponent::move m = ai.choose(w.world, player);
+		if (m.edge == game::world::npos and m.root == game::world::npos)
+			return last;
+		play(w, m, player);
+		last = player;
+		player = player == game::blue ? game::red : game::blue;
+	}
+}
+
+// the winner of a world with a closed form is known before it is played, and
+// the opponent finds the winning moves from the exact values
+static void test_closed_forms(std::mt19937 &rng)
+{
+	game::opponent ai(200);
+	for (int trial = 0; trial < 40; ++trial)
+	{
+		test_world w;
+		const bool green = trial % 2;
+		random_forest(w, rng, 3, green);
+		const game::branch_type first = trial % 4 < 2 ? game::blue : game::red;
+
+		game::evaluator evaluate;
+		const game::evaluation e = evaluate(w.world);
+		const game::outcome o = evaluate.outcome_of(e);
+		const game::branch_type winner =
+				o == game::outcome::left ? game::blue :
+				o == game::outcome::right ? game::red :
+				o == game::outcome::next ? first :
+				first == game::blue ? game::red : game::blue;
+
+		const game::branch_type last = play_out(w, ai, first);
+		if (last == game::invalid)
+			assert(winner != first);
+		else
+			assert(last == winner);
+	}
+}
+
+// a stack is cut at the branch the opponent chose, and keeps the value of the
+// world on the side of the player who chose it
+static void test_stacks()
+{
+	test_world w;
+	const auto a = w.node(0.0f, 0.0f), b = w.node(0.0f, 1.0f),
+			c = w.node(0.0f, 2.0f);
+	w.edge(game::blue, a, b);
+	w.edge(game::red, b, c);
+	w.edge(game::red, w.node(1.0f, 0.0f), w.node(1.0f, 1.0f));
+	const auto root = w.stack(4.0f, 0.0f, 4.0f, FRACTION,
+							  new int32_t[2]{2, 3});
+	w.settle();
+
+	// 2/3 + 1/2 - 1 is worth 1/6, and blue must keep at least 1/2 of the stack
+	game::evaluator evaluate;
+	assert(evaluate(w.world).stacks + evaluate(w.world).number ==
+		   game::surreal::fraction(1, 6));
+	game::opponent ai(200);
+	const game::opponent::move m = ai.choose(w.world, game::blue);
+	assert(m.root == root and m.edge == game::world::npos);
+	play(w, m, game::blue);
+	const game::evaluation after = evaluate(w.world);
+	assert(after.exact() and after.stacks.is_zero() and
+		   after.number.sign() >= 0);
+}
+
+// the worker thinks while the caller goes on, and the move is taken from the
+// mailbox once, within the budget
+static void test_mailbox(std::mt19937 &rng)
+{
+	// ladders of mixed colours, which have no closed form and are searched
+	// until the budget runs out
+	test_world w;
+	const game::branch_type types[] = {game::red, game::green, game::blue};
+	for (int l = 0; l < 4; ++l)
+	{
+		game::world::id_t below[2] = {w.node(4.0f * l, 0.0f),
+									  w.node(4.0f * l + 1.0f, 0.0f)};
+		for (int rung = 1; rung <= 4; ++rung)
+		{
+			game::world::id_t above[2];
+			for (int side = 0; side < 2; ++side)
+			{
+				above[side] = w.node(4.0f * l + side, rung);
+				w.edge(types[rng() % 3], below[side], above[side]);
+				below[side] = above[side];
+			}
+			w.edge(types[rng() % 3], above[0], above[1]);
+		}
+	}
+	w.settle();
+
+	game::opponent ai(50);
+	assert(ai.think(w.world, game::red));
+	assert(!ai.think(w.world, game::red));
+	game::opponent::move m;
+	const auto start = std::chrono::steady_clock::now();
+	while (!ai.poll(m))
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	const double waited = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - start).count();
+	assert(waited < 5000.0);
+	assert(m.depth >= 1 and m.positions > 0);
+	assert(!ai.poll(m));
+	play(w, m, game::red);
+
+	// the move is stale once the world changed
+	assert(!game::opponent::resolve(w.world, m));
+
+	// a long search returns early when it is hurried
+	ai.set_budget(60000);
+	assert(ai.think(w.world, game::blue));
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	ai.hurry();
+	while (!ai.poll(m))
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	play(w, m, game::blue);
+
+	assert(ai.get_latencies().size() == 2);
+	assert(ai.get_latencies()[1] < 5000.0);
+	std::ostringstream os;
+	ai.report(os);
+	assert(os.str().find("2 moves") == 0);
+}
+
+// the hint moves in the hottest component: nimbers before numbers, and the
+// number with the largest denominator first
+static void test_hint(std::mt19937 &rng)
+{
+	test_world w;
+	const auto g0 = w.node(0.0f, 0.0f), a = w.node(0.0f, 1.0f);
+	w.edge(game::blue, g0, a);
+	const auto g1 = w.node(2.0f, 0.0f), b = w.node(2.0f, 1.0f),
+			c = w.node(2.0f, 2.0f);
+	const auto half = w.edge(game::blue, g1, b);
+	w.edge(game::red, b, c);
+	const auto star = w.edge(game::green, w.node(4.0f, 0.0f),
+							 w.node(4.0f, 1.0f));
+	w.settle();
+
+	game::opponent ai(200);
+	game::opponent::move m = ai.hint(w.world, game::blue);
+	assert(m.edge == star and m.depth == 0);
+	assert(game::opponent::resolve(w.world, m));
+	play(w, m, game::blue);
+
+	// 1 + 1/2 is left, where blue plays in 1/2 and red can only play there
+	m = ai.hint(w.world, game::blue);
+	assert(m.edge == half);
+	m = ai.hint(w.world, game::red);
+	assert(m.edge != game::world::npos and w.world.get_type(m.edge) == game::red);
+
+	// a world of many components is hinted without searching it
+	test_world large;
+	random_forest(large, rng, 400, false);
+	const game::branch_type types[] = {game::red, game::green, game::blue};
+	for (int l = 0; l < 200; ++l)
+	{
+		const float x = 5000.0f + 4.0f * l;
+		const auto base = large.node(x, 0.0f);
+		const auto top = large.node(x, 1.0f);
+		large.edge(types[rng() % 3], base, top);
+		large.edge(types[rng() % 3], top, large.node(x + 1.0f, 2.0f));
+		large.edge(types[rng() % 3], top, large.node(x - 1.0f, 2.0f));
+	}
+	large.settle();
+	const auto start = std::chrono::steady_clock::now();
+	m = ai.hint(large.world, game::blue);
+	const double ms = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - start).count();
+	assert(m.edge != game::world::npos and ms < 5000.0);
+	assert(large.world.get_type(m.edge) != game::red);
+
+	// no moves, no hint
+	test_world empty;
+	empty.edge(game::red, empty.node(0.0f, 0.0f), empty.node(0.0f, 1.0f));
+	empty.settle();
+	m = ai.hint(empty.world, game::blue);
+	assert(m.edge == game::world::npos and m.root == game::world::npos);
+}
+
+int main()
+{
+	std::mt19937 rng(18);
+	test_closed_forms(rng);
+	test_stacks();
+	test_mailbox(rng);
+	test_hint(rng);
+
+	// the opponent can be destroyed while it is thinking
+	test_world w;
+	random_forest(w, rng, 20, false);
+	{
+		game::opponent ai(60000);
+		ai.think(w.world, game::blue);
+	}
+	std::cout << "opponent tests passed\n";
+	return 0;
+}
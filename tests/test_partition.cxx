@@ -0,0 +1,332 @@
+#include "game/prereqs.hpp"
+#include "game/nodes.hpp"
+#include "game/generators.hpp"
+#include "game/world.hpp"
+#include "game/value.hpp"
+#include "game/partition.hpp"
+#include "game/canonical.hpp"
+#include "tests/fixture.hpp"
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+// a world of many small components: trees, cycles, green and mixed ones, and
+// edges lying on the ground
+static void random_world(test_world &w, std::mt19937 &rng, int components)
+{
+	const game::branch_type types[] = {game::red, game::green, game::blue};
+	for (int c = 0; c < components; ++c)
+	{
+		const float x = 10.0f * c;
+		const int kind = rng() % 4;
+		const int air = 1 + rng() % 5;
+		std::vector<game::world::id_t> ids{w.node(x, 0.0f), w.node(x + 5.0f, 0.0f)};
+		for (int i = 0; i < air; ++i)
+			ids.push_back(w.node(x + i, 1.0f + i));
+
+		std::set<std::pair<int, int>> pairs{{0, 1}};
+		if (rng() % 4 == 0)
+			w.edge(types[rng() % 3], ids[0], ids[1]);
+		for (int i = 0; i < air; ++i)
+		{
+			// every node hangs from the ground or an earlier node
+			const int a = i ? rng() % (i + 2) : rng() % 2;
+			pairs.emplace(a, i + 2);
+			const game::branch_type type = kind == 0 ? game::green :
+										   kind == 1 ? types[rng() % 2 * 2] :
+										   types[rng() % 3];
+			w.edge(type, ids[a], ids[i + 2]);
+		}
+		for (int extra = rng() % 3; extra > 0; --extra)
+		{
+			const int a = rng() % ids.size(), b = 2 + rng() % air;
+			if (a == b or !pairs.emplace(std::min(a, b), std::max(a, b)).second)
+				continue;
+			w.edge(kind == 0 ? game::green : types[rng() % 3], ids[a], ids[b]);
+		}
+	}
+	w.settle();
+}
+
+// the cached values always add up to the value of the whole world, and only
+// the pieces of the chopped component are valued again
+static void test_chops(std::mt19937 &rng)
+{
+	for (int trial = 0; trial < 20; ++trial)
+	{
+		test_world w;
+		random_world(w, rng, 30);
+		game::partition parts(nullptr, 1 + trial % 3);
+		parts.build(w.world);
+		assert(parts.get_revalued() == parts.num_components());
+
+		game::evaluator evaluate;
+		for (int chop = 0; chop < 60; ++chop)
+		{
+			const game::evaluation expected = evaluate(w.world);
+			const game::evaluation &got = parts.get_value(w.world);
+			assert(!parts.is_pending());
+			assert(got.number == expected.number);
+			assert(got.nimber == expected.nimber);
+			assert(got.components == expected.components);
+			assert(got.components == parts.num_components());
+			assert(got.trees == expected.trees and
+				   got.searched == expected.searched and
+				   got.green == expected.green and
+				   got.canonical == expected.canonical and
+				   got.unsupported == expected.unsupported);
+
+			// the forms of two evaluators have their own ids, so the sums of
+			// the mixed components are compared by what they do
+			game::evaluator &mine = parts.get_evaluator();
+			assert(mine.outcome_of(got) == evaluate.outcome_of(expected));
+			assert(mine.get_forms().birthday(got.form) ==
+				   evaluate.get_forms().birthday(expected.form));
+
+			std::vector<game::world::id_t> alive;
+			for (game::world::id_t e = 0; e < w.world.num_edges(); ++e)
+				if (w.world.is_alive(e))
+					alive.push_back(e);
+			if (alive.empty())
+				break;
+
+			const game::world::id_t e = alive[rng() % alive.size()];
+			const std::size_t before = parts.num_components();
+			game::world::fallout fallen;
+			w.world.cut(e, fallen);
+			parts.update(w.world, e);
+			assert(parts.num_components() + 1 == before + parts.get_revalued());
+			assert(parts.get_component(e) == game::partition::none);
+		}
+	}
+}
+
+// trees are valued down the chopped path, and agree with valuing the whole
+// world after every chop, whether what fell is reported or looked for
+static void test_trees(std::mt19937 &rng)
+{
+	for (int trial = 0; trial < 10; ++trial)
+	{
+		test_world w;
+		for (int t = 0; t < 8; ++t)
+		{
+			const float x = 100.0f * t;
+			std::vector<game::world::id_t> ids{w.node(x, 0.0f)};
+			for (int i = 1; i <= 40; ++i)
+			{
+				ids.push_back(w.node(x + 0.5f * i, (float) i));
+				w.edge(t % 2 ? game::green : rng() % 2 ? game::blue : game::red,
+					   ids[rng() % (ids.size() - 1)], ids.back());
+			}
+		}
+		w.settle();
+		game::partition parts(nullptr, 1 + trial % 2);
+		parts.build(w.world);
+
+		game::evaluator evaluate;
+		for (int chop = 0; chop < 200; ++chop)
+		{
+			std::vector<game::world::id_t> alive;
+			for (game::world::id_t e = 0; e < w.world.num_edges(); ++e)
+				if (w.world.is_alive(e))
+					alive.push_back(e);
+			if (alive.empty())
+				break;
+
+			const game::world::id_t e = alive[rng() % alive.size()];
+			const uint32_t c = parts.get_component(e);
+			game::world::fallout fallen;
+			w.world.cut(e, fallen);
+			parts.update(w.world, e, trial % 2 ? &fallen : nullptr);
+			assert(parts.get_revalued() <= 1);
+			assert(parts.get_component(e) == game::partition::none);
+			for (game::world::id_t x: fallen.edges)
+				assert(parts.get_component(x) == game::partition::none);
+
+			const game::evaluation expected = evaluate(w.world);
+			const game::evaluation &got = parts.get_value(w.world);
+			assert(got.number == expected.number and
+				   got.nimber == expected.nimber);
+			assert(got.components == expected.components and
+				   got.trees == expected.trees and got.green == expected.green);
+
+			// the tree keeps its component and its edges
+			if (parts.get_revalued())
+			{
+				const auto &edges = parts.get_component_edges(c);
+				for (game::world::id_t x: alive)
+					if (w.world.is_alive(x) and parts.get_component(x) == c)
+						assert(std::find(edges.begin(), edges.end(), x) !=
+							   edges.end());
+			}
+		}
+	}
+}
+
+// chops undone in reverse order bring back the values the components had
+static void test_restore(std::mt19937 &rng)
+{
+	for (int trial = 0; trial < 10; ++trial)
+	{
+		test_world w;
+		random_world(w, rng, 20);
+		game::partition parts(nullptr, 1 + trial % 2);
+		parts.build(w.world);
+
+		game::evaluator evaluate;
+		const auto check = [&]()
+		{
+			const game::evaluation expected = evaluate(w.world);
+			const game::evaluation &got = parts.get_value(w.world);
+			assert(got.number == expected.number and
+				   got.nimber == expected.nimber);
+			assert(got.components == expected.components and
+				   got.components == parts.num_components());
+			assert(got.trees == expected.trees and
+				   got.searched == expected.searched and
+				   got.green == expected.green and
+				   got.canonical == expected.canonical);
+		};
+
+		std::vector<game::world::id_t> cuts;
+		std::vector<game::world::fallout> fallen;
+		for (int chop = 0; chop < 40; ++chop)
+		{
+			std::vector<game::world::id_t> alive;
+			for (game::world::id_t e = 0; e < w.world.num_edges(); ++e)
+				if (w.world.is_alive(e))
+					alive.push_back(e);
+			if (alive.empty())
+				break;
+			cuts.push_back(alive[rng() % alive.size()]);
+			fallen.emplace_back();
+			w.world.cut(cuts.back(), fallen.back());
+			parts.update(w.world, cuts.back(), &fallen.back());
+		}
+		while (!cuts.empty())
+		{
+			w.world.uncut(cuts.back(), fallen.back());
+			parts.restore(w.world, cuts.back(), fallen.back());
+			check();
+			cuts.pop_back();
+			fallen.pop_back();
+		}
+	}
+}
+
+// cutting a stack revalues the component it is in, whether the cut removes its
+// link or the stack was cut before
+static void test_stacks()
+{
+	test_world w;
+	const auto a = w.node(0.0f, 1.0f);
+	w.edge(game::blue, w.node(0.0f, 0.0f), a);
+	const auto high = w.stack(1.0f, 2.0f, 4.0f, FRACTION,
+							  new int32_t[2]{2, 3});
+	w.edge(game::blue, a, high);
+	const auto low = w.stack(4.0f, 0.0f, 4.0f, ALL_BLUE);
+	const auto far = w.stack(8.0f, 0.0f, 4.0f, ALL_RED);
+	w.settle();
+
+	game::partition parts(nullptr, 1);
+	parts.build(w.world);
+	const auto check = [&]()
+	{
+		game::evaluator evaluate;
+		const game::evaluation expected = evaluate(w.world);
+		const game::evaluation &got = parts.get_value(w.world);
+		assert(got.exact() and expected.exact());
+		assert(got.number == expected.number and got.stacks == expected.stacks);
+		assert(got.components == expected.components and
+			   got.stacked == expected.stacked);
+		return got.stacks + got.number;
+	};
+	assert(check() == game::graft(game::blue, game::graft(
+			game::blue, game::surreal::fraction(2, 3))));
+
+	const auto chop = [&](game::world::id_t root, int64_t order)
+	{
+		w.root(root).detach(order);
+		const game::world::id_t link = w.world.get_link(root);
+		if (link == game::world::npos)
+		{
+			parts.restack(w.world, root);
+			return;
+		}
+		game::world::fallout fallen;
+		w.world.cut(link, fallen);
+		parts.update(w.world, link);
+	};
+	for (int64_t order: {9, 5, 2})
+	{
+		chop(high, order);
+		check();
+		chop(low, order);
+		check();
+		assert(parts.get_revalued() == 1);
+	}
+	chop(far, 3);
+	assert(check() == 3 + 1 - 2);
+}
+
+// a chop at a stack on the ground without its link, taken back and made
+// again, keeps the stack in a component of its own
+static void test_restore_stack()
+{
+	test_world w;
+	const auto root = w.stack(0.0f, 0.0f, 4.0f, FRACTION,
+							  new int32_t[2]{1000, 3});
+	const auto a = w.node(-1.0f, 1.0f);
+	const auto b = w.node(-2.0f, 2.0f);
+	// the stack root refuses edges as node1, so the normal end goes first
+	const auto cut = w.edge(game::red, a, root);
+	assert(cut != game::world::npos);
+	w.edge(game::blue, a, b);
+	w.settle();
+
+	game::partition parts(nullptr, 1);
+	parts.build(w.world);
+	const auto check = [&]()
+	{
+		game::evaluator evaluate;
+		const game::evaluation expected = evaluate(w.world);
+		const game::evaluation &got = parts.get_value(w.world);
+		assert(got.number == expected.number and got.stacks == expected.stacks);
+		assert(got.components == expected.components and
+			   got.components == parts.num_components());
+	};
+
+	w.root(root).detach(5);
+	game::world::fallout fallen;
+	const game::world::id_t link = w.world.get_link(root);
+	w.world.cut(link, fallen);
+	parts.update(w.world, link, &fallen);
+	check();
+
+	for (int round = 0; round < 2; ++round)
+	{
+		fallen.clear();
+		w.world.cut(cut, fallen);
+		parts.update(w.world, cut, &fallen);
+		check();
+		w.world.uncut(cut, fallen);
+		parts.restore(w.world, cut, fallen);
+		check();
+	}
+}
+
+int main()
+{
+	std::mt19937 rng(16);
+	test_chops(rng);
+	test_trees(rng);
+	test_restore(rng);
+	test_restore_stack();
+	test_stacks();
+	std::cout << "partition tests passed\n";
+	return 0;
+}
@@ -0,0 +1,126 @@
+#include "worldgen/parser.hpp"
+#include "worldgen/position_map.hpp"
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <unordered_set>
+
+using worldgen::position_map;
+
+// every position of a lattice gets its own id, and is found again after the
+// table has grown many times
+static void test_lattice()
+{
+	position_map map;
+	int32_t id = 0;
+	for (int x = -10; x < 10; ++x)
+		for (int y = 0; y < 10; ++y)
+			for (int z = -10; z < 10; ++z)
+			{
+				auto [found, inserted] = map.insert(glm::vec3(x, y, z), id);
+				assert(inserted and found == id);
+				++id;
+			}
+	assert(map.size() == (std::size_t) id);
+
+	id = 0;
+	for (int x = -10; x < 10; ++x)
+		for (int y = 0; y < 10; ++y)
+			for (int z = -10; z < 10; ++z)
+			{
+				assert(map.find(glm::vec3(x, y, z)) == id);
+				auto [found, inserted] = map.insert(glm::vec3(x, y, z), -5);
+				assert(!inserted and found == id);
+				++id;
+			}
+	assert(map.find(glm::vec3(10.0f, 0.0f, 0.0f)) == position_map::npos);
+	assert(map.find(glm::vec3(0.5f, 0.0f, 0.0f)) == position_map::npos);
+}
+
+// positions that only differ by rounding errors are the same node
+static void test_quantization()
+{
+	position_map map(4);
+	assert(map.find(glm::vec3(0.0f)) == position_map::npos);
+
+	map.insert(glm::vec3(0.3f, 1.0f, 0.0f), 7);
+	assert(map.find(glm::vec3(0.1f + 0.2f, 1.0f, -0.0f)) == 7);
+	assert(map.find(glm::vec3(0.3f + position_map::QUANTUM, 1.0f, 0.0f)) ==
+		   position_map::npos);
+
+	assert(position_map::in_range(glm::vec3(-position_map::LIMIT)));
+	assert(!position_map::in_range(glm::vec3(0.0f, 1e9f, 0.0f)));
+	assert(!position_map::in_range(glm::vec3(std::nanf(""), 0.0f, 0.0f)));
+}
+
+// permutations and repeated coordinates no longer share a hash
+static void test_hashes()
+{
+	std::hash<glm::vec3> h3;
+	assert(h3(glm::vec3(1.0f, 1.0f, 0.0f)) != h3(glm::vec3(0.0f, 1.0f, 1.0f)));
+	assert(h3(glm::vec3(1.0f, 2.0f, 3.0f)) != h3(glm::vec3(3.0f, 2.0f, 1.0f)));
+	assert(h3(glm::vec3(0.0f)) == h3(glm::vec3(-0.0f)));
+
+	std::hash<std::pair<int32_t, int32_t>> h2;
+	assert(h2({2, 3}) != h2({3, 2}));
+	assert(h2({5, 5}) != h2({7, 7}));
+
+	// a small lattice gets distinct hashes in the low bits of a table
+	std::unordered_set<std::size_t> buckets;
+	for (int x = 0; x < 16; ++x)
+		for (int y = 0; y < 16; ++y)
+			for (int z = 0; z < 16; ++z)
+				buckets.insert(h3(glm::vec3(x, y, z)) & 0xffff);
+	assert(buckets.size() > 4096 * 9 / 10);
+}
+
+// a file with shared end points is parsed into one node per position
+static void test_parse()
+{
+	const char *filename = "test_position_map.hkb";
+	{
+		std::ofstream file(filename);
+		file << "# a square with a tail\n"
+			 << "b b 0 0 0 -- 1 0 0\n"
+			 << "b r 1 0 0 -- 1 1 0\n"
+			 << "b g 1 1 0 -- 0 1 0\n"
+			 << "b b 0 1 0 -- 0.0 0.0 0.0\n"
+			 << "b r 0.1 1 0 -- 0.30000001 2 0\n";
+	}
+
+	worldgen::lut_t node_pos;
+	worldgen::adj_list_t adj_list;
+	assert(worldgen::parse(filename, node_pos, adj_list));
+	assert(node_pos.size() == 6);
+	assert(adj_list.size() == 6);
+	assert(adj_list[0].conn.front().id == 1);
+	assert(adj_list[3].conn.front().id == 0);
+	assert(node_pos[5] == glm::vec3(0.30000001f, 2.0f, 0.0f));
+
+	{
+		std::ofstream file(filename);
+		file << "b b 0 0 0 -- 1 1e12 0\n";
+	}
+	bool thrown = false;
+	try
+	{
+		worldgen::parse(filename, node_pos, adj_list);
+	}
+	catch (const worldgen::hackenbush_parsing_exception &)
+	{
+		thrown = true;
+	}
+	assert(thrown);
+	std::remove(filename);
+}
+
+int main()
+{
+	test_lattice();
+	test_quantization();
+	test_hashes();
+	test_parse();
+	std::cout << "position map tests passed" << std::endl;
+	return 0;
+}
@@ -0,0 +1,263 @@
+#include "game/prereqs.hpp"
+#include "game/nodes.hpp"
+#include "game/world.hpp"
+#include "game/value.hpp"
+#include "game/solver.hpp"
+#include "tests/fixture.hpp"
+#include <cassert>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+using game::outcome;
+
+// a green edge with a blue (up) or red (down) edge on top of it, and a green
+// edge next to them, as in up.hkb and down.hkb
+static void arrow(test_world &w, float x, game::branch_type top)
+{
+	const auto g = w.node(x, 0.0f);
+	const auto a = w.node(x, 2.0f);
+	w.edge(game::green, g, a);
+	w.edge(game::green, g, w.node(x + 1.4f, 1.0f));
+	w.edge(top, a, w.node(x, 3.0f, 3.6f));
+}
+
+// who wins the whole world found by trying every move, for worlds of at most
+// 20 edges
+struct brute_force
+{
+	struct edge
+	{
+		uint32_t p1, p2;
+		game::branch_type type;
+	};
+	std::vector<edge> edges; // local nodes, 0 is the ground
+	std::unordered_map<uint64_t, bool> memo;
+
+	explicit brute_force(const game::world &w)
+	{
+		std::unordered_map<game::world::id_t, uint32_t> local;
+		const auto id = [&](game::world::id_t n)
+		{
+			if (w.is_grounded(n))
+				return 0u;
+			return local.emplace(n, local.size() + 1).first->second;
+		};
+		for (game::world::id_t e = 0; e < w.num_edges(); ++e)
+			if (w.is_alive(e))
+				edges.push_back({id(w.get_p1(e)), id(w.get_p2(e)),
+								 w.get_type(e)});
+		assert(edges.size() <= 20);
+	}
+
+	uint32_t grounded(uint32_t alive) const
+	{
+		uint64_t reached = 1;
+		uint32_t kept = 0;
+		for (bool grew = true; grew;)
+		{
+			grew = false;
+			for (uint32_t j = 0; j < edges.size(); ++j)
+			{
+				const bool a = reached >> edges[j].p1 & 1;
+				const bool b = reached >> edges[j].p2 & 1;
+				if (!(alive >> j & 1) or !(a or b) or kept >> j & 1)
+					continue;
+				kept |= 1u << j;
+				reached |= 1ull << edges[j].p1 | 1ull << edges[j].p2;
+				grew = true;
+			}
+		}
+		return kept;
+	}
+
+	bool wins(uint32_t alive, game::branch_type player)
+	{
+		const uint64_t key = (uint64_t) alive << 1 | (player == game::blue);
+		auto it = memo.find(key);
+		if (it != memo.end())
+			return it->second;
+
+		const game::branch_type opponent =
+				player == game::blue ? game::red : game::blue;
+		bool won = false;
+		for (uint32_t j = 0; j < edges.size() and !won; ++j)
+			if (alive >> j & 1 and edges[j].type != opponent)
+				won = !wins(grounded(alive & ~(1u << j)), opponent);
+		return memo[key] = won;
+	}
+
+	outcome operator()()
+	{
+		const uint32_t all = (1u << edges.size()) - 1;
+		const bool left = wins(all, game::blue), right = wins(all, game::red);
+		if (left)
+			return right ? outcome::next : outcome::left;
+		return right ? outcome::right : outcome::previous;
+	}
+};
+
+// up is positive, down is negative, and their sum is zero
+static void test_arrows()
+{
+	game::solver solve(nullptr, 1);
+	{
+		test_world w;
+		arrow(w, 0.0f, game::blue);
+		w.settle();
+		const game::solution s = solve(w.world);
+		assert(s.solved and s.result == outcome::left);
+		assert(s.searched_edges == 2 and s.exact.nimber == 1);
+	}
+	{
+		test_world w;
+		arrow(w, 0.0f, game::red);
+		w.settle();
+		assert(solve(w.world).result == outcome::right);
+	}
+	{
+		test_world w;
+		arrow(w, 0.0f, game::blue);
+		arrow(w, 5.0f, game::red);
+		w.settle();
+		assert(solve(w.world).result == outcome::previous);
+
+		// up and down with a star on top is fuzzy, and a tiny number decides
+		// it for blue
+		w.edge(game::green, w.node(10.0f, 0.0f), w.node(10.0f, 1.0f));
+		w.settle();
+		assert(solve(w.world).result == outcome::next);
+		const auto g = w.node(12.0f, 0.0f), a = w.node(12.0f, 1.0f);
+		w.edge(game::blue, g, a);
+		w.edge(game::red, a, w.node(12.0f, 2.0f));
+		w.settle();
+		const game::solution s = solve(w.world);
+		assert(s.exact.number == game::dyadic::fraction(1, 1) and
+			   s.exact.nimber == 1);
+		assert(s.result == outcome::left);
+	}
+}
+
+// worlds that are exact are not searched
+static void test_exact()
+{
+	test_world w;
+	const auto g = w.node(0.0f, 0.0f);
+	w.edge(game::green, g, w.node(0.0f, 1.0f));
+	w.settle();
+	game::solver solve;
+	game::solution s = solve(w.world);
+	assert(s.solved and s.result == outcome::next and s.positions == 0);
+
+	w.edge(game::red, g, w.node(1.0f, 1.0f));
+	w.settle();
+	s = solve(w.world);
+	assert(s.result == outcome::right and s.positions == 0);
+}
+
+// random worlds of mixed components, with every number of threads: the
+// solver agrees with trying every move
+static void test_random(std::mt19937 &rng)
+{
+	// the positions of the nodes repeat between trials, so the trials share
+	// positions in the table
+	game::transposition_table table(1);
+	for (int trial = 0; trial < 300; ++trial)
+	{
+		test_world w;
+		std::vector<game::world::id_t> ids;
+		const int ground = 1 + rng() % 3, air = 2 + rng() % 6;
+		for (int i = 0; i < ground; ++i)
+			ids.push_back(w.node((float) i * 3.0f, 0.0f));
+		for (int i = 0; i < air; ++i)
+			ids.push_back(w.node((float) i, 1.0f + i));
+
+		std::set<std::pair<int, int>> pairs;
+		const int num_edges = air + rng() % 8;
+		for (int e = 0; e < num_edges; ++e)
+		{
+			int a = rng() % ids.size(), b = ground + rng() % air;
+			if (a == b or !pairs.emplace(std::min(a, b), std::max(a, b)).second)
+				continue;
+			const game::branch_type types[] = {game::red, game::green,
+											   game::blue};
+			w.edge(types[rng() % 3], ids[a], ids[b]);
+		}
+		w.settle();
+
+		brute_force brute(w.world);
+		const outcome expected = brute();
+		for (int threads: {1, 4})
+		{
+			game::solver solve(&table, threads);
+			const game::solution s = solve(w.world);
+			assert(s.solved and s.result == expected);
+		}
+	}
+}
+
+// two strings of mixed colours, too many edges for 64 bits: a chop in a
+// string leaves the edges below it, so who wins is found from the lengths
+// left in each string
+static void test_wide(std::mt19937 &rng)
+{
+	const game::branch_type types[] = {game::red, game::green, game::blue};
+	for (int trial = 0; trial < 10; ++trial)
+	{
+		test_world w;
+		std::vector<game::branch_type> strings[2];
+		for (int s = 0; s < 2; ++s)
+		{
+			auto below = w.node(10.0f * s, 0.0f);
+			for (int i = 0; i < 40; ++i)
+			{
+				strings[s].push_back(i == 0 ? game::green : types[rng() % 3]);
+				const auto above = w.node(10.0f * s, 1.0f + i);
+				w.edge(strings[s].back(), below, above);
+				below = above;
+			}
+		}
+		w.settle();
+
+		// wins[a][b][p] for strings cut down to a and b edges, with blue to
+		// move when p is 1
+		bool wins[41][41][2];
+		for (int a = 0; a <= 40; ++a)
+			for (int b = 0; b <= 40; ++b)
+				for (int p = 0; p < 2; ++p)
+				{
+					const game::branch_type opponent = p ? game::red :
+													   game::blue;
+					bool won = false;
+					for (int i = 0; i < a and !won; ++i)
+						if (strings[0][i] != opponent)
+							won = !wins[i][b][!p];
+					for (int i = 0; i < b and !won; ++i)
+						if (strings[1][i] != opponent)
+							won = !wins[a][i][!p];
+					wins[a][b][p] = won;
+				}
+
+		const bool left = wins[40][40][1], right = wins[40][40][0];
+		const outcome expected = left ? right ? outcome::next : outcome::left :
+								 right ? outcome::right : outcome::previous;
+		game::solver solve(nullptr, 1 + trial % 2);
+		const game::solution s = solve(w.world);
+		assert(s.solved and s.searched_edges == 80);
+		assert(s.result == expected);
+	}
+}
+
+int main()
+{
+	std::mt19937 rng(14);
+	test_arrows();
+	test_exact();
+	test_random(rng);
+	test_wide(rng);
+	std::cout << "solver tests passed\n";
+	return 0;
+}
@@ -0,0 +1,92 @@
+#include "game/prereqs.hpp"
+#include "game/nodes.hpp"
+#include "game/generators.hpp"
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+// count every allocation made by the program
+static std::size_t allocations = 0;
+
+void *operator new(std::size_t size)
+{
+	++allocations;
+	if (void *p = std::malloc(size))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{ std::free(p); }
+
+void operator delete(void *p, std::size_t) noexcept
+{ std::free(p); }
+
+/**
+ * @brief render the visible part of the stack, like a frame of the game does.
+ */
+static void render_frame(game::node::container &visible,
+						 game::edge::container &edges)
+{
+	for (game::node *n: visible)
+		n->render(edges);
+}
+
+static void test_no_allocations()
+{
+	const glm::vec3 bottomleft(-2.0f, -2.0f, -2.0f);
+	const glm::vec3 topright(2.0f, 2.0f, 2.0f);
+
+	game::nodes::stack_root root(glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f),
+								 ALL_BLUE, GEOMETRIC, nullptr);
+
+	game::node::container visible;
+	root.collect(visible, bottomleft, topright);
+	assert(!visible.empty());
+
+	// the first frame materializes the branches
+	game::edge::container first, edges;
+	render_frame(visible, first);
+	assert(!first.empty());
+	edges = first;
+
+	// later frames reuse them without allocating anything
+	const std::size_t before = allocations;
+	for (int frame = 0; frame < 1000; ++frame)
+		render_frame(visible, edges);
+	assert(allocations == before);
+	assert(edges == first);
+}
+
+static void test_invalidate_on_detach()
+{
+	const glm::vec3 bottomleft(-2.0f, -2.0f, -2.0f);
+	const glm::vec3 topright(2.0f, 2.0f, 2.0f);
+
+	game::nodes::stack_root root(glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f),
+								 ALL_RED, GEOMETRIC, nullptr);
+	game::node::container visible;
+	root.collect(visible, bottomleft, topright);
+
+	game::edge *low = root.branch(2);
+	game::edge *high = root.branch(10);
+	assert(low and high and low != high);
+	assert(root.branch(2) == low);
+
+	// cutting the stack at order 5 keeps the branches below it
+	root.detach(5);
+	assert(root.branch(2) == low);
+	assert(root.branch(3) != nullptr);
+	assert(root.branch(4) == nullptr);
+	assert(root.branch(10) == nullptr);
+	assert(root[5] == nullptr);
+}
+
+int main(int argc, char **argv)
+{
+	test_no_allocations();
+	test_invalidate_on_detach();
+	std::cout << "stack cache tests passed" << std::endl;
+	return 0;
+}
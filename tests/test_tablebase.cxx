@@ -0,0 +1,243 @@
+#include "game/prereqs.hpp"
+#include "game/nodes.hpp"
+#include "game/world.hpp"
+#include "game/value.hpp"
+#include "game/tablebase.hpp"
+#include "tests/fixture.hpp"
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using game::dyadic;
+using game::tablebase;
+
+static const char *FILENAME = "/tmp/test_tablebase.hkbt";
+
+// a component of the given edges, with the ground as node 0
+static void build(test_world &w, const std::vector<tablebase::edge> &component)
+{
+	uint32_t k = 0;
+	for (const tablebase::edge &e: component)
+		k = std::max({k, e.p1, e.p2});
+	std::vector<game::world::id_t> ids{w.node(0.0f, 0.0f)};
+	for (uint32_t v = 1; v <= k; ++v)
+		ids.push_back(w.node((float) v, 1.0f + v));
+	for (const tablebase::edge &e: component)
+		w.edge(e.type, ids[e.p1], ids[e.p2]);
+	w.settle();
+}
+
+// a red-blue component of k nodes above the ground with a cycle, which stays
+// connected without the ground. Edges of the same colour between the same
+// nodes have the same zobrist key in the world, so they are not drawn twice.
+static std::vector<tablebase::edge> random_component(std::mt19937 &rng,
+													 uint32_t k, uint32_t n)
+{
+	std::vector<tablebase::edge> edges;
+	const auto colour = [&rng]()
+	{ return rng() % 2 ? game::blue : game::red; };
+	for (uint32_t v = 1; v <= k; ++v)
+		edges.push_back({v == 1 ? 0 : 1 + (uint32_t) (rng() % (v - 1)), v,
+						 colour()});
+	while (edges.size() < n)
+	{
+		const tablebase::edge e{(uint32_t) (rng() % (k + 1)),
+								(uint32_t) (rng() % (k + 1)), colour()};
+		if (e.p1 != e.p2 and std::none_of(edges.begin(), edges.end(),
+										  [&e](const tablebase::edge &f)
+		{
+			return f.type == e.type and std::minmax(f.p1, f.p2) ==
+										std::minmax(e.p1, e.p2);
+		}))
+			edges.push_back(e);
+	}
+	return edges;
+}
+
+// the same component with its nodes numbered and its edges listed otherwise
+static std::vector<tablebase::edge> relabel(std::vector<tablebase::edge> edges,
+											std::mt19937 &rng)
+{
+	uint32_t k = 0;
+	for (const tablebase::edge &e: edges)
+		k = std::max({k, e.p1, e.p2});
+	std::vector<uint32_t> label(k + 1);
+	std::iota(label.begin(), label.end(), 0);
+	std::shuffle(label.begin() + 1, label.end(), rng);
+	for (tablebase::edge &e: edges)
+	{
+		e = {label[e.p1], label[e.p2], e.type};
+		if (rng() % 2)
+			std::swap(e.p1, e.p2);
+	}
+	std::shuffle(edges.begin(), edges.end(), rng);
+	return edges;
+}
+
+static void test_canonical(std::mt19937 &rng)
+{
+	for (int trial = 0; trial < 500; ++trial)
+	{
+		const uint32_t k = 2 + rng() % 7;
+		const auto edges = random_component(rng, k, k + rng() % 4);
+		const tablebase::code_t code = tablebase::canonical(edges.data(),
+															edges.size());
+		assert(code);
+		for (int r = 0; r < 5; ++r)
+		{
+			const auto other = relabel(edges, rng);
+			assert(tablebase::canonical(other.data(), other.size()) == code);
+		}
+
+		// the code decodes to a numbering of the same component
+		tablebase::edge decoded[tablebase::MAX_EDGES];
+		assert(tablebase::decode(code, decoded) == edges.size());
+		assert(tablebase::canonical(decoded, edges.size()) == code);
+
+		// a colour changed is another component
+		auto flipped = edges;
+		flipped[0].type = flipped[0].type == game::blue ? game::red : game::blue;
+		assert(tablebase::canonical(flipped.data(), flipped.size()) != code);
+	}
+
+	// loops, other colours and too many edges have no code
+	const tablebase::edge loop{1, 1, game::blue}, green{0, 1, game::green};
+	assert(!tablebase::canonical(&loop, 1));
+	assert(!tablebase::canonical(&green, 1));
+	std::vector<tablebase::edge> many(tablebase::MAX_EDGES + 1,
+									  {0, 1, game::blue});
+	assert(!tablebase::canonical(many.data(), many.size()));
+}
+
+// the values in the table are the values the evaluator finds by searching,
+// and the evaluator finds them in the table instead once it has one
+static void test_lookup(std::mt19937 &rng)
+{
+	std::vector<std::vector<tablebase::edge>> components;
+	std::map<tablebase::code_t, dyadic> values;
+	for (int trial = 0; trial < 100; ++trial)
+	{
+		const uint32_t k = 2 + rng() % 4;
+		components.push_back(random_component(rng, k, k + 1 + rng() % 3));
+		const auto &edges = components.back();
+
+		test_world w;
+		build(w, edges);
+		game::evaluator evaluate;
+		const game::evaluation e = evaluate(w.world);
+		assert(e.exact() and e.searched == 1 and e.tabled == 0);
+
+		const tablebase::code_t code = tablebase::canonical(edges.data(),
+															edges.size());
+		const auto found = values.find(code);
+		assert(found == values.end() or found->second == e.number);
+		values[code] = e.number;
+	}
+
+	// half of the components go into the table
+	std::vector<tablebase::entry> entries;
+	for (const auto &[code, value]: values)
+		if (entries.size() < values.size() / 2)
+			entries.push_back({code, value});
+	tablebase::write(FILENAME, entries, 6);
+	const tablebase table(FILENAME);
+	assert(table.size() == entries.size() and table.max_edges() == 6);
+	for (const tablebase::entry &e: entries)
+	{
+		dyadic value;
+		assert(table.probe(e.code, value) and value == e.value);
+	}
+
+	std::size_t hits = 0;
+	for (const auto &edges: components)
+	{
+		const tablebase::code_t code = tablebase::canonical(edges.data(),
+															edges.size());
+		const bool listed = std::any_of(entries.begin(), entries.end(),
+										[code](const tablebase::entry &e)
+										{ return e.code == code; });
+		dyadic value;
+		assert(table.probe(edges.data(), edges.size(), value) == listed);
+
+		test_world w;
+		build(w, edges);
+		game::evaluator evaluate;
+		evaluate.set_tablebase(&table);
+		const game::evaluation e = evaluate(w.world);
+		assert(e.number == values[code]);
+		assert(e.tabled == (listed ? 1u : 0u));
+		assert(e.searched == (listed ? 0u : 1u));
+		hits += listed;
+	}
+	assert(hits > 0);
+}
+
+// the evaluator trusts the table, so a value that could not be searched is
+// found in it
+static void test_trusted()
+{
+	const std::vector<tablebase::edge> triangle{{0, 1, game::blue},
+												{0, 2, game::blue},
+												{1, 2, game::red}};
+	const tablebase::code_t code = tablebase::canonical(triangle.data(),
+														triangle.size());
+	tablebase::write(FILENAME, {{code, 100}}, 3);
+	const tablebase table(FILENAME);
+
+	std::mt19937 rng(19);
+	test_world w;
+	build(w, relabel(triangle, rng));
+	game::evaluator evaluate;
+	evaluate.set_tablebase(&table);
+	game::evaluation e = evaluate(w.world);
+	assert(e.number == 100 and e.tabled == 1);
+
+	// components larger than the table are searched
+	test_world larger;
+	build(larger, {{0, 1, game::blue}, {0, 2, game::blue}, {1, 2, game::red},
+				  {2, 3, game::red}});
+	e = evaluate(larger.world);
+	assert(e.tabled == 0 and e.searched == 1);
+}
+
+static void test_errors()
+{
+	bool thrown = false;
+	try
+	{
+		tablebase missing("/tmp/no such table");
+	}
+	catch (const std::runtime_error &)
+	{
+		thrown = true;
+	}
+	assert(thrown);
+
+	thrown = false;
+	try
+	{
+		tablebase not_a_table(__FILE__);
+	}
+	catch (const std::runtime_error &)
+	{
+		thrown = true;
+	}
+	assert(thrown);
+}
+
+int main()
+{
+	std::mt19937 rng(19);
+	test_canonical(rng);
+	test_lookup(rng);
+	test_trusted();
+	test_errors();
+	std::cout << "tablebase tests passed\n";
+	return 0;
+}
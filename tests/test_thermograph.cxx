@@ -0,0 +1,165 @@
+#include "game/value.hpp"
+#include "game/canonical.hpp"
+#include "game/thermograph.hpp"
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using game::dyadic;
+using game::forms;
+using game::thermographs;
+
+static dyadic frac(int64_t num, uint32_t exp)
+{
+	return dyadic::fraction(num, exp);
+}
+
+// the thermographs of well known games, and cooling them
+static void test_known()
+{
+	forms f;
+	thermographs th(f);
+	const forms::id_t one = f.number(1), two = f.number(2);
+
+	// numbers are cold, and colder the simpler they are
+	assert(th.temperature(f.number(5)) == -1 and th.mean(f.number(5)) == 5);
+	assert(th.temperature(f.number(frac(3, 2))) == frac(-1, 2));
+	assert(th.temperature(f.number(frac(-5, 3))) == frac(-1, 3));
+	assert(th.temperature(game::forms::zero) == -1);
+
+	// infinitesimals and nimbers are tepid
+	for (forms::id_t g: {f.nimber(1), f.nimber(3), f.up(1), f.up(-2)})
+		assert(th.temperature(g) == 0 and th.mean(g) == 0);
+
+	// the switch ±1 and the hot games {2|-1} and {3|{2|1}}
+	const forms::id_t pm = f.make({one}, {f.number(-1)});
+	assert(th.temperature(pm) == 1 and th.mean(pm) == 0);
+	const forms::id_t hot = f.make({two}, {f.number(-1)});
+	assert(th.temperature(hot) == frac(3, 1) and th.mean(hot) == frac(1, 1));
+	const forms::id_t inner = f.make({two}, {one});
+	const forms::id_t outer = f.make({f.number(3)}, {inner});
+	assert(th.temperature(inner) == frac(1, 1) and
+		   th.mean(inner) == frac(3, 1));
+	assert(th.temperature(outer) == frac(3, 2) and
+		   th.mean(outer) == frac(9, 2));
+
+	// the walls of {3|{2|1}}: blue gets 3 - t, and red gets 2 until {2|1}
+	// is cooled to its mast, then 3/2 + t
+	const game::thermograph &graph = th(outer);
+	assert(graph.left(-1) == 4 and graph.left(0) == 3 and
+		   graph.left(frac(1, 1)) == frac(5, 1));
+	assert(graph.right(-1) == 2 and graph.right(frac(1, 2)) == 2 and
+		   graph.right(frac(5, 3)) == frac(17, 3));
+	assert(graph.left(5) == frac(9, 2) and graph.right(5) == frac(9, 2));
+
+	// cooling ±1 by 1 leaves *, and {2|-1} cools to {1|0}, 1/2* and 1/2
+	assert(th.cool(pm, 1) == f.nimber(1));
+	assert(th.cool(hot, 1) == f.make({one}, {game::forms::zero}));
+	assert(th.cool(hot, frac(3, 1)) ==
+		   f.add(f.number(frac(1, 1)), f.nimber(1)));
+	assert(th.cool(hot, 2) == f.number(frac(1, 1)));
+	assert(th.cool(f.number(7), 3) == f.number(7));
+
+	bool thrown = false;
+	try
+	{
+		th.cool(hot, -1);
+	}
+	catch (const std::domain_error &)
+	{
+		thrown = true;
+	}
+	assert(thrown);
+}
+
+// games made of random options of smaller games, starting from numbers,
+// nimbers and switches
+static std::vector<forms::id_t> random_games(forms &f, std::mt19937 &rng,
+											 int count)
+{
+	std::vector<forms::id_t> pool{f.number(0), f.number(1), f.number(-1),
+								  f.number(frac(1, 1)), f.number(3),
+								  f.nimber(1), f.nimber(2), f.up(1)};
+	while ((int) pool.size() < count)
+	{
+		std::vector<forms::id_t> left, right;
+		for (int i = 0, n = 1 + rng() % 3; i < n; ++i)
+			left.push_back(pool[rng() % pool.size()]);
+		for (int i = 0, n = 1 + rng() % 3; i < n; ++i)
+			right.push_back(pool[rng() % pool.size()]);
+		pool.push_back(f.make(left, right));
+	}
+	return pool;
+}
+
+// the walls never cross, meet at the temperature and stay at the mast, which
+// is the mean value: it adds up over sums and moves with the numbers added
+static void test_properties(std::mt19937 &rng)
+{
+	forms f;
+	thermographs th(f);
+	const std::vector<forms::id_t> games = random_games(f, rng, 60);
+	for (forms::id_t g: games)
+	{
+		const game::thermograph &graph = th(g);
+		assert(graph.left(graph.temperature) == graph.mast);
+		assert(graph.right(graph.temperature) == graph.mast);
+		for (int i = -8; i <= 40; ++i)
+		{
+			const dyadic t = frac(i, 3);
+			assert(graph.left(t) >= graph.right(t));
+			if (t >= graph.temperature)
+				assert(graph.left(t) == graph.mast and
+					   graph.right(t) == graph.mast);
+		}
+		if (f.is_number(g))
+			continue;
+		assert(graph.temperature.sign() >= 0);
+
+		const game::thermograph &negative = th(f.neg(g));
+		assert(negative.temperature == graph.temperature and
+			   negative.mast == -graph.mast);
+		for (int i = -8; i <= 40; ++i)
+			assert(negative.left(frac(i, 3)) == -graph.right(frac(i, 3)));
+
+		const forms::id_t moved = f.add(g, f.number(frac(3, 2)));
+		assert(th.temperature(moved) == graph.temperature and
+			   th.mean(moved) == graph.mast + frac(3, 2));
+
+		// cooling keeps the mean and takes the temperature down by as much
+		assert(th.cool(g, 0) == g);
+		for (int i = 1; i <= 12; ++i)
+		{
+			const dyadic t = frac(i, 2);
+			const forms::id_t cooled = th.cool(g, t);
+			assert(th.mean(cooled) == graph.mast);
+			if (t < graph.temperature)
+				assert(th.temperature(cooled) == graph.temperature - t);
+			else
+				assert(!(th.temperature(cooled) > 0));
+		}
+	}
+
+	// a sum is no hotter than its hottest term
+	for (int trial = 0; trial < 200; ++trial)
+	{
+		const forms::id_t a = games[rng() % games.size()];
+		const forms::id_t b = games[rng() % games.size()];
+		const forms::id_t sum = f.add(a, b);
+		assert(th.mean(sum) == th.mean(a) + th.mean(b));
+		if (!f.is_number(sum))
+			assert(th.temperature(sum) <= std::max(th.temperature(a),
+												   th.temperature(b)));
+	}
+}
+
+int main()
+{
+	std::mt19937 rng(20);
+	test_known();
+	test_properties(rng);
+	std::cout << "thermograph tests passed\n";
+	return 0;
+}
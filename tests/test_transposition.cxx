@@ -0,0 +1,178 @@
+#include "game/prereqs.hpp"
+#include "game/nodes.hpp"
+#include "game/world.hpp"
+#include "game/value.hpp"
+#include "game/transposition.hpp"
+#include "common/hash.hpp"
+#include "tests/fixture.hpp"
+#include <cassert>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using game::dyadic;
+using game::transposition_table;
+
+// values are found again exactly, including negative and fractional ones
+static void test_store_probe()
+{
+	transposition_table table(1);
+	assert(table.num_buckets() == 1 << 14);
+
+	dyadic value;
+	assert(!table.probe(42, value));
+	table.store(42, dyadic::fraction(-13, 5), 3);
+	table.store(43, dyadic(0), 1);
+	assert(table.probe(42, value) and value == dyadic::fraction(-13, 5));
+	assert(table.probe(43, value) and value == 0);
+
+	// the largest values of a search of MAX_SEARCH_EDGES edges fit
+	const dyadic large = dyadic::fraction(((int64_t) 1 << 40) + 1, 40);
+	table.store(44, -large, 40);
+	assert(table.probe(44, value) and value == -large);
+
+	table.store(45, dyadic(1).ldexp(-70), 2);
+	assert(!table.probe(45, value));
+
+	const auto stats = table.get_stats();
+	assert(stats.probes == 5 and stats.hits == 3 and stats.stores == 3);
+	assert(stats.rejected == 1 and stats.collisions == 0);
+
+	table.clear();
+	assert(!table.probe(42, value) and table.get_stats().probes == 1);
+}
+
+// a full bucket loses its smallest position, older generations first
+static void test_replacement()
+{
+	transposition_table table(0);
+	assert(table.num_buckets() == 1);
+
+	dyadic value;
+	for (uint64_t key = 1; key <= transposition_table::BUCKET_SIZE; ++key)
+		table.store(key, dyadic(key), 10 + key);
+	table.store(100, dyadic(100), 20);
+	assert(!table.probe(1, value) and table.probe(2, value) and value == 2);
+	assert(table.get_stats().collisions == 1);
+
+	// storing a key again overwrites it in place
+	table.store(100, dyadic(-100), 20);
+	assert(table.probe(100, value) and value == -100);
+	assert(table.get_stats().collisions == 1);
+
+	// after aging, even a small new position replaces the largest old one
+	table.age();
+	for (uint64_t key = 200; key < 200 + transposition_table::BUCKET_SIZE; ++key)
+		table.store(key, dyadic(key), 1);
+	for (uint64_t key = 200; key < 200 + transposition_table::BUCKET_SIZE; ++key)
+		assert(table.probe(key, value) and value == (int64_t) key);
+}
+
+// threads hammering the same few buckets never read a value stored for
+// another key
+static void test_threads()
+{
+	transposition_table table(0);
+	const auto value_of = [](uint64_t key)
+	{ return dyadic::fraction((int64_t) (key % 1000) - 500, key % 7); };
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t)
+	{
+		threads.emplace_back([&, t]()
+		{
+			dyadic value;
+			for (uint64_t i = 0; i < 200000; ++i)
+			{
+				const uint64_t key = hashing::mix(i % 64 + 1);
+				if (table.probe(key, value))
+					assert(value == value_of(key));
+				else
+					table.store(key, value_of(key), t + 1);
+			}
+		});
+	}
+	for (std::thread &thread: threads)
+		thread.join();
+	assert(table.get_stats().hits > 0);
+}
+
+// the key of the world only depends on which edges are left
+static void test_world_keys()
+{
+	test_world a, b;
+	for (test_world *w: {&a, &b})
+	{
+		const auto g = w->node(0.0f, 0.0f);
+		const auto p = w->node(0.0f, 1.0f), q = w->node(1.0f, 1.0f);
+		w->edge(game::blue, g, p);
+		w->edge(game::red, p, q);
+		w->edge(game::blue, g, q);
+		w->edge(game::green, q, w->node(1.0f, 2.0f));
+		w->settle();
+	}
+	assert(a.world.get_key() == b.world.get_key() and a.world.get_key());
+
+	// chopping the same edges in either order gives the same key, and the
+	// green edge falls in both
+	game::world::fallout fallen;
+	a.world.cut(0, fallen);
+	a.world.cut(2, fallen);
+	b.world.cut(2, fallen);
+	assert(a.world.get_key() != b.world.get_key());
+	b.world.cut(0, fallen);
+	assert(a.world.get_key() == b.world.get_key() and !a.world.get_key());
+
+	// the key of an edge does not depend on the order of its nodes or its id
+	test_world c;
+	const auto q = c.node(1.0f, 1.0f), p = c.node(0.0f, 1.0f);
+	const auto g = c.node(0.0f, 0.0f);
+	const auto e = c.edge(game::red, q, p);
+	c.edge(game::blue, g, p);
+	assert(c.world.get_key(e) == b.world.get_key(1));
+	assert(c.world.get_key(e) != c.world.get_key(1 - e));
+}
+
+// evaluating with a shared table gives the same values, and a second
+// evaluation finds every position it searches
+static void test_evaluator()
+{
+	test_world w;
+	const auto g1 = w.node(0.0f, 0.0f), g2 = w.node(4.0f, 0.0f);
+	std::vector<game::world::id_t> row{g1};
+	for (int i = 1; i < 4; ++i)
+		row.push_back(w.node((float) i, 1.0f));
+	row.push_back(g2);
+	for (std::size_t i = 0; i + 1 < row.size(); ++i)
+		w.edge(i % 2 ? game::red : game::blue, row[i], row[i + 1]);
+	for (int i = 1; i < 4; ++i)
+		w.edge(i == 2 ? game::red : game::blue, row[i],
+			   w.node((float) i, 2.0f));
+	w.settle();
+
+	const game::evaluation alone = game::evaluator()(w.world);
+	assert(alone.exact() and alone.searched == 1);
+
+	transposition_table table(1);
+	game::evaluator evaluate(&table);
+	assert(evaluate(w.world).number == alone.number);
+	const auto first = table.get_stats();
+	assert(first.stores > 0 and first.collisions == 0);
+
+	assert(evaluate(w.world).number == alone.number);
+	const auto second = table.get_stats();
+	assert(second.probes == first.probes + 1 and second.hits == first.hits + 1);
+	assert(second.stores == first.stores);
+}
+
+int main()
+{
+	test_store_probe();
+	test_replacement();
+	test_threads();
+	test_world_keys();
+	test_evaluator();
+	std::cout << "transposition tests passed\n";
+	return 0;
+}
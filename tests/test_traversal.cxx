@@ -0,0 +1,82 @@
+#include "game/prereqs.hpp"
+#include "game/nodes.hpp"
+#include "game/world.hpp"
+#include <cassert>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+/**
+ * @brief a vertical chain of nodes, much deeper than DEFAULT_MAX_DEPTH.
+ */
+struct chain
+{
+	std::vector<std::unique_ptr<game::nodes::normal>> nodes;
+	std::vector<std::unique_ptr<game::edge>> edges;
+
+	chain(int length, game::world *world)
+	{
+		for (int i = 0; i < length; ++i)
+		{
+			nodes.emplace_back(new game::nodes::normal(
+					glm::vec3(0.0f, (float) i, 0.0f)));
+			if (world)
+				world->add_node(nodes.back().get(), game::node_kind::normal);
+			if (i)
+				edges.emplace_back(game::attach(game::blue,
+												nodes[i - 1].get(),
+												nodes[i].get()));
+		}
+	}
+};
+
+// the nodes are found no matter how deep they are
+static void test_deep(int length, game::world *world)
+{
+	chain c(length, world);
+
+	game::node::container nodes;
+	(*c.nodes.front())(nodes, glm::vec3(-1.0f, length - 10.5f, -1.0f),
+					   glm::vec3(1.0f, (float) length, 1.0f));
+	assert(nodes.size() == 10);
+	assert(nodes.count(c.nodes.back().get()));
+}
+
+// several queries run at the same time, each with its own context
+static void test_concurrent()
+{
+	const int length = 20000;
+	game::world world;
+	chain c(length, &world);
+
+	std::vector<std::thread> threads;
+	std::vector<std::size_t> found(8);
+	for (int t = 0; t < 8; ++t)
+	{
+		threads.emplace_back([&, t]() {
+			game::traversal ctx;
+			for (int i = 0; i < 20; ++i)
+			{
+				game::node::container nodes;
+				(*c.nodes[t * 1000])(nodes, glm::vec3(-1.0f, t * 100.0f, -1.0f),
+									 glm::vec3(1.0f, t * 100.0f + 99.5f, 1.0f),
+									 ctx);
+				found[t] = nodes.size();
+			}
+		});
+	}
+	for (auto &thread: threads)
+		thread.join();
+	for (std::size_t n: found)
+		assert(n == 100);
+}
+
+int main(int argc, char **argv)
+{
+	game::world world;
+	test_deep(100 * DEFAULT_MAX_DEPTH, &world);
+	test_deep(4 * DEFAULT_MAX_DEPTH, nullptr);
+	test_concurrent();
+	std::cout << "traversal tests passed" << std::endl;
+	return 0;
+}
@@ -0,0 +1,537 @@
+#include "game/prereqs.hpp"
+#include "game/nodes.hpp"
+#include "game/generators.hpp"
+#include "game/world.hpp"
+#include "game/value.hpp"
+#include "game/canonical.hpp"
+#include "worldgen/parser.hpp"
+#include "tests/fixture.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+
+using game::dyadic;
+using game::surreal;
+
+static dyadic frac(int64_t num, uint32_t exp)
+{
+	return dyadic::fraction(num, exp);
+}
+
+static void test_dyadic()
+{
+	assert(frac(6, 2) == frac(3, 1));
+	assert(frac(4, 2) == 1 and frac(4, 2).is_integer());
+	assert(frac(1, 1) + frac(1, 2) == frac(3, 2));
+	assert(frac(1, 1) - 1 == frac(-1, 1));
+	assert(frac(-3, 2).floor() == -1 and frac(3, 2).floor() == 0);
+	assert(frac(-1, 3) < frac(-1, 4) and frac(1, 4) < frac(1, 3) + frac(1, 3));
+	assert(dyadic(3).half() == frac(3, 1) and dyadic(4).half() == 2);
+	assert(frac(5, 3).to_double() == 0.625);
+
+	std::stringstream ss;
+	ss << frac(-5, 3) << ' ' << dyadic(7);
+	assert(ss.str() == "-5/8 7");
+
+	// numerators wider than 64 bits stay exact
+	const dyadic tiny = frac(1, 1).ldexp(-200);
+	assert(tiny.exp() == 201 and tiny + tiny == frac(1, 200));
+	const dyadic big = dyadic(std::numeric_limits<int64_t>::max()) + 1;
+	assert(!big.is_narrow() and big - 1 == std::numeric_limits<int64_t>::max());
+	assert(-big == dyadic(std::numeric_limits<int64_t>::min()));
+	assert((-big).is_narrow() and big.ldexp(-63) == 1);
+	assert(big + tiny > big and big + tiny - big == tiny);
+	bool thrown = false;
+	try
+	{
+		big.floor();
+	}
+	catch (const std::overflow_error &)
+	{
+		thrown = true;
+	}
+	assert(thrown);
+	assert((-tiny).floor() == -1 and (big - tiny).to_double() == 0x1p63);
+
+	ss.str("");
+	ss << big << ' ' << -big.ldexp(64) + 1 << ' ' << frac(3, 1).ldexp(-99);
+	assert(ss.str() == "9223372036854775808 -170141183460469231731687303715884105727"
+					   " 3/2^100");
+}
+
+static void test_simplest()
+{
+	using opt = std::optional<dyadic>;
+	assert(game::simplest(opt(), opt()) == 0);
+	assert(game::simplest(dyadic(0), opt()) == 1);
+	assert(game::simplest(opt(), dyadic(0)) == -1);
+	assert(game::simplest(dyadic(5), opt()) == 6);
+	assert(game::simplest(dyadic(-1), dyadic(1)) == 0);
+	assert(game::simplest(frac(1, 1), dyadic(1)) == frac(3, 2));
+	assert(game::simplest(dyadic(1), dyadic(2)) == frac(3, 1));
+	assert(game::simplest(frac(1, 2), frac(1, 1)) == frac(3, 3));
+	assert(game::simplest(dyadic(-2), dyadic(-1)) == frac(-3, 1));
+	assert(game::simplest(frac(-1, 1), dyadic(0)) == frac(-1, 2));
+	assert(game::simplest(frac(7, 3), dyadic(3)) == 1);
+}
+
+// the sign expansion rule agrees with grafting one edge at a time
+static void test_strings(std::mt19937 &rng)
+{
+	const game::branch_type plus_minus_plus[] = {game::blue, game::red,
+												 game::blue};
+	assert(game::string_value(plus_minus_plus, 3) == frac(3, 2));
+	const game::branch_type minus_minus_plus[] = {game::red, game::red,
+												  game::blue};
+	assert(game::string_value(minus_minus_plus, 3) == frac(-3, 1));
+
+	for (int trial = 0; trial < 200; ++trial)
+	{
+		std::vector<game::branch_type> types(rng() % 300);
+		for (auto &t: types)
+			t = rng() % 2 ? game::blue : game::red;
+
+		dyadic grafted;
+		for (std::size_t i = types.size(); i-- > 0;)
+			grafted = game::graft(types[i], grafted);
+		assert(game::string_value(types.data(), types.size()) == grafted);
+	}
+}
+
+// random forests of red-blue trees: the closed form agrees with searching
+static void test_trees(std::mt19937 &rng)
+{
+	for (int trial = 0; trial < 50; ++trial)
+	{
+		test_world w;
+		const int num_trees = 1 + rng() % 3;
+		for (int t = 0; t < num_trees; ++t)
+		{
+			const game::world::id_t ground = w.node(10.0f * t, 0.0f);
+			std::vector<game::world::id_t> tree{ground};
+			const int size = 1 + rng() % 10;
+			for (int i = 0; i < size; ++i)
+			{
+				const game::world::id_t parent = tree[rng() % tree.size()];
+				const game::world::id_t child =
+						w.node(10.0f * t + i * 0.1f, 1.0f + i);
+				w.edge(rng() % 2 ? game::blue : game::red, parent, child);
+				tree.push_back(child);
+			}
+		}
+		w.settle();
+
+		game::evaluator evaluate;
+		const game::evaluation closed = evaluate(w.world);
+		const game::evaluation searched = evaluate(w.world, false);
+		assert(closed.exact() and searched.exact());
+		assert(closed.components == searched.components);
+		assert(closed.trees == closed.components and closed.searched == 0);
+		assert(searched.searched == searched.components);
+		assert(closed.number == searched.number);
+	}
+}
+
+// components with cycles, through the ground or above it
+static void test_cycles()
+{
+	test_world w;
+	const auto g1 = w.node(0.0f, 0.0f), g2 = w.node(2.0f, 0.0f);
+	const auto a = w.node(0.0f, 1.0f), b = w.node(2.0f, 1.0f);
+	w.edge(game::blue, g1, a);
+	w.edge(game::blue, g2, b);
+	const auto top = w.edge(game::red, a, b);
+	w.settle();
+
+	// blue chops a leg and leaves 1/2, red chops the top and leaves 2
+	game::evaluator evaluate;
+	game::evaluation result = evaluate(w.world);
+	assert(result.components == 1 and result.searched == 1);
+	assert(result.number == 1);
+
+	// an edge between two nodes on the ground is a component on its own
+	w.edge(game::red, g1, g2);
+	result = evaluate(w.world);
+	assert(result.components == 2 and result.number == 0);
+
+	// without the top, the legs are two separate trees
+	game::world::fallout fallen;
+	w.world.cut(top, fallen);
+	assert(fallen.nodes.empty());
+	result = evaluate(w.world);
+	assert(result.components == 3 and result.trees == 2);
+	assert(result.number == 1);
+
+	// a triangle above a single blue edge
+	test_world t;
+	const auto ground = t.node(0.0f, 0.0f);
+	const auto p = t.node(0.0f, 1.0f), q = t.node(-1.0f, 2.0f);
+	const auto r = t.node(1.0f, 2.0f);
+	t.edge(game::blue, ground, p);
+	t.edge(game::red, p, q);
+	t.edge(game::red, p, r);
+	t.edge(game::blue, q, r);
+	t.settle();
+	result = evaluate(t.world);
+	assert(result.exact() and result.searched == 1);
+
+	// blue: chop the trunk (0) or the top (leaving 1/4). red: chop a side,
+	// leaving blue, red, blue = 3/4
+	assert(result.number == frac(1, 1));
+}
+
+// the nim value of a green component found by trying every move, for
+// components of at most 20 edges
+struct brute_force
+{
+	struct edge
+	{
+		uint32_t p1, p2;
+	};
+	std::vector<edge> edges; // local nodes, 0 is the ground
+	std::unordered_map<uint32_t, uint64_t> memo;
+
+	uint32_t grounded(uint32_t alive) const
+	{
+		uint64_t reached = 1;
+		uint32_t kept = 0;
+		for (bool grew = true; grew;)
+		{
+			grew = false;
+			for (uint32_t j = 0; j < edges.size(); ++j)
+			{
+				const bool a = reached >> edges[j].p1 & 1;
+				const bool b = reached >> edges[j].p2 & 1;
+				if (!(alive >> j & 1) or !(a or b) or kept >> j & 1)
+					continue;
+				kept |= 1u << j;
+				reached |= 1ull << edges[j].p1 | 1ull << edges[j].p2;
+				grew = true;
+			}
+		}
+		return kept;
+	}
+
+	uint64_t operator()(uint32_t alive)
+	{
+		auto it = memo.find(alive);
+		if (it != memo.end())
+			return it->second;
+		std::vector<bool> options(edges.size() + 2);
+		for (uint32_t j = 0; j < edges.size(); ++j)
+			if (alive >> j & 1)
+			{
+				const uint64_t option = (*this)(grounded(alive & ~(1u << j)));
+				if (option < options.size())
+					options[option] = true;
+			}
+		uint64_t mex = 0;
+		while (options[mex])
+			++mex;
+		return memo[alive] = mex;
+	}
+};
+
+// green graphs: the fusion and colon principles agree with trying every move
+static void test_green(std::mt19937 &rng)
+{
+	// a stalk of n edges is worth *n, however long it is
+	{
+		test_world w;
+		game::world::id_t below = w.node(0.0f, 0.0f);
+		for (int i = 1; i <= 100000; ++i)
+		{
+			const auto above = w.node(0.0f, (float) i);
+			w.edge(game::green, below, above);
+			below = above;
+		}
+		w.settle();
+		const game::evaluation result = game::evaluator()(w.world);
+		assert(result.exact() and result.green == 1);
+		assert(result.nimber == 100000 and result.number == 0);
+	}
+
+	// a cycle through the ground is worth *1 when it is odd, 0 when it is even
+	for (int length = 2; length < 7; ++length)
+	{
+		test_world w;
+		auto prev = w.node(0.0f, 0.0f);
+		for (int i = 1; i < length; ++i)
+		{
+			const auto next = w.node((float) i, 1.0f);
+			w.edge(game::green, prev, next);
+			prev = next;
+		}
+		w.edge(game::green, prev, w.node((float) length, 0.0f));
+		w.settle();
+		assert(game::evaluator()(w.world).nimber == (uint64_t) (length & 1));
+	}
+
+	for (int trial = 0; trial < 300; ++trial)
+	{
+		test_world w;
+		brute_force brute;
+		const int num_nodes = 1 + rng() % 8, num_ground = 1 + rng() % 2;
+		std::vector<game::world::id_t> ids;
+		for (int i = 0; i < num_ground; ++i)
+			ids.push_back(w.node((float) i, 0.0f));
+		for (int i = 0; i < num_nodes; ++i)
+		{
+			ids.push_back(w.node((float) i, 1.0f + i));
+			const int parent = rng() % (ids.size() - 1);
+			w.edge(game::green, ids[parent], ids.back());
+		}
+		// extra edges close cycles, through the ground or above it, and may
+		// be parallel to other edges
+		const int extra = rng() % 5;
+		for (int i = 0; i < extra; ++i)
+		{
+			const int a = rng() % ids.size(), b = rng() % ids.size();
+			if (a != b)
+				w.edge(game::green, ids[a], ids[b]);
+		}
+		w.settle();
+
+		uint64_t expected = 0;
+		for (game::world::id_t e = 0; e < w.world.num_edges(); ++e)
+		{
+			auto local = [&](game::world::id_t n) {
+				return w.world.is_grounded(n) ? 0u : (uint32_t) n;
+			};
+			brute.edges.push_back({local(w.world.get_p1(e)),
+								   local(w.world.get_p2(e))});
+		}
+		expected = brute(brute.grounded((1u << brute.edges.size()) - 1));
+
+		const game::evaluation result = game::evaluator()(w.world);
+		assert(result.exact() and result.green == result.components);
+		assert(result.nimber == expected);
+	}
+}
+
+// components mixing green with red or blue are valued by their canonical
+// forms when they are small, and left out of the sum otherwise
+static void test_unsupported()
+{
+	test_world w;
+	const auto g = w.node(0.0f, 0.0f);
+	const auto a = w.node(0.0f, 1.0f), b = w.node(0.0f, 2.0f);
+	const auto c = w.node(3.0f, 1.0f);
+	w.edge(game::green, g, a);
+	w.edge(game::red, a, b);
+	w.edge(game::blue, w.node(3.0f, 0.0f), c);
+	w.settle();
+
+	game::evaluator evaluate;
+	game::evaluation result = evaluate(w.world);
+	assert(result.components == 2 and result.canonical == 1);
+	assert(result.exact() and result.number == 1 and result.form != 0);
+
+	evaluate.set_canonical_edges(0);
+	result = evaluate(w.world);
+	assert(result.components == 2 and result.unsupported == 1);
+	assert(!result.exact() and result.number == 1 and result.form == 0);
+}
+
+static std::string show(const surreal &s)
+{
+	std::ostringstream os;
+	os << s;
+	return os.str();
+}
+
+static void test_surreal()
+{
+	const surreal third = surreal::fraction(1, 3);
+	assert(third.get_real() == 0 and third.get_residue() == 1 and
+		   third.get_modulus() == 3);
+	assert(surreal::fraction(-1, 3) == -third and (-third).get_real() == -1);
+	assert(third + surreal::fraction(2, 3) == 1);
+	assert((third + surreal::fraction(2, 3)).is_dyadic());
+	assert(surreal::fraction(1, 6) == third.ldexp(-1));
+	assert(surreal::fraction(4, 3) == third.ldexp(2));
+	assert(surreal::fraction(6, 4) == frac(3, 1));
+	assert(third.sign() == 1 and (third - frac(1, 1)).sign() == -1);
+	assert(surreal::fraction(-7, 3).floor() == -3 and
+		   surreal::fraction(7, 3).floor() == 2);
+	assert(third < frac(3, 3) and third > frac(5, 4));
+
+	// the dyadic standing for 1/3 is on no grid of 2^-4 between it and 1/3
+	assert(third.nearby(4) == frac(11, 5));
+	assert(surreal(frac(3, 2)).nearby(1) == frac(3, 2));
+
+	// grafting follows the sign expansion
+	assert(game::graft(game::blue, surreal::fraction(2, 3)) ==
+		   surreal::fraction(5, 3));
+	assert(game::graft(game::red, surreal::fraction(2, 3)) ==
+		   surreal::fraction(-2, 3));
+	assert(game::graft(game::blue, surreal::omega()) == surreal::omega());
+	bool thrown = false;
+	try
+	{
+		game::graft(game::red, surreal::omega());
+	}
+	catch (const std::domain_error &)
+	{
+		thrown = true;
+	}
+	assert(thrown);
+
+	// an infinite term outweighs every real part
+	const surreal w = surreal::omega();
+	assert(w > 1000000 and -w < -1000000 and w - 1 < w);
+	assert(surreal::omega(1, 2) > surreal::omega(1000));
+	assert(w + third - w == third and (w - w).is_zero());
+	assert(show(surreal::omega(1, 2) + surreal::omega(2) - frac(1, 1)) ==
+		   "ω^2 + ω·2 - 1/2");
+	assert(show(-surreal::omega(frac(1, 1))) == "-ω·1/2");
+	assert(show(surreal::fraction(22, 7)) == "22/7");
+	assert(show(w + surreal::fraction(-1, 6)) == "ω - 1/6");
+	assert(show(surreal()) == "0");
+}
+
+// stacks are valued from their generators, before and after they are cut
+static void test_stacks()
+{
+	{
+		// ω blue branches under ω red ones, with red edges on both stacks
+		test_world w;
+		const auto peak = w.node(0.0f, 8.0f);
+		const auto top = w.stack(0.0f, 4.0f, 4.0f, ALL_RED, nullptr, peak);
+		w.stack(0.0f, 0.0f, 4.0f, ALL_BLUE, nullptr, top);
+		w.edge(game::red, peak, w.node(0.0f, 9.0f));
+		w.edge(game::red, w.node(1.0f, 5.0f), top);
+		w.settle();
+		game::evaluator evaluate;
+		game::evaluation result = evaluate(w.world);
+		assert(result.exact() and result.stacked == 1 and result.trees == 0);
+		assert(result.stacks == surreal::omega(frac(1, 1)) - 2);
+		std::ostringstream os;
+		evaluate.print(os, result);
+		assert(os.str() == "ω·1/2 - 2");
+		assert(evaluate.outcome_of(result) == game::outcome::left);
+
+		// a blue edge under ω red branches is worth an infinitesimal
+		const auto root = w.stack(3.0f, 1.0f, 4.0f, ALL_RED);
+		w.edge(game::blue, w.node(3.0f, 0.0f), root);
+		w.settle();
+		result = evaluate(w.world);
+		assert(result.stacked == 1 and result.unsupported == 1 and
+			   result.infinite == 1);
+	}
+	{
+		test_world w;
+		const auto a = w.node(0.0f, 1.0f);
+		w.edge(game::blue, w.node(0.0f, 0.0f), a);
+		const auto root = w.stack(1.0f, 2.0f, 4.0f, ALL_BLUE);
+		w.edge(game::red, a, root);
+		w.settle();
+		game::evaluator evaluate;
+		game::evaluation result = evaluate(w.world);
+		assert(!result.exact() and result.infinite == 1);
+
+		// the 3 branches left are a finite string
+		w.chop(root, 4);
+		result = evaluate(w.world);
+		assert(result.exact() and result.stacked == 1);
+		assert(result.number ==
+			   game::graft(game::blue, game::graft(game::red, dyadic(3))));
+	}
+
+	int32_t *fraction = new int32_t[2]{22, 7};
+	test_world w;
+	const auto root = w.stack(0.0f, 0.0f, 4.0f, FRACTION, fraction);
+	w.settle();
+	game::nodes::stack_root &stack = w.root(root);
+	assert(game::stack_value(stack) == surreal::fraction(22, 7));
+
+	// the branches follow the sign expansion of 22/7 = 3.001001...
+	std::vector<game::branch_type> types;
+	for (int64_t order = 0; order < 40; ++order)
+		types.push_back(stack.get_type(order));
+	const game::branch_type expansion[] = {
+			game::blue, game::blue, game::blue, game::blue, game::red,
+			game::red, game::red, game::blue, game::red, game::red, game::blue};
+	assert(std::equal(std::begin(expansion), std::end(expansion),
+					  types.begin()));
+	const double pi = game::string_value(types.data(), types.size()).to_double();
+	assert(std::abs(pi - 22.0 / 7.0) < 1e-9);
+
+	// a cut stack is the string of the branches left
+	for (int64_t order = 20; order > 0; order -= 7)
+	{
+		w.chop(root, order);
+		const game::evaluation result = game::evaluator()(w.world);
+		assert(result.exact() and result.components == 1);
+		assert(result.number ==
+			   game::string_value(types.data(), stack.size()));
+	}
+}
+
+// the red-blue games bundled with the world generator
+static void test_common_games(const std::string &dir)
+{
+	struct known
+	{
+		const char *file;
+		surreal value;
+	};
+	const known games[] = {
+			{"three_quarters.hkb",     frac(3, 2)},
+			{"one_arch.hkb",           1},
+			{"two_thirds.hkb",         surreal::fraction(2, 3)},
+			{"twentytwo_sevenths.hkb", surreal::fraction(22, 7)},
+			{"omega.hkb",              surreal::omega()},
+			{"minus_omega.hkb",        -surreal::omega()},
+			{"double_omega.hkb",       surreal::omega(2)},
+	};
+
+	test_world all;
+	surreal sum;
+	for (const known &k: games)
+	{
+		test_world w;
+		w.load(dir + k.file);
+		const game::evaluation result = game::evaluator()(w.world);
+		assert(result.exact());
+		assert(result.stacks + result.number == k.value);
+		all.load(dir + k.file);
+		sum += k.value;
+	}
+
+	// the whole sum is valued at once
+	game::evaluator evaluate;
+	const game::evaluation result = evaluate(all.world);
+	assert(result.exact() and result.stacks + result.number == sum);
+	assert(result.components == std::size(games) and result.stacked == 5);
+	std::ostringstream os;
+	evaluate.print(os, result);
+	assert(os.str() == "ω·2 + 467/84");
+	assert(evaluate.outcome_of(result) == game::outcome::left);
+}
+
+int main(int argc, char **argv)
+{
+	const std::string dir = argc > 1 ? argv[1] : "worldgen/common_games/";
+
+	std::mt19937 rng(11);
+	test_dyadic();
+	test_simplest();
+	test_strings(rng);
+	test_trees(rng);
+	test_cycles();
+	test_green(rng);
+	test_unsupported();
+	test_surreal();
+	test_stacks();
+	test_common_games(dir);
+	std::cout << "value tests passed" << std::endl;
+	return 0;
+}
@@ -0,0 +1,319 @@
+#include "game/prereqs.hpp"
+#include "game/nodes.hpp"
+#include "game/world.hpp"
+#include "game/generators.hpp"
+#include "tests/fixture.hpp"
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <memory>
+#include <random>
+
+template<typename T>
+static std::vector<T> sorted(std::vector<T> v)
+{
+	std::sort(v.begin(), v.end());
+	return v;
+}
+
+static void test_chain()
+{
+	test_world t;
+	auto g = t.node(0, 0), a = t.node(0, 1), b = t.node(0, 2), c = t.node(0, 3);
+	auto ga = t.edge(game::green, g, a), ab = t.edge(game::green, a, b);
+	auto bc = t.edge(game::green, b, c);
+
+	game::world::fallout out;
+	t.world.settle(0, out);
+	assert(out.nodes.empty());
+
+	t.world.cut(ga, out);
+	assert(sorted(out.nodes) == sorted(std::vector<uint32_t>{a, b, c}));
+	assert(sorted(out.edges) == sorted(std::vector<uint32_t>{ab, bc}));
+	assert(t.world.is_present(g) and !t.world.is_present(a));
+}
+
+static void test_cycle()
+{
+	test_world t;
+	auto g1 = t.node(0, 0), g2 = t.node(2, 0);
+	auto a = t.node(0, 1), b = t.node(2, 1), c = t.node(1, 2);
+	auto g1a = t.edge(game::green, g1, a), ab = t.edge(game::green, a, b);
+	auto bg2 = t.edge(game::green, b, g2);
+	auto ac = t.edge(game::green, a, c);
+
+	game::world::fallout out;
+	t.world.settle(0, out);
+
+	// the arch is held up by both ends
+	t.world.cut(g1a, out);
+	assert(out.nodes.empty() and out.edges.empty());
+
+	t.world.cut(bg2, out);
+	assert(sorted(out.nodes) == sorted(std::vector<uint32_t>{a, b, c}));
+	assert(sorted(out.edges) == sorted(std::vector<uint32_t>{ab, ac}));
+}
+
+static void test_unsupported_on_load()
+{
+	test_world t;
+	auto g = t.node(0, 0), a = t.node(0, 1);
+	auto f1 = t.node(5, 5), f2 = t.node(5, 6);
+	t.edge(game::green, g, a);
+	auto f = t.edge(game::green, f1, f2);
+
+	game::world::fallout out;
+	t.world.settle(0, out);
+	assert(sorted(out.nodes) == sorted(std::vector<uint32_t>{f1, f2}));
+	assert(out.edges == std::vector<uint32_t>{f});
+}
+
+// compare against a full reachability search after every cut
+static void test_random()
+{
+	std::mt19937 rng(7);
+	test_world t;
+	const int n = 2000;
+	for (int i = 0; i < n; ++i)
+		t.node((float) i, i < 20 ? 0.0f : 1.0f);
+	for (int i = 0; i < 3 * n; ++i)
+		t.edge(game::green, rng() % n, rng() % n);
+
+	game::world::fallout out;
+	t.world.settle(0, out);
+
+	for (int round = 0; round < 1000; ++round)
+	{
+		const game::world::id_t e = rng() % t.world.num_edges();
+		out.clear();
+		t.world.cut(e, out);
+
+		std::vector<uint8_t> reached(n, false);
+		std::vector<game::world::id_t> queue;
+		for (int i = 0; i < 20; ++i)
+		{
+			reached[i] = true;
+			queue.push_back(i);
+		}
+		for (std::size_t i = 0; i < queue.size(); ++i)
+		{
+			for (auto *h = t.world.adj_begin(queue[i]);
+				 h != t.world.adj_end(queue[i]); ++h)
+			{
+				if (!reached[h->other])
+				{
+					reached[h->other] = true;
+					queue.push_back(h->other);
+				}
+			}
+		}
+		for (int i = 0; i < n; ++i)
+			assert((bool) reached[i] == t.world.is_present(i));
+	}
+}
+
+// cuts undone in reverse order leave the world as it was before each of them,
+// and the same cuts made again drop the same nodes
+static void test_uncut()
+{
+	std::mt19937 rng(24);
+	test_world t;
+	const int n = 500;
+	for (int i = 0; i < n; ++i)
+		t.node((float) i, i < 10 ? 0.0f : 1.0f);
+	for (int i = 0; i < 2 * n; ++i)
+		t.edge(game::green, rng() % n, rng() % n);
+	game::world::fallout settled;
+	t.world.settle(0, settled);
+
+	struct snapshot
+	{
+		uint64_t key;
+		std::vector<uint8_t> present, alive;
+		std::vector<game::world::id_t> parents;
+	};
+	const auto take = [&t]()
+	{
+		snapshot s{t.world.get_key()};
+		for (game::world::id_t v = 0; v < t.world.num_nodes(); ++v)
+		{
+			s.present.push_back(t.world.is_present(v));
+			s.parents.push_back(t.world.get_parent(v));
+		}
+		for (game::world::id_t e = 0; e < t.world.num_edges(); ++e)
+			s.alive.push_back(t.world.is_alive(e));
+		return s;
+	};
+
+	std::vector<game::world::id_t> cuts;
+	std::vector<game::world::fallout> fallen;
+	std::vector<snapshot> before;
+	for (int round = 0; round < 300; ++round)
+	{
+		const game::world::id_t e = rng() % t.world.num_edges();
+		if (!t.world.is_alive(e))
+			continue;
+		before.push_back(take());
+		cuts.push_back(e);
+		fallen.emplace_back();
+		t.world.cut(e, fallen.back());
+	}
+
+	while (!cuts.empty())
+	{
+		t.world.uncut(cuts.back(), fallen.back());
+		const snapshot now = take(), &then = before.back();
+		assert(now.key == then.key and now.present == then.present and
+			   now.alive == then.alive and now.parents == then.parents);
+
+		// the adjacency is back too
+		for (game::world::id_t v = 0; v < t.world.num_nodes(); ++v)
+			for (auto *h = t.world.adj_begin(v); h != t.world.adj_end(v); ++h)
+				assert(t.world.is_alive(h->edge) and t.world.is_present(h->other));
+
+		game::world::fallout again;
+		t.world.cut(cuts.back(), again);
+		assert(sorted(again.nodes) == sorted(fallen.back().nodes) and
+			   sorted(again.edges) == sorted(fallen.back().edges));
+		t.world.uncut(cuts.back(), again);
+		cuts.pop_back();
+		fallen.pop_back();
+		before.pop_back();
+	}
+}
+
+// the lists of moves hold the edges of the colours of each player that are
+// left, after every cut and every cut undone, and the stacks with a branch of
+// their colours
+static void test_moves()
+{
+	std::mt19937 rng(25);
+	test_world t;
+	const int n = 300;
+	const game::branch_type types[] = {game::blue, game::red, game::green};
+	for (int i = 0; i < n; ++i)
+		t.node((float) i, i < 10 ? 0.0f : 1.0f);
+	for (int i = 0; i < 2 * n; ++i)
+		t.edge(types[rng() % 3], rng() % n, rng() % n);
+	game::world::fallout settled;
+	t.world.settle(0, settled);
+
+	const auto check = [&t]()
+	{
+		for (game::branch_type player: {game::blue, game::red})
+		{
+			const game::branch_type other =
+					player == game::blue ? game::red : game::blue;
+			std::vector<game::world::id_t> expected;
+			for (game::world::id_t e = 0; e < t.world.num_edges(); ++e)
+				if (t.world.is_alive(e) and t.world.get_type(e) != other)
+					expected.push_back(e);
+			assert(sorted(t.world.get_moves(player)) == expected);
+			assert(t.world.has_move(player) == !expected.empty());
+		}
+	};
+	check();
+
+	std::vector<game::world::id_t> cuts;
+	std::vector<game::world::fallout> fallen;
+	while (t.world.has_move(game::blue) or t.world.has_move(game::red))
+	{
+		const auto &moves = t.world.get_moves(
+				cuts.size() % 2 ? game::red : game::blue);
+		if (moves.empty())
+			break;
+		cuts.push_back(moves[rng() % moves.size()]);
+		fallen.emplace_back();
+		t.world.cut(cuts.back(), fallen.back());
+		check();
+	}
+	while (!cuts.empty())
+	{
+		t.world.uncut(cuts.back(), fallen.back());
+		check();
+		cuts.pop_back();
+		fallen.pop_back();
+	}
+
+	// a blue stack on the ground is a move for blue until it is cut down
+	game::nodes::stack_root root(glm::vec3(-1.0f, 0.0f, 0.0f),
+								 glm::vec3(0.0f, 1.0f, 0.0f), ALL_BLUE,
+								 GEOMETRIC, nullptr);
+	const game::world::id_t r = t.world.add_node(&root,
+												 game::node_kind::stack_root);
+	assert(t.world.get_stack_moves(game::blue) ==
+		   std::vector<game::world::id_t>{r});
+	assert(t.world.get_stack_moves(game::red).empty());
+	root.detach(1);
+	t.world.restack(r);
+	assert(t.world.get_stack_moves(game::blue).empty());
+
+	// the first red branch of 1000/3 is far up the stack, past its integral part
+	game::nodes::stack_root high(glm::vec3(-2.0f, 0.0f, 0.0f),
+								 glm::vec3(0.0f, 1.0f, 0.0f), FRACTION,
+								 GEOMETRIC, new int32_t[2]{1000, 3});
+	const game::world::id_t h = t.world.add_node(&high,
+												 game::node_kind::stack_root);
+	assert(t.world.get_stack_moves(game::red) ==
+		   std::vector<game::world::id_t>{h});
+	high.detach(335);
+	t.world.restack(h);
+	assert(t.world.get_stack_moves(game::red).empty());
+	assert(t.world.get_stack_moves(game::blue) ==
+		   std::vector<game::world::id_t>{h});
+}
+
+// the grid finds the same edges as testing every node, also after chops
+static void test_visible()
+{
+	std::mt19937 rng(11);
+	std::uniform_real_distribution<float> coord(-60.0f, 60.0f);
+	test_world t;
+	const int n = 3000;
+	for (int i = 0; i < n; ++i)
+		t.node(coord(rng), i < 100 ? 0.0f : std::abs(coord(rng)), coord(rng));
+	for (int i = 0; i < 2 * n; ++i)
+		t.edge(game::green, rng() % n, rng() % n);
+
+	game::world::fallout out;
+	t.world.settle(0, out);
+
+	for (int round = 0; round < 200; ++round)
+	{
+		out.clear();
+		t.world.cut(rng() % t.world.num_edges(), out);
+
+		const glm::vec3 centre(coord(rng), coord(rng), coord(rng));
+		const float size = round % 10 ? 15.0f : 200.0f;
+		const glm::vec3 bottomleft = centre - glm::vec3(size, size, size);
+		const glm::vec3 topright = centre + glm::vec3(size, size, size);
+
+		game::edge::container expected, found;
+		for (int i = 0; i < n; ++i)
+		{
+			const glm::vec3 pos = t.world.get_pos(i);
+			if (!t.world.is_present(i) or pos.x < bottomleft.x or
+				pos.x > topright.x or pos.y < bottomleft.y or
+				pos.y > topright.y or pos.z < bottomleft.z or
+				pos.z > topright.z)
+				continue;
+			for (auto *h = t.world.adj_begin(i); h != t.world.adj_end(i); ++h)
+				expected.insert(t.world.get_edge(h->edge));
+		}
+		t.world.visible(found, bottomleft, topright);
+		assert(found == expected);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	test_chain();
+	test_cycle();
+	test_unsupported_on_load();
+	test_random();
+	test_uncut();
+	test_moves();
+	test_visible();
+	std::cout << "world tests passed" << std::endl;
+	return 0;
+}
@@ -0,0 +1,151 @@
+/**
+ * @file eval.cxx
+ * @author Jonah Chen
+ * @brief evaluate worlds without opening the client, such as the worlds made
+ * by the finite generator. Every file is loaded into a game of its own, its
+ * value is found as the client keeps it and its outcome by the solver, and
+ * one line of CSV is written for it. The files are shared among the threads,
+ * each with a game it loads one file after another into, so the positions
+ * searched for one world are kept for the next.
+ *
+ * Usage: hkb-eval [-o output.csv] [directories or .hkb files...]
+ * @version 1.0
+ * @date 2021-12-12
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include "game/game.hpp"
+#include "game/canonical.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+using clk = std::chrono::steady_clock;
+
+/**
+ * @brief a field of a CSV line, quoted when it has a comma, a quote or a line
+ * break in it.
+ */
+static std::string field(const std::string &s)
+{
+	if (s.find_first_of(",\"\n") == std::string::npos)
+		return s;
+	std::string quoted = "\"";
+	for (char c: s)
+	{
+		if (c == '"')
+			quoted += '"';
+		quoted += c;
+	}
+	return quoted + '"';
+}
+
+/**
+ * @brief evaluate the world of a file in a game, reset first.
+ *
+ * @return std::string the line of the file, without the line break.
+ */
+static std::string evaluate(hackenbush &game, const std::string &filename)
+{
+	std::ostringstream line;
+	line << field(filename) << ',';
+	game.reset();
+	const auto start = clk::now();
+	try
+	{
+		if (!game.load_world(filename.c_str()))
+			return line.str() + ",error,,,";
+
+		std::ostringstream value;
+		game.print_value(value);
+		const game::solution s = game.solve();
+		const double seconds = std::chrono::duration<double>(clk::now() -
+															 start).count();
+
+		std::size_t edges = 0;
+		const game::world &w = game.get_world();
+		for (game::world::id_t e = 0; e < w.num_edges(); ++e)
+			edges += w.is_alive(e);
+		line << field(value.str()) << ','
+			 << (s.solved ? game::outcome_name(s.result) : "unknown") << ','
+			 << game.value().components << ',' << edges << ','
+			 << seconds * 1e3;
+	}
+	catch (const std::exception &e)
+	{
+		std::cerr << filename << ": " << e.what() << '\n';
+		return line.str() + ",error,,,";
+	}
+	return line.str();
+}
+
+int main(int argc, char **argv)
+{
+	if (argc == 1)
+	{
+		std::cout << "Usage: hkb-eval [-o output.csv] "
+					 "[directories or .hkb files...]\n"
+					 "The .hkb files of a directory are evaluated in the order "
+					 "of their names, and\nthe CSV is written to the standard "
+					 "output unless an output file is given.\n";
+		return 0;
+	}
+
+	std::string output;
+	std::vector<std::string> files;
+	for (int arg = 1; arg < argc; ++arg)
+	{
+		if (strcmp(argv[arg], "-o") == 0 and arg + 1 < argc)
+		{
+			output = argv[++arg];
+			continue;
+		}
+		if (!fs::is_directory(argv[arg]))
+		{
+			files.emplace_back(argv[arg]);
+			continue;
+		}
+		std::vector<std::string> found;
+		for (const auto &entry: fs::directory_iterator(argv[arg]))
+			if (entry.is_regular_file() and entry.path().extension() == ".hkb")
+				found.push_back(entry.path().string());
+		std::sort(found.begin(), found.end());
+		files.insert(files.end(), found.begin(), found.end());
+	}
+
+	// the worlds take very different times, so they are handed out one by one
+	std::vector<std::string> lines(files.size());
+#pragma omp parallel
+	{
+		hackenbush game;
+#pragma omp for schedule(dynamic)
+		for (std::size_t i = 0; i < files.size(); ++i)
+			lines[i] = evaluate(game, files[i]);
+	}
+
+	std::ofstream file;
+	if (!output.empty())
+	{
+		file.open(output);
+		if (!file.is_open())
+		{
+			std::cerr << "Could not open file: " << output << '\n';
+			return 1;
+		}
+	}
+	std::ostream &out = output.empty() ? std::cout : file;
+	out << "file,value,outcome,components,edges,milliseconds\n";
+	for (const std::string &line: lines)
+		out << line << '\n';
+	return 0;
+}
@@ -20,7 +20,7 @@
  * @param filename the filename of the file to parse.
  */
 static void parse_positions(worldgen::lut_t &node_pos,
-							std::unordered_map<glm::vec3, int32_t> &node_ids,
+							worldgen::position_map &node_ids,
 							const char *filename)
 {
 	std::ifstream file(filename);
@@ -53,29 +53,23 @@ static void parse_positions(worldgen::lut_t &node_pos,
 		    throw worldgen::hackenbush_parsing_exception(line_number, line);
 
 		ss >> pos1.x >> pos1.y >> pos1.z;
-		if (ss.fail())
+		if (ss.fail() or !worldgen::position_map::in_range(pos1))
 		    throw worldgen::hackenbush_parsing_exception(line_number, line);
 
 		// if the position is not found, update the database to include it.
-		if (node_ids.find(pos1) == node_ids.end())
-		{
-			node_ids[pos1] = node_id;
+		if (node_ids.insert(pos1, node_id).second)
 			node_pos[node_id++] = pos1;
-		}
 
 		ss >> command;
 		if (command.size() != 2)
 		    throw worldgen::hackenbush_parsing_exception(line_number, line);
 
 		ss >> pos2.x >> pos2.y >> pos2.z;
-		if (ss.fail())
+		if (ss.fail() or !worldgen::position_map::in_range(pos2))
 		    throw worldgen::hackenbush_parsing_exception(line_number, line);
 
-		if (node_ids.find(pos2) == node_ids.end() and option[0] != 'f')
-		{
-			node_ids[pos2] = node_id;
+		if (option[0] != 'f' and node_ids.insert(pos2, node_id).second)
 			node_pos[node_id++] = pos2;
-		}
 	}
 	file.close();
 }
@@ -95,7 +89,7 @@ namespace worldgen {
  */
 bool parse(const char *filename, lut_t &node_pos, adj_list_t &adj_list)
 {
-	std::unordered_map<glm::vec3, int32_t> node_ids;
+	position_map node_ids;
 	parse_positions(node_pos, node_ids, filename);
 
 	const std::size_t num_nodes = node_ids.size();
@@ -158,12 +152,16 @@ bool parse(const char *filename, lut_t &node_pos, adj_list_t &adj_list)
 		if (ss.fail())
 		    throw worldgen::hackenbush_parsing_exception(line_number, line);
 
-		id1 = node_ids.at(pos1);
+		id1 = node_ids.find(pos1);
+		if (id1 == position_map::npos)
+			throw hackenbush_parsing_exception(line_number, line);
 		if (branch_type == game::invalid)
 			adj_list[id1].ty = node_type::stack_root;
 		else
 		{
-			id2 = node_ids.at(pos2);
+			id2 = node_ids.find(pos2);
+			if (id2 == position_map::npos)
+				throw hackenbush_parsing_exception(line_number, line);
 			adj_list[id1].conn.push_back(edge(id2, branch_type));
 		}
 
@@ -189,18 +187,19 @@ bool parse(const char *filename, lut_t &node_pos, adj_list_t &adj_list)
 			case 'g':
 			{
 				glm::vec3 leaf = pos1 + pos2;
-				auto it = node_ids.find(leaf);
+				if (!position_map::in_range(leaf))
+					throw hackenbush_parsing_exception(line_number, line);
 
 				// if the leaf is not attached to anything else, it won't
 				// be in the LUT yet. Thus, add it.
-				if (it == node_ids.end())
+				bool inserted;
+				std::tie(id2, inserted) = node_ids.insert(leaf,
+														  node_ids.size());
+				if (inserted)
 				{
-					id2 = node_ids.size();
-					node_ids[leaf] = id2;
 					node_pos[id2] = leaf;
+					adj_list.resize(node_ids.size());
 				}
-				else
-					id2 = it->second;
 				break;
 			}
 			default:
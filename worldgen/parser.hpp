@@ -21,17 +21,20 @@
 #include <unordered_map>
 #include <vector>
 #include <list>
+#include <tuple>
+#include "common/hash.hpp"
 #include "game/prereqs.hpp"
 #include "game/nodes.hpp"
 #include "game/generators.hpp"
+#include "position_map.hpp"
 
 template<>
 struct std::hash<glm::vec3>
 {
 	size_t operator()(const glm::vec3 &vec) const
 	{
-		return std::hash<float>()(vec.x) ^ std::hash<float>()(vec.y) ^
-			   std::hash<float>()(vec.z);
+		return hashing::combine(hashing::bits(vec.x), hashing::bits(vec.y),
+								hashing::bits(vec.z));
 	}
 };
 
@@ -0,0 +1,171 @@
+/**
+ * @file position_map.hpp
+ * @author Jonah Chen
+ * @brief map the positions read from a world generation file to the ids of the
+ * nodes at those positions, so every position becomes exactly one node.
+ * @version 1.0
+ * @date 2021-11-25
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#pragma once
+
+#include "common/hash.hpp"
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace worldgen {
+
+/**
+ * @brief open addressing hash map from positions to node ids.
+ *
+ * @details
+ * - Positions are quantized to multiples of QUANTUM before they are hashed and
+ *   compared, so positions that only differ by rounding errors of the text
+ *   format are the same node. QUANTUM is a power of two, so any coordinate with
+ *   at most 10 binary digits after the point, like 0.5 or 0.125, is exact.
+ * - The three quantized coordinates are hashed together with hashing::combine,
+ *   so lattices, where many coordinates are permutations of each other, spread
+ *   evenly over the table.
+ * - The keys and ids live in one flat array probed linearly, which is kept at
+ *   most half full.
+ */
+class position_map
+{
+public:
+	// id returned by find when the position is not in the map.
+	static constexpr int32_t npos = -1;
+
+	// the positions are rounded to the nearest multiple of QUANTUM.
+	static constexpr float QUANTUM = 1.0f / 1024.0f;
+
+	// the largest magnitude of a coordinate that can be quantized.
+	static constexpr float LIMIT = 2097151.0f;
+
+	/**
+	 * @brief Construct an empty map.
+	 *
+	 * @param expected the number of positions expected, to avoid growing the
+	 * table while inserting them.
+	 */
+	explicit position_map(std::size_t expected = 0)
+	{ reserve(expected); }
+
+	/**
+	 * @return true if every coordinate of the position is finite and at most
+	 * LIMIT in magnitude, so it can be stored in the map.
+	 */
+	static bool in_range(const glm::vec3 &pos)
+	{
+		return std::abs(pos.x) <= LIMIT and std::abs(pos.y) <= LIMIT and
+			   std::abs(pos.z) <= LIMIT;
+	}
+
+	/**
+	 * @brief find the id of the node at a position.
+	 *
+	 * @pre the position is in range.
+	 * @return int32_t the id, or npos if no node is at the position.
+	 */
+	int32_t find(const glm::vec3 &pos) const
+	{
+		if (slots_.empty())
+			return npos;
+		const key k = quantize(pos);
+		for (std::size_t i = home(k);; i = (i + 1) & mask_)
+		{
+			if (slots_[i].id == npos)
+				return npos;
+			if (slots_[i].k == k)
+				return slots_[i].id;
+		}
+	}
+
+	/**
+	 * @brief insert the id of the node at a position, unless there already is
+	 * a node at the position.
+	 *
+	 * @pre the position is in range.
+	 * @param pos the position of the node.
+	 * @param id the id of the node, which must not be npos.
+	 * @return std::pair<int32_t, bool> the id of the node at the position, and
+	 * whether it was inserted by this call.
+	 */
+	std::pair<int32_t, bool> insert(const glm::vec3 &pos, int32_t id)
+	{
+		if (2 * (size_ + 1) > slots_.size())
+			reserve(size_ + 1);
+		const key k = quantize(pos);
+		std::size_t i = home(k);
+		for (; slots_[i].id != npos; i = (i + 1) & mask_)
+			if (slots_[i].k == k)
+				return {slots_[i].id, false};
+		slots_[i] = {k, id};
+		++size_;
+		return {id, true};
+	}
+
+	/**
+	 * @brief grow the table so it can hold n positions without growing again.
+	 */
+	void reserve(std::size_t n)
+	{
+		std::size_t capacity = 16;
+		while (capacity < 2 * n)
+			capacity *= 2;
+		if (capacity <= slots_.size())
+			return;
+
+		std::vector<slot> old(capacity);
+		old.swap(slots_);
+		mask_ = capacity - 1;
+		for (const slot &s: old)
+		{
+			if (s.id == npos)
+				continue;
+			std::size_t i = home(s.k);
+			while (slots_[i].id != npos)
+				i = (i + 1) & mask_;
+			slots_[i] = s;
+		}
+	}
+
+	inline std::size_t size() const
+	{ return size_; }
+
+private:
+	struct key
+	{
+		int32_t x, y, z;
+
+		bool operator==(const key &other) const
+		{ return x == other.x and y == other.y and z == other.z; }
+	};
+
+	struct slot
+	{
+		key k;
+		int32_t id = npos;
+	};
+
+	static key quantize(const glm::vec3 &pos)
+	{
+		return {(int32_t) std::lround(pos.x / QUANTUM),
+				(int32_t) std::lround(pos.y / QUANTUM),
+				(int32_t) std::lround(pos.z / QUANTUM)};
+	}
+
+	inline std::size_t home(const key &k) const
+	{ return hashing::combine(k.x, k.y, k.z) & mask_; }
+
+	std::vector<slot> slots_;
+	std::size_t mask_ = 0;
+	std::size_t size_ = 0;
+};
+
+}
@@ -0,0 +1,211 @@
+/**
+ * @file tablebase.cxx
+ * @author Jonah Chen
+ * @brief builds the table of game::tablebase. Every connected red-blue
+ * component up to the given number of edges is enumerated once up to the
+ * numbering of its nodes, by adding every possible edge to the components
+ * with one edge less and keeping the canonical codes seen for the first time.
+ * The components with cycles, which the evaluator would search, are valued
+ * and written to the table. Trees have a closed form and are left out.
+ *
+ * Usage: tablebase [output file] [max edges]
+ * @version 1.0
+ * @date 2021-12-09
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include "game/tablebase.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using game::tablebase;
+using clk = std::chrono::steady_clock;
+
+/**
+ * @brief the value of a component, by searching every position reached by
+ * chopping its edges.
+ */
+class valuer
+{
+public:
+	game::dyadic operator()(const tablebase::edge *edges, std::size_t n)
+	{
+		edges_ = edges;
+		incident_.assign(tablebase::MAX_NODES + 1, 0);
+		for (std::size_t j = 0; j < n; ++j)
+		{
+			incident_[edges[j].p1] |= 1u << j;
+			incident_[edges[j].p2] |= 1u << j;
+		}
+		values_.clear();
+		return value((1u << n) - 1);
+	}
+
+private:
+	const tablebase::edge *edges_ = nullptr;
+	std::vector<uint32_t> incident_;
+	std::unordered_map<uint32_t, game::dyadic> values_;
+
+	uint32_t grounded(uint32_t alive) const
+	{
+		uint32_t kept = 0, reached = 1, stack[tablebase::MAX_NODES + 1];
+		int top = 0;
+		stack[top++] = 0;
+		while (top)
+		{
+			const uint32_t fresh = incident_[stack[--top]] & alive & ~kept;
+			kept |= fresh;
+			for (uint32_t rest = fresh; rest; rest &= rest - 1)
+			{
+				const tablebase::edge &e = edges_[__builtin_ctz(rest)];
+				for (uint32_t v: {e.p1, e.p2})
+				{
+					if (reached >> v & 1)
+						continue;
+					reached |= 1u << v;
+					stack[top++] = v;
+				}
+			}
+		}
+		return kept;
+	}
+
+	game::dyadic value(uint32_t alive)
+	{
+		if (!alive)
+			return 0;
+		const auto found = values_.find(alive);
+		if (found != values_.end())
+			return found->second;
+
+		std::optional<game::dyadic> left, right;
+		for (uint32_t rest = alive; rest; rest &= rest - 1)
+		{
+			const int j = __builtin_ctz(rest);
+			const game::dyadic option = value(grounded(alive & ~(1u << j)));
+			if (edges_[j].type == game::blue)
+				left = left ? std::max(*left, option) : option;
+			else
+				right = right ? std::min(*right, option) : option;
+		}
+		return values_[alive] = game::simplest(left, right);
+	}
+};
+
+static uint32_t num_nodes(const tablebase::edge *edges, std::size_t n)
+{
+	uint32_t k = 0;
+	for (std::size_t j = 0; j < n; ++j)
+		k = std::max({k, edges[j].p1, edges[j].p2});
+	return k;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 2)
+	{
+		std::cout << "Usage: tablebase [output file] [max edges]\n"
+					 "- max edges is at most " << tablebase::MAX_EDGES
+				  << ", and 7 if it is not given.\n";
+		return 0;
+	}
+	const uint32_t max_edges = std::min<uint32_t>(
+			argc > 2 ? std::stoul(argv[2]) : 7, tablebase::MAX_EDGES);
+
+	const auto start = clk::now();
+	std::vector<tablebase::entry> entries;
+	std::vector<tablebase::code_t> level;
+	for (game::branch_type type: {game::blue, game::red})
+	{
+		const tablebase::edge e{0, 1, type};
+		level.push_back(tablebase::canonical(&e, 1));
+	}
+
+	for (uint32_t m = 1; m <= max_edges; ++m)
+	{
+		// value the components with cycles of this size
+		std::vector<tablebase::entry> found(level.size(), {0, 0});
+#pragma omp parallel
+		{
+			valuer value;
+			tablebase::edge edges[tablebase::MAX_EDGES];
+#pragma omp for schedule(dynamic, 64)
+			for (std::size_t i = 0; i < level.size(); ++i)
+			{
+				const std::size_t n = tablebase::decode(level[i], edges);
+				if (n > num_nodes(edges, n))
+					found[i] = {level[i], value(edges, n)};
+			}
+		}
+		std::size_t cycles = 0;
+		for (const tablebase::entry &e: found)
+		{
+			if (e.code)
+			{
+				entries.push_back(e);
+				++cycles;
+			}
+		}
+		std::cout << m << " edges: " << level.size() << " components, "
+				  << cycles << " with cycles\n";
+		if (m == max_edges)
+			break;
+
+		// every component of one more edge is a component of this size with
+		// an edge added, between two of its nodes or from one of its nodes
+		// other than the ground to a new node, which would otherwise be a
+		// component of its own
+		std::vector<tablebase::code_t> next;
+#pragma omp parallel
+		{
+			std::vector<tablebase::code_t> mine;
+			tablebase::edge edges[tablebase::MAX_EDGES + 1];
+#pragma omp for schedule(dynamic, 64) nowait
+			for (std::size_t i = 0; i < level.size(); ++i)
+			{
+				const std::size_t n = tablebase::decode(level[i], edges);
+				const uint32_t k = num_nodes(edges, n);
+				for (uint32_t a = 0; a <= k; ++a)
+				{
+					for (uint32_t b = a + 1; b <= std::min(k + 1,
+														   tablebase::MAX_NODES); ++b)
+					{
+						if (a == 0 and b == k + 1)
+							continue;
+						for (game::branch_type type: {game::blue, game::red})
+						{
+							edges[n] = {a, b, type};
+							const tablebase::code_t code =
+									tablebase::canonical(edges, n + 1);
+							if (code)
+								mine.push_back(code);
+						}
+					}
+				}
+			}
+#pragma omp critical
+			next.insert(next.end(), mine.begin(), mine.end());
+		}
+		std::sort(next.begin(), next.end());
+		next.erase(std::unique(next.begin(), next.end()), next.end());
+		level.swap(next);
+	}
+
+	tablebase::write(argv[1], entries, max_edges);
+	const double seconds = std::chrono::duration<double>(clk::now() -
+														 start).count();
+	const tablebase table(argv[1]);
+	std::cout << "wrote " << table.size() << " components to " << argv[1]
+			  << ", " << table.bytes() << " bytes, in " << seconds << " s\n";
+	return 0;
+}